@@ -0,0 +1,289 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2017 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/** \file
+ * Check and benchmark of the AVX2 effects.
+ *
+ * Every AVX2 kernel of the scale and hq effects is run on random rows
+ * of all the lengths up to BENCH_SHORT, and of some lengths around
+ * INTERP_MASK_MAX, in the RGB 565, 555 and 888 formats. The result
+ * must be equal byte by byte to the one of the C kernel.
+ *
+ * Then it reports the time in ns for every source pixel of both the
+ * implementations, processing rows of BENCH_WIDTH pixels.
+ */
+
+#include "portable.h"
+
+#include "rgb.h"
+#include "interp.h"
+#include "scale2x.h"
+#include "scale3x.h"
+#include "hq2x.h"
+#include "hq2x3.h"
+#include "hq2x4.h"
+#include "hq3x.h"
+#include "hq4x.h"
+
+#include <sys/time.h>
+
+/** Max row length checked, over the limit of the HQ masks computed in advance. */
+#define BENCH_MAX (INTERP_MASK_MAX + 64)
+
+/** Short row lengths checked, all of them from 2. */
+#define BENCH_SHORT 80
+
+/** Row length of the benchmark. */
+#define BENCH_WIDTH 320
+
+/** Rows processed by the benchmark. */
+#define BENCH_ROWS 100000
+
+/** Number of kernels. */
+#define BENCH_KERNEL 9
+
+static double bench_time(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, 0);
+
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+#if defined(USE_BLIT_AVX2)
+
+/** Random generator, always with the same sequence. */
+static unsigned bench_seed;
+
+static unsigned bench_rand(void)
+{
+	bench_seed = bench_seed * 1103515245 + 12345;
+	return bench_seed >> 8;
+}
+
+/**
+ * Fill three rows with random pixels.
+ * Pixels are taken from a small set of colors, some of them nearly equal,
+ * to exercise all the equal and different cases of the effects.
+ */
+static void bench_fill(uint32 (*src)[BENCH_MAX], unsigned bytes_per_pixel, unsigned count)
+{
+	unsigned color[8];
+	unsigned i, j;
+
+	for (i = 0; i < 8; i += 2) {
+		color[i] = bench_rand();
+		color[i + 1] = color[i] ^ (bench_rand() & 0x070707);
+	}
+
+	for (i = 0; i < 3; ++i) {
+		for (j = 0; j < count; ++j) {
+			unsigned c = color[bench_rand() % 8];
+			if (bytes_per_pixel == 2)
+				((uint16*)src[i])[j] = c;
+			else
+				src[i][j] = c;
+		}
+	}
+}
+
+static const char* bench_name[BENCH_KERNEL] = {
+	"scale2x", "scale2x3", "scale2x4", "scale3x", "hq2x", "hq2x3", "hq2x4", "hq3x", "hq4x"
+};
+
+static const unsigned bench_factor[BENCH_KERNEL] = {
+	2, 2, 2, 3, 2, 2, 2, 3, 4
+};
+
+static const unsigned bench_rows[BENCH_KERNEL] = {
+	2, 3, 4, 3, 2, 3, 4, 3, 4
+};
+
+#define BENCH_CALL(name, bits, impl, ...) name ## _ ## bits ## _ ## impl(__VA_ARGS__)
+
+#define BENCH_RUN(bits, impl, type) \
+	switch (kernel) { \
+	case 0 : BENCH_CALL(scale2x, bits, impl, (type*)dst[0], (type*)dst[1], (type*)src[0], (type*)src[1], (type*)src[2], count); break; \
+	case 1 : BENCH_CALL(scale2x3, bits, impl, (type*)dst[0], (type*)dst[1], (type*)dst[2], (type*)src[0], (type*)src[1], (type*)src[2], count); break; \
+	case 2 : BENCH_CALL(scale2x4, bits, impl, (type*)dst[0], (type*)dst[1], (type*)dst[2], (type*)dst[3], (type*)src[0], (type*)src[1], (type*)src[2], count); break; \
+	case 3 : BENCH_CALL(scale3x, bits, impl, (type*)dst[0], (type*)dst[1], (type*)dst[2], (type*)src[0], (type*)src[1], (type*)src[2], count); break; \
+	case 4 : BENCH_CALL(hq2x, bits, impl, (type*)dst[0], (type*)dst[1], (type*)src[0], (type*)src[1], (type*)src[2], count); break; \
+	case 5 : BENCH_CALL(hq2x3, bits, impl, (type*)dst[0], (type*)dst[1], (type*)dst[2], (type*)src[0], (type*)src[1], (type*)src[2], count); break; \
+	case 6 : BENCH_CALL(hq2x4, bits, impl, (type*)dst[0], (type*)dst[1], (type*)dst[2], (type*)dst[3], (type*)src[0], (type*)src[1], (type*)src[2], count); break; \
+	case 7 : BENCH_CALL(hq3x, bits, impl, (type*)dst[0], (type*)dst[1], (type*)dst[2], (type*)src[0], (type*)src[1], (type*)src[2], count); break; \
+	case 8 : BENCH_CALL(hq4x, bits, impl, (type*)dst[0], (type*)dst[1], (type*)dst[2], (type*)dst[3], (type*)src[0], (type*)src[1], (type*)src[2], count); break; \
+	}
+
+/**
+ * Run a kernel with the C implementation.
+ */
+static void bench_def(unsigned kernel, uint32 (*dst)[4 * BENCH_MAX], uint32 (*src)[BENCH_MAX], unsigned bytes_per_pixel, unsigned count)
+{
+	if (bytes_per_pixel == 2) {
+		BENCH_RUN(16, def, interp_uint16);
+	} else {
+		BENCH_RUN(32, def, interp_uint32);
+	}
+}
+
+/**
+ * Run a kernel with the AVX2 implementation.
+ */
+static void bench_avx2(unsigned kernel, uint32 (*dst)[4 * BENCH_MAX], uint32 (*src)[BENCH_MAX], unsigned bytes_per_pixel, unsigned count)
+{
+	if (bytes_per_pixel == 2) {
+		BENCH_RUN(16, avx2, interp_uint16);
+	} else {
+		BENCH_RUN(32, avx2, interp_uint32);
+	}
+}
+
+/**
+ * Check the AVX2 implementations of a pixel format against the C ones.
+ * \return The number of mismatches.
+ */
+static unsigned check(adv_color_def def, uint32 (*dst_def)[4 * BENCH_MAX], uint32 (*dst_avx2)[4 * BENCH_MAX], uint32 (*src)[BENCH_MAX])
+{
+	/* the long rows are around the limit of the masks computed in advance */
+	static const unsigned long_map[] = { INTERP_MASK_MAX - 1, INTERP_MASK_MAX, INTERP_MASK_MAX + 1, BENCH_MAX };
+	unsigned bytes_per_pixel = color_def_bytes_per_pixel_get(def);
+	unsigned mismatch = 0;
+	unsigned kernel;
+	unsigned l;
+
+	/* the HQ effects compare the pixels with the masks of the format */
+	interp_set(def);
+
+	for (l = 2; l <= BENCH_SHORT + sizeof(long_map) / sizeof(long_map[0]); ++l) {
+		unsigned count = l <= BENCH_SHORT ? l : long_map[l - BENCH_SHORT - 1];
+
+		bench_fill(src, bytes_per_pixel, count);
+
+		for (kernel = 0; kernel < BENCH_KERNEL; ++kernel) {
+			unsigned i;
+
+			/* use different initial values to detect missing writes */
+			memset(dst_def, 0x00, 4 * sizeof(*dst_def));
+			memset(dst_avx2, 0xFF, 4 * sizeof(*dst_avx2));
+
+			bench_def(kernel, dst_def, src, bytes_per_pixel, count);
+			bench_avx2(kernel, dst_avx2, src, bytes_per_pixel, count);
+
+			for (i = 0; i < bench_rows[kernel]; ++i) {
+				if (memcmp(dst_def[i], dst_avx2[i], bench_factor[kernel] * count * bytes_per_pixel) != 0) {
+					printf("%-8s %-12s %4u pixels  AVX2 differs from C\n", bench_name[kernel], color_def_name_get(def), count);
+					++mismatch;
+					break;
+				}
+			}
+		}
+	}
+
+	return mismatch;
+}
+
+/**
+ * Benchmark the C and AVX2 implementations of a pixel format.
+ */
+static void bench(adv_color_def def, uint32 (*dst)[4 * BENCH_MAX], uint32 (*src)[BENCH_MAX])
+{
+	unsigned bytes_per_pixel = color_def_bytes_per_pixel_get(def);
+	unsigned kernel;
+	unsigned i;
+
+	interp_set(def);
+
+	bench_fill(src, bytes_per_pixel, BENCH_WIDTH);
+
+	for (kernel = 0; kernel < BENCH_KERNEL; ++kernel) {
+		double start, time_def, time_avx2;
+
+		start = bench_time();
+		for (i = 0; i < BENCH_ROWS; ++i)
+			bench_def(kernel, dst, src, bytes_per_pixel, BENCH_WIDTH);
+		time_def = bench_time() - start;
+
+		start = bench_time();
+		for (i = 0; i < BENCH_ROWS; ++i)
+			bench_avx2(kernel, dst, src, bytes_per_pixel, BENCH_WIDTH);
+		time_avx2 = bench_time() - start;
+
+		printf("%-8s %-12s  C %6.2f ns/pixel  AVX2 %6.2f ns/pixel  speedup %4.1fx\n",
+			bench_name[kernel], color_def_name_get(def),
+			time_def * 1E9 / ((double)BENCH_ROWS * BENCH_WIDTH), time_avx2 * 1E9 / ((double)BENCH_ROWS * BENCH_WIDTH),
+			time_def / time_avx2);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	adv_color_def def_map[3];
+	uint32 (*src)[BENCH_MAX];
+	uint32 (*dst_def)[4 * BENCH_MAX];
+	uint32 (*dst_avx2)[4 * BENCH_MAX];
+	unsigned mismatch;
+	unsigned i;
+
+	__builtin_cpu_init();
+	if (!__builtin_cpu_supports("avx2")) {
+		printf("AVX2 not supported by this processor\n");
+		return EXIT_SUCCESS;
+	}
+
+	def_map[0] = color_def_make_rgb_from_sizelenpos(2, 5, 11, 6, 5, 5, 0);
+	def_map[1] = color_def_make_rgb_from_sizelenpos(2, 5, 10, 5, 5, 5, 0);
+	def_map[2] = color_def_make_rgb_from_sizelenpos(4, 8, 16, 8, 8, 8, 0);
+
+	src = malloc(3 * sizeof(*src));
+	dst_def = malloc(4 * sizeof(*dst_def));
+	dst_avx2 = malloc(4 * sizeof(*dst_avx2));
+
+	bench_seed = 1;
+
+	mismatch = 0;
+	for (i = 0; i < 3; ++i)
+		mismatch += check(def_map[i], dst_def, dst_avx2, src);
+
+	for (i = 0; i < 3; ++i)
+		bench(def_map[i], dst_def, src);
+
+	free(src);
+	free(dst_def);
+	free(dst_avx2);
+
+	if (mismatch) {
+		printf("Results don't match!\n");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+#else
+
+int main(int argc, char* argv[])
+{
+	printf("AVX2 not supported by this compiler\n");
+
+	return EXIT_SUCCESS;
+}
+
+#endif
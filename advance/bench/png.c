@@ -0,0 +1,359 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2017 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/** \file
+ * Benchmark of the PNG decoder.
+ *
+ * It decodes all the PNG files specified in the command line, like the
+ * snapshots shown by the menu, and it reports the speed in MB/s of
+ * decoded image data.
+ *
+ * Then every image is filtered with every filter type, and the unfilter
+ * functions are compared with the previous C implementation, checking
+ * that the result is the same. The palette images are also expanded
+ * at 24 and 32 bits, to measure the RGB unfilters with any image set.
+ */
+
+#include "portable.h"
+
+#include "png.h"
+#include "fz.h"
+#include "error.h"
+
+#include <sys/time.h>
+
+/** Min time of every measure in seconds. */
+#define BENCH_TIME 0.5
+
+static double bench_time(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, 0);
+
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/**
+ * Previous implementation of the unfilter, one byte at time.
+ */
+static inline void ref_unfilter(unsigned width, unsigned height, unsigned char* p, unsigned line, unsigned bpp)
+{
+	unsigned i, j;
+
+	for (i = 0; i < height; ++i) {
+		unsigned char f = *p++;
+
+		if (f == 1) { /* sub */
+			for (j = bpp; j < width; ++j)
+				p[j] += p[j - bpp];
+		} else if (f == 2) { /* up */
+			if (i) {
+				unsigned char* u = p - line;
+				for (j = 0; j < width; ++j)
+					p[j] += u[j];
+			}
+		} else if (f == 3) { /* average */
+			if (i) {
+				unsigned char* u = p - line;
+				for (j = 0; j < bpp; ++j)
+					p[j] += u[j] / 2;
+				for (j = bpp; j < width; ++j)
+					p[j] += ((unsigned)u[j] + (unsigned)p[j - bpp]) >> 1;
+			} else {
+				for (j = bpp; j < width; ++j)
+					p[j] += p[j - bpp] / 2;
+			}
+		} else if (f == 4) { /* paeth */
+			unsigned char* u = p - line;
+			for (j = 0; j < width; ++j) {
+				unsigned a, b, c;
+				int v;
+				int da, db, dc;
+				a = j < bpp ? 0 : p[j - bpp];
+				b = i < 1 ? 0 : u[j];
+				c = (j < bpp || i < 1) ? 0 : u[j - bpp];
+				v = a + b - c;
+				da = v - a;
+				if (da < 0)
+					da = -da;
+				db = v - b;
+				if (db < 0)
+					db = -db;
+				dc = v - c;
+				if (dc < 0)
+					dc = -dc;
+				if (da <= db && da <= dc)
+					p[j] += a;
+				else if (db <= dc)
+					p[j] += b;
+				else
+					p[j] += c;
+			}
+		}
+
+		p += line - 1;
+	}
+}
+
+static void ref_unfilter_bpp(unsigned width, unsigned height, unsigned char* p, unsigned line, unsigned bpp)
+{
+	/* the previous implementation had a function for every pixel size */
+	if (bpp == 1)
+		ref_unfilter(width, height, p, line, 1);
+	else if (bpp == 3)
+		ref_unfilter(width, height, p, line, 3);
+	else
+		ref_unfilter(width, height, p, line, 4);
+}
+
+static void new_unfilter(unsigned width, unsigned height, unsigned char* p, unsigned line, unsigned bpp)
+{
+	if (bpp == 1)
+		adv_png_unfilter_8(width, height, p, line);
+	else if (bpp == 3)
+		adv_png_unfilter_24(width, height, p, line);
+	else
+		adv_png_unfilter_32(width, height, p, line);
+}
+
+/**
+ * Filter all the rows of an image with the specified filter type.
+ */
+static void bench_filter(unsigned char* d, const unsigned char* s, unsigned width, unsigned height, unsigned line, unsigned bpp, unsigned char f)
+{
+	unsigned i, j;
+
+	for (i = 0; i < height; ++i) {
+		const unsigned char* p = s + i * line + 1;
+		const unsigned char* u = p - line;
+		unsigned char* o = d + i * line;
+
+		*o++ = f;
+
+		for (j = 0; j < width; ++j) {
+			int a = j >= bpp ? p[j - bpp] : 0;
+			int b = i ? u[j] : 0;
+			int c = i && j >= bpp ? u[j - bpp] : 0;
+			int v, da, db, dc, pr;
+
+			switch (f) {
+			case 0 : pr = 0; break;
+			case 1 : pr = a; break;
+			case 2 : pr = b; break;
+			case 3 : pr = (a + b) >> 1; break;
+			default :
+				v = a + b - c;
+				da = abs(v - a);
+				db = abs(v - b);
+				dc = abs(v - c);
+				if (da <= db && da <= dc)
+					pr = a;
+				else if (db <= dc)
+					pr = b;
+				else
+					pr = c;
+				break;
+			}
+
+			o[j] = p[j] - pr;
+		}
+	}
+}
+
+/**
+ * Measure an unfilter function.
+ * \return The speed in MB/s.
+ */
+static double bench_unfilter(void (*func)(unsigned, unsigned, unsigned char*, unsigned, unsigned), unsigned char* buf, const unsigned char* filtered, unsigned size, unsigned width, unsigned height, unsigned line, unsigned bpp)
+{
+	double start, stop;
+	unsigned count = 0;
+
+	start = bench_time();
+	do {
+		memcpy(buf, filtered, size);
+		func(width, height, buf, line, bpp);
+		++count;
+		stop = bench_time();
+	} while (stop - start < BENCH_TIME);
+
+	return (double)count * width * height / (stop - start) / 1E6;
+}
+
+/**
+ * Check and measure all the unfilter functions on an image.
+ * \param dat_ptr Image data, every row prefixed by the filter type byte.
+ */
+static int bench_unfilter_image(const unsigned char* dat_ptr, unsigned pix_width, unsigned pix_height, unsigned pix_pixel, unsigned pix_scanline)
+{
+	unsigned char* filtered;
+	unsigned char* buf;
+	unsigned width, line, size;
+	unsigned char f;
+	unsigned i;
+
+	width = pix_width * pix_pixel;
+	line = pix_scanline;
+	size = pix_height * line;
+
+	filtered = malloc(size);
+	buf = malloc(size);
+
+	for (f = 1; f <= 4; ++f) {
+		static const char* name[5] = { "none", "sub", "up", "average", "paeth" };
+		double ref, new;
+
+		bench_filter(filtered, dat_ptr, width, pix_height, line, pix_pixel, f);
+
+		memcpy(buf, filtered, size);
+		new_unfilter(width, pix_height, buf, line, pix_pixel);
+		for (i = 0; i < pix_height; ++i) {
+			if (memcmp(buf + i * line + 1, dat_ptr + i * line + 1, width) != 0) {
+				fprintf(stderr, "Wrong result with the %s filter\n", name[f]);
+				free(buf);
+				free(filtered);
+				return -1;
+			}
+		}
+
+		ref = bench_unfilter(ref_unfilter_bpp, buf, filtered, size, width, pix_height, line, pix_pixel);
+		new = bench_unfilter(new_unfilter, buf, filtered, size, width, pix_height, line, pix_pixel);
+
+		printf("\t%-8s %8.1f MB/s, previous %8.1f MB/s, %.2fx\n", name[f], new, ref, new / ref);
+	}
+
+	free(buf);
+	free(filtered);
+
+	return 0;
+}
+
+static int bench_file(const char* file, double* total_size, double* total_time)
+{
+	unsigned pix_width, pix_height, pix_pixel;
+	unsigned char* dat_ptr;
+	unsigned dat_size;
+	unsigned char* pix_ptr;
+	unsigned pix_scanline;
+	unsigned char* pal_ptr;
+	unsigned pal_size;
+	double start, stop;
+	unsigned count;
+	unsigned i;
+	adv_fz* fz;
+
+	/* decode */
+	count = 0;
+	start = bench_time();
+	do {
+		fz = fzopen(file, "rb");
+		if (!fz) {
+			fprintf(stderr, "Error opening %s\n", file);
+			return -1;
+		}
+
+		if (adv_png_read(&pix_width, &pix_height, &pix_pixel, &dat_ptr, &dat_size, &pix_ptr, &pix_scanline, &pal_ptr, &pal_size, fz) != 0) {
+			fprintf(stderr, "Error reading %s, %s\n", file, error_get());
+			fzclose(fz);
+			return -1;
+		}
+
+		fzclose(fz);
+
+		++count;
+		stop = bench_time();
+
+		if (stop - start < BENCH_TIME) {
+			free(dat_ptr);
+			free(pal_ptr);
+		}
+	} while (stop - start < BENCH_TIME);
+
+	printf("%s %ux%ux%u\n", file, pix_width, pix_height, pix_pixel * 8);
+	printf("\tdecode %8.1f MB/s\n", (double)count * pix_width * pix_height * pix_pixel / (stop - start) / 1E6);
+
+	*total_size += (double)count * pix_width * pix_height * pix_pixel;
+	*total_time += stop - start;
+
+	/* unfilter */
+	if (bench_unfilter_image(dat_ptr, pix_width, pix_height, pix_pixel, pix_scanline) != 0)
+		exit(EXIT_FAILURE);
+
+	/* unfilter the palette images also expanded at 24 and 32 bits */
+	if (pix_pixel == 1 && pal_ptr) {
+		unsigned bpp;
+
+		for (bpp = 3; bpp <= 4; ++bpp) {
+			unsigned rgb_scanline = pix_width * bpp + 1;
+			unsigned char* rgb_ptr = malloc(pix_height * rgb_scanline);
+
+			for (i = 0; i < pix_height; ++i) {
+				const unsigned char* s = dat_ptr + i * pix_scanline + 1;
+				unsigned char* d = rgb_ptr + i * rgb_scanline;
+				unsigned j;
+
+				*d++ = 0;
+				for (j = 0; j < pix_width; ++j) {
+					unsigned k = s[j] * 3 < pal_size ? s[j] * 3 : 0;
+					d[0] = pal_ptr[k];
+					d[1] = pal_ptr[k + 1];
+					d[2] = pal_ptr[k + 2];
+					if (bpp == 4)
+						d[3] = 0xFF;
+					d += bpp;
+				}
+			}
+
+			printf("\texpanded %ux%ux%u\n", pix_width, pix_height, bpp * 8);
+
+			if (bench_unfilter_image(rgb_ptr, pix_width, pix_height, bpp, rgb_scanline) != 0)
+				exit(EXIT_FAILURE);
+
+			free(rgb_ptr);
+		}
+	}
+
+	free(dat_ptr);
+	free(pal_ptr);
+
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	double total_size = 0;
+	double total_time = 0;
+	int i;
+
+	if (argc < 2) {
+		fprintf(stderr, "Syntax: advpng FILE.png...\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for (i = 1; i < argc; ++i) {
+		if (bench_file(argv[i], &total_size, &total_time) != 0)
+			exit(EXIT_FAILURE);
+	}
+
+	printf("Decoded %.1f MB/s\n", total_size / total_time / 1E6);
+
+	return EXIT_SUCCESS;
+}
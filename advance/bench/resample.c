@@ -0,0 +1,308 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2017 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/** \file
+ * Benchmark of the stream resampler of the emulator.
+ *
+ * It resamples some seconds of a synthetic signal between the sample
+ * rates of some common sound chips and of the sound card, in blocks of
+ * one frame of a 60 Hz game, and it reports the time in ns for every
+ * output sample of:
+ *  - the previous implementation with the loops that carry the position
+ *    from one sample to the next;
+ *  - the current vectorized implementation, with the linear
+ *    interpolation or the box filter;
+ *  - the windowed sinc filter of the 'sound_resample sinc' option.
+ *
+ * The previous and the vectorized implementations must give the same
+ * result bit by bit.
+ *
+ * The quality of the two modes is reported as the error in dB of a tone
+ * in the pass band compared to the ideal one, and when downsampling, as
+ * the level in dB of a tone over the Nyquist frequency of the output
+ * that should be removed.
+ */
+
+#include "resample.h"
+
+#include <stdlib.h>
+#include <math.h>
+#include <sys/time.h>
+
+/** Seconds of sound to process. */
+#define BENCH_SECONDS 10
+
+/** Frames per second of the emulated game. */
+#define BENCH_FPS 60
+
+/** Amplitude of the tones. */
+#define BENCH_AMPLITUDE 10000
+
+/** Gain of the resampling in 8.8 format. */
+#define BENCH_GAIN 0xC0
+
+/** Source samples kept before the position, like in the emulator. */
+#define BENCH_KEEP 256
+
+static double bench_time(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, 0);
+
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/**
+ * Previous implementation of the resampler.
+ */
+static UINT32 ref_process(INT32* dest, const INT32* source, UINT32 pos, UINT32 step, int gain, int samples)
+{
+	INT32 sample;
+
+	/* perfectly matching */
+	if (step == RESAMPLE_FRAC_ONE) {
+		while (samples--) {
+			sample = source[pos >> RESAMPLE_FRAC_BITS];
+			*dest++ = (sample * gain) >> 8;
+			pos += RESAMPLE_FRAC_ONE;
+		}
+	}
+
+	/* input is undersampled: use linear interpolation */
+	else if (step < RESAMPLE_FRAC_ONE) {
+		while (samples--) {
+			sample  = source[(pos >> RESAMPLE_FRAC_BITS) + 0] * (RESAMPLE_FRAC_ONE - (pos & RESAMPLE_FRAC_MASK));
+			sample += source[(pos >> RESAMPLE_FRAC_BITS) + 1] * (pos & RESAMPLE_FRAC_MASK);
+			sample >>= RESAMPLE_FRAC_BITS;
+			*dest++ = (sample * gain) >> 8;
+			pos += step;
+		}
+	}
+
+	/* input is oversampled: sum the energy */
+	else {
+		int smallstep = step >> (RESAMPLE_FRAC_BITS - 8);
+
+		while (samples--) {
+			int tpos = pos >> RESAMPLE_FRAC_BITS;
+			int remainder = smallstep;
+			int scale;
+
+			scale = (RESAMPLE_FRAC_ONE - (pos & RESAMPLE_FRAC_MASK)) >> (RESAMPLE_FRAC_BITS - 8);
+			sample = source[tpos++] * scale;
+			remainder -= scale;
+			while (remainder > 0x100) {
+				sample += source[tpos++] * 0x100;
+				remainder -= 0x100;
+			}
+			sample += source[tpos] * remainder;
+			sample /= smallstep;
+
+			*dest++ = (sample * gain) >> 8;
+			pos += step;
+		}
+	}
+
+	return pos;
+}
+
+/**
+ * Resample all the source in blocks of one frame.
+ * Like in the emulator, the position is moved back after every block,
+ * keeping some previous samples, to fit in the 32 bits of the position.
+ * \param sinc_taps Taps of the sinc filter, 0 for linear, -1 for the previous implementation.
+ * \return The time used.
+ */
+static double run(INT32* output, unsigned output_size, const INT32* input, UINT32 step, int gain, const INT32* sinc_coef, int sinc_taps, unsigned count)
+{
+	double start;
+	UINT32 pos;
+	unsigned i;
+
+	start = bench_time();
+
+	pos = 0;
+	for (i = 0; i < output_size; i += count) {
+		unsigned run = output_size - i < count ? output_size - i : count;
+		unsigned base = pos >> RESAMPLE_FRAC_BITS;
+
+		if (base > BENCH_KEEP) {
+			input += base - BENCH_KEEP;
+			pos -= (base - BENCH_KEEP) << RESAMPLE_FRAC_BITS;
+		}
+
+		if (sinc_taps < 0)
+			pos = ref_process(output + i, input, pos, step, gain, run);
+		else
+			pos = resample_process(output + i, input, pos, step, gain, sinc_coef, sinc_taps, run);
+	}
+
+	return bench_time() - start;
+}
+
+/**
+ * Fill the source with a tone.
+ */
+static void tone(INT32* input, unsigned input_size, unsigned rate, double freq)
+{
+	unsigned i;
+
+	for (i = 0; i < input_size; ++i)
+		input[i] = floor(BENCH_AMPLITUDE * sin(2 * M_PI * freq * i / rate) + 0.5);
+}
+
+/**
+ * Error in dB of a resampled tone compared with the ideal one.
+ * \param delay Delay of the output in source samples.
+ */
+static double error_db(const INT32* output, unsigned output_size, UINT32 step, unsigned rate, double freq, double delay, unsigned skip)
+{
+	double sum = 0;
+	unsigned i;
+
+	for (i = skip; i < output_size; ++i) {
+		double t = (double)i * step / RESAMPLE_FRAC_ONE - delay;
+		double ideal = BENCH_AMPLITUDE * sin(2 * M_PI * freq * t / rate);
+		double diff = output[i] - ideal;
+		sum += diff * diff;
+	}
+
+	return 10 * log10(sum / (output_size - skip) / (BENCH_AMPLITUDE * BENCH_AMPLITUDE / 2.0));
+}
+
+/**
+ * Level in dB of a resampled tone that should be removed.
+ */
+static double level_db(const INT32* output, unsigned output_size, unsigned skip)
+{
+	double sum = 0;
+	unsigned i;
+
+	for (i = skip; i < output_size; ++i)
+		sum += (double)output[i] * output[i];
+
+	return 10 * log10(sum / (output_size - skip) / (BENCH_AMPLITUDE * BENCH_AMPLITUDE / 2.0));
+}
+
+static void print_db(const char* name, double linear, double sinc)
+{
+	printf("  %s %6.1f/%6.1f dB", name, linear, sinc);
+}
+
+static int bench(unsigned input_rate, unsigned output_rate)
+{
+	UINT32 step = ((UINT64)input_rate << RESAMPLE_FRAC_BITS) / output_rate;
+	unsigned input_size = input_rate * BENCH_SECONDS;
+	/* the last output sample reads the source up to pos + 1 */
+	unsigned output_size = (UINT64)(input_size - 2) * RESAMPLE_FRAC_ONE / step;
+	unsigned count = output_rate / BENCH_FPS;
+	INT32* input = malloc(input_size * sizeof(INT32));
+	INT32* output_ref = malloc(output_size * sizeof(INT32));
+	INT32* output_linear = malloc(output_size * sizeof(INT32));
+	INT32* output_sinc = malloc(output_size * sizeof(INT32));
+	INT32* sinc_coef = malloc(RESAMPLE_SINC_SIZE * sizeof(INT32));
+	double time_ref, time_linear, time_sinc;
+	double low = input_rate < output_rate ? input_rate : output_rate;
+	double delay_linear, delay_sinc;
+	unsigned skip;
+	unsigned i, mismatch;
+	int sinc_taps;
+
+	sinc_taps = step != RESAMPLE_FRAC_ONE ? resample_sinc_compute(sinc_coef, step) : 0;
+
+	/* the box filter averages the source from pos to pos + step */
+	delay_linear = step > RESAMPLE_FRAC_ONE ? -0.5 * ((double)step / RESAMPLE_FRAC_ONE - 1) : 0;
+	/* the sinc filter is delayed to never read ahead of pos + 1 */
+	delay_sinc = sinc_taps != 0 ? sinc_taps / 2 - 1 : delay_linear;
+	skip = sinc_taps + 1;
+
+	/* two tones and some noise */
+	srand(input_rate);
+	for (i = 0; i < input_size; ++i) {
+		double t = (double)i / input_rate;
+		double v = BENCH_AMPLITUDE * sin(2 * M_PI * 440 * t) + BENCH_AMPLITUDE / 2 * sin(2 * M_PI * 3000 * t);
+		v += (rand() % 2001) - 1000;
+		input[i] = v;
+	}
+
+	time_ref = run(output_ref, output_size, input, step, BENCH_GAIN, 0, -1, count);
+	time_linear = run(output_linear, output_size, input, step, BENCH_GAIN, 0, 0, count);
+	time_sinc = run(output_sinc, output_size, input, step, BENCH_GAIN, sinc_coef, sinc_taps, count);
+
+	mismatch = 0;
+	for (i = 0; i < output_size; ++i)
+		if (output_ref[i] != output_linear[i])
+			++mismatch;
+
+	printf("%7u -> %5u Hz  taps %3d  previous %5.1f  vectorized %5.1f  sinc %5.1f ns/sample  mismatch %u\n",
+		input_rate, output_rate, sinc_taps,
+		time_ref * 1E9 / output_size, time_linear * 1E9 / output_size, time_sinc * 1E9 / output_size,
+		mismatch);
+
+	/* quality, with unity gain */
+	printf("%26s", "linear/sinc");
+
+	/* tone in the pass band */
+	tone(input, input_size, input_rate, 0.2 * low);
+	run(output_linear, output_size, input, step, 0x100, 0, 0, count);
+	run(output_sinc, output_size, input, step, 0x100, sinc_coef, sinc_taps, count);
+	print_db("pass band error",
+		error_db(output_linear, output_size, step, input_rate, 0.2 * low, delay_linear, skip),
+		error_db(output_sinc, output_size, step, input_rate, 0.2 * low, delay_sinc, skip));
+
+	/* tone over the Nyquist frequency of the output */
+	if (0.75 * output_rate < 0.45 * input_rate) {
+		tone(input, input_size, input_rate, 0.75 * output_rate);
+		run(output_linear, output_size, input, step, 0x100, 0, 0, count);
+		run(output_sinc, output_size, input, step, 0x100, sinc_coef, sinc_taps, count);
+		print_db("  alias", level_db(output_linear, output_size, skip), level_db(output_sinc, output_size, skip));
+	}
+
+	printf("\n");
+
+	free(input);
+	free(output_ref);
+	free(output_linear);
+	free(output_sinc);
+	free(sinc_coef);
+
+	return mismatch != 0;
+}
+
+int main(int argc, char* argv[])
+{
+	int err = 0;
+
+	err |= bench(44100, 44100); /* same rate */
+	err |= bench(22050, 44100); /* upsampling */
+	err |= bench(8000, 48000);
+	err |= bench(48000, 44100); /* downsampling */
+	err |= bench(96000, 44100);
+	err |= bench(223721, 44100); /* 3.579545 MHz / 16, like the AY8910 */
+	err |= bench(1000000, 48000);
+
+	if (err) {
+		printf("Results don't match!\n");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
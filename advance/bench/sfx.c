@@ -0,0 +1,267 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2017 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/** \file
+ * Benchmark of the sound post processing chain.
+ *
+ * It processes some seconds of a synthetic signal with the volume
+ * adjustment, the equalizer and the resampling enabled, like in the
+ * emulator with a 60 Hz game, and it reports the time in ns for every
+ * sample.
+ *
+ * The result is compared with the previous implementation that calls
+ * the filters band by band and uses a buffer for every stage.
+ */
+
+#include "portable.h"
+
+#include "soundfx.h"
+#include "filter.h"
+#include "slice.h"
+
+#include <sys/time.h>
+
+/** Seconds of sound to process. */
+#define BENCH_SECONDS 20
+
+/** Frames per second of the emulated game. */
+#define BENCH_FPS 60
+
+/** Samples added at every frame by the sync correction. */
+#define BENCH_DIFF 3
+
+/** Volume and equalizer settings. */
+#define BENCH_VOLUME_DB 6
+#define BENCH_LOW_DB 3
+#define BENCH_MID_DB -6
+#define BENCH_HIGH_DB 9
+
+static double bench_time(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, 0);
+
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/**
+ * Previous implementation of the chain.
+ */
+struct bench_ref {
+	unsigned channel;
+	int mult;
+	adv_filter band[SOUNDFX_BAND_MAX];
+	adv_filter_state state[SOUNDFX_BAND_MAX][2];
+	double factor[SOUNDFX_BAND_MAX];
+	unsigned overflow;
+};
+
+static void ref_adjust(struct bench_ref* ref, const short* input_sample, short* output_sample, unsigned sample_count)
+{
+	unsigned i;
+	unsigned count = ref->channel * sample_count;
+
+	for (i = 0; i < count; ++i) {
+		int v = input_sample[i];
+
+		v = v * ref->mult / SOUNDFX_MULT_BASE;
+
+		if (v > 32767) {
+			++ref->overflow;
+			v = 32767;
+		}
+		if (v < -32768) {
+			++ref->overflow;
+			v = -32768;
+		}
+
+		output_sample[i] = v;
+	}
+}
+
+static void ref_equalizer(struct bench_ref* ref, const short* input_sample, short* output_sample, unsigned sample_count)
+{
+	unsigned i, j, b;
+	unsigned channel = ref->channel;
+
+	for (j = 0; j < channel; ++j) {
+		unsigned off = j;
+		for (i = 0; i < sample_count; ++i) {
+			double v, vr;
+			int vi;
+
+			v = input_sample[off];
+
+			vr = 0;
+
+			for (b = 0; b < SOUNDFX_BAND_MAX; ++b) {
+				adv_filter_insert(&ref->band[b], &ref->state[b][j], v);
+				vr += ref->factor[b] * adv_filter_extract(&ref->band[b], &ref->state[b][j]);
+			}
+
+			vi = lrint(vr);
+
+			if (vi > 32767) {
+				++ref->overflow;
+				vi = 32767;
+			}
+			if (vi < -32768) {
+				++ref->overflow;
+				vi = -32768;
+			}
+
+			output_sample[off] = vi;
+			off += channel;
+		}
+	}
+}
+
+static void ref_scale(struct bench_ref* ref, const short* input_sample, short* output_sample, unsigned sample_count, unsigned sample_recount)
+{
+	unsigned* map = malloc(sample_recount * sizeof(unsigned));
+	unsigned i, c;
+
+	slice_vector(map, sample_count, sample_recount);
+
+	for (i = 0; i < sample_recount; ++i)
+		for (c = 0; c < ref->channel; ++c)
+			output_sample[i * ref->channel + c] = input_sample[map[i] * ref->channel + c];
+
+	free(map);
+}
+
+static void ref_process(struct bench_ref* ref, const short* input_sample, unsigned sample_count, short* output_sample, unsigned sample_recount)
+{
+	short* sample_adjust = malloc(sample_count * ref->channel * sizeof(short));
+	short* sample_equalizer = malloc(sample_count * ref->channel * sizeof(short));
+
+	ref_adjust(ref, input_sample, sample_adjust, sample_count);
+	ref_equalizer(ref, sample_adjust, sample_equalizer, sample_count);
+	ref_scale(ref, sample_equalizer, output_sample, sample_count, sample_recount);
+
+	free(sample_adjust);
+	free(sample_equalizer);
+}
+
+static void bench_filter(adv_filter* band, unsigned rate)
+{
+	double cut1 = 800. / rate;
+	double cut2 = 8000. / rate;
+
+	adv_filter_lp_chebyshev_set(&band[0], cut1, 5, -1);
+	adv_filter_bp_chebyshev_set(&band[1], cut1, cut2, 5, -1);
+	adv_filter_hp_chebyshev_set(&band[2], cut2, 5, -1);
+}
+
+static int bench(unsigned rate, unsigned channel)
+{
+	unsigned frame = BENCH_SECONDS * BENCH_FPS;
+	unsigned count = rate / BENCH_FPS;
+	unsigned recount = count + BENCH_DIFF;
+	unsigned input_size = frame * count * channel;
+	unsigned output_size = frame * recount * channel;
+	short* input = malloc(input_size * sizeof(short));
+	short* output_ref = malloc(output_size * sizeof(short));
+	short* output_fx = malloc(output_size * sizeof(short));
+	struct bench_ref ref;
+	adv_soundfx fx;
+	adv_filter band[SOUNDFX_BAND_MAX];
+	double factor[SOUNDFX_BAND_MAX];
+	double start, time_ref, time_fx;
+	unsigned i, b, mismatch;
+	int mult;
+
+	/* two tones and some noise */
+	srand(rate + channel);
+	for (i = 0; i < input_size; ++i) {
+		double t = (double)(i / channel) / rate;
+		double v = 8000 * sin(2 * M_PI * 440 * t) + 4000 * sin(2 * M_PI * (3000 + 1000 * (i % channel)) * t);
+		v += (rand() % 2001) - 1000;
+		input[i] = v;
+	}
+
+	mult = SOUNDFX_MULT_BASE * pow(10, BENCH_VOLUME_DB / 20.0);
+	factor[0] = pow(10, BENCH_LOW_DB / 20.0);
+	factor[1] = pow(10, BENCH_MID_DB / 20.0);
+	factor[2] = pow(10, BENCH_HIGH_DB / 20.0);
+
+	/* previous implementation */
+	ref.channel = channel;
+	ref.mult = mult;
+	ref.overflow = 0;
+	bench_filter(ref.band, rate);
+	for (b = 0; b < SOUNDFX_BAND_MAX; ++b) {
+		ref.factor[b] = factor[b];
+		adv_filter_state_reset(&ref.band[b], &ref.state[b][0]);
+		adv_filter_state_reset(&ref.band[b], &ref.state[b][1]);
+	}
+
+	start = bench_time();
+	for (i = 0; i < frame; ++i)
+		ref_process(&ref, input + i * count * channel, count, output_ref + i * recount * channel, recount);
+	time_ref = bench_time() - start;
+
+	/* single pass implementation */
+	soundfx_init(&fx, channel, soundfx_mix_none);
+	soundfx_volume_set(&fx, mult);
+	bench_filter(band, rate);
+	soundfx_equalizer_set(&fx, band, factor, 1);
+
+	start = bench_time();
+	for (i = 0; i < frame; ++i)
+		soundfx_process(&fx, input + i * count * channel, count, output_fx + i * recount * channel, recount, 0);
+	time_fx = bench_time() - start;
+
+	mismatch = 0;
+	for (i = 0; i < output_size; ++i)
+		if (output_ref[i] != output_fx[i])
+			++mismatch;
+
+	printf("%5u Hz %-6s  previous %6.1f ns/sample  single pass %6.1f ns/sample  speedup %4.1fx  overflow %u/%u  mismatch %u\n",
+		rate, channel == 1 ? "mono" : "stereo",
+		time_ref * 1E9 / (frame * count), time_fx * 1E9 / (frame * count),
+		time_ref / time_fx, ref.overflow, fx.overflow, mismatch);
+
+	soundfx_done(&fx);
+	free(input);
+	free(output_ref);
+	free(output_fx);
+
+	return mismatch != 0 || ref.overflow != fx.overflow;
+}
+
+int main(int argc, char* argv[])
+{
+	int err = 0;
+
+	err |= bench(44100, 1);
+	err |= bench(44100, 2);
+	err |= bench(48000, 1);
+	err |= bench(48000, 2);
+
+	if (err) {
+		printf("Results don't match!\n");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
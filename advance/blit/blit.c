@@ -113,6 +113,32 @@ static inline void internal_end(void)
 
 #endif
 
+/***************************************************************************/
+/* avx2 */
+
+#if defined(USE_BLIT_AVX2)
+
+adv_bool the_blit_avx2 = 0;
+
+#define BLITTER_AVX2(name) (the_blit_avx2 ? name ## _avx2 : BLITTER(name))
+#define BLITTER_AVX2_DEF(name) (the_blit_avx2 ? name ## _avx2 : name ## _def)
+
+static adv_bool blit_has_avx2(void)
+{
+	__builtin_cpu_init();
+
+	return __builtin_cpu_supports("avx2") != 0;
+}
+
+#else
+
+#define the_blit_avx2 0
+
+#define BLITTER_AVX2(name) BLITTER(name)
+#define BLITTER_AVX2_DEF(name) (name ## _def)
+
+#endif
+
 /***************************************************************************/
 /* internal */
 
@@ -226,34 +252,40 @@ static inline void internal_end(void)
 /* Align */
 #define FAST_BUFFER_ALIGN 16 /* SSE2 requirement */
 
-void* fast_buffer; /* raw pointer */
-void* fast_buffer_aligned; /* aligned pointer */
-unsigned fast_buffer_map[FAST_BUFFER_MAX]; /* stack of incremental size used */
-unsigned fast_buffer_mac; /* top of the stack */
+/* Arena of buffers */
+struct video_buffer_struct {
+	void* ptr; /* raw pointer */
+	void* aligned; /* aligned pointer */
+	unsigned map[FAST_BUFFER_MAX]; /* stack of incremental size used */
+	unsigned mac; /* top of the stack */
+};
 
-static void* video_buffer_alloc(unsigned size)
+/* Main arena, used by all the pipelines */
+static struct video_buffer_struct fast_buffer;
+
+static void* video_buffer_alloc(struct video_buffer_struct* arena, unsigned size)
 {
 	unsigned size_aligned = ALIGN_UNSIGNED(size, FAST_BUFFER_ALIGN);
 
-	assert(fast_buffer_mac < FAST_BUFFER_MAX);
+	assert(arena->mac < FAST_BUFFER_MAX);
 
-	if (fast_buffer_map[fast_buffer_mac] + size_aligned > FAST_BUFFER_SIZE - FAST_BUFFER_ALIGN) {
+	if (arena->map[arena->mac] + size_aligned > FAST_BUFFER_SIZE - FAST_BUFFER_ALIGN) {
 		log_std(("ERROR:blit: out of memory\n"));
 		return 0;
 	}
 
-	++fast_buffer_mac;
-	fast_buffer_map[fast_buffer_mac] = fast_buffer_map[fast_buffer_mac - 1] + size_aligned;
+	++arena->mac;
+	arena->map[arena->mac] = arena->map[arena->mac - 1] + size_aligned;
 
-	return (uint8*)fast_buffer_aligned + fast_buffer_map[fast_buffer_mac - 1];
+	return (uint8*)arena->aligned + arena->map[arena->mac - 1];
 }
 
 /* Buffers must be allocated and freed in exact reverse order */
-static void video_buffer_free(void* buffer)
+static void video_buffer_free(struct video_buffer_struct* arena, void* buffer)
 {
 	(void)buffer;
-	assert(fast_buffer_mac != 0);
-	--fast_buffer_mac;
+	assert(arena->mac != 0);
+	--arena->mac;
 }
 
 /* Debug version of the alloc functions */
@@ -261,22 +293,22 @@ static void video_buffer_free(void* buffer)
 
 #define WRAP_SIZE 32
 
-static void* video_buffer_alloc_wrap(unsigned size)
+static void* video_buffer_alloc_wrap(struct video_buffer_struct* arena, unsigned size)
 {
-	uint8* buffer8 = (uint8*)video_buffer_alloc(size + WRAP_SIZE);
+	uint8* buffer8 = (uint8*)video_buffer_alloc(arena, size + WRAP_SIZE);
 	unsigned i;
 	for (i = 0; i < WRAP_SIZE; ++i)
 		buffer8[i] = i;
 	return buffer8 + WRAP_SIZE;
 }
 
-static void video_buffer_free_wrap(void* buffer)
+static void video_buffer_free_wrap(struct video_buffer_struct* arena, void* buffer)
 {
 	uint8* buffer8 = (uint8*)buffer - WRAP_SIZE;
 	unsigned i;
 	for (i = 0; i < WRAP_SIZE; ++i)
 		assert(buffer8[i] == i);
-	video_buffer_free(buffer8);
+	video_buffer_free(arena, buffer8);
 }
 
 #define video_buffer_free video_buffer_free_wrap
@@ -284,23 +316,30 @@ static void video_buffer_free_wrap(void* buffer)
 
 #endif
 
-static void video_buffer_init(void)
+static adv_error video_buffer_init(struct video_buffer_struct* arena)
 {
-	fast_buffer = malloc(FAST_BUFFER_SIZE + FAST_BUFFER_ALIGN);
-	fast_buffer_aligned = ALIGN_PTR(fast_buffer, FAST_BUFFER_ALIGN);
-	fast_buffer_mac = 0;
-	fast_buffer_map[0] = 0;
+	arena->ptr = malloc(FAST_BUFFER_SIZE + FAST_BUFFER_ALIGN);
+	if (!arena->ptr)
+		return -1;
+	arena->aligned = ALIGN_PTR(arena->ptr, FAST_BUFFER_ALIGN);
+	arena->mac = 0;
+	arena->map[0] = 0;
+
+	return 0;
 }
 
-static void video_buffer_done(void)
+static void video_buffer_done(struct video_buffer_struct* arena)
 {
-	assert(fast_buffer_mac == 0);
-	free(fast_buffer);
+	assert(arena->mac == 0);
+	free(arena->ptr);
 }
 
 /***************************************************************************/
 /* init/done */
 
+/** SIMD levels supported. */
+static adv_bool blit_simd_map[VIDEO_SIMD_MAX];
+
 adv_error video_blit_init(void)
 {
 	if (blit_cpu() != 0) {
@@ -308,14 +347,71 @@ adv_error video_blit_init(void)
 		return -1;
 	}
 
-	video_buffer_init();
+	if (video_buffer_init(&fast_buffer) != 0) {
+		error_set("Low memory.\n");
+		return -1;
+	}
+
+	blit_simd_map[VIDEO_SIMD_C] = 1;
+	blit_simd_map[VIDEO_SIMD_SSE2] = the_blit_asm;
+	blit_simd_map[VIDEO_SIMD_AVX2] = 0;
+
+#if defined(USE_BLIT_AVX2)
+	blit_simd_map[VIDEO_SIMD_AVX2] = blit_has_avx2();
+	log_std(("blit: AVX2 %s\n", blit_simd_map[VIDEO_SIMD_AVX2] ? "enabled" : "disabled"));
+#endif
+
+	video_blit_simd_set(VIDEO_SIMD_MAX - 1);
+
+	log_std(("blit: SIMD level %s\n", video_blit_simd_name(video_blit_simd_get())));
 
 	return 0;
 }
 
 void video_blit_done(void)
 {
-	video_buffer_done();
+	video_buffer_done(&fast_buffer);
+}
+
+adv_bool video_blit_simd_supported(unsigned level)
+{
+	if (level >= VIDEO_SIMD_MAX)
+		return 0;
+
+	return blit_simd_map[level];
+}
+
+void video_blit_simd_set(unsigned level)
+{
+	if (level >= VIDEO_SIMD_MAX)
+		level = VIDEO_SIMD_MAX - 1;
+
+#if defined(USE_ASM_INLINE)
+	the_blit_asm = level >= VIDEO_SIMD_SSE2 && blit_simd_map[VIDEO_SIMD_SSE2];
+#endif
+#if defined(USE_BLIT_AVX2)
+	the_blit_avx2 = level >= VIDEO_SIMD_AVX2 && blit_simd_map[VIDEO_SIMD_AVX2];
+#endif
+}
+
+unsigned video_blit_simd_get(void)
+{
+	if (the_blit_avx2)
+		return VIDEO_SIMD_AVX2;
+	if (the_blit_asm)
+		return VIDEO_SIMD_SSE2;
+	return VIDEO_SIMD_C;
+}
+
+const char* video_blit_simd_name(unsigned level)
+{
+	switch (level) {
+	case VIDEO_SIMD_C: return "c";
+	case VIDEO_SIMD_SSE2: return "sse2";
+	case VIDEO_SIMD_AVX2: return "avx2";
+	}
+
+	return "unknown";
 }
 
 /***************************************************************************/
@@ -424,8 +520,8 @@ static inline void scale2x(void* dst0, void* dst1, void* src0, void* src1, void*
 {
 	switch (bytes_per_pixel) {
 	case 1: BLITTER(scale2x_8)(dst0, dst1, src0, src1, src2, count); break;
-	case 2: BLITTER(scale2x_16)(dst0, dst1, src0, src1, src2, count); break;
-	case 4: BLITTER(scale2x_32)(dst0, dst1, src0, src1, src2, count); break;
+	case 2: BLITTER_AVX2(scale2x_16)(dst0, dst1, src0, src1, src2, count); break;
+	case 4: BLITTER_AVX2(scale2x_32)(dst0, dst1, src0, src1, src2, count); break;
 	}
 }
 
@@ -433,8 +529,8 @@ static inline void scale2x3(void* dst0, void* dst1, void* dst2, void* src0, void
 {
 	switch (bytes_per_pixel) {
 	case 1: BLITTER(scale2x3_8)(dst0, dst1, dst2, src0, src1, src2, count); break;
-	case 2: BLITTER(scale2x3_16)(dst0, dst1, dst2, src0, src1, src2, count); break;
-	case 4: BLITTER(scale2x3_32)(dst0, dst1, dst2, src0, src1, src2, count); break;
+	case 2: BLITTER_AVX2(scale2x3_16)(dst0, dst1, dst2, src0, src1, src2, count); break;
+	case 4: BLITTER_AVX2(scale2x3_32)(dst0, dst1, dst2, src0, src1, src2, count); break;
 	}
 }
 
@@ -442,8 +538,8 @@ static inline void scale2x4(void* dst0, void* dst1, void* dst2, void* dst3, void
 {
 	switch (bytes_per_pixel) {
 	case 1: BLITTER(scale2x4_8)(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
-	case 2: BLITTER(scale2x4_16)(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
-	case 4: BLITTER(scale2x4_32)(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
+	case 2: BLITTER_AVX2(scale2x4_16)(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
+	case 4: BLITTER_AVX2(scale2x4_32)(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
 	}
 }
 
@@ -460,8 +556,8 @@ static inline void scale2k(void* dst0, void* dst1, void* src0, void* src1, void*
 static inline void hq2x(void* dst0, void* dst1, void* src0, void* src1, void* src2, unsigned interp, unsigned count)
 {
 	switch (interp) {
-	case INTERP_16: hq2x_16_def(dst0, dst1, src0, src1, src2, count); break;
-	case INTERP_32: hq2x_32_def(dst0, dst1, src0, src1, src2, count); break;
+	case INTERP_16: BLITTER_AVX2_DEF(hq2x_16)(dst0, dst1, src0, src1, src2, count); break;
+	case INTERP_32: BLITTER_AVX2_DEF(hq2x_32)(dst0, dst1, src0, src1, src2, count); break;
 	case INTERP_YUY2: hq2x_yuy2_def(dst0, dst1, src0, src1, src2, count); break;
 	}
 }
@@ -469,8 +565,8 @@ static inline void hq2x(void* dst0, void* dst1, void* src0, void* src1, void* sr
 static inline void hq2x3(void* dst0, void* dst1, void* dst2, void* src0, void* src1, void* src2, unsigned interp, unsigned count)
 {
 	switch (interp) {
-	case INTERP_16: hq2x3_16_def(dst0, dst1, dst2, src0, src1, src2, count); break;
-	case INTERP_32: hq2x3_32_def(dst0, dst1, dst2, src0, src1, src2, count); break;
+	case INTERP_16: BLITTER_AVX2_DEF(hq2x3_16)(dst0, dst1, dst2, src0, src1, src2, count); break;
+	case INTERP_32: BLITTER_AVX2_DEF(hq2x3_32)(dst0, dst1, dst2, src0, src1, src2, count); break;
 	case INTERP_YUY2: hq2x3_yuy2_def(dst0, dst1, dst2, src0, src1, src2, count); break;
 	}
 }
@@ -478,8 +574,8 @@ static inline void hq2x3(void* dst0, void* dst1, void* dst2, void* src0, void* s
 static inline void hq2x4(void* dst0, void* dst1, void* dst2, void* dst3, void* src0, void* src1, void* src2, unsigned interp, unsigned count)
 {
 	switch (interp) {
-	case INTERP_16: hq2x4_16_def(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
-	case INTERP_32: hq2x4_32_def(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
+	case INTERP_16: BLITTER_AVX2_DEF(hq2x4_16)(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
+	case INTERP_32: BLITTER_AVX2_DEF(hq2x4_32)(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
 	case INTERP_YUY2: hq2x4_yuy2_def(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
 	}
 }
@@ -498,8 +594,8 @@ static inline void scale3x(void* dst0, void* dst1, void* dst2, void* src0, void*
 {
 	switch (bytes_per_pixel) {
 	case 1: scale3x_8_def(dst0, dst1, dst2, src0, src1, src2, count); break;
-	case 2: scale3x_16_def(dst0, dst1, dst2, src0, src1, src2, count); break;
-	case 4: scale3x_32_def(dst0, dst1, dst2, src0, src1, src2, count); break;
+	case 2: BLITTER_AVX2_DEF(scale3x_16)(dst0, dst1, dst2, src0, src1, src2, count); break;
+	case 4: BLITTER_AVX2_DEF(scale3x_32)(dst0, dst1, dst2, src0, src1, src2, count); break;
 	}
 }
 
@@ -516,8 +612,8 @@ static inline void scale3k(void* dst0, void* dst1, void* dst2, void* src0, void*
 static inline void hq3x(void* dst0, void* dst1, void* dst2, void* src0, void* src1, void* src2, unsigned interp, unsigned count)
 {
 	switch (interp) {
-	case INTERP_16: hq3x_16_def(dst0, dst1, dst2, src0, src1, src2, count); break;
-	case INTERP_32: hq3x_32_def(dst0, dst1, dst2, src0, src1, src2, count); break;
+	case INTERP_16: BLITTER_AVX2_DEF(hq3x_16)(dst0, dst1, dst2, src0, src1, src2, count); break;
+	case INTERP_32: BLITTER_AVX2_DEF(hq3x_32)(dst0, dst1, dst2, src0, src1, src2, count); break;
 	case INTERP_YUY2: hq3x_yuy2_def(dst0, dst1, dst2, src0, src1, src2, count); break;
 	}
 }
@@ -545,8 +641,8 @@ static inline void scale4k(void* dst0, void* dst1, void* dst2, void* dst3, void*
 static inline void hq4x(void* dst0, void* dst1, void* dst2, void* dst3, void* src0, void* src1, void* src2, unsigned interp, unsigned count)
 {
 	switch (interp) {
-	case INTERP_16: hq4x_16_def(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
-	case INTERP_32: hq4x_32_def(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
+	case INTERP_16: BLITTER_AVX2_DEF(hq4x_16)(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
+	case INTERP_32: BLITTER_AVX2_DEF(hq4x_32)(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
 	case INTERP_YUY2: hq4x_yuy2_def(dst0, dst1, dst2, dst3, src0, src1, src2, count); break;
 	}
 }
@@ -672,13 +768,36 @@ void video_pipeline_init(struct video_pipeline_struct* pipeline)
 	unsigned i;
 
 	pipeline->stage_mac = 0;
+	pipeline->band_map = 0;
+	pipeline->band_mac = 0;
 	pipeline->target.line = &video_line;
+	pipeline->target.arena = &fast_buffer;
 	pipeline->target.ptr = 0;
 	pipeline->target.color_def = video_color_def();
 	pipeline->target.bytes_per_pixel = color_def_bytes_per_pixel_get(video_color_def());
 	pipeline->target.bytes_per_scanline = video_bytes_per_scanline();
 }
 
+adv_error video_pipeline_init_private(struct video_pipeline_struct* pipeline)
+{
+	struct video_buffer_struct* arena;
+
+	video_pipeline_init(pipeline);
+
+	arena = malloc(sizeof(struct video_buffer_struct));
+	if (!arena)
+		return -1;
+
+	if (video_buffer_init(arena) != 0) {
+		free(arena);
+		return -1;
+	}
+
+	pipeline->target.arena = arena;
+
+	return 0;
+}
+
 void video_pipeline_target(struct video_pipeline_struct* pipeline, void* ptr, unsigned bytes_per_scanline, adv_color_def def)
 {
 	pipeline->target.line = &memory_line;
@@ -692,19 +811,33 @@ void video_pipeline_done(struct video_pipeline_struct* pipeline)
 {
 	int i;
 
+	if (pipeline->band_mac) {
+		for (i = 0; i < pipeline->band_mac; ++i)
+			video_buffer_done(&pipeline->band_map[i]);
+		free(pipeline->band_map);
+		pipeline->band_map = 0;
+		pipeline->band_mac = 0;
+	}
+
 	if (pipeline->stage_mac) {
 		/* deallocate with the same allocation order */
 		for (i = pipeline->stage_mac - 1; i >= 0; --i) {
 			struct video_stage_horz_struct* stage = &pipeline->stage_map[i];
 			if (stage->buffer_extra)
-				video_buffer_free(stage->buffer_extra);
+				video_buffer_free(pipeline->target.arena, stage->buffer_extra);
 		}
 		for (i = pipeline->stage_mac - 1; i >= 0; --i) {
 			struct video_stage_horz_struct* stage = &pipeline->stage_map[i];
 			if (stage->buffer)
-				video_buffer_free(stage->buffer);
+				video_buffer_free(pipeline->target.arena, stage->buffer);
 		}
 	}
+
+	if (pipeline->target.arena != &fast_buffer) {
+		video_buffer_done(pipeline->target.arena);
+		free(pipeline->target.arena);
+		pipeline->target.arena = &fast_buffer;
+	}
 }
 
 static inline struct video_stage_horz_struct* video_pipeline_begin_mutable(struct video_pipeline_struct* pipeline)
@@ -759,7 +892,7 @@ static void video_pipeline_realize(struct video_pipeline_struct* pipeline, unsig
 	stage = stage_begin;
 	while (stage != stage_end) {
 		if (stage->buffer_size) {
-			stage->buffer = video_buffer_alloc(stage->buffer_size);
+			stage->buffer = video_buffer_alloc(pipeline->target.arena, stage->buffer_size);
 		} else {
 			stage->buffer = 0;
 		}
@@ -771,7 +904,7 @@ static void video_pipeline_realize(struct video_pipeline_struct* pipeline, unsig
 	stage = stage_begin;
 	while (stage != stage_end) {
 		if (stage->buffer_extra_size) {
-			stage->buffer_extra = video_buffer_alloc(stage->buffer_extra_size);
+			stage->buffer_extra = video_buffer_alloc(pipeline->target.arena, stage->buffer_extra_size);
 		} else {
 			stage->buffer_extra = 0;
 		}
@@ -1049,7 +1182,7 @@ static void video_stage_stretchy_x1(const struct video_pipeline_target_struct* t
 	int down = stage_vert->slice.down;
 	int error = stage_vert->slice.error;
 	unsigned count = stage_vert->slice.count;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 
 	while (count) {
 		void* dst;
@@ -1076,14 +1209,14 @@ static void video_stage_stretchy_max_x1(const struct video_pipeline_target_struc
 	const struct video_stage_horz_struct* stage_end = stage_vert->stage_end;
 	const struct video_stage_horz_struct* stage_pivot = stage_vert->stage_pivot;
 
-	void* buffer = video_buffer_alloc(stage_vert->stage_begin->sdx * stage_vert->stage_begin->sbpp);
+	void* buffer = video_buffer_alloc(target->arena, stage_vert->stage_begin->sdx * stage_vert->stage_begin->sbpp);
 
 	unsigned whole = stage_vert->slice.whole;
 	int up = stage_vert->slice.up;
 	int down = stage_vert->slice.down;
 	int error = stage_vert->slice.error;
 	unsigned count = stage_vert->slice.count;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 
 	while (count) {
 		void* dst;
@@ -1122,7 +1255,7 @@ static void video_stage_stretchy_max_x1(const struct video_pipeline_target_struc
 		--count;
 	}
 
-	video_buffer_free(buffer);
+	video_buffer_free(target->arena, buffer);
 }
 
 /* Compute the mean of every lines reduced to a single line */
@@ -1134,14 +1267,14 @@ static void video_stage_stretchy_mean_x1(const struct video_pipeline_target_stru
 	const struct video_stage_horz_struct* stage_end = stage_vert->stage_end;
 	const struct video_stage_horz_struct* stage_pivot = stage_vert->stage_pivot;
 
-	void* buffer = video_buffer_alloc(stage_pivot->sdx * stage_pivot->sbpp);
+	void* buffer = video_buffer_alloc(target->arena, stage_pivot->sdx * stage_pivot->sbpp);
 
 	unsigned whole = stage_vert->slice.whole;
 	int up = stage_vert->slice.up;
 	int down = stage_vert->slice.down;
 	int error = stage_vert->slice.error;
 	unsigned count = stage_vert->slice.count;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 
 	while (count) {
 		void* dst;
@@ -1177,7 +1310,7 @@ static void video_stage_stretchy_mean_x1(const struct video_pipeline_target_stru
 		--count;
 	}
 
-	video_buffer_free(buffer);
+	video_buffer_free(target->arena, buffer);
 }
 
 /* Compute the mean of the previous line and the first of every iteration */
@@ -1190,14 +1323,14 @@ static void video_stage_stretchy_filter_x1(const struct video_pipeline_target_st
 	const struct video_stage_horz_struct* stage_pivot = stage_vert->stage_pivot;
 
 	adv_bool buffer_full = 0;
-	void* buffer = video_buffer_alloc(stage_pivot->sdx * stage_pivot->sbpp);
+	void* buffer = video_buffer_alloc(target->arena, stage_pivot->sdx * stage_pivot->sbpp);
 
 	unsigned whole = stage_vert->slice.whole;
 	int up = stage_vert->slice.up;
 	int down = stage_vert->slice.down;
 	int error = stage_vert->slice.error;
 	unsigned count = stage_vert->slice.count;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 
 	while (count) {
 		void* dst;
@@ -1233,7 +1366,7 @@ static void video_stage_stretchy_filter_x1(const struct video_pipeline_target_st
 		--count;
 	}
 
-	video_buffer_free(buffer);
+	video_buffer_free(target->arena, buffer);
 }
 
 /***************************************************************************/
@@ -1263,7 +1396,7 @@ static void video_stage_stretchy_1x(const struct video_pipeline_target_struct* t
 	int down = stage_vert->slice.down;
 	int error = stage_vert->slice.error;
 	unsigned count = stage_vert->slice.count;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	while (count) {
@@ -1305,7 +1438,7 @@ static void video_stage_stretchy_mean_1x(const struct video_pipeline_target_stru
 	const struct video_stage_horz_struct* stage_end = stage_vert->stage_end;
 	const struct video_stage_horz_struct* stage_pivot = stage_vert->stage_pivot;
 
-	void* buffer = video_buffer_alloc(stage_pivot->sdx * stage_pivot->sbpp);
+	void* buffer = video_buffer_alloc(target->arena, stage_pivot->sdx * stage_pivot->sbpp);
 	void* previous_buffer = 0;
 
 	unsigned whole = stage_vert->slice.whole;
@@ -1313,7 +1446,7 @@ static void video_stage_stretchy_mean_1x(const struct video_pipeline_target_stru
 	int down = stage_vert->slice.down;
 	int error = stage_vert->slice.error;
 	unsigned count = stage_vert->slice.count;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 
 	while (count) {
 		void* src_buffer;
@@ -1362,7 +1495,7 @@ static void video_stage_stretchy_mean_1x(const struct video_pipeline_target_stru
 		--count;
 	}
 
-	video_buffer_free(buffer);
+	video_buffer_free(target->arena, buffer);
 }
 
 static void video_stage_stretchy_min_1x(const struct video_pipeline_target_struct* target, const struct video_stage_vert_struct* stage_vert, unsigned x, unsigned y, const void* src)
@@ -1373,7 +1506,7 @@ static void video_stage_stretchy_min_1x(const struct video_pipeline_target_struc
 	const struct video_stage_horz_struct* stage_end = stage_vert->stage_end;
 	const struct video_stage_horz_struct* stage_pivot = stage_vert->stage_pivot;
 
-	void* buffer = video_buffer_alloc(stage_pivot->sdx * stage_pivot->sbpp);
+	void* buffer = video_buffer_alloc(target->arena, stage_pivot->sdx * stage_pivot->sbpp);
 	adv_bool buffer_set = 0;
 
 	unsigned whole = stage_vert->slice.whole;
@@ -1381,7 +1514,7 @@ static void video_stage_stretchy_min_1x(const struct video_pipeline_target_struc
 	int down = stage_vert->slice.down;
 	int error = stage_vert->slice.error;
 	unsigned count = stage_vert->slice.count;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 
 	while (count) {
 		void* src_buffer;
@@ -1428,7 +1561,7 @@ static void video_stage_stretchy_min_1x(const struct video_pipeline_target_struc
 		--count;
 	}
 
-	video_buffer_free(buffer);
+	video_buffer_free(target->arena, buffer);
 }
 
 
@@ -1441,7 +1574,7 @@ static void video_stage_stretchy_filter_1x(const struct video_pipeline_target_st
 	const struct video_stage_horz_struct* stage_end = stage_vert->stage_end;
 	const struct video_stage_horz_struct* stage_pivot = stage_vert->stage_pivot;
 
-	void* buffer = video_buffer_alloc(stage_pivot->sdx * stage_pivot->sbpp);
+	void* buffer = video_buffer_alloc(target->arena, stage_pivot->sdx * stage_pivot->sbpp);
 	void* previous_buffer = 0;
 
 	unsigned whole = stage_vert->slice.whole;
@@ -1449,7 +1582,7 @@ static void video_stage_stretchy_filter_1x(const struct video_pipeline_target_st
 	int down = stage_vert->slice.down;
 	int error = stage_vert->slice.error;
 	unsigned count = stage_vert->slice.count;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 
 	while (count) {
 		void* src_buffer;
@@ -1494,7 +1627,7 @@ static void video_stage_stretchy_filter_1x(const struct video_pipeline_target_st
 		--count;
 	}
 
-	video_buffer_free(buffer);
+	video_buffer_free(target->arena, buffer);
 }
 
 /***************************************************************************/
@@ -1505,7 +1638,7 @@ static void video_stage_stretchy_scale2x(const struct video_pipeline_target_stru
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -1521,7 +1654,7 @@ static void video_stage_stretchy_scale2x(const struct video_pipeline_target_stru
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 2; ++i) {
-			final[i] = video_buffer_alloc(2 * stage_pivot->sdx * stage_pivot->sbpp);
+			final[i] = video_buffer_alloc(target->arena, 2 * stage_pivot->sdx * stage_pivot->sbpp);
 		}
 	} else {
 		for (i = 0; i < 2; ++i) {
@@ -1536,7 +1669,7 @@ static void video_stage_stretchy_scale2x(const struct video_pipeline_target_stru
 	PADD(input[2], stage_vert->sdw * 2);
 
 	for (i = 0; i < 3; ++i) {
-		partial_copy[i] = partial[i] = video_buffer_alloc(stage_vert->sdx * stage_vert->bpp);
+		partial_copy[i] = partial[i] = video_buffer_alloc(target->arena, stage_vert->sdx * stage_vert->bpp);
 	}
 
 	partial[0] = video_pipeline_run_partial(partial[0], stage_begin, stage_pivot, 0, input[0], -1);
@@ -1642,12 +1775,12 @@ static void video_stage_stretchy_scale2x(const struct video_pipeline_target_stru
 	}
 
 	for (i = 0; i < 3; ++i) {
-		video_buffer_free(partial_copy[2 - i]);
+		video_buffer_free(target->arena, partial_copy[2 - i]);
 	}
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 2; ++i) {
-			video_buffer_free(final[1 - i]);
+			video_buffer_free(target->arena, final[1 - i]);
 		}
 	}
 }
@@ -1656,7 +1789,7 @@ static void video_stage_stretchy_scale2x3(const struct video_pipeline_target_str
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -1672,7 +1805,7 @@ static void video_stage_stretchy_scale2x3(const struct video_pipeline_target_str
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 3; ++i) {
-			final[i] = video_buffer_alloc(2 * stage_pivot->sdx * stage_pivot->sbpp);
+			final[i] = video_buffer_alloc(target->arena, 2 * stage_pivot->sdx * stage_pivot->sbpp);
 		}
 	} else {
 		for (i = 0; i < 3; ++i) {
@@ -1687,7 +1820,7 @@ static void video_stage_stretchy_scale2x3(const struct video_pipeline_target_str
 	PADD(input[2], stage_vert->sdw * 2);
 
 	for (i = 0; i < 3; ++i) {
-		partial_copy[i] = partial[i] = video_buffer_alloc(stage_vert->sdx * stage_vert->bpp);
+		partial_copy[i] = partial[i] = video_buffer_alloc(target->arena, stage_vert->sdx * stage_vert->bpp);
 	}
 
 	partial[0] = video_pipeline_run_partial(partial[0], stage_begin, stage_pivot, 0, input[0], -1);
@@ -1792,12 +1925,12 @@ static void video_stage_stretchy_scale2x3(const struct video_pipeline_target_str
 	}
 
 	for (i = 0; i < 3; ++i) {
-		video_buffer_free(partial_copy[2 - i]);
+		video_buffer_free(target->arena, partial_copy[2 - i]);
 	}
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 3; ++i) {
-			video_buffer_free(final[2 - i]);
+			video_buffer_free(target->arena, final[2 - i]);
 		}
 	}
 }
@@ -1806,7 +1939,7 @@ static void video_stage_stretchy_scale2x4(const struct video_pipeline_target_str
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -1822,7 +1955,7 @@ static void video_stage_stretchy_scale2x4(const struct video_pipeline_target_str
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 4; ++i) {
-			final[i] = video_buffer_alloc(2 * stage_pivot->sdx * stage_pivot->sbpp);
+			final[i] = video_buffer_alloc(target->arena, 2 * stage_pivot->sdx * stage_pivot->sbpp);
 		}
 	} else {
 		for (i = 0; i < 4; ++i) {
@@ -1837,7 +1970,7 @@ static void video_stage_stretchy_scale2x4(const struct video_pipeline_target_str
 	PADD(input[2], stage_vert->sdw * 2);
 
 	for (i = 0; i < 3; ++i) {
-		partial_copy[i] = partial[i] = video_buffer_alloc(stage_vert->sdx * stage_vert->bpp);
+		partial_copy[i] = partial[i] = video_buffer_alloc(target->arena, stage_vert->sdx * stage_vert->bpp);
 	}
 
 	partial[0] = video_pipeline_run_partial(partial[0], stage_begin, stage_pivot, 0, input[0], -1);
@@ -1942,12 +2075,12 @@ static void video_stage_stretchy_scale2x4(const struct video_pipeline_target_str
 	}
 
 	for (i = 0; i < 3; ++i) {
-		video_buffer_free(partial_copy[2 - i]);
+		video_buffer_free(target->arena, partial_copy[2 - i]);
 	}
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 4; ++i) {
-			video_buffer_free(final[3 - i]);
+			video_buffer_free(target->arena, final[3 - i]);
 		}
 	}
 }
@@ -1961,7 +2094,7 @@ static void video_stage_stretchy_scale2k(const struct video_pipeline_target_stru
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -1977,7 +2110,7 @@ static void video_stage_stretchy_scale2k(const struct video_pipeline_target_stru
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 2; ++i) {
-			final[i] = video_buffer_alloc(2 * stage_pivot->sdx * stage_pivot->sbpp);
+			final[i] = video_buffer_alloc(target->arena, 2 * stage_pivot->sdx * stage_pivot->sbpp);
 		}
 	} else {
 		for (i = 0; i < 2; ++i) {
@@ -1992,7 +2125,7 @@ static void video_stage_stretchy_scale2k(const struct video_pipeline_target_stru
 	PADD(input[2], stage_vert->sdw * 2);
 
 	for (i = 0; i < 3; ++i) {
-		partial_copy[i] = partial[i] = video_buffer_alloc(stage_vert->sdx * stage_vert->bpp);
+		partial_copy[i] = partial[i] = video_buffer_alloc(target->arena, stage_vert->sdx * stage_vert->bpp);
 	}
 
 	partial[0] = video_pipeline_run_partial(partial[0], stage_begin, stage_pivot, 0, input[0], -1);
@@ -2097,12 +2230,12 @@ static void video_stage_stretchy_scale2k(const struct video_pipeline_target_stru
 	}
 
 	for (i = 0; i < 3; ++i) {
-		video_buffer_free(partial_copy[2 - i]);
+		video_buffer_free(target->arena, partial_copy[2 - i]);
 	}
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 2; ++i) {
-			video_buffer_free(final[1 - i]);
+			video_buffer_free(target->arena, final[1 - i]);
 		}
 	}
 }
@@ -2117,7 +2250,7 @@ static void video_stage_stretchy_hq2x(const struct video_pipeline_target_struct*
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -2133,7 +2266,7 @@ static void video_stage_stretchy_hq2x(const struct video_pipeline_target_struct*
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 2; ++i) {
-			final[i] = video_buffer_alloc(2 * stage_pivot->sdx * stage_pivot->sbpp);
+			final[i] = video_buffer_alloc(target->arena, 2 * stage_pivot->sdx * stage_pivot->sbpp);
 		}
 	} else {
 		for (i = 0; i < 2; ++i) {
@@ -2148,7 +2281,7 @@ static void video_stage_stretchy_hq2x(const struct video_pipeline_target_struct*
 	PADD(input[2], stage_vert->sdw * 2);
 
 	for (i = 0; i < 3; ++i) {
-		partial_copy[i] = partial[i] = video_buffer_alloc(stage_vert->sdx * stage_vert->bpp);
+		partial_copy[i] = partial[i] = video_buffer_alloc(target->arena, stage_vert->sdx * stage_vert->bpp);
 	}
 
 	partial[0] = video_pipeline_run_partial(partial[0], stage_begin, stage_pivot, 0, input[0], -1);
@@ -2253,12 +2386,12 @@ static void video_stage_stretchy_hq2x(const struct video_pipeline_target_struct*
 	}
 
 	for (i = 0; i < 3; ++i) {
-		video_buffer_free(partial_copy[2 - i]);
+		video_buffer_free(target->arena, partial_copy[2 - i]);
 	}
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 2; ++i) {
-			video_buffer_free(final[1 - i]);
+			video_buffer_free(target->arena, final[1 - i]);
 		}
 	}
 }
@@ -2267,7 +2400,7 @@ static void video_stage_stretchy_hq2x3(const struct video_pipeline_target_struct
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -2283,7 +2416,7 @@ static void video_stage_stretchy_hq2x3(const struct video_pipeline_target_struct
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 3; ++i) {
-			final[i] = video_buffer_alloc(2 * stage_pivot->sdx * stage_pivot->sbpp);
+			final[i] = video_buffer_alloc(target->arena, 2 * stage_pivot->sdx * stage_pivot->sbpp);
 		}
 	} else {
 		for (i = 0; i < 3; ++i) {
@@ -2298,7 +2431,7 @@ static void video_stage_stretchy_hq2x3(const struct video_pipeline_target_struct
 	PADD(input[2], stage_vert->sdw * 2);
 
 	for (i = 0; i < 3; ++i) {
-		partial_copy[i] = partial[i] = video_buffer_alloc(stage_vert->sdx * stage_vert->bpp);
+		partial_copy[i] = partial[i] = video_buffer_alloc(target->arena, stage_vert->sdx * stage_vert->bpp);
 	}
 
 	partial[0] = video_pipeline_run_partial(partial[0], stage_begin, stage_pivot, 0, input[0], -1);
@@ -2403,12 +2536,12 @@ static void video_stage_stretchy_hq2x3(const struct video_pipeline_target_struct
 	}
 
 	for (i = 0; i < 3; ++i) {
-		video_buffer_free(partial_copy[2 - i]);
+		video_buffer_free(target->arena, partial_copy[2 - i]);
 	}
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 3; ++i) {
-			video_buffer_free(final[2 - i]);
+			video_buffer_free(target->arena, final[2 - i]);
 		}
 	}
 }
@@ -2417,7 +2550,7 @@ static void video_stage_stretchy_hq2x4(const struct video_pipeline_target_struct
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -2433,7 +2566,7 @@ static void video_stage_stretchy_hq2x4(const struct video_pipeline_target_struct
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 4; ++i) {
-			final[i] = video_buffer_alloc(2 * stage_pivot->sdx * stage_pivot->sbpp);
+			final[i] = video_buffer_alloc(target->arena, 2 * stage_pivot->sdx * stage_pivot->sbpp);
 		}
 	} else {
 		for (i = 0; i < 4; ++i) {
@@ -2448,7 +2581,7 @@ static void video_stage_stretchy_hq2x4(const struct video_pipeline_target_struct
 	PADD(input[2], stage_vert->sdw * 2);
 
 	for (i = 0; i < 3; ++i) {
-		partial_copy[i] = partial[i] = video_buffer_alloc(stage_vert->sdx * stage_vert->bpp);
+		partial_copy[i] = partial[i] = video_buffer_alloc(target->arena, stage_vert->sdx * stage_vert->bpp);
 	}
 
 	partial[0] = video_pipeline_run_partial(partial[0], stage_begin, stage_pivot, 0, input[0], -1);
@@ -2553,12 +2686,12 @@ static void video_stage_stretchy_hq2x4(const struct video_pipeline_target_struct
 	}
 
 	for (i = 0; i < 3; ++i) {
-		video_buffer_free(partial_copy[2 - i]);
+		video_buffer_free(target->arena, partial_copy[2 - i]);
 	}
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 4; ++i) {
-			video_buffer_free(final[3 - i]);
+			video_buffer_free(target->arena, final[3 - i]);
 		}
 	}
 }
@@ -2574,7 +2707,7 @@ static void video_stage_stretchy_xbr2x(const struct video_pipeline_target_struct
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -2590,7 +2723,7 @@ static void video_stage_stretchy_xbr2x(const struct video_pipeline_target_struct
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 2; ++i) {
-			final[i] = video_buffer_alloc(2 * stage_pivot->sdx * stage_pivot->sbpp);
+			final[i] = video_buffer_alloc(target->arena, 2 * stage_pivot->sdx * stage_pivot->sbpp);
 		}
 	} else {
 		for (i = 0; i < 2; ++i) {
@@ -2609,7 +2742,7 @@ static void video_stage_stretchy_xbr2x(const struct video_pipeline_target_struct
 	PADD(input[4], stage_vert->sdw * 4);
 
 	for (i = 0; i < 5; ++i) {
-		partial_copy[i] = partial[i] = video_buffer_alloc(stage_vert->sdx * stage_vert->bpp);
+		partial_copy[i] = partial[i] = video_buffer_alloc(target->arena, stage_vert->sdx * stage_vert->bpp);
 	}
 
 	partial[0] = video_pipeline_run_partial(partial[0], stage_begin, stage_pivot, 0, input[0], -1);
@@ -2764,12 +2897,12 @@ static void video_stage_stretchy_xbr2x(const struct video_pipeline_target_struct
 	}
 
 	for (i = 0; i < 5; ++i) {
-		video_buffer_free(partial_copy[4 - i]);
+		video_buffer_free(target->arena, partial_copy[4 - i]);
 	}
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 2; ++i) {
-			video_buffer_free(final[1 - i]);
+			video_buffer_free(target->arena, final[1 - i]);
 		}
 	}
 }
@@ -2785,7 +2918,7 @@ static void video_stage_stretchy_scale3x(const struct video_pipeline_target_stru
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -2801,7 +2934,7 @@ static void video_stage_stretchy_scale3x(const struct video_pipeline_target_stru
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 3; ++i) {
-			final[i] = video_buffer_alloc(3 * stage_pivot->sdx * stage_pivot->sbpp);
+			final[i] = video_buffer_alloc(target->arena, 3 * stage_pivot->sdx * stage_pivot->sbpp);
 		}
 	} else {
 		for (i = 0; i < 3; ++i) {
@@ -2816,7 +2949,7 @@ static void video_stage_stretchy_scale3x(const struct video_pipeline_target_stru
 	PADD(input[2], stage_vert->sdw * 2);
 
 	for (i = 0; i < 3; ++i) {
-		partial_copy[i] = partial[i] = video_buffer_alloc(stage_vert->sdx * stage_vert->bpp);
+		partial_copy[i] = partial[i] = video_buffer_alloc(target->arena, stage_vert->sdx * stage_vert->bpp);
 	}
 
 	partial[0] = video_pipeline_run_partial(partial[0], stage_begin, stage_pivot, 0, input[0], -1);
@@ -2921,12 +3054,12 @@ static void video_stage_stretchy_scale3x(const struct video_pipeline_target_stru
 	}
 
 	for (i = 0; i < 3; ++i) {
-		video_buffer_free(partial_copy[2 - i]);
+		video_buffer_free(target->arena, partial_copy[2 - i]);
 	}
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 3; ++i) {
-			video_buffer_free(final[2 - i]);
+			video_buffer_free(target->arena, final[2 - i]);
 		}
 	}
 }
@@ -2940,7 +3073,7 @@ static void video_stage_stretchy_scale3k(const struct video_pipeline_target_stru
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -2956,7 +3089,7 @@ static void video_stage_stretchy_scale3k(const struct video_pipeline_target_stru
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 3; ++i) {
-			final[i] = video_buffer_alloc(3 * stage_pivot->sdx * stage_pivot->sbpp);
+			final[i] = video_buffer_alloc(target->arena, 3 * stage_pivot->sdx * stage_pivot->sbpp);
 		}
 	} else {
 		for (i = 0; i < 3; ++i) {
@@ -2971,7 +3104,7 @@ static void video_stage_stretchy_scale3k(const struct video_pipeline_target_stru
 	PADD(input[2], stage_vert->sdw * 2);
 
 	for (i = 0; i < 3; ++i) {
-		partial_copy[i] = partial[i] = video_buffer_alloc(stage_vert->sdx * stage_vert->bpp);
+		partial_copy[i] = partial[i] = video_buffer_alloc(target->arena, stage_vert->sdx * stage_vert->bpp);
 	}
 
 	partial[0] = video_pipeline_run_partial(partial[0], stage_begin, stage_pivot, 0, input[0], -1);
@@ -3076,12 +3209,12 @@ static void video_stage_stretchy_scale3k(const struct video_pipeline_target_stru
 	}
 
 	for (i = 0; i < 3; ++i) {
-		video_buffer_free(partial_copy[2 - i]);
+		video_buffer_free(target->arena, partial_copy[2 - i]);
 	}
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 3; ++i) {
-			video_buffer_free(final[2 - i]);
+			video_buffer_free(target->arena, final[2 - i]);
 		}
 	}
 }
@@ -3096,7 +3229,7 @@ static void video_stage_stretchy_hq3x(const struct video_pipeline_target_struct*
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -3112,7 +3245,7 @@ static void video_stage_stretchy_hq3x(const struct video_pipeline_target_struct*
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 3; ++i) {
-			final[i] = video_buffer_alloc(3 * stage_pivot->sdx * stage_pivot->sbpp);
+			final[i] = video_buffer_alloc(target->arena, 3 * stage_pivot->sdx * stage_pivot->sbpp);
 		}
 	} else {
 		for (i = 0; i < 3; ++i) {
@@ -3127,7 +3260,7 @@ static void video_stage_stretchy_hq3x(const struct video_pipeline_target_struct*
 	PADD(input[2], stage_vert->sdw * 2);
 
 	for (i = 0; i < 3; ++i) {
-		partial_copy[i] = partial[i] = video_buffer_alloc(stage_vert->sdx * stage_vert->bpp);
+		partial_copy[i] = partial[i] = video_buffer_alloc(target->arena, stage_vert->sdx * stage_vert->bpp);
 	}
 
 	partial[0] = video_pipeline_run_partial(partial[0], stage_begin, stage_pivot, 0, input[0], -1);
@@ -3232,12 +3365,12 @@ static void video_stage_stretchy_hq3x(const struct video_pipeline_target_struct*
 	}
 
 	for (i = 0; i < 3; ++i) {
-		video_buffer_free(partial_copy[2 - i]);
+		video_buffer_free(target->arena, partial_copy[2 - i]);
 	}
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 3; ++i) {
-			video_buffer_free(final[2 - i]);
+			video_buffer_free(target->arena, final[2 - i]);
 		}
 	}
 }
@@ -3253,7 +3386,7 @@ static void video_stage_stretchy_xbr3x(const struct video_pipeline_target_struct
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -3269,7 +3402,7 @@ static void video_stage_stretchy_xbr3x(const struct video_pipeline_target_struct
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 3; ++i) {
-			final[i] = video_buffer_alloc(3 * stage_pivot->sdx * stage_pivot->sbpp);
+			final[i] = video_buffer_alloc(target->arena, 3 * stage_pivot->sdx * stage_pivot->sbpp);
 		}
 	} else {
 		for (i = 0; i < 3; ++i) {
@@ -3288,7 +3421,7 @@ static void video_stage_stretchy_xbr3x(const struct video_pipeline_target_struct
 	PADD(input[4], stage_vert->sdw * 4);
 
 	for (i = 0; i < 5; ++i) {
-		partial_copy[i] = partial[i] = video_buffer_alloc(stage_vert->sdx * stage_vert->bpp);
+		partial_copy[i] = partial[i] = video_buffer_alloc(target->arena, stage_vert->sdx * stage_vert->bpp);
 	}
 
 	partial[0] = video_pipeline_run_partial(partial[0], stage_begin, stage_pivot, 0, input[0], -1);
@@ -3443,12 +3576,12 @@ static void video_stage_stretchy_xbr3x(const struct video_pipeline_target_struct
 	}
 
 	for (i = 0; i < 5; ++i) {
-		video_buffer_free(partial_copy[4 - i]);
+		video_buffer_free(target->arena, partial_copy[4 - i]);
 	}
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 3; ++i) {
-			video_buffer_free(final[2 - i]);
+			video_buffer_free(target->arena, final[2 - i]);
 		}
 	}
 }
@@ -3463,7 +3596,7 @@ static void video_stage_stretchy_scale4x(const struct video_pipeline_target_stru
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -3481,7 +3614,7 @@ static void video_stage_stretchy_scale4x(const struct video_pipeline_target_stru
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 4; ++i) {
-			final[i] = video_buffer_alloc(4 * stage_pivot->sdx * stage_pivot->sbpp);
+			final[i] = video_buffer_alloc(target->arena, 4 * stage_pivot->sdx * stage_pivot->sbpp);
 		}
 	} else {
 		for (i = 0; i < 4; ++i) {
@@ -3500,11 +3633,11 @@ static void video_stage_stretchy_scale4x(const struct video_pipeline_target_stru
 	PADD(input[4], stage_vert->sdw * 4);
 
 	for (i = 0; i < 5; ++i) {
-		partial_copy[i] = partial[i] = video_buffer_alloc(stage_vert->sdx * stage_vert->bpp);
+		partial_copy[i] = partial[i] = video_buffer_alloc(target->arena, stage_vert->sdx * stage_vert->bpp);
 	}
 
 	for (i = 0; i < 6; ++i) {
-		middle_copy[i] = middle[i] = video_buffer_alloc(2 * stage_vert->sdx * stage_vert->bpp);
+		middle_copy[i] = middle[i] = video_buffer_alloc(target->arena, 2 * stage_vert->sdx * stage_vert->bpp);
 	}
 
 	for (i = 0; i < 4; ++i) {
@@ -3680,16 +3813,16 @@ static void video_stage_stretchy_scale4x(const struct video_pipeline_target_stru
 	}
 
 	for (i = 0; i < 6; ++i) {
-		video_buffer_free(middle_copy[5 - i]);
+		video_buffer_free(target->arena, middle_copy[5 - i]);
 	}
 
 	for (i = 0; i < 5; ++i) {
-		video_buffer_free(partial_copy[4 - i]);
+		video_buffer_free(target->arena, partial_copy[4 - i]);
 	}
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 4; ++i) {
-			video_buffer_free(final[3 - i]);
+			video_buffer_free(target->arena, final[3 - i]);
 		}
 	}
 }
@@ -3703,7 +3836,7 @@ static void video_stage_stretchy_scale4k(const struct video_pipeline_target_stru
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -3719,7 +3852,7 @@ static void video_stage_stretchy_scale4k(const struct video_pipeline_target_stru
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 4; ++i) {
-			final[i] = video_buffer_alloc(4 * stage_pivot->sdx * stage_pivot->sbpp);
+			final[i] = video_buffer_alloc(target->arena, 4 * stage_pivot->sdx * stage_pivot->sbpp);
 		}
 	} else {
 		for (i = 0; i < 4; ++i) {
@@ -3734,7 +3867,7 @@ static void video_stage_stretchy_scale4k(const struct video_pipeline_target_stru
 	PADD(input[2], stage_vert->sdw * 2);
 
 	for (i = 0; i < 3; ++i) {
-		partial_copy[i] = partial[i] = video_buffer_alloc(stage_vert->sdx * stage_vert->bpp);
+		partial_copy[i] = partial[i] = video_buffer_alloc(target->arena, stage_vert->sdx * stage_vert->bpp);
 	}
 
 	partial[0] = video_pipeline_run_partial(partial[0], stage_begin, stage_pivot, 0, input[0], -1);
@@ -3839,12 +3972,12 @@ static void video_stage_stretchy_scale4k(const struct video_pipeline_target_stru
 	}
 
 	for (i = 0; i < 3; ++i) {
-		video_buffer_free(partial_copy[2 - i]);
+		video_buffer_free(target->arena, partial_copy[2 - i]);
 	}
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 4; ++i) {
-			video_buffer_free(final[3 - i]);
+			video_buffer_free(target->arena, final[3 - i]);
 		}
 	}
 }
@@ -3859,7 +3992,7 @@ static void video_stage_stretchy_hq4x(const struct video_pipeline_target_struct*
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -3875,7 +4008,7 @@ static void video_stage_stretchy_hq4x(const struct video_pipeline_target_struct*
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 4; ++i) {
-			final[i] = video_buffer_alloc(4 * stage_pivot->sdx * stage_pivot->sbpp);
+			final[i] = video_buffer_alloc(target->arena, 4 * stage_pivot->sdx * stage_pivot->sbpp);
 		}
 	} else {
 		for (i = 0; i < 4; ++i) {
@@ -3890,7 +4023,7 @@ static void video_stage_stretchy_hq4x(const struct video_pipeline_target_struct*
 	PADD(input[2], stage_vert->sdw * 2);
 
 	for (i = 0; i < 3; ++i) {
-		partial_copy[i] = partial[i] = video_buffer_alloc(stage_vert->sdx * stage_vert->bpp);
+		partial_copy[i] = partial[i] = video_buffer_alloc(target->arena, stage_vert->sdx * stage_vert->bpp);
 	}
 
 	partial[0] = video_pipeline_run_partial(partial[0], stage_begin, stage_pivot, 0, input[0], -1);
@@ -3995,12 +4128,12 @@ static void video_stage_stretchy_hq4x(const struct video_pipeline_target_struct*
 	}
 
 	for (i = 0; i < 3; ++i) {
-		video_buffer_free(partial_copy[2 - i]);
+		video_buffer_free(target->arena, partial_copy[2 - i]);
 	}
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 4; ++i) {
-			video_buffer_free(final[3 - i]);
+			video_buffer_free(target->arena, final[3 - i]);
 		}
 	}
 }
@@ -4016,7 +4149,7 @@ static void video_stage_stretchy_xbr4x(const struct video_pipeline_target_struct
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	const struct video_stage_horz_struct* stage_begin = stage_vert->stage_begin;
@@ -4032,7 +4165,7 @@ static void video_stage_stretchy_xbr4x(const struct video_pipeline_target_struct
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 4; ++i) {
-			final[i] = video_buffer_alloc(4 * stage_pivot->sdx * stage_pivot->sbpp);
+			final[i] = video_buffer_alloc(target->arena, 4 * stage_pivot->sdx * stage_pivot->sbpp);
 		}
 	} else {
 		for (i = 0; i < 4; ++i) {
@@ -4051,7 +4184,7 @@ static void video_stage_stretchy_xbr4x(const struct video_pipeline_target_struct
 	PADD(input[4], stage_vert->sdw * 4);
 
 	for (i = 0; i < 5; ++i) {
-		partial_copy[i] = partial[i] = video_buffer_alloc(stage_vert->sdx * stage_vert->bpp);
+		partial_copy[i] = partial[i] = video_buffer_alloc(target->arena, stage_vert->sdx * stage_vert->bpp);
 	}
 
 	partial[0] = video_pipeline_run_partial(partial[0], stage_begin, stage_pivot, 0, input[0], -1);
@@ -4206,12 +4339,12 @@ static void video_stage_stretchy_xbr4x(const struct video_pipeline_target_struct
 	}
 
 	for (i = 0; i < 5; ++i) {
-		video_buffer_free(partial_copy[4 - i]);
+		video_buffer_free(target->arena, partial_copy[4 - i]);
 	}
 
 	if (stage_pivot != stage_end) {
 		for (i = 0; i < 4; ++i) {
-			video_buffer_free(final[3 - i]);
+			video_buffer_free(target->arena, final[3 - i]);
 		}
 	}
 }
@@ -4226,7 +4359,7 @@ static void video_stage_stretchy_11(const struct video_pipeline_target_struct* t
 {
 	unsigned x_off = x * target->bytes_per_pixel;
 	unsigned count = stage_vert->sdy;
-	unsigned line = 0;
+	unsigned line = stage_vert->line;
 	unsigned pos = -1;
 
 	while (count) {
@@ -4281,6 +4414,7 @@ static void video_stage_stretchy_set(const struct video_pipeline_target_struct*
 	stage_vert->sdy = sdy;
 	stage_vert->sdw = sdw;
 	stage_vert->ddy = ddy;
+	stage_vert->line = 0;
 
 	/* the pixel type is always the target pixel type because, when used, any conversion is done before */
 	if (color_def_type_get(target->color_def) == adv_color_type_yuy2)
@@ -4520,6 +4654,7 @@ static void video_stage_stretchy_11_set(struct video_stage_vert_struct* stage_ve
 	stage_vert->sdy = sdy;
 	stage_vert->sdw = sdw;
 	stage_vert->ddy = sdy;
+	stage_vert->line = 0;
 
 	slice_set(&stage_vert->slice, sdy, sdy);
 
@@ -4982,3 +5117,200 @@ void video_pipeline_blit(const struct video_pipeline_struct* pipeline, unsigned
 	video_pipeline_vert_run(pipeline, dst_x, dst_y, src);
 }
 
+/***************************************************************************/
+/* band */
+
+/* Min number of source rows in a band */
+#define VIDEO_BAND_ROW_MIN 16
+
+/* Target of a band */
+struct video_pipeline_band_struct {
+	struct video_pipeline_target_struct target; /* must be the first */
+	const struct video_pipeline_target_struct* parent; /* real target */
+	unsigned y_begin; /* first destination row of the band */
+	unsigned y_end; /* last destination row of the band, excluded */
+	unsigned char* scratch; /* row used for the rows outside the band */
+};
+
+/* Line of a band. The rows outside the band are redirected to the scratch row */
+static unsigned char* band_line(const struct video_pipeline_target_struct* target, unsigned y)
+{
+	const struct video_pipeline_band_struct* band = (const struct video_pipeline_band_struct*)target;
+
+	if (y < band->y_begin || y >= band->y_end)
+		return band->scratch;
+
+	return band->parent->line(band->parent, y);
+}
+
+/*
+ * Number of source rows required as context over and under every row.
+ * Return -1 if the vertical stage cannot be split.
+ */
+static int band_context(const struct video_stage_vert_struct* stage_vert)
+{
+	switch (stage_vert->type) {
+	case pipe_y_copy:
+		if (stage_vert->put == video_stage_stretchy_11)
+			return 0;
+		return -1;
+#ifndef USE_BLIT_TINY
+	case pipe_y_scale2x:
+	case pipe_y_scale2x3:
+	case pipe_y_scale2x4:
+	case pipe_y_scale3x:
+	case pipe_y_scale2k:
+	case pipe_y_scale3k:
+	case pipe_y_scale4k:
+#ifndef USE_BLIT_SMALL
+	case pipe_y_hq2x:
+	case pipe_y_hq2x3:
+	case pipe_y_hq2x4:
+	case pipe_y_hq3x:
+	case pipe_y_hq4x:
+#endif
+		return 1; /* 3 rows kernels */
+	case pipe_y_scale4x: /* two 3 rows kernels in sequence */
+#ifndef USE_BLIT_SMALL
+	case pipe_y_xbr2x:
+	case pipe_y_xbr3x:
+	case pipe_y_xbr4x:
+#endif
+		return 2; /* 5 rows kernels */
+#endif
+	default:
+		return -1;
+	}
+}
+
+adv_error video_pipeline_band(struct video_pipeline_struct* pipeline, unsigned max)
+{
+	unsigned i;
+
+	assert(pipeline->band_mac == 0);
+
+	if (max > VIDEO_BAND_MAX)
+		max = VIDEO_BAND_MAX;
+
+	pipeline->band_map = malloc(max * sizeof(struct video_buffer_struct));
+	if (!pipeline->band_map) {
+		error_set("Low memory.\n");
+		return -1;
+	}
+
+	for (i = 0; i < max; ++i) {
+		if (video_buffer_init(&pipeline->band_map[i]) != 0) {
+			while (i > 0) {
+				--i;
+				video_buffer_done(&pipeline->band_map[i]);
+			}
+			free(pipeline->band_map);
+			pipeline->band_map = 0;
+			error_set("Low memory.\n");
+			return -1;
+		}
+	}
+
+	pipeline->band_mac = max;
+
+	return 0;
+}
+
+unsigned video_pipeline_band_max(const struct video_pipeline_struct* pipeline)
+{
+	const struct video_stage_vert_struct* stage_vert = video_pipeline_vert(pipeline);
+	unsigned max;
+
+	if (band_context(stage_vert) < 0)
+		return 1;
+
+	max = pipeline->band_mac;
+	if (max > stage_vert->sdy / VIDEO_BAND_ROW_MIN)
+		max = stage_vert->sdy / VIDEO_BAND_ROW_MIN;
+	if (max < 1)
+		max = 1;
+
+	return max;
+}
+
+void video_pipeline_blit_band(const struct video_pipeline_struct* pipeline, unsigned dst_x, unsigned dst_y, const void* src, unsigned num, unsigned max)
+{
+	const struct video_stage_vert_struct* stage_vert = video_pipeline_vert(pipeline);
+	struct video_pipeline_band_struct band;
+	struct video_stage_horz_struct stage_map[VIDEO_STAGE_MAX];
+	struct video_stage_vert_struct band_vert;
+	struct video_buffer_struct* arena;
+	unsigned factor;
+	unsigned context;
+	unsigned row_begin;
+	unsigned row_end;
+	unsigned ext_begin;
+	unsigned ext_end;
+	int i;
+
+	if (max <= 1) {
+		video_pipeline_vert_run(pipeline, dst_x, dst_y, src);
+		return;
+	}
+
+	assert(max <= video_pipeline_band_max(pipeline));
+	assert(num < max);
+
+	arena = &pipeline->band_map[num];
+	factor = stage_vert->ddy / stage_vert->sdy;
+	context = band_context(stage_vert);
+
+	/* source rows of the band */
+	row_begin = stage_vert->sdy * num / max;
+	row_end = stage_vert->sdy * (num + 1) / max;
+
+	/* source rows processed, including the context */
+	ext_begin = row_begin > context ? row_begin - context : 0;
+	ext_end = row_end + context < stage_vert->sdy ? row_end + context : stage_vert->sdy;
+
+	/* target that writes only the rows of the band */
+	band.target = pipeline->target;
+	band.target.line = &band_line;
+	band.target.arena = arena;
+	band.parent = &pipeline->target;
+	band.y_begin = dst_y + row_begin * factor;
+	band.y_end = dst_y + row_end * factor;
+	band.scratch = video_buffer_alloc(arena, pipeline->target.bytes_per_scanline);
+
+	/* private copy of the stages with private buffers */
+	for (i = 0; i < pipeline->stage_mac; ++i) {
+		stage_map[i] = pipeline->stage_map[i];
+		stage_map[i].buffer = stage_map[i].buffer_size ? video_buffer_alloc(arena, stage_map[i].buffer_size) : 0;
+	}
+	for (i = 0; i < pipeline->stage_mac; ++i) {
+		stage_map[i].buffer_extra = stage_map[i].buffer_extra_size ? video_buffer_alloc(arena, stage_map[i].buffer_extra_size) : 0;
+	}
+
+	band_vert = *stage_vert;
+	band_vert.stage_begin = stage_map;
+	band_vert.stage_end = stage_map + (stage_vert->stage_end - stage_vert->stage_begin);
+	band_vert.stage_pivot = stage_map + (stage_vert->stage_pivot - stage_vert->stage_begin);
+	band_vert.sdy = ext_end - ext_begin;
+	band_vert.ddy = band_vert.sdy * factor;
+	band_vert.line = stage_vert->line + ext_begin * factor;
+
+	PADD(src, (int)ext_begin * stage_vert->sdw);
+
+	band_vert.put(&band.target, &band_vert, dst_x, dst_y + ext_begin * factor, src);
+
+	/* restore the SSE2 micro state */
+	internal_end();
+
+	/* deallocate with the same allocation order */
+	for (i = pipeline->stage_mac - 1; i >= 0; --i) {
+		if (stage_map[i].buffer_extra)
+			video_buffer_free(arena, stage_map[i].buffer_extra);
+	}
+	for (i = pipeline->stage_mac - 1; i >= 0; --i) {
+		if (stage_map[i].buffer)
+			video_buffer_free(arena, stage_map[i].buffer);
+	}
+
+	video_buffer_free(arena, band.scratch);
+}
+
@@ -230,6 +230,7 @@ struct __attribute__((aligned(8))) video_stage_horz_struct {
 /*@}*/
 
 struct video_stage_vert_struct;
+struct video_buffer_struct;
 
 /**
  * Pipeline target.
@@ -240,6 +241,7 @@ struct video_pipeline_target_struct {
 	adv_color_def color_def;
 	unsigned bytes_per_pixel;
 	unsigned bytes_per_scanline;
+	struct video_buffer_struct* arena; /**< Arena for the temporary buffers. */
 };
 
 /**
@@ -268,6 +270,8 @@ struct __attribute__((aligned(8))) video_stage_vert_struct {
 
 	unsigned bpp;
 
+	unsigned line; /**< Number of the first line passed at the horizontal stages. */
+
 	/* stretch slice */
 	adv_slice slice;
 
@@ -287,6 +291,11 @@ struct __attribute__((aligned(8))) video_stage_vert_struct {
  */
 #define VIDEO_STAGE_MAX 8
 
+/**
+ * Max number of bands in a blit pipeline.
+ */
+#define VIDEO_BAND_MAX 16
+
 /**
  * Blit pipeline.
  * A blit pipeline is a sequence of blit stages which operates on the images pixels.
@@ -299,12 +308,18 @@ struct __attribute__((aligned(8))) video_stage_vert_struct {
  *
  * The vertical stage cannot be the last stage in the pipeline, the horizontal stage
  * immediatly after the vertical stage is called "pivot" stage.
+ *
+ * The pipeline can also be split in horizontal bands, blitted concurrently.
+ * Every band has its own buffers, and it computes also the rows required
+ * as context by the vertical stage, without writing them.
  */
 struct __attribute__((aligned(8))) video_pipeline_struct {
 	struct video_stage_horz_struct stage_map[VIDEO_STAGE_MAX]; /**< Horizontal stages. */
 	struct video_stage_vert_struct stage_vert; /**< Vertical stage. */
 	unsigned stage_mac; /**< Number of horizontal stages. */
 	struct video_pipeline_target_struct target; /**< Target of the pipeline. */
+	struct video_buffer_struct* band_map; /**< Buffer arenas of the bands. */
+	unsigned band_mac; /**< Number of bands. 0 if bands are not allocated. */
 };
 
 /**
@@ -312,6 +327,15 @@ struct __attribute__((aligned(8))) video_pipeline_struct {
  */
 void video_pipeline_init(struct video_pipeline_struct* pipeline);
 
+/**
+ * Initialize an empty blit pipeline with its own arena of temporary buffers.
+ * The pipeline doesn't share buffers with the other pipelines, and if it has
+ * a memory target set with video_pipeline_target() it can be built and
+ * used in a thread different than the video one.
+ * The arena is freed by video_pipeline_done().
+ */
+adv_error video_pipeline_init_private(struct video_pipeline_struct* pipeline);
+
 /**
  * Set the target of the pipeline.
  * The default target is the screen.
@@ -376,6 +400,38 @@ adv_error video_blit_init(void);
  */
 void video_blit_done(void);
 
+/**
+ * SIMD level of the blit functions.
+ */
+#define VIDEO_SIMD_C 0 /**< C implementation. */
+#define VIDEO_SIMD_SSE2 1 /**< MMX/SSE2 implementation. */
+#define VIDEO_SIMD_AVX2 2 /**< AVX2 implementation. */
+#define VIDEO_SIMD_MAX 3 /**< Number of SIMD levels. */
+
+/**
+ * Check if a SIMD level is supported by the processor.
+ * It's valid only after video_blit_init().
+ */
+adv_bool video_blit_simd_supported(unsigned level);
+
+/**
+ * Select the SIMD level of the blit functions.
+ * At the initialization the best supported level is selected.
+ * It must not be changed while a blit is in progress.
+ * \param level One of the VIDEO_SIMD_* levels. If not supported the nearest lower level is used.
+ */
+void video_blit_simd_set(unsigned level);
+
+/**
+ * Get the current SIMD level of the blit functions.
+ */
+unsigned video_blit_simd_get(void);
+
+/**
+ * Get the name of a SIMD level.
+ */
+const char* video_blit_simd_name(unsigned level);
+
 /***************************************************************************/
 /* pipeline blit */
 
@@ -412,6 +468,33 @@ void video_pipeline_palette16(struct video_pipeline_struct* pipeline, unsigned d
  */
 void video_pipeline_blit(const struct video_pipeline_struct* pipeline, unsigned dst_x, unsigned dst_y, const void* src);
 
+/**
+ * Allocate the buffers for a band blit of a precomputed pipeline.
+ * \param pipeline Pipeline to use.
+ * \param max Number of bands. From 1 to VIDEO_BAND_MAX.
+ */
+adv_error video_pipeline_band(struct video_pipeline_struct* pipeline, unsigned max);
+
+/**
+ * Get the max number of bands usable with video_pipeline_blit_band().
+ * Only the pipelines with an integer vertical scaling factor can be split,
+ * for all the other the result is 1.
+ */
+unsigned video_pipeline_band_max(const struct video_pipeline_struct* pipeline);
+
+/**
+ * Blit a single band using a precomputed pipeline.
+ * The different bands can be blitted concurrently from different threads.
+ * With max == 1 it's equivalent at video_pipeline_blit().
+ * \param pipeline Pipeline to use.
+ * \param dst_x Destination x.
+ * \param dst_y Destination y.
+ * \param src Source data.
+ * \param num Band to blit. From 0 to max - 1.
+ * \param max Number of bands. Not greather than video_pipeline_band_max().
+ */
+void video_pipeline_blit_band(const struct video_pipeline_struct* pipeline, unsigned dst_x, unsigned dst_y, const void* src, unsigned num, unsigned max);
+
 /***************************************************************************/
 /* blit */
 
@@ -41,7 +41,7 @@
  * This effect is a rewritten implementation of the hq2x effect made by Maxim Stepin
  */
 
-void hq2x_16_def(interp_uint16* restrict volatile dst0, interp_uint16* restrict volatile dst1, const interp_uint16* restrict src0, const interp_uint16* restrict src1, const interp_uint16* restrict src2, unsigned count)
+static inline void hq2x_16_row(interp_uint16* restrict volatile dst0, interp_uint16* restrict volatile dst1, const interp_uint16* restrict src0, const interp_uint16* restrict src1, const interp_uint16* restrict src2, unsigned count, const unsigned char* restrict mask_map)
 {
 	/* The volatile keyword for destination pointer ensures that */
 	/* the destination memory is only written and never read. */
@@ -78,24 +78,28 @@ void hq2x_16_def(interp_uint16* restrict volatile dst0, interp_uint16* restrict
 			c[8] = c[7];
 		}
 
-		mask = 0;
-
-		if (interp_16_diff(c[0], c[4]))
-			mask |= 1 << 0;
-		if (interp_16_diff(c[1], c[4]))
-			mask |= 1 << 1;
-		if (interp_16_diff(c[2], c[4]))
-			mask |= 1 << 2;
-		if (interp_16_diff(c[3], c[4]))
-			mask |= 1 << 3;
-		if (interp_16_diff(c[5], c[4]))
-			mask |= 1 << 4;
-		if (interp_16_diff(c[6], c[4]))
-			mask |= 1 << 5;
-		if (interp_16_diff(c[7], c[4]))
-			mask |= 1 << 6;
-		if (interp_16_diff(c[8], c[4]))
-			mask |= 1 << 7;
+		if (mask_map) {
+			mask = mask_map[i];
+		} else {
+			mask = 0;
+
+			if (interp_16_diff(c[0], c[4]))
+				mask |= 1 << 0;
+			if (interp_16_diff(c[1], c[4]))
+				mask |= 1 << 1;
+			if (interp_16_diff(c[2], c[4]))
+				mask |= 1 << 2;
+			if (interp_16_diff(c[3], c[4]))
+				mask |= 1 << 3;
+			if (interp_16_diff(c[5], c[4]))
+				mask |= 1 << 4;
+			if (interp_16_diff(c[6], c[4]))
+				mask |= 1 << 5;
+			if (interp_16_diff(c[7], c[4]))
+				mask |= 1 << 6;
+			if (interp_16_diff(c[8], c[4]))
+				mask |= 1 << 7;
+		}
 
 #define P(a, b) dst ## b[a]
 #define MUR interp_16_diff(c[1], c[5])
@@ -127,7 +131,9 @@ void hq2x_16_def(interp_uint16* restrict volatile dst0, interp_uint16* restrict
 	}
 }
 
-void hq2x_32_def(interp_uint32* restrict volatile dst0, interp_uint32* restrict volatile dst1, const interp_uint32* restrict src0, const interp_uint32* restrict src1, const interp_uint32* restrict src2, unsigned count)
+INTERP_HQ(hq2x, 16, (interp_uint16* restrict volatile dst0, interp_uint16* restrict volatile dst1), (dst0, dst1))
+
+static inline void hq2x_32_row(interp_uint32* restrict volatile dst0, interp_uint32* restrict volatile dst1, const interp_uint32* restrict src0, const interp_uint32* restrict src1, const interp_uint32* restrict src2, unsigned count, const unsigned char* restrict mask_map)
 {
 	unsigned i;
 
@@ -160,24 +166,28 @@ void hq2x_32_def(interp_uint32* restrict volatile dst0, interp_uint32* restrict
 			c[8] = c[7];
 		}
 
-		mask = 0;
-
-		if (interp_32_diff(c[0], c[4]))
-			mask |= 1 << 0;
-		if (interp_32_diff(c[1], c[4]))
-			mask |= 1 << 1;
-		if (interp_32_diff(c[2], c[4]))
-			mask |= 1 << 2;
-		if (interp_32_diff(c[3], c[4]))
-			mask |= 1 << 3;
-		if (interp_32_diff(c[5], c[4]))
-			mask |= 1 << 4;
-		if (interp_32_diff(c[6], c[4]))
-			mask |= 1 << 5;
-		if (interp_32_diff(c[7], c[4]))
-			mask |= 1 << 6;
-		if (interp_32_diff(c[8], c[4]))
-			mask |= 1 << 7;
+		if (mask_map) {
+			mask = mask_map[i];
+		} else {
+			mask = 0;
+
+			if (interp_32_diff(c[0], c[4]))
+				mask |= 1 << 0;
+			if (interp_32_diff(c[1], c[4]))
+				mask |= 1 << 1;
+			if (interp_32_diff(c[2], c[4]))
+				mask |= 1 << 2;
+			if (interp_32_diff(c[3], c[4]))
+				mask |= 1 << 3;
+			if (interp_32_diff(c[5], c[4]))
+				mask |= 1 << 4;
+			if (interp_32_diff(c[6], c[4]))
+				mask |= 1 << 5;
+			if (interp_32_diff(c[7], c[4]))
+				mask |= 1 << 6;
+			if (interp_32_diff(c[8], c[4]))
+				mask |= 1 << 7;
+		}
 
 #define P(a, b) dst ## b[a]
 #define MUR interp_32_diff(c[1], c[5])
@@ -209,6 +219,8 @@ void hq2x_32_def(interp_uint32* restrict volatile dst0, interp_uint32* restrict
 	}
 }
 
+INTERP_HQ(hq2x, 32, (interp_uint32* restrict volatile dst0, interp_uint32* restrict volatile dst1), (dst0, dst1))
+
 void hq2x_yuy2_def(interp_uint32* restrict volatile dst0, interp_uint32* restrict volatile dst1, const interp_uint32* restrict src0, const interp_uint32* restrict src1, const interp_uint32* restrict src2, unsigned count)
 {
 	unsigned i;
@@ -37,5 +37,10 @@ void hq2x_16_def(interp_uint16* dst0, interp_uint16* dst1, const interp_uint16*
 void hq2x_32_def(interp_uint32* dst0, interp_uint32* dst1, const interp_uint32* src0, const interp_uint32* src1, const interp_uint32* src2, unsigned count);
 void hq2x_yuy2_def(interp_uint32* dst0, interp_uint32* dst1, const interp_uint32* src0, const interp_uint32* src1, const interp_uint32* src2, unsigned count);
 
+#if defined(USE_BLIT_AVX2)
+void hq2x_16_avx2(interp_uint16* dst0, interp_uint16* dst1, const interp_uint16* src0, const interp_uint16* src1, const interp_uint16* src2, unsigned count);
+void hq2x_32_avx2(interp_uint32* dst0, interp_uint32* dst1, const interp_uint32* src0, const interp_uint32* src1, const interp_uint32* src2, unsigned count);
+#endif
+
 #endif
 
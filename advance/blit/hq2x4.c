@@ -41,7 +41,7 @@
  * This effect is derived from the hq4x effect made by Maxim Stepin
  */
 
-void hq2x4_16_def(interp_uint16* restrict dst0, interp_uint16* restrict dst1, interp_uint16* restrict dst2, interp_uint16* restrict dst3, const interp_uint16* restrict src0, const interp_uint16* restrict src1, const interp_uint16* restrict src2, unsigned count)
+static inline void hq2x4_16_row(interp_uint16* restrict dst0, interp_uint16* restrict dst1, interp_uint16* restrict dst2, interp_uint16* restrict dst3, const interp_uint16* restrict src0, const interp_uint16* restrict src1, const interp_uint16* restrict src2, unsigned count, const unsigned char* restrict mask_map)
 {
 	unsigned i;
 
@@ -74,24 +74,28 @@ void hq2x4_16_def(interp_uint16* restrict dst0, interp_uint16* restrict dst1, in
 			c[8] = c[7];
 		}
 
-		mask = 0;
-
-		if (interp_16_diff(c[0], c[4]))
-			mask |= 1 << 0;
-		if (interp_16_diff(c[1], c[4]))
-			mask |= 1 << 1;
-		if (interp_16_diff(c[2], c[4]))
-			mask |= 1 << 2;
-		if (interp_16_diff(c[3], c[4]))
-			mask |= 1 << 3;
-		if (interp_16_diff(c[5], c[4]))
-			mask |= 1 << 4;
-		if (interp_16_diff(c[6], c[4]))
-			mask |= 1 << 5;
-		if (interp_16_diff(c[7], c[4]))
-			mask |= 1 << 6;
-		if (interp_16_diff(c[8], c[4]))
-			mask |= 1 << 7;
+		if (mask_map) {
+			mask = mask_map[i];
+		} else {
+			mask = 0;
+
+			if (interp_16_diff(c[0], c[4]))
+				mask |= 1 << 0;
+			if (interp_16_diff(c[1], c[4]))
+				mask |= 1 << 1;
+			if (interp_16_diff(c[2], c[4]))
+				mask |= 1 << 2;
+			if (interp_16_diff(c[3], c[4]))
+				mask |= 1 << 3;
+			if (interp_16_diff(c[5], c[4]))
+				mask |= 1 << 4;
+			if (interp_16_diff(c[6], c[4]))
+				mask |= 1 << 5;
+			if (interp_16_diff(c[7], c[4]))
+				mask |= 1 << 6;
+			if (interp_16_diff(c[8], c[4]))
+				mask |= 1 << 7;
+		}
 
 #define P(a, b) dst ## b[a]
 #define MUR interp_16_diff(c[1], c[5])
@@ -125,7 +129,9 @@ void hq2x4_16_def(interp_uint16* restrict dst0, interp_uint16* restrict dst1, in
 	}
 }
 
-void hq2x4_32_def(interp_uint32* restrict dst0, interp_uint32* restrict dst1, interp_uint32* restrict dst2, interp_uint32* restrict dst3, const interp_uint32* restrict src0, const interp_uint32* restrict src1, const interp_uint32* restrict src2, unsigned count)
+INTERP_HQ(hq2x4, 16, (interp_uint16* restrict dst0, interp_uint16* restrict dst1, interp_uint16* restrict dst2, interp_uint16* restrict dst3), (dst0, dst1, dst2, dst3))
+
+static inline void hq2x4_32_row(interp_uint32* restrict dst0, interp_uint32* restrict dst1, interp_uint32* restrict dst2, interp_uint32* restrict dst3, const interp_uint32* restrict src0, const interp_uint32* restrict src1, const interp_uint32* restrict src2, unsigned count, const unsigned char* restrict mask_map)
 {
 	unsigned i;
 
@@ -158,24 +164,28 @@ void hq2x4_32_def(interp_uint32* restrict dst0, interp_uint32* restrict dst1, in
 			c[8] = c[7];
 		}
 
-		mask = 0;
-
-		if (interp_32_diff(c[0], c[4]))
-			mask |= 1 << 0;
-		if (interp_32_diff(c[1], c[4]))
-			mask |= 1 << 1;
-		if (interp_32_diff(c[2], c[4]))
-			mask |= 1 << 2;
-		if (interp_32_diff(c[3], c[4]))
-			mask |= 1 << 3;
-		if (interp_32_diff(c[5], c[4]))
-			mask |= 1 << 4;
-		if (interp_32_diff(c[6], c[4]))
-			mask |= 1 << 5;
-		if (interp_32_diff(c[7], c[4]))
-			mask |= 1 << 6;
-		if (interp_32_diff(c[8], c[4]))
-			mask |= 1 << 7;
+		if (mask_map) {
+			mask = mask_map[i];
+		} else {
+			mask = 0;
+
+			if (interp_32_diff(c[0], c[4]))
+				mask |= 1 << 0;
+			if (interp_32_diff(c[1], c[4]))
+				mask |= 1 << 1;
+			if (interp_32_diff(c[2], c[4]))
+				mask |= 1 << 2;
+			if (interp_32_diff(c[3], c[4]))
+				mask |= 1 << 3;
+			if (interp_32_diff(c[5], c[4]))
+				mask |= 1 << 4;
+			if (interp_32_diff(c[6], c[4]))
+				mask |= 1 << 5;
+			if (interp_32_diff(c[7], c[4]))
+				mask |= 1 << 6;
+			if (interp_32_diff(c[8], c[4]))
+				mask |= 1 << 7;
+		}
 
 #define P(a, b) dst ## b[a]
 #define MUR interp_32_diff(c[1], c[5])
@@ -209,6 +219,8 @@ void hq2x4_32_def(interp_uint32* restrict dst0, interp_uint32* restrict dst1, in
 	}
 }
 
+INTERP_HQ(hq2x4, 32, (interp_uint32* restrict dst0, interp_uint32* restrict dst1, interp_uint32* restrict dst2, interp_uint32* restrict dst3), (dst0, dst1, dst2, dst3))
+
 void hq2x4_yuy2_def(interp_uint32* restrict dst0, interp_uint32* restrict dst1, interp_uint32* restrict dst2, interp_uint32* restrict dst3, const interp_uint32* restrict src0, const interp_uint32* restrict src1, const interp_uint32* restrict src2, unsigned count)
 {
 	unsigned i;
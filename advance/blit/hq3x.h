@@ -37,5 +37,10 @@ void hq3x_16_def(interp_uint16* dst0, interp_uint16* dst1, interp_uint16* dst2,
 void hq3x_32_def(interp_uint32* dst0, interp_uint32* dst1, interp_uint32* dst2, const interp_uint32* src0, const interp_uint32* src1, const interp_uint32* src2, unsigned count);
 void hq3x_yuy2_def(interp_uint32* dst0, interp_uint32* dst1, interp_uint32* dst2, const interp_uint32* src0, const interp_uint32* src1, const interp_uint32* src2, unsigned count);
 
+#if defined(USE_BLIT_AVX2)
+void hq3x_16_avx2(interp_uint16* dst0, interp_uint16* dst1, interp_uint16* dst2, const interp_uint16* src0, const interp_uint16* src1, const interp_uint16* src2, unsigned count);
+void hq3x_32_avx2(interp_uint32* dst0, interp_uint32* dst1, interp_uint32* dst2, const interp_uint32* src0, const interp_uint32* src1, const interp_uint32* src2, unsigned count);
+#endif
+
 #endif
 
@@ -276,3 +276,219 @@ void interp_set(unsigned color_def)
 	}
 }
 
+/***************************************************************************/
+/* diff mask AVX2 implementation */
+
+#if defined(USE_BLIT_AVX2)
+
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+/*
+ * The vector diff functions don't have the early exit on equal pixels of the
+ * C implementation, but they always return the same result because
+ * nearly equal pixels never exceed the limits.
+ */
+
+static inline __m256i interp_16_diff_avx2(__m256i p1, __m256i p2)
+{
+	__m256i m5 = _mm256_set1_epi16(0x1F);
+	__m256i m6 = _mm256_set1_epi16(0x3F);
+	__m256i r, g, b;
+	__m256i y4, u4, v8;
+
+	b = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_and_si256(p1, m5), _mm256_and_si256(p2, m5)), 3);
+
+	if (interp_green_mask == 0x7E0) {
+		g = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_and_si256(_mm256_srli_epi16(p1, 5), m6), _mm256_and_si256(_mm256_srli_epi16(p2, 5), m6)), 2);
+		r = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_srli_epi16(p1, 11), _mm256_srli_epi16(p2, 11)), 3);
+	} else {
+		g = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_and_si256(_mm256_srli_epi16(p1, 5), m5), _mm256_and_si256(_mm256_srli_epi16(p2, 5), m5)), 3);
+		r = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_and_si256(_mm256_srli_epi16(p1, 10), m5), _mm256_and_si256(_mm256_srli_epi16(p2, 10), m5)), 3);
+	}
+
+	y4 = _mm256_add_epi16(_mm256_add_epi16(r, g), b);
+	u4 = _mm256_sub_epi16(r, b);
+	v8 = _mm256_sub_epi16(_mm256_sub_epi16(_mm256_add_epi16(g, g), r), b);
+
+	return _mm256_or_si256(_mm256_or_si256(
+		_mm256_cmpgt_epi16(_mm256_abs_epi16(y4), _mm256_set1_epi16(INTERP_Y_LIMIT_S2)),
+		_mm256_cmpgt_epi16(_mm256_abs_epi16(u4), _mm256_set1_epi16(INTERP_U_LIMIT_S2))),
+		_mm256_cmpgt_epi16(_mm256_abs_epi16(v8), _mm256_set1_epi16(INTERP_V_LIMIT_S3)));
+}
+
+static inline __m256i interp_32_diff_avx2(__m256i p1, __m256i p2)
+{
+	__m256i m8 = _mm256_set1_epi32(0xFF);
+	__m256i r, g, b;
+	__m256i y, u, v;
+
+	b = _mm256_sub_epi32(_mm256_and_si256(p1, m8), _mm256_and_si256(p2, m8));
+	g = _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(p1, 8), m8), _mm256_and_si256(_mm256_srli_epi32(p2, 8), m8));
+	r = _mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(p1, 16), m8), _mm256_and_si256(_mm256_srli_epi32(p2, 16), m8));
+
+	y = _mm256_add_epi32(_mm256_add_epi32(r, g), b);
+	u = _mm256_sub_epi32(r, b);
+	v = _mm256_sub_epi32(_mm256_sub_epi32(_mm256_add_epi32(g, g), r), b);
+
+	return _mm256_or_si256(_mm256_or_si256(
+		_mm256_cmpgt_epi32(_mm256_abs_epi32(y), _mm256_set1_epi32(INTERP_Y_LIMIT_S2)),
+		_mm256_cmpgt_epi32(_mm256_abs_epi32(u), _mm256_set1_epi32(INTERP_U_LIMIT_S2))),
+		_mm256_cmpgt_epi32(_mm256_abs_epi32(v), _mm256_set1_epi32(INTERP_V_LIMIT_S3)));
+}
+
+static inline unsigned char interp_16_diff_mask_pixel(const interp_uint16* src0, const interp_uint16* src1, const interp_uint16* src2, unsigned i, unsigned count)
+{
+	unsigned l = i > 0 ? i - 1 : i;
+	unsigned r = i < count - 1 ? i + 1 : i;
+	interp_uint16 c = src1[i];
+	unsigned char mask = 0;
+
+	if (interp_16_diff(src0[l], c))
+		mask |= 1 << 0;
+	if (interp_16_diff(src0[i], c))
+		mask |= 1 << 1;
+	if (interp_16_diff(src0[r], c))
+		mask |= 1 << 2;
+	if (interp_16_diff(src1[l], c))
+		mask |= 1 << 3;
+	if (interp_16_diff(src1[r], c))
+		mask |= 1 << 4;
+	if (interp_16_diff(src2[l], c))
+		mask |= 1 << 5;
+	if (interp_16_diff(src2[i], c))
+		mask |= 1 << 6;
+	if (interp_16_diff(src2[r], c))
+		mask |= 1 << 7;
+
+	return mask;
+}
+
+/**
+ * Computes the HQ neighbour mask of a row of pixels of 16 bits.
+ * The bit N of every mask is set if the Nth neighbour of the pixel
+ * is different, like in the hq C implementations.
+ * The pixels over the left and right borders are assumed of the same color of
+ * the pixels on the border.
+ * The CPU must support the AVX2 instruction set.
+ * \param mask Destination vector of masks, one for every pixel.
+ * \param src0 Pointer at the first pixel of the previous row.
+ * \param src1 Pointer at the first pixel of the current row.
+ * \param src2 Pointer at the first pixel of the next row.
+ * \param count Length in pixels of the src0, src1 and src2 rows.
+ */
+void interp_16_diff_mask_avx2(unsigned char* mask, const interp_uint16* src0, const interp_uint16* src1, const interp_uint16* src2, unsigned count)
+{
+	unsigned i;
+
+	if (!count)
+		return;
+
+	/* first pixel */
+	mask[0] = interp_16_diff_mask_pixel(src0, src1, src2, 0, count);
+
+	/* central pixels, 16 at time */
+	for (i = 1; i + 17 <= count; i += 16) {
+		__m256i c = _mm256_loadu_si256((const __m256i*)(src1 + i));
+		__m256i m;
+
+		m = _mm256_and_si256(interp_16_diff_avx2(_mm256_loadu_si256((const __m256i*)(src0 + i - 1)), c), _mm256_set1_epi16(1 << 0));
+		m = _mm256_or_si256(m, _mm256_and_si256(interp_16_diff_avx2(_mm256_loadu_si256((const __m256i*)(src0 + i)), c), _mm256_set1_epi16(1 << 1)));
+		m = _mm256_or_si256(m, _mm256_and_si256(interp_16_diff_avx2(_mm256_loadu_si256((const __m256i*)(src0 + i + 1)), c), _mm256_set1_epi16(1 << 2)));
+		m = _mm256_or_si256(m, _mm256_and_si256(interp_16_diff_avx2(_mm256_loadu_si256((const __m256i*)(src1 + i - 1)), c), _mm256_set1_epi16(1 << 3)));
+		m = _mm256_or_si256(m, _mm256_and_si256(interp_16_diff_avx2(_mm256_loadu_si256((const __m256i*)(src1 + i + 1)), c), _mm256_set1_epi16(1 << 4)));
+		m = _mm256_or_si256(m, _mm256_and_si256(interp_16_diff_avx2(_mm256_loadu_si256((const __m256i*)(src2 + i - 1)), c), _mm256_set1_epi16(1 << 5)));
+		m = _mm256_or_si256(m, _mm256_and_si256(interp_16_diff_avx2(_mm256_loadu_si256((const __m256i*)(src2 + i)), c), _mm256_set1_epi16(1 << 6)));
+		m = _mm256_or_si256(m, _mm256_and_si256(interp_16_diff_avx2(_mm256_loadu_si256((const __m256i*)(src2 + i + 1)), c), _mm256_set1_epi16(1 << 7)));
+
+		/* pack to 8 bits */
+		m = _mm256_permute4x64_epi64(_mm256_packus_epi16(m, m), 0x08);
+		_mm_storeu_si128((__m128i*)(mask + i), _mm256_castsi256_si128(m));
+	}
+
+	/* remaining pixels */
+	for (; i < count; ++i)
+		mask[i] = interp_16_diff_mask_pixel(src0, src1, src2, i, count);
+}
+
+static inline unsigned char interp_32_diff_mask_pixel(const interp_uint32* src0, const interp_uint32* src1, const interp_uint32* src2, unsigned i, unsigned count)
+{
+	unsigned l = i > 0 ? i - 1 : i;
+	unsigned r = i < count - 1 ? i + 1 : i;
+	interp_uint32 c = src1[i];
+	unsigned char mask = 0;
+
+	if (interp_32_diff(src0[l], c))
+		mask |= 1 << 0;
+	if (interp_32_diff(src0[i], c))
+		mask |= 1 << 1;
+	if (interp_32_diff(src0[r], c))
+		mask |= 1 << 2;
+	if (interp_32_diff(src1[l], c))
+		mask |= 1 << 3;
+	if (interp_32_diff(src1[r], c))
+		mask |= 1 << 4;
+	if (interp_32_diff(src2[l], c))
+		mask |= 1 << 5;
+	if (interp_32_diff(src2[i], c))
+		mask |= 1 << 6;
+	if (interp_32_diff(src2[r], c))
+		mask |= 1 << 7;
+
+	return mask;
+}
+
+/**
+ * Computes the HQ neighbour mask of a row of pixels of 32 bits.
+ * The bit N of every mask is set if the Nth neighbour of the pixel
+ * is different, like in the hq C implementations.
+ * The pixels over the left and right borders are assumed of the same color of
+ * the pixels on the border.
+ * The CPU must support the AVX2 instruction set.
+ * \param mask Destination vector of masks, one for every pixel.
+ * \param src0 Pointer at the first pixel of the previous row.
+ * \param src1 Pointer at the first pixel of the current row.
+ * \param src2 Pointer at the first pixel of the next row.
+ * \param count Length in pixels of the src0, src1 and src2 rows.
+ */
+void interp_32_diff_mask_avx2(unsigned char* mask, const interp_uint32* src0, const interp_uint32* src1, const interp_uint32* src2, unsigned count)
+{
+	unsigned i;
+
+	if (!count)
+		return;
+
+	/* first pixel */
+	mask[0] = interp_32_diff_mask_pixel(src0, src1, src2, 0, count);
+
+	/* central pixels, 8 at time */
+	for (i = 1; i + 9 <= count; i += 8) {
+		__m256i c = _mm256_loadu_si256((const __m256i*)(src1 + i));
+		__m256i m;
+
+		m = _mm256_and_si256(interp_32_diff_avx2(_mm256_loadu_si256((const __m256i*)(src0 + i - 1)), c), _mm256_set1_epi32(1 << 0));
+		m = _mm256_or_si256(m, _mm256_and_si256(interp_32_diff_avx2(_mm256_loadu_si256((const __m256i*)(src0 + i)), c), _mm256_set1_epi32(1 << 1)));
+		m = _mm256_or_si256(m, _mm256_and_si256(interp_32_diff_avx2(_mm256_loadu_si256((const __m256i*)(src0 + i + 1)), c), _mm256_set1_epi32(1 << 2)));
+		m = _mm256_or_si256(m, _mm256_and_si256(interp_32_diff_avx2(_mm256_loadu_si256((const __m256i*)(src1 + i - 1)), c), _mm256_set1_epi32(1 << 3)));
+		m = _mm256_or_si256(m, _mm256_and_si256(interp_32_diff_avx2(_mm256_loadu_si256((const __m256i*)(src1 + i + 1)), c), _mm256_set1_epi32(1 << 4)));
+		m = _mm256_or_si256(m, _mm256_and_si256(interp_32_diff_avx2(_mm256_loadu_si256((const __m256i*)(src2 + i - 1)), c), _mm256_set1_epi32(1 << 5)));
+		m = _mm256_or_si256(m, _mm256_and_si256(interp_32_diff_avx2(_mm256_loadu_si256((const __m256i*)(src2 + i)), c), _mm256_set1_epi32(1 << 6)));
+		m = _mm256_or_si256(m, _mm256_and_si256(interp_32_diff_avx2(_mm256_loadu_si256((const __m256i*)(src2 + i + 1)), c), _mm256_set1_epi32(1 << 7)));
+
+		/* pack to 8 bits */
+		m = _mm256_packus_epi32(m, m);
+		m = _mm256_packus_epi16(m, m);
+		m = _mm256_permutevar8x32_epi32(m, _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0));
+		_mm_storel_epi64((__m128i*)(mask + i), _mm256_castsi256_si128(m));
+	}
+
+	/* remaining pixels */
+	for (; i < count; ++i)
+		mask[i] = interp_32_diff_mask_pixel(src0, src1, src2, i, count);
+}
+
+#pragma GCC pop_options
+
+#endif
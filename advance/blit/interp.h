@@ -472,6 +472,70 @@ int interp_16_diff(interp_uint16 p1, interp_uint16 p2);
 int interp_32_diff(interp_uint32 p1, interp_uint32 p2);
 int interp_yuy2_diff(interp_uint32 p1, interp_uint32 p2);
 
+#if defined(USE_BLIT_AVX2)
+
+/**
+ * Max row length in pixels for which the HQ neighbour mask is computed in advance.
+ * Longer rows use the C implementation.
+ */
+#define INTERP_MASK_MAX 2048
+
+/**
+ * Computes the HQ neighbour masks of a row of pixels.
+ * Used by the AVX2 HQ algorithm.
+ */
+void interp_16_diff_mask_avx2(unsigned char* mask, const interp_uint16* src0, const interp_uint16* src1, const interp_uint16* src2, unsigned count);
+void interp_32_diff_mask_avx2(unsigned char* mask, const interp_uint32* src0, const interp_uint32* src1, const interp_uint32* src2, unsigned count);
+
+#endif
+
+/** Expand a list in parenthesis. */
+#define INTERP_HQ_LIST(...) __VA_ARGS__
+
+/**
+ * Define the NAME_BITS_def() C version of a row of a HQ effect.
+ * It calls the NAME_BITS_row() function of the effect, that computes
+ * the neighbour masks by itself.
+ * \param name Name of the effect, like hq2x.
+ * \param bits Bits per pixel, 16 or 32.
+ * \param dst Declaration of the destination rows, in parenthesis.
+ * \param arg Names of the destination rows, in parenthesis.
+ */
+#define INTERP_HQ_DEF(name, bits, dst, arg) \
+	void name ## _ ## bits ## _def(INTERP_HQ_LIST dst, const interp_uint ## bits* restrict src0, const interp_uint ## bits* restrict src1, const interp_uint ## bits* restrict src2, unsigned count) \
+	{ \
+		name ## _ ## bits ## _row(INTERP_HQ_LIST arg, src0, src1, src2, count, 0); \
+	}
+
+/**
+ * Define the NAME_BITS_avx2() version of a row of a HQ effect.
+ * Like INTERP_HQ_DEF() but with the neighbour masks computed in advance
+ * with AVX2 instructions. The rows longer than INTERP_MASK_MAX use the
+ * C version. The CPU must support the AVX2 instruction set.
+ */
+#if defined(USE_BLIT_AVX2)
+#define INTERP_HQ_AVX2(name, bits, dst, arg) \
+	void name ## _ ## bits ## _avx2(INTERP_HQ_LIST dst, const interp_uint ## bits* restrict src0, const interp_uint ## bits* restrict src1, const interp_uint ## bits* restrict src2, unsigned count) \
+	{ \
+		unsigned char mask_map[INTERP_MASK_MAX]; \
+		if (count > INTERP_MASK_MAX) { \
+			name ## _ ## bits ## _row(INTERP_HQ_LIST arg, src0, src1, src2, count, 0); \
+			return; \
+		} \
+		interp_ ## bits ## _diff_mask_avx2(mask_map, src0, src1, src2, count); \
+		name ## _ ## bits ## _row(INTERP_HQ_LIST arg, src0, src1, src2, count, mask_map); \
+	}
+#else
+#define INTERP_HQ_AVX2(name, bits, dst, arg)
+#endif
+
+/**
+ * Define all the versions of a row of a HQ effect.
+ */
+#define INTERP_HQ(name, bits, dst, arg) \
+	INTERP_HQ_DEF(name, bits, dst, arg) \
+	INTERP_HQ_AVX2(name, bits, dst, arg)
+
 /**
  * Computes the distance between two pixels.
  * Used by XBR algorithm.
@@ -1497,3 +1497,295 @@ void scale2x4_32_asm(scale2x_uint32* dst0, scale2x_uint32* dst1, scale2x_uint32*
 
 #endif
 
+
+/***************************************************************************/
+/* Scale2x AVX2 implementation */
+
+#if defined(USE_BLIT_AVX2)
+
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+/*
+ * The AVX2 implementation computes the same result of the C one.
+ * The central pixels are processed in blocks of 256 bits, the first pixel
+ * and the pixels not filling a complete block are processed in C.
+ * The pixels over the left and right borders are the same of the pixels
+ * on the border, like in the C implementation.
+ */
+
+static inline __m256i scale2x_avx2_load(const void* p)
+{
+	return _mm256_loadu_si256((const __m256i*)p);
+}
+
+static inline void scale2x_avx2_store(void* p, __m256i v)
+{
+	_mm256_storeu_si256((__m256i*)p, v);
+}
+
+static inline void scale2x_16_avx2_border_pixel(scale2x_uint16* restrict dst, const scale2x_uint16* restrict src0, const scale2x_uint16* restrict src1, const scale2x_uint16* restrict src2, unsigned i, unsigned count)
+{
+	unsigned l = i > 0 ? i - 1 : i;
+	unsigned r = i < count - 1 ? i + 1 : i;
+
+	if (src0[i] != src2[i] && src1[l] != src1[r]) {
+		dst[0] = src1[l] == src0[i] ? src0[i] : src1[i];
+		dst[1] = src1[r] == src0[i] ? src0[i] : src1[i];
+	} else {
+		dst[0] = src1[i];
+		dst[1] = src1[i];
+	}
+}
+
+static inline void scale2x_16_avx2_center_pixel(scale2x_uint16* restrict dst, const scale2x_uint16* restrict src0, const scale2x_uint16* restrict src1, const scale2x_uint16* restrict src2, unsigned i, unsigned count)
+{
+	unsigned l = i > 0 ? i - 1 : i;
+	unsigned r = i < count - 1 ? i + 1 : i;
+
+	if (src0[i] != src2[i] && src1[l] != src1[r]) {
+		dst[0] = (src1[l] == src0[i] && src1[i] != src2[l]) || (src1[l] == src2[i] && src1[i] != src0[l]) ? src1[l] : src1[i];
+		dst[1] = (src1[r] == src0[i] && src1[i] != src2[r]) || (src1[r] == src2[i] && src1[i] != src0[r]) ? src1[r] : src1[i];
+	} else {
+		dst[0] = src1[i];
+		dst[1] = src1[i];
+	}
+}
+
+static inline void scale2x_32_avx2_border_pixel(scale2x_uint32* restrict dst, const scale2x_uint32* restrict src0, const scale2x_uint32* restrict src1, const scale2x_uint32* restrict src2, unsigned i, unsigned count)
+{
+	unsigned l = i > 0 ? i - 1 : i;
+	unsigned r = i < count - 1 ? i + 1 : i;
+
+	if (src0[i] != src2[i] && src1[l] != src1[r]) {
+		dst[0] = src1[l] == src0[i] ? src0[i] : src1[i];
+		dst[1] = src1[r] == src0[i] ? src0[i] : src1[i];
+	} else {
+		dst[0] = src1[i];
+		dst[1] = src1[i];
+	}
+}
+
+static inline void scale2x_32_avx2_center_pixel(scale2x_uint32* restrict dst, const scale2x_uint32* restrict src0, const scale2x_uint32* restrict src1, const scale2x_uint32* restrict src2, unsigned i, unsigned count)
+{
+	unsigned l = i > 0 ? i - 1 : i;
+	unsigned r = i < count - 1 ? i + 1 : i;
+
+	if (src0[i] != src2[i] && src1[l] != src1[r]) {
+		dst[0] = (src1[l] == src0[i] && src1[i] != src2[l]) || (src1[l] == src2[i] && src1[i] != src0[l]) ? src1[l] : src1[i];
+		dst[1] = (src1[r] == src0[i] && src1[i] != src2[r]) || (src1[r] == src2[i] && src1[i] != src0[r]) ? src1[r] : src1[i];
+	} else {
+		dst[0] = src1[i];
+		dst[1] = src1[i];
+	}
+}
+
+static void scale2x_16_avx2_border(scale2x_uint16* restrict dst, const scale2x_uint16* restrict src0, const scale2x_uint16* restrict src1, const scale2x_uint16* restrict src2, unsigned count)
+{
+	unsigned i;
+
+	assert(count >= 2);
+
+	/* first pixel */
+	scale2x_16_avx2_border_pixel(dst, src0, src1, src2, 0, count);
+
+	/* central pixels, 16 at time */
+	for (i = 1; i + 17 <= count; i += 16) {
+		__m256i a = scale2x_avx2_load(src0 + i);
+		__m256i c = scale2x_avx2_load(src2 + i);
+		__m256i e = scale2x_avx2_load(src1 + i);
+		__m256i l = scale2x_avx2_load(src1 + i - 1);
+		__m256i r = scale2x_avx2_load(src1 + i + 1);
+		__m256i skip = _mm256_or_si256(_mm256_cmpeq_epi16(a, c), _mm256_cmpeq_epi16(l, r));
+		__m256i d0 = _mm256_blendv_epi8(e, a, _mm256_andnot_si256(skip, _mm256_cmpeq_epi16(l, a)));
+		__m256i d1 = _mm256_blendv_epi8(e, a, _mm256_andnot_si256(skip, _mm256_cmpeq_epi16(r, a)));
+		__m256i lo = _mm256_unpacklo_epi16(d0, d1);
+		__m256i hi = _mm256_unpackhi_epi16(d0, d1);
+
+		scale2x_avx2_store(dst + 2 * i, _mm256_permute2x128_si256(lo, hi, 0x20));
+		scale2x_avx2_store(dst + 2 * i + 16, _mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+
+	/* remaining pixels */
+	for (; i < count; ++i)
+		scale2x_16_avx2_border_pixel(dst + 2 * i, src0, src1, src2, i, count);
+}
+
+static void scale2x_16_avx2_center(scale2x_uint16* restrict dst, const scale2x_uint16* restrict src0, const scale2x_uint16* restrict src1, const scale2x_uint16* restrict src2, unsigned count)
+{
+	unsigned i;
+
+	assert(count >= 2);
+
+	/* first pixel */
+	scale2x_16_avx2_center_pixel(dst, src0, src1, src2, 0, count);
+
+	/* central pixels, 16 at time */
+	for (i = 1; i + 17 <= count; i += 16) {
+		__m256i a = scale2x_avx2_load(src0 + i);
+		__m256i c = scale2x_avx2_load(src2 + i);
+		__m256i e = scale2x_avx2_load(src1 + i);
+		__m256i l = scale2x_avx2_load(src1 + i - 1);
+		__m256i r = scale2x_avx2_load(src1 + i + 1);
+		__m256i al = scale2x_avx2_load(src0 + i - 1);
+		__m256i cl = scale2x_avx2_load(src2 + i - 1);
+		__m256i ar = scale2x_avx2_load(src0 + i + 1);
+		__m256i cr = scale2x_avx2_load(src2 + i + 1);
+		__m256i skip = _mm256_or_si256(_mm256_cmpeq_epi16(a, c), _mm256_cmpeq_epi16(l, r));
+		__m256i ml = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi16(e, cl), _mm256_cmpeq_epi16(l, a)), _mm256_andnot_si256(_mm256_cmpeq_epi16(e, al), _mm256_cmpeq_epi16(l, c)));
+		__m256i mr = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi16(e, cr), _mm256_cmpeq_epi16(r, a)), _mm256_andnot_si256(_mm256_cmpeq_epi16(e, ar), _mm256_cmpeq_epi16(r, c)));
+		__m256i d0 = _mm256_blendv_epi8(e, l, _mm256_andnot_si256(skip, ml));
+		__m256i d1 = _mm256_blendv_epi8(e, r, _mm256_andnot_si256(skip, mr));
+		__m256i lo = _mm256_unpacklo_epi16(d0, d1);
+		__m256i hi = _mm256_unpackhi_epi16(d0, d1);
+
+		scale2x_avx2_store(dst + 2 * i, _mm256_permute2x128_si256(lo, hi, 0x20));
+		scale2x_avx2_store(dst + 2 * i + 16, _mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+
+	/* remaining pixels */
+	for (; i < count; ++i)
+		scale2x_16_avx2_center_pixel(dst + 2 * i, src0, src1, src2, i, count);
+}
+
+static void scale2x_32_avx2_border(scale2x_uint32* restrict dst, const scale2x_uint32* restrict src0, const scale2x_uint32* restrict src1, const scale2x_uint32* restrict src2, unsigned count)
+{
+	unsigned i;
+
+	assert(count >= 2);
+
+	/* first pixel */
+	scale2x_32_avx2_border_pixel(dst, src0, src1, src2, 0, count);
+
+	/* central pixels, 8 at time */
+	for (i = 1; i + 9 <= count; i += 8) {
+		__m256i a = scale2x_avx2_load(src0 + i);
+		__m256i c = scale2x_avx2_load(src2 + i);
+		__m256i e = scale2x_avx2_load(src1 + i);
+		__m256i l = scale2x_avx2_load(src1 + i - 1);
+		__m256i r = scale2x_avx2_load(src1 + i + 1);
+		__m256i skip = _mm256_or_si256(_mm256_cmpeq_epi32(a, c), _mm256_cmpeq_epi32(l, r));
+		__m256i d0 = _mm256_blendv_epi8(e, a, _mm256_andnot_si256(skip, _mm256_cmpeq_epi32(l, a)));
+		__m256i d1 = _mm256_blendv_epi8(e, a, _mm256_andnot_si256(skip, _mm256_cmpeq_epi32(r, a)));
+		__m256i lo = _mm256_unpacklo_epi32(d0, d1);
+		__m256i hi = _mm256_unpackhi_epi32(d0, d1);
+
+		scale2x_avx2_store(dst + 2 * i, _mm256_permute2x128_si256(lo, hi, 0x20));
+		scale2x_avx2_store(dst + 2 * i + 8, _mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+
+	/* remaining pixels */
+	for (; i < count; ++i)
+		scale2x_32_avx2_border_pixel(dst + 2 * i, src0, src1, src2, i, count);
+}
+
+static void scale2x_32_avx2_center(scale2x_uint32* restrict dst, const scale2x_uint32* restrict src0, const scale2x_uint32* restrict src1, const scale2x_uint32* restrict src2, unsigned count)
+{
+	unsigned i;
+
+	assert(count >= 2);
+
+	/* first pixel */
+	scale2x_32_avx2_center_pixel(dst, src0, src1, src2, 0, count);
+
+	/* central pixels, 8 at time */
+	for (i = 1; i + 9 <= count; i += 8) {
+		__m256i a = scale2x_avx2_load(src0 + i);
+		__m256i c = scale2x_avx2_load(src2 + i);
+		__m256i e = scale2x_avx2_load(src1 + i);
+		__m256i l = scale2x_avx2_load(src1 + i - 1);
+		__m256i r = scale2x_avx2_load(src1 + i + 1);
+		__m256i al = scale2x_avx2_load(src0 + i - 1);
+		__m256i cl = scale2x_avx2_load(src2 + i - 1);
+		__m256i ar = scale2x_avx2_load(src0 + i + 1);
+		__m256i cr = scale2x_avx2_load(src2 + i + 1);
+		__m256i skip = _mm256_or_si256(_mm256_cmpeq_epi32(a, c), _mm256_cmpeq_epi32(l, r));
+		__m256i ml = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi32(e, cl), _mm256_cmpeq_epi32(l, a)), _mm256_andnot_si256(_mm256_cmpeq_epi32(e, al), _mm256_cmpeq_epi32(l, c)));
+		__m256i mr = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi32(e, cr), _mm256_cmpeq_epi32(r, a)), _mm256_andnot_si256(_mm256_cmpeq_epi32(e, ar), _mm256_cmpeq_epi32(r, c)));
+		__m256i d0 = _mm256_blendv_epi8(e, l, _mm256_andnot_si256(skip, ml));
+		__m256i d1 = _mm256_blendv_epi8(e, r, _mm256_andnot_si256(skip, mr));
+		__m256i lo = _mm256_unpacklo_epi32(d0, d1);
+		__m256i hi = _mm256_unpackhi_epi32(d0, d1);
+
+		scale2x_avx2_store(dst + 2 * i, _mm256_permute2x128_si256(lo, hi, 0x20));
+		scale2x_avx2_store(dst + 2 * i + 8, _mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+
+	/* remaining pixels */
+	for (; i < count; ++i)
+		scale2x_32_avx2_center_pixel(dst + 2 * i, src0, src1, src2, i, count);
+}
+
+/**
+ * Scale by a factor of 2 a row of pixels of 16 bits.
+ * This function operates like scale2x_16_def() but it uses AVX2 instructions.
+ * The CPU must support the AVX2 instruction set.
+ */
+void scale2x_16_avx2(scale2x_uint16* dst0, scale2x_uint16* dst1, const scale2x_uint16* src0, const scale2x_uint16* src1, const scale2x_uint16* src2, unsigned count)
+{
+	scale2x_16_avx2_border(dst0, src0, src1, src2, count);
+	scale2x_16_avx2_border(dst1, src2, src1, src0, count);
+}
+
+/**
+ * Scale by a factor of 2 a row of pixels of 32 bits.
+ * This function operates like scale2x_32_def() but it uses AVX2 instructions.
+ * The CPU must support the AVX2 instruction set.
+ */
+void scale2x_32_avx2(scale2x_uint32* dst0, scale2x_uint32* dst1, const scale2x_uint32* src0, const scale2x_uint32* src1, const scale2x_uint32* src2, unsigned count)
+{
+	scale2x_32_avx2_border(dst0, src0, src1, src2, count);
+	scale2x_32_avx2_border(dst1, src2, src1, src0, count);
+}
+
+/**
+ * Scale by a factor of 2x3 a row of pixels of 16 bits.
+ * \note Like scale2x_16_avx2();
+ */
+void scale2x3_16_avx2(scale2x_uint16* dst0, scale2x_uint16* dst1, scale2x_uint16* dst2, const scale2x_uint16* src0, const scale2x_uint16* src1, const scale2x_uint16* src2, unsigned count)
+{
+	scale2x_16_avx2_border(dst0, src0, src1, src2, count);
+	scale2x_16_avx2_center(dst1, src0, src1, src2, count);
+	scale2x_16_avx2_border(dst2, src2, src1, src0, count);
+}
+
+/**
+ * Scale by a factor of 2x3 a row of pixels of 32 bits.
+ * \note Like scale2x_32_avx2();
+ */
+void scale2x3_32_avx2(scale2x_uint32* dst0, scale2x_uint32* dst1, scale2x_uint32* dst2, const scale2x_uint32* src0, const scale2x_uint32* src1, const scale2x_uint32* src2, unsigned count)
+{
+	scale2x_32_avx2_border(dst0, src0, src1, src2, count);
+	scale2x_32_avx2_center(dst1, src0, src1, src2, count);
+	scale2x_32_avx2_border(dst2, src2, src1, src0, count);
+}
+
+/**
+ * Scale by a factor of 2x4 a row of pixels of 16 bits.
+ * \note Like scale2x_16_avx2();
+ */
+void scale2x4_16_avx2(scale2x_uint16* dst0, scale2x_uint16* dst1, scale2x_uint16* dst2, scale2x_uint16* dst3, const scale2x_uint16* src0, const scale2x_uint16* src1, const scale2x_uint16* src2, unsigned count)
+{
+	scale2x_16_avx2_border(dst0, src0, src1, src2, count);
+	scale2x_16_avx2_center(dst1, src0, src1, src2, count);
+	scale2x_16_avx2_center(dst2, src0, src1, src2, count);
+	scale2x_16_avx2_border(dst3, src2, src1, src0, count);
+}
+
+/**
+ * Scale by a factor of 2x4 a row of pixels of 32 bits.
+ * \note Like scale2x_32_avx2();
+ */
+void scale2x4_32_avx2(scale2x_uint32* dst0, scale2x_uint32* dst1, scale2x_uint32* dst2, scale2x_uint32* dst3, const scale2x_uint32* src0, const scale2x_uint32* src1, const scale2x_uint32* src2, unsigned count)
+{
+	scale2x_32_avx2_border(dst0, src0, src1, src2, count);
+	scale2x_32_avx2_center(dst1, src0, src1, src2, count);
+	scale2x_32_avx2_center(dst2, src0, src1, src2, count);
+	scale2x_32_avx2_border(dst3, src2, src1, src0, count);
+}
+
+#pragma GCC pop_options
+
+#endif
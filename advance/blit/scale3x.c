@@ -709,3 +709,294 @@ void scale3x_32_def(scale3x_uint32* dst0, scale3x_uint32* dst1, scale3x_uint32*
 #endif
 }
 
+/***************************************************************************/
+/* Scale3x AVX2 implementation */
+
+#if defined(USE_BLIT_AVX2)
+
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+/*
+ * The AVX2 implementation computes the same result of the C one.
+ * The central pixels are processed in blocks of 256 bits, the first pixel
+ * and the pixels not filling a complete block are processed in C.
+ */
+
+static inline __m256i scale3x_avx2_load(const void* p)
+{
+	return _mm256_loadu_si256((const __m256i*)p);
+}
+
+/**
+ * Interleave three vectors of 8 pixels of 32 bits.
+ */
+static inline void scale3x_avx2_interleave32(__m256i* o0, __m256i* o1, __m256i* o2, __m256i d0, __m256i d1, __m256i d2)
+{
+	__m256i i0 = _mm256_setr_epi32(0, 0, 0, 1, 1, 1, 2, 2);
+	__m256i i1 = _mm256_setr_epi32(2, 3, 3, 3, 4, 4, 4, 5);
+	__m256i i2 = _mm256_setr_epi32(5, 5, 6, 6, 6, 7, 7, 7);
+
+	*o0 = _mm256_blend_epi32(_mm256_blend_epi32(_mm256_permutevar8x32_epi32(d0, i0), _mm256_permutevar8x32_epi32(d1, i0), 0x92), _mm256_permutevar8x32_epi32(d2, i0), 0x24);
+	*o1 = _mm256_blend_epi32(_mm256_blend_epi32(_mm256_permutevar8x32_epi32(d0, i1), _mm256_permutevar8x32_epi32(d1, i1), 0x24), _mm256_permutevar8x32_epi32(d2, i1), 0x49);
+	*o2 = _mm256_blend_epi32(_mm256_blend_epi32(_mm256_permutevar8x32_epi32(d0, i2), _mm256_permutevar8x32_epi32(d1, i2), 0x49), _mm256_permutevar8x32_epi32(d2, i2), 0x92);
+}
+
+static inline void scale3x_16_avx2_store(scale3x_uint16* dst, __m256i d0, __m256i d1, __m256i d2)
+{
+	unsigned h;
+
+	/* expand to 32 bits, interleave and pack again to 16 bits */
+	for (h = 0; h < 2; ++h) {
+		__m256i w0 = _mm256_cvtepu16_epi32(h ? _mm256_extracti128_si256(d0, 1) : _mm256_castsi256_si128(d0));
+		__m256i w1 = _mm256_cvtepu16_epi32(h ? _mm256_extracti128_si256(d1, 1) : _mm256_castsi256_si128(d1));
+		__m256i w2 = _mm256_cvtepu16_epi32(h ? _mm256_extracti128_si256(d2, 1) : _mm256_castsi256_si128(d2));
+		__m256i o0, o1, o2;
+
+		scale3x_avx2_interleave32(&o0, &o1, &o2, w0, w1, w2);
+
+		_mm256_storeu_si256((__m256i*)(dst + 24 * h), _mm256_permute4x64_epi64(_mm256_packus_epi32(o0, o1), 0xD8));
+		_mm_storeu_si128((__m128i*)(dst + 24 * h + 16), _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi32(o2, o2), 0xD8)));
+	}
+}
+
+static inline void scale3x_32_avx2_store(scale3x_uint32* dst, __m256i d0, __m256i d1, __m256i d2)
+{
+	__m256i o0, o1, o2;
+
+	scale3x_avx2_interleave32(&o0, &o1, &o2, d0, d1, d2);
+
+	_mm256_storeu_si256((__m256i*)dst, o0);
+	_mm256_storeu_si256((__m256i*)(dst + 8), o1);
+	_mm256_storeu_si256((__m256i*)(dst + 16), o2);
+}
+
+static inline void scale3x_16_avx2_border_pixel(scale3x_uint16* restrict dst, const scale3x_uint16* restrict src0, const scale3x_uint16* restrict src1, const scale3x_uint16* restrict src2, unsigned i, unsigned count)
+{
+	unsigned l = i > 0 ? i - 1 : i;
+	unsigned r = i < count - 1 ? i + 1 : i;
+
+	if (src0[i] != src2[i] && src1[l] != src1[r]) {
+		dst[0] = src1[l] == src0[i] ? src1[l] : src1[i];
+		dst[1] = (src1[l] == src0[i] && src1[i] != src0[r]) || (src1[r] == src0[i] && src1[i] != src0[l]) ? src0[i] : src1[i];
+		dst[2] = src1[r] == src0[i] ? src1[r] : src1[i];
+	} else {
+		dst[0] = src1[i];
+		dst[1] = src1[i];
+		dst[2] = src1[i];
+	}
+}
+
+static inline void scale3x_16_avx2_center_pixel(scale3x_uint16* restrict dst, const scale3x_uint16* restrict src0, const scale3x_uint16* restrict src1, const scale3x_uint16* restrict src2, unsigned i, unsigned count)
+{
+	unsigned l = i > 0 ? i - 1 : i;
+	unsigned r = i < count - 1 ? i + 1 : i;
+
+	if (src0[i] != src2[i] && src1[l] != src1[r]) {
+		dst[0] = (src1[l] == src0[i] && src1[i] != src2[l]) || (src1[l] == src2[i] && src1[i] != src0[l]) ? src1[l] : src1[i];
+		dst[1] = src1[i];
+		dst[2] = (src1[r] == src0[i] && src1[i] != src2[r]) || (src1[r] == src2[i] && src1[i] != src0[r]) ? src1[r] : src1[i];
+	} else {
+		dst[0] = src1[i];
+		dst[1] = src1[i];
+		dst[2] = src1[i];
+	}
+}
+
+static inline void scale3x_32_avx2_border_pixel(scale3x_uint32* restrict dst, const scale3x_uint32* restrict src0, const scale3x_uint32* restrict src1, const scale3x_uint32* restrict src2, unsigned i, unsigned count)
+{
+	unsigned l = i > 0 ? i - 1 : i;
+	unsigned r = i < count - 1 ? i + 1 : i;
+
+	if (src0[i] != src2[i] && src1[l] != src1[r]) {
+		dst[0] = src1[l] == src0[i] ? src1[l] : src1[i];
+		dst[1] = (src1[l] == src0[i] && src1[i] != src0[r]) || (src1[r] == src0[i] && src1[i] != src0[l]) ? src0[i] : src1[i];
+		dst[2] = src1[r] == src0[i] ? src1[r] : src1[i];
+	} else {
+		dst[0] = src1[i];
+		dst[1] = src1[i];
+		dst[2] = src1[i];
+	}
+}
+
+static inline void scale3x_32_avx2_center_pixel(scale3x_uint32* restrict dst, const scale3x_uint32* restrict src0, const scale3x_uint32* restrict src1, const scale3x_uint32* restrict src2, unsigned i, unsigned count)
+{
+	unsigned l = i > 0 ? i - 1 : i;
+	unsigned r = i < count - 1 ? i + 1 : i;
+
+	if (src0[i] != src2[i] && src1[l] != src1[r]) {
+		dst[0] = (src1[l] == src0[i] && src1[i] != src2[l]) || (src1[l] == src2[i] && src1[i] != src0[l]) ? src1[l] : src1[i];
+		dst[1] = src1[i];
+		dst[2] = (src1[r] == src0[i] && src1[i] != src2[r]) || (src1[r] == src2[i] && src1[i] != src0[r]) ? src1[r] : src1[i];
+	} else {
+		dst[0] = src1[i];
+		dst[1] = src1[i];
+		dst[2] = src1[i];
+	}
+}
+
+static void scale3x_16_avx2_border(scale3x_uint16* restrict dst, const scale3x_uint16* restrict src0, const scale3x_uint16* restrict src1, const scale3x_uint16* restrict src2, unsigned count)
+{
+	unsigned i;
+
+	assert(count >= 2);
+
+	/* first pixel */
+	scale3x_16_avx2_border_pixel(dst, src0, src1, src2, 0, count);
+
+	/* central pixels, 16 at time */
+	for (i = 1; i + 17 <= count; i += 16) {
+		__m256i a = scale3x_avx2_load(src0 + i);
+		__m256i c = scale3x_avx2_load(src2 + i);
+		__m256i e = scale3x_avx2_load(src1 + i);
+		__m256i l = scale3x_avx2_load(src1 + i - 1);
+		__m256i r = scale3x_avx2_load(src1 + i + 1);
+		__m256i al = scale3x_avx2_load(src0 + i - 1);
+		__m256i ar = scale3x_avx2_load(src0 + i + 1);
+		__m256i skip = _mm256_or_si256(_mm256_cmpeq_epi16(a, c), _mm256_cmpeq_epi16(l, r));
+		__m256i la = _mm256_cmpeq_epi16(l, a);
+		__m256i ra = _mm256_cmpeq_epi16(r, a);
+		__m256i m1 = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi16(e, ar), la), _mm256_andnot_si256(_mm256_cmpeq_epi16(e, al), ra));
+		__m256i d0 = _mm256_blendv_epi8(e, l, _mm256_andnot_si256(skip, la));
+		__m256i d1 = _mm256_blendv_epi8(e, a, _mm256_andnot_si256(skip, m1));
+		__m256i d2 = _mm256_blendv_epi8(e, r, _mm256_andnot_si256(skip, ra));
+
+		scale3x_16_avx2_store(dst + 3 * i, d0, d1, d2);
+	}
+
+	/* remaining pixels */
+	for (; i < count; ++i)
+		scale3x_16_avx2_border_pixel(dst + 3 * i, src0, src1, src2, i, count);
+}
+
+static void scale3x_16_avx2_center(scale3x_uint16* restrict dst, const scale3x_uint16* restrict src0, const scale3x_uint16* restrict src1, const scale3x_uint16* restrict src2, unsigned count)
+{
+	unsigned i;
+
+	assert(count >= 2);
+
+	/* first pixel */
+	scale3x_16_avx2_center_pixel(dst, src0, src1, src2, 0, count);
+
+	/* central pixels, 16 at time */
+	for (i = 1; i + 17 <= count; i += 16) {
+		__m256i a = scale3x_avx2_load(src0 + i);
+		__m256i c = scale3x_avx2_load(src2 + i);
+		__m256i e = scale3x_avx2_load(src1 + i);
+		__m256i l = scale3x_avx2_load(src1 + i - 1);
+		__m256i r = scale3x_avx2_load(src1 + i + 1);
+		__m256i al = scale3x_avx2_load(src0 + i - 1);
+		__m256i cl = scale3x_avx2_load(src2 + i - 1);
+		__m256i ar = scale3x_avx2_load(src0 + i + 1);
+		__m256i cr = scale3x_avx2_load(src2 + i + 1);
+		__m256i skip = _mm256_or_si256(_mm256_cmpeq_epi16(a, c), _mm256_cmpeq_epi16(l, r));
+		__m256i ml = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi16(e, cl), _mm256_cmpeq_epi16(l, a)), _mm256_andnot_si256(_mm256_cmpeq_epi16(e, al), _mm256_cmpeq_epi16(l, c)));
+		__m256i mr = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi16(e, cr), _mm256_cmpeq_epi16(r, a)), _mm256_andnot_si256(_mm256_cmpeq_epi16(e, ar), _mm256_cmpeq_epi16(r, c)));
+		__m256i d0 = _mm256_blendv_epi8(e, l, _mm256_andnot_si256(skip, ml));
+		__m256i d2 = _mm256_blendv_epi8(e, r, _mm256_andnot_si256(skip, mr));
+
+		scale3x_16_avx2_store(dst + 3 * i, d0, e, d2);
+	}
+
+	/* remaining pixels */
+	for (; i < count; ++i)
+		scale3x_16_avx2_center_pixel(dst + 3 * i, src0, src1, src2, i, count);
+}
+
+static void scale3x_32_avx2_border(scale3x_uint32* restrict dst, const scale3x_uint32* restrict src0, const scale3x_uint32* restrict src1, const scale3x_uint32* restrict src2, unsigned count)
+{
+	unsigned i;
+
+	assert(count >= 2);
+
+	/* first pixel */
+	scale3x_32_avx2_border_pixel(dst, src0, src1, src2, 0, count);
+
+	/* central pixels, 8 at time */
+	for (i = 1; i + 9 <= count; i += 8) {
+		__m256i a = scale3x_avx2_load(src0 + i);
+		__m256i c = scale3x_avx2_load(src2 + i);
+		__m256i e = scale3x_avx2_load(src1 + i);
+		__m256i l = scale3x_avx2_load(src1 + i - 1);
+		__m256i r = scale3x_avx2_load(src1 + i + 1);
+		__m256i al = scale3x_avx2_load(src0 + i - 1);
+		__m256i ar = scale3x_avx2_load(src0 + i + 1);
+		__m256i skip = _mm256_or_si256(_mm256_cmpeq_epi32(a, c), _mm256_cmpeq_epi32(l, r));
+		__m256i la = _mm256_cmpeq_epi32(l, a);
+		__m256i ra = _mm256_cmpeq_epi32(r, a);
+		__m256i m1 = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi32(e, ar), la), _mm256_andnot_si256(_mm256_cmpeq_epi32(e, al), ra));
+		__m256i d0 = _mm256_blendv_epi8(e, l, _mm256_andnot_si256(skip, la));
+		__m256i d1 = _mm256_blendv_epi8(e, a, _mm256_andnot_si256(skip, m1));
+		__m256i d2 = _mm256_blendv_epi8(e, r, _mm256_andnot_si256(skip, ra));
+
+		scale3x_32_avx2_store(dst + 3 * i, d0, d1, d2);
+	}
+
+	/* remaining pixels */
+	for (; i < count; ++i)
+		scale3x_32_avx2_border_pixel(dst + 3 * i, src0, src1, src2, i, count);
+}
+
+static void scale3x_32_avx2_center(scale3x_uint32* restrict dst, const scale3x_uint32* restrict src0, const scale3x_uint32* restrict src1, const scale3x_uint32* restrict src2, unsigned count)
+{
+	unsigned i;
+
+	assert(count >= 2);
+
+	/* first pixel */
+	scale3x_32_avx2_center_pixel(dst, src0, src1, src2, 0, count);
+
+	/* central pixels, 8 at time */
+	for (i = 1; i + 9 <= count; i += 8) {
+		__m256i a = scale3x_avx2_load(src0 + i);
+		__m256i c = scale3x_avx2_load(src2 + i);
+		__m256i e = scale3x_avx2_load(src1 + i);
+		__m256i l = scale3x_avx2_load(src1 + i - 1);
+		__m256i r = scale3x_avx2_load(src1 + i + 1);
+		__m256i al = scale3x_avx2_load(src0 + i - 1);
+		__m256i cl = scale3x_avx2_load(src2 + i - 1);
+		__m256i ar = scale3x_avx2_load(src0 + i + 1);
+		__m256i cr = scale3x_avx2_load(src2 + i + 1);
+		__m256i skip = _mm256_or_si256(_mm256_cmpeq_epi32(a, c), _mm256_cmpeq_epi32(l, r));
+		__m256i ml = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi32(e, cl), _mm256_cmpeq_epi32(l, a)), _mm256_andnot_si256(_mm256_cmpeq_epi32(e, al), _mm256_cmpeq_epi32(l, c)));
+		__m256i mr = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi32(e, cr), _mm256_cmpeq_epi32(r, a)), _mm256_andnot_si256(_mm256_cmpeq_epi32(e, ar), _mm256_cmpeq_epi32(r, c)));
+		__m256i d0 = _mm256_blendv_epi8(e, l, _mm256_andnot_si256(skip, ml));
+		__m256i d2 = _mm256_blendv_epi8(e, r, _mm256_andnot_si256(skip, mr));
+
+		scale3x_32_avx2_store(dst + 3 * i, d0, e, d2);
+	}
+
+	/* remaining pixels */
+	for (; i < count; ++i)
+		scale3x_32_avx2_center_pixel(dst + 3 * i, src0, src1, src2, i, count);
+}
+
+/**
+ * Scale by a factor of 3 a row of pixels of 16 bits.
+ * This function operates like scale3x_16_def() but it uses AVX2 instructions.
+ * The CPU must support the AVX2 instruction set.
+ */
+void scale3x_16_avx2(scale3x_uint16* dst0, scale3x_uint16* dst1, scale3x_uint16* dst2, const scale3x_uint16* src0, const scale3x_uint16* src1, const scale3x_uint16* src2, unsigned count)
+{
+	scale3x_16_avx2_border(dst0, src0, src1, src2, count);
+	scale3x_16_avx2_center(dst1, src0, src1, src2, count);
+	scale3x_16_avx2_border(dst2, src2, src1, src0, count);
+}
+
+/**
+ * Scale by a factor of 3 a row of pixels of 32 bits.
+ * This function operates like scale3x_32_def() but it uses AVX2 instructions.
+ * The CPU must support the AVX2 instruction set.
+ */
+void scale3x_32_avx2(scale3x_uint32* dst0, scale3x_uint32* dst1, scale3x_uint32* dst2, const scale3x_uint32* src0, const scale3x_uint32* src1, const scale3x_uint32* src2, unsigned count)
+{
+	scale3x_32_avx2_border(dst0, src0, src1, src2, count);
+	scale3x_32_avx2_center(dst1, src0, src1, src2, count);
+	scale3x_32_avx2_border(dst2, src2, src1, src0, count);
+}
+
+#pragma GCC pop_options
+
+#endif
@@ -290,6 +290,7 @@ soundb_driver soundb_allegro_driver = {
 	soundb_allegro_buffered,
 	soundb_allegro_start,
 	soundb_allegro_stop,
-	soundb_allegro_volume
+	soundb_allegro_volume,
+	0
 };
 
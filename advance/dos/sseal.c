@@ -442,6 +442,7 @@ soundb_driver soundb_seal_driver = {
 	soundb_seal_buffered,
 	soundb_seal_start,
 	soundb_seal_stop,
-	soundb_seal_volume
+	soundb_seal_volume,
+	0
 };
 
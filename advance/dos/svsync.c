@@ -192,6 +192,7 @@ soundb_driver soundb_vsync_driver = {
 	soundb_vsync_buffered,
 	soundb_vsync_start,
 	soundb_vsync_stop,
-	soundb_vsync_volume
+	soundb_vsync_volume,
+	0
 };
 
@@ -46,8 +46,12 @@ ADVANCEOBJS += \
 ifeq ($(CONF_LIB_PTHREAD),yes)
 CFLAGS += -D_REENTRANT
 ADVANCECFLAGS += -DUSE_SMP
+ifeq ($(CONF_CPUPARALLEL),yes)
+# the memory and CPU state of the core is private of the thread running the parallel CPU
+EMUCFLAGS += -DUSE_THREAD_LOCAL
+endif
 ADVANCELIBS += -lpthread
-ADVANCEOBJS += $(OBJ)/advance/osd/thdouble.o
+ADVANCEOBJS += $(OBJ)/advance/osd/thpool.o
 else
 ADVANCEOBJS += $(OBJ)/advance/osd/thmono.o
 endif
@@ -280,7 +284,7 @@ CFLAGS += -D_REENTRANT
 ADVANCECFLAGS += -DUSE_SMP
 # pthread-win32 library without exceptions management
 ADVANCELIBS += -lpthread
-ADVANCEOBJS += $(OBJ)/advance/osd/thdouble.o
+ADVANCEOBJS += $(OBJ)/advance/osd/thpool.o
 else
 ADVANCEOBJS += $(OBJ)/advance/osd/thmono.o
 endif
@@ -438,6 +442,7 @@ ADVANCEOBJS += \
 	$(OBJ)/advance/osd/menu.o \
 	$(OBJ)/advance/osd/estimate.o \
 	$(OBJ)/advance/osd/record.o \
+	$(OBJ)/advance/osd/trace.o \
 	$(OBJ)/advance/osd/sound.o \
 	$(OBJ)/advance/osd/input.o \
 	$(OBJ)/advance/osd/lexyy.o \
@@ -478,6 +483,7 @@ ADVANCEOBJS += \
 	$(OBJ)/advance/lib/bitmap.o \
 	$(OBJ)/advance/lib/filter.o \
 	$(OBJ)/advance/lib/dft.o \
+	$(OBJ)/advance/lib/soundfx.o \
 	$(OBJ)/advance/lib/complex.o \
 	$(OBJ)/advance/lib/png.o \
 	$(OBJ)/advance/lib/pngdef.o \
@@ -517,7 +523,11 @@ EMUCHDMANOBJS += \
 	$(OBJ)/chdcd.o \
 	$(OBJ)/sha1.o \
 	$(OBJ)/md5.o \
-	$(OBJ)/version.o
+	$(OBJ)/version.o \
+	$(OBJ)/advance/osd/tool.o
+ifeq ($(CONF_LIB_PTHREAD),yes)
+EMUCHDMANLDFLAGS += -lpthread
+endif
 
 ############################################################################
 # expat
@@ -47,25 +47,36 @@
  */
 #define ERROR_DESC_MAX 2048
 
+/**
+ * Storage of the error state.
+ * With USE_ERROR_THREAD every thread has its own error state, and
+ * the errors of a background thread don't overwrite the ones of the main thread.
+ */
+#ifdef USE_ERROR_THREAD
+#define ERROR_LOCAL __thread
+#else
+#define ERROR_LOCAL
+#endif
+
 /**
  * Last error description.
  */
-static char error_desc_buffer[ERROR_DESC_MAX];
+static ERROR_LOCAL char error_desc_buffer[ERROR_DESC_MAX];
 
 /**
  * Flag set if an unsupported feature is found.
  */
-static adv_bool error_unsupported_flag;
+static ERROR_LOCAL adv_bool error_unsupported_flag;
 
 /**
  * Flag for cat mode.
  */
-static adv_bool error_cat_flag;
+static ERROR_LOCAL adv_bool error_cat_flag;
 
 /**
  * Prefix for cat mode.
  */
-static char error_cat_prefix_buffer[ERROR_DESC_MAX];
+static ERROR_LOCAL char error_cat_prefix_buffer[ERROR_DESC_MAX];
 
 /**
  * Set the error cat mode.
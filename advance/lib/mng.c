@@ -899,6 +899,9 @@ adv_error adv_mng_write_mhdr(
 		| (1 << 6); /* Enable flags */
 	if (is_lc)
 		simplicity |= (1 << 1); /* Basic features */
+	else
+		simplicity |= (1 << 1) /* Basic features */
+			| (1 << 5); /* Delta-PNG */
 
 	memset(mhdr, 0, 28);
 	be_uint32_write(mhdr, pix_width);
@@ -920,6 +923,20 @@ adv_error adv_mng_write_mend(adv_fz* f, unsigned* count)
 	return 0;
 }
 
+adv_error adv_mng_write_defi(unsigned id, adv_fz* f, unsigned* count)
+{
+	uint8 defi[4];
+
+	be_uint16_write(defi, id); /* Object id */
+	defi[2] = 0; /* Visible */
+	defi[3] = 1; /* Concrete */
+
+	if (adv_png_write_chunk(f, ADV_MNG_CN_DEFI, defi, 4, count) != 0)
+		return -1;
+
+	return 0;
+}
+
 adv_error adv_mng_write_fram(unsigned tick, adv_fz* f, unsigned* count)
 {
 	uint8 fram[10];
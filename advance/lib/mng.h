@@ -94,6 +94,7 @@ adv_error adv_mng_write_mhdr(
 	adv_fz* f, unsigned* count
 );
 adv_error adv_mng_write_mend(adv_fz* f, unsigned* count);
+adv_error adv_mng_write_defi(unsigned id, adv_fz* f, unsigned* count);
 adv_error adv_mng_write_fram(unsigned tick, adv_fz* f, unsigned* count);
 
 /** \addtogroup VideoFile */
@@ -34,6 +34,12 @@
 #include "endianrw.h"
 #include "error.h"
 
+/* SSE2 code, always available on x86_64 */
+#if defined(__SSE2__)
+#define USE_PNG_SSE2
+#include <emmintrin.h>
+#endif
+
 /**************************************************************************************/
 /* PNG */
 
@@ -262,6 +268,223 @@ void adv_png_expand_1(unsigned width, unsigned height, unsigned char* ptr)
 	}
 }
 
+/*
+ * Unfilter of a single row.
+ * The Up filter doesn't depend on the previous pixel, and it's vectorized
+ * by the compiler. The Sub, Average and Paeth filters depend on the
+ * previous pixel. The Paeth filter, and the Average filter of the 32 bit
+ * images, process a whole pixel at time in a SSE2 register. The Sub filter
+ * stays in C, at 32 bit the compiler already adds a whole pixel at time
+ * in a vector register, and a SSE2 version wasn't faster. For the 8 bit
+ * images there is nothing to process in parallel. The row functions are
+ * inlined to get the pixel size as a constant.
+ * The u pointer is the previous row, or 0 for the first row.
+ */
+
+#if defined(USE_PNG_SSE2)
+
+static inline __m128i png_sse2_load(const unsigned char* p, unsigned bpp)
+{
+	uint32 v;
+
+	/* don't read over the end of the image */
+	if (bpp == 3)
+		v = p[0] | (unsigned)p[1] << 8 | (unsigned)p[2] << 16;
+	else
+		memcpy(&v, p, 4);
+
+	return _mm_cvtsi32_si128(v);
+}
+
+static inline void png_sse2_store(unsigned char* p, __m128i x, unsigned bpp)
+{
+	uint32 v = _mm_cvtsi128_si32(x);
+
+	if (bpp == 3) {
+		p[0] = v;
+		p[1] = v >> 8;
+		p[2] = v >> 16;
+	} else {
+		memcpy(p, &v, 4);
+	}
+}
+
+static inline void png_sse2_average(unsigned char* p, const unsigned char* u, unsigned width, unsigned bpp)
+{
+	__m128i one = _mm_set1_epi8(1);
+	__m128i a = _mm_setzero_si128();
+	unsigned j;
+
+	for (j = 0; j < width; j += bpp) {
+		__m128i b = png_sse2_load(u + j, bpp);
+		/* _mm_avg_epu8() rounds up, PNG rounds down */
+		__m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+		a = _mm_add_epi8(png_sse2_load(p + j, bpp), avg);
+		png_sse2_store(p + j, a, bpp);
+	}
+}
+
+static inline __m128i png_sse2_abs16(__m128i x)
+{
+	return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+static inline __m128i png_sse2_select(__m128i mask, __m128i x, __m128i y)
+{
+	return _mm_or_si128(_mm_and_si128(mask, x), _mm_andnot_si128(mask, y));
+}
+
+static inline void png_sse2_paeth(unsigned char* p, const unsigned char* u, unsigned width, unsigned bpp)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i mask = _mm_set1_epi16(0xFF);
+	__m128i a = zero;
+	__m128i c = zero;
+	unsigned j;
+
+	/* computed with 16 bit lanes */
+	for (j = 0; j < width; j += bpp) {
+		__m128i b = _mm_unpacklo_epi8(png_sse2_load(u + j, bpp), zero);
+		__m128i x = _mm_unpacklo_epi8(png_sse2_load(p + j, bpp), zero);
+		__m128i pa = _mm_sub_epi16(b, c); /* p - a, with p = a + b - c */
+		__m128i pb = _mm_sub_epi16(a, c); /* p - b */
+		__m128i pc = _mm_add_epi16(pa, pb); /* p - c */
+		__m128i smallest;
+		__m128i nearest;
+
+		pa = png_sse2_abs16(pa);
+		pb = png_sse2_abs16(pb);
+		pc = png_sse2_abs16(pc);
+
+		smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+		/* the same precedence of the C code, a, b and then c */
+		nearest = png_sse2_select(_mm_cmpeq_epi16(smallest, pa), a, png_sse2_select(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+		a = _mm_and_si128(_mm_add_epi16(x, nearest), mask);
+		png_sse2_store(p + j, _mm_packus_epi16(a, a), bpp);
+
+		c = b;
+	}
+}
+#endif
+
+static inline void png_unfilter_sub(unsigned char* p, unsigned width, unsigned bpp)
+{
+	unsigned j;
+
+	for (j = bpp; j < width; ++j)
+		p[j] += p[j - bpp];
+}
+
+static inline void png_unfilter_up(unsigned char* restrict p, const unsigned char* restrict u, unsigned width)
+{
+	unsigned j;
+
+	if (!u)
+		return;
+
+	/* vectorized by the compiler */
+	for (j = 0; j < width; ++j)
+		p[j] += u[j];
+}
+
+static inline void png_unfilter_average(unsigned char* p, const unsigned char* u, unsigned width, unsigned bpp)
+{
+	unsigned j;
+
+	if (!u) {
+		for (j = bpp; j < width; ++j)
+			p[j] += p[j - bpp] / 2;
+		return;
+	}
+
+#if defined(USE_PNG_SSE2)
+	if (bpp == 4) {
+		png_sse2_average(p, u, width, 4);
+		return;
+	}
+#endif
+
+	for (j = 0; j < bpp; ++j)
+		p[j] += u[j] / 2;
+	for (; j < width; ++j) {
+		unsigned a = (unsigned)u[j] + (unsigned)p[j - bpp];
+		p[j] += a >> 1;
+	}
+}
+
+static inline void png_unfilter_paeth(unsigned char* p, const unsigned char* u, unsigned width, unsigned bpp)
+{
+	unsigned j;
+
+	/* in the first row the predictor is always the left pixel */
+	if (!u) {
+		png_unfilter_sub(p, width, bpp);
+		return;
+	}
+
+#if defined(USE_PNG_SSE2)
+	if (bpp == 3) {
+		png_sse2_paeth(p, u, width, 3);
+		return;
+	}
+	if (bpp == 4) {
+		png_sse2_paeth(p, u, width, 4);
+		return;
+	}
+#endif
+
+	/* in the first pixel the predictor is always the up pixel */
+	for (j = 0; j < bpp; ++j)
+		p[j] += u[j];
+
+	for (; j < width; ++j) {
+		int a, b, c;
+		int v;
+		int da, db, dc;
+		a = p[j - bpp];
+		b = u[j];
+		c = u[j - bpp];
+		v = a + b - c;
+		da = v - a;
+		if (da < 0)
+			da = -da;
+		db = v - b;
+		if (db < 0)
+			db = -db;
+		dc = v - c;
+		if (dc < 0)
+			dc = -dc;
+		if (da <= db && da <= dc)
+			p[j] += a;
+		else if (db <= dc)
+			p[j] += b;
+		else
+			p[j] += c;
+	}
+}
+
+static inline void png_unfilter(unsigned width, unsigned height, unsigned char* p, unsigned line, unsigned bpp)
+{
+	unsigned i;
+
+	for (i = 0; i < height; ++i) {
+		unsigned char f = p[0];
+		unsigned char* d = p + 1;
+		const unsigned char* u = i != 0 ? d - line : 0;
+
+		switch (f) {
+		case 1 : png_unfilter_sub(d, width, bpp); break;
+		case 2 : png_unfilter_up(d, u, width); break;
+		case 3 : png_unfilter_average(d, u, width, bpp); break;
+		case 4 : png_unfilter_paeth(d, u, width, bpp); break;
+		}
+
+		p += line;
+	}
+}
+
 /**
  * Unfilter a 8 bit image.
  * \param width With of the image.
@@ -271,81 +494,7 @@ void adv_png_expand_1(unsigned width, unsigned height, unsigned char* ptr)
  */
 void adv_png_unfilter_8(unsigned width, unsigned height, unsigned char* p, unsigned line)
 {
-	unsigned i, j;
-
-	for (i = 0; i < height; ++i) {
-		unsigned char f = *p++;
-
-		if (f == 0) { /* none */
-			p += width;
-		} else if (f == 1) { /* sub */
-			++p;
-			for (j = 1; j < width; ++j) {
-				p[0] += p[-1];
-				++p;
-			}
-		} else if (f == 2) { /* up */
-			if (i) {
-				unsigned char* u = p - line;
-				for (j = 0; j < width; ++j) {
-					*p += *u;
-					++p;
-					++u;
-				}
-			} else {
-				p += width;
-			}
-		} else if (f == 3) { /* average */
-			if (i) {
-				unsigned char* u = p - line;
-				p[0] += u[0] / 2;
-				++p;
-				++u;
-				for (j = 1; j < width; ++j) {
-					unsigned a = (unsigned)u[0] + (unsigned)p[-1];
-					p[0] += a >> 1;
-					++p;
-					++u;
-				}
-			} else {
-				++p;
-				for (j = 1; j < width; ++j) {
-					p[0] += p[-1] / 2;
-					++p;
-				}
-			}
-		} else if (f == 4) { /* paeth */
-			unsigned char* u = p - line;
-			for (j = 0; j < width; ++j) {
-				unsigned a, b, c;
-				int v;
-				int da, db, dc;
-				a = j < 1 ? 0 : p[-1];
-				b = i < 1 ? 0 : u[0];
-				c = (j < 1 || i < 1) ? 0 : u[-1];
-				v = a + b - c;
-				da = v - a;
-				if (da < 0)
-					da = -da;
-				db = v - b;
-				if (db < 0)
-					db = -db;
-				dc = v - c;
-				if (dc < 0)
-					dc = -dc;
-				if (da <= db && da <= dc)
-					p[0] += a;
-				else if (db <= dc)
-					p[0] += b;
-				else
-					p[0] += c;
-				++p;
-				++u;
-			}
-		}
-
-		p += line - width - 1;
-	}
+	png_unfilter(width, height, p, line, 1);
 }
 
 /**
@@ -357,83 +506,7 @@ void adv_png_unfilter_8(unsigned width, unsigned height, unsigned char* p, unsig
  */
 void adv_png_unfilter_24(unsigned width, unsigned height, unsigned char* p, unsigned line)
 {
-	unsigned i, j;
-
-	for (i = 0; i < height; ++i) {
-		unsigned char f = *p++;
-
-		if (f == 0) { /* none */
-			p += width;
-		} else if (f == 1) { /* sub */
-			p += 3;
-			for (j = 3; j < width; ++j) {
-				p[0] += p[-3];
-				++p;
-			}
-		} else if (f == 2) { /* up */
-			if (i) {
-				unsigned char* u = p - line;
-				for (j = 0; j < width; ++j) {
-					*p += *u;
-					++p;
-					++u;
-				}
-			} else {
-				p += width;
-			}
-		} else if (f == 3) { /* average */
-			if (i) {
-				unsigned char* u = p - line;
-				p[0] += u[0] / 2;
-				p[1] += u[1] / 2;
-				p[2] += u[2] / 2;
-				p += 3;
-				u += 3;
-				for (j = 3; j < width; ++j) {
-					unsigned a = (unsigned)u[0] + (unsigned)p[-3];
-					p[0] += a >> 1;
-					++p;
-					++u;
-				}
-			} else {
-				p += 3;
-				for (j = 3; j < width; ++j) {
-					p[0] += p[-3] / 2;
-					++p;
-				}
-			}
-		} else if (f == 4) { /* paeth */
-			unsigned char* u = p - line;
-			for (j = 0; j < width; ++j) {
-				unsigned a, b, c;
-				int v;
-				int da, db, dc;
-				a = j < 3 ? 0 : p[-3];
-				b = i < 1 ? 0 : u[0];
-				c = (j < 3 || i < 1) ? 0 : u[-3];
-				v = a + b - c;
-				da = v - a;
-				if (da < 0)
-					da = -da;
-				db = v - b;
-				if (db < 0)
-					db = -db;
-				dc = v - c;
-				if (dc < 0)
-					dc = -dc;
-				if (da <= db && da <= dc)
-					p[0] += a;
-				else if (db <= dc)
-					p[0] += b;
-				else
-					p[0] += c;
-				++p;
-				++u;
-			}
-		}
-
-		p += line - width - 1;
-	}
+	png_unfilter(width, height, p, line, 3);
 }
 
 /**
@@ -445,84 +518,7 @@ void adv_png_unfilter_24(unsigned width, unsigned height, unsigned char* p, unsi
  */
 void adv_png_unfilter_32(unsigned width, unsigned height, unsigned char* p, unsigned line)
 {
-	unsigned i, j;
-
-	for (i = 0; i < height; ++i) {
-		unsigned char f = *p++;
-
-		if (f == 0) { /* none */
-			p += width;
-		} else if (f == 1) { /* sub */
-			p += 4;
-			for (j = 4; j < width; ++j) {
-				p[0] += p[-4];
-				++p;
-			}
-		} else if (f == 2) { /* up */
-			if (i) {
-				unsigned char* u = p - line;
-				for (j = 0; j < width; ++j) {
-					*p += *u;
-					++p;
-					++u;
-				}
-			} else {
-				p += width;
-			}
-		} else if (f == 3) { /* average */
-			if (i) {
-				unsigned char* u = p - line;
-				p[0] += u[0] / 2;
-				p[1] += u[1] / 2;
-				p[2] += u[2] / 2;
-				p[3] += u[3] / 2;
-				p += 4;
-				u += 4;
-				for (j = 4; j < width; ++j) {
-					unsigned a = (unsigned)u[0] + (unsigned)p[-4];
-					p[0] += a >> 1;
-					++p;
-					++u;
-				}
-			} else {
-				p += 4;
-				for (j = 4; j < width; ++j) {
-					p[0] += p[-4] / 2;
-					++p;
-				}
-			}
-		} else if (f == 4) { /* paeth */
-			unsigned char* u = p - line;
-			for (j = 0; j < width; ++j) {
-				unsigned a, b, c;
-				int v;
-				int da, db, dc;
-				a = j < 4 ? 0 : p[-4];
-				b = i < 1 ? 0 : u[0];
-				c = (j < 4 || i < 1) ? 0 : u[-4];
-				v = a + b - c;
-				da = v - a;
-				if (da < 0)
-					da = -da;
-				db = v - b;
-				if (db < 0)
-					db = -db;
-				dc = v - c;
-				if (dc < 0)
-					dc = -dc;
-				if (da <= db && da <= dc)
-					p[0] += a;
-				else if (db <= dc)
-					p[0] += b;
-				else
-					p[0] += c;
-				++p;
-				++u;
-			}
-		}
-
-		p += line - width - 1;
-	}
+	png_unfilter(width, height, p, line, 4);
 }
 
 /**
@@ -944,8 +940,91 @@ adv_error adv_png_write_iend(adv_fz* f, unsigned* count)
 	return 0;
 }
 
+/**
+ * Paeth predictor.
+ */
+static inline int png_paeth(int a, int b, int c)
+{
+	int v = a + b - c;
+	int da = v - a;
+	int db = v - b;
+	int dc = v - c;
+
+	if (da < 0)
+		da = -da;
+	if (db < 0)
+		db = -db;
+	if (dc < 0)
+		dc = -dc;
+
+	if (da <= db && da <= dc)
+		return a;
+	else if (db <= dc)
+		return b;
+	else
+		return c;
+}
+
+/**
+ * Filter a row.
+ * The filter is selected with the minimum sum of absolute differences
+ * heuristic suggested by the PNG specification.
+ * \param d Destination of the filtered row.
+ * \param p Row to filter.
+ * \param u Previous row, or 0 for the first row.
+ * \param width Size of the row in bytes.
+ * \param bpp Bytes per pixel.
+ * \return The filter type.
+ */
+static unsigned char png_filter_row(unsigned char* d, const unsigned char* p, const unsigned char* u, unsigned width, unsigned bpp)
+{
+	unsigned sum[5];
+	unsigned best;
+	unsigned j, k;
+
+	for (k = 0; k < 5; ++k)
+		sum[k] = 0;
+
+	for (j = 0; j < width; ++j) {
+		int a = j >= bpp ? p[j - bpp] : 0;
+		int b = u ? u[j] : 0;
+		int c = u && j >= bpp ? u[j - bpp] : 0;
+		int x = p[j];
+
+		sum[0] += abs((signed char)x);
+		sum[1] += abs((signed char)(x - a));
+		sum[2] += abs((signed char)(x - b));
+		sum[3] += abs((signed char)(x - ((a + b) >> 1)));
+		sum[4] += abs((signed char)(x - png_paeth(a, b, c)));
+	}
+
+	best = 0;
+	for (k = 1; k < 5; ++k)
+		if (sum[k] < sum[best])
+			best = k;
+
+	for (j = 0; j < width; ++j) {
+		int a = j >= bpp ? p[j - bpp] : 0;
+		int b = u ? u[j] : 0;
+		int c = u && j >= bpp ? u[j - bpp] : 0;
+
+		switch (best) {
+		case 0 : d[j] = p[j]; break;
+		case 1 : d[j] = p[j] - a; break;
+		case 2 : d[j] = p[j] - b; break;
+		case 3 : d[j] = p[j] - ((a + b) >> 1); break;
+		case 4 : d[j] = p[j] - png_paeth(a, b, c); break;
+		}
+	}
+
+	return best;
+}
+
 /**
  * Write the PNG IDAT chunk.
+ * The 24 and 32 bit images select the filter of every row, the palette
+ * images are not filtered as suggested by the PNG specification.
+ * \param fast Use a fast compression and no filter.
  * \param f File to write.
  * \param count Pointer at the incremental counter of bytes written. Use 0 for disabling it.
  */
@@ -957,28 +1036,41 @@ adv_error adv_png_write_idat(
 {
 	uint8* z_ptr;
 	uint8* r_ptr;
+	uint8* f_ptr;
 	unsigned char filter;
 	unsigned long z_size;
 	unsigned res_size;
+	unsigned row_size;
 	const uint8* p;
+	const uint8* u;
 	unsigned i;
 	int method;
 	z_stream z;
 	int r;
 
 	z_size = pix_height * (pix_width * (pix_pixel + 1)) * 103 / 100 + 12;
+	row_size = pix_width * pix_pixel;
 
+	/* two rows, the current and the previous one */
 	if (pix_pixel_pitch != pix_pixel) {
-		r_ptr = (uint8*)malloc(pix_width * pix_pixel);
+		r_ptr = (uint8*)malloc(2 * row_size);
 		if (!r_ptr)
 			goto err;
 	} else {
 		r_ptr = 0;
 	}
 
+	if (!fast && pix_pixel >= 3) {
+		f_ptr = (uint8*)malloc(row_size);
+		if (!f_ptr)
+			goto err_row;
+	} else {
+		f_ptr = 0;
+	}
+
 	z_ptr = (uint8*)malloc(z_size);
 	if (!z_ptr)
-		goto err_row;
+		goto err_filter;
 
 	if (fast)
 		method = Z_BEST_SPEED;
@@ -993,22 +1085,16 @@ adv_error adv_png_write_idat(
 	z.avail_in = 0;
 
 	p = pix_ptr;
+	u = 0;
 	filter = 0;
 
 	r = deflateInit(&z, method);
 
 	for (i = 0; i < pix_height; ++i) {
-		z.next_in = &filter; /* filter byte */
-		z.avail_in = 1;
-
-		r = deflate(&z, Z_NO_FLUSH);
-		if (r != Z_OK) {
-			error_set("Error compressing data");
-			goto err_free;
-		}
+		const uint8* row;
 
 		if (r_ptr) {
-			unsigned char* r = r_ptr;
+			unsigned char* r = r_ptr + (i % 2) * row_size;
 			unsigned j;
 			for (j = 0; j < pix_width; ++j) {
 				unsigned k;
@@ -1017,15 +1103,31 @@ adv_error adv_png_write_idat(
 				}
 				p += pix_pixel_pitch - pix_pixel;
 			}
-			z.next_in = r_ptr; /* pixel data */
-			z.avail_in = pix_width * pix_pixel;
-			p += pix_scanline_pitch - pix_width * pix_pixel_pitch;
+			row = r_ptr + (i % 2) * row_size;
+			p += pix_scanline_pitch - (int)pix_width * pix_pixel_pitch;
 		} else {
-			z.next_in = (uint8*)p; /* pixel data */
-			z.avail_in = pix_width * pix_pixel;
+			row = p;
 			p += pix_scanline_pitch;
 		}
 
+		if (f_ptr) {
+			filter = png_filter_row(f_ptr, row, u, row_size, pix_pixel);
+			u = row;
+			row = f_ptr;
+		}
+
+		z.next_in = &filter; /* filter byte */
+		z.avail_in = 1;
+
+		r = deflate(&z, Z_NO_FLUSH);
+		if (r != Z_OK) {
+			error_set("Error compressing data");
+			goto err_free;
+		}
+
+		z.next_in = (uint8*)row; /* pixel data */
+		z.avail_in = row_size;
+
 		r = deflate(&z, Z_NO_FLUSH);
 		if (r != Z_OK) {
 			error_set("Error compressing data");
@@ -1051,6 +1153,8 @@ adv_error adv_png_write_idat(
 		goto err_free;
 
 	free(z_ptr);
+	if (f_ptr)
+		free(f_ptr);
 	if (r_ptr)
 		free(r_ptr);
 
@@ -1058,6 +1162,9 @@ adv_error adv_png_write_idat(
 
 err_free:
 	free(z_ptr);
+err_filter:
+	if (f_ptr)
+		free(f_ptr);
 err_row:
 	if (r_ptr)
 		free(r_ptr);
@@ -68,153 +68,168 @@ adv_bool adv_png_color_def_is_valid(adv_color_def def)
 	return def == adv_png_color_def(pixel);
 }
 
-static adv_error png_write_raw_pal(
-	unsigned pix_width, unsigned pix_height, unsigned pix_pixel,
-	const unsigned char* pix_ptr, int pix_pixel_pitch, int pix_scanline_pitch,
-	adv_color_rgb* rgb_ptr, unsigned rgb_max,
-	adv_bool fast,
-	adv_fz* f, unsigned* count
-)
+/**
+ * Get the bytes per pixel of an image converted in a format supported by PNG.
+ * \param pix_def Image color definition.
+ * \param rgb_max Palette size in number of colors. Use 0 for RGB image.
+ * \return The bytes per pixel, 1, 3 or 4, or 0 if the format is not supported.
+ */
+unsigned adv_png_convert_pixel_get(adv_color_def pix_def, unsigned rgb_max)
 {
-	uint8 palette[3 * 256];
-	uint8* i_ptr;
-	unsigned i_size;
-	uint8* p;
-	unsigned i, j;
-
-	if (rgb_max > 256)
-		goto err;
-
-	for (i = 0; i < rgb_max; ++i) {
-		palette[i * 3] = rgb_ptr[i].red;
-		palette[i * 3 + 1] = rgb_ptr[i].green;
-		palette[i * 3 + 2] = rgb_ptr[i].blue;
-	}
+	adv_color_type type = color_def_type_get(pix_def);
 
-	i_size = pix_height * pix_width;
-	i_ptr = malloc(i_size);
-	if (!i_ptr)
-		goto err;
-
-	p = i_ptr;
-	for (i = 0; i < pix_height; ++i) {
-		for (j = 0; j < pix_width; ++j) {
-			adv_pixel pixel;
-
-			pixel = cpu_uint_read(pix_ptr, pix_pixel);
-
-			p[0] = pixel;
-
-			p += 1;
-			pix_ptr += pix_pixel_pitch;
-		}
-		pix_ptr += pix_scanline_pitch - pix_pixel_pitch * pix_width;
-	}
-
-	if (adv_png_write_raw(pix_width, pix_height, 1, i_ptr, 1, 1 * pix_width, palette, rgb_max * 3, 0, 0, fast, f, count) != 0) {
-		goto err_free;
+	if (type == adv_color_type_palette) {
+		if (rgb_max <= 256)
+			return 1;
+		else
+			return 3; /* convert from palette to 24 bit rgb */
+	} else if (type == adv_color_type_rgb) {
+		if (adv_png_color_def_is_valid(pix_def))
+			return color_def_bytes_per_pixel_get(pix_def);
+		else
+			return 3; /* convert from generic rgb to 24 bit rgb */
+	} else {
+		return 0;
 	}
-
-	free(i_ptr);
-	return 0;
-
-err_free:
-	free(i_ptr);
-err:
-	return -1;
 }
 
-static adv_error png_write_raw_paltorgb(
-	unsigned pix_width, unsigned pix_height, unsigned pix_pixel,
+/**
+ * Convert an image in a format supported by PNG.
+ * The image must have a format supported by adv_png_convert_pixel_get().
+ * \param pix_width Image width.
+ * \param pix_height Image height.
+ * \param pix_def Image color definition.
+ * \param pix_ptr Pointer at the start of the image data.
+ * \param pix_pixel_pitch Pitch for the next pixel.
+ * \param pix_scanline_pitch Pitch for the next scanline.
+ * \param rgb_ptr Palette data pointer. Use 0 for RGB image.
+ * \param rgb_max Palette size in number of colors. Use 0 for RGB image.
+ * \param dst_ptr Destination of pix_height * (pix_width * adv_png_convert_pixel_get() + dst_filter) bytes.
+ * \param dst_filter If a zero filter byte is stored at the start of every row, like in the PNG raw data.
+ * \param pal_ptr Destination of the palette, of 3 * 256 bytes.
+ * \param pal_size Where to store the size of the palette in bytes. 0 for RGB image.
+ */
+void adv_png_convert_def(
+	unsigned pix_width, unsigned pix_height, adv_color_def pix_def,
 	const unsigned char* pix_ptr, int pix_pixel_pitch, int pix_scanline_pitch,
 	adv_color_rgb* rgb_ptr, unsigned rgb_max,
-	adv_bool fast,
-	adv_fz* f, unsigned* count)
+	unsigned char* dst_ptr, adv_bool dst_filter,
+	unsigned char* pal_ptr, unsigned* pal_size)
 {
-	uint8* i_ptr;
-	unsigned i_size;
+	enum { convert_pal, convert_paltorgb, convert_copy, convert_rgb } mode;
+	adv_color_type type = color_def_type_get(pix_def);
+	unsigned pix_pixel = color_def_bytes_per_pixel_get(pix_def);
+	union adv_color_def_union def;
+	int red_shift = 0, green_shift = 0, blue_shift = 0;
+	unsigned red_mask = 0, green_mask = 0, blue_mask = 0;
 	uint8* p;
 	unsigned i, j;
 
-	i_size = pix_height * (pix_width * 3);
-	i_ptr = malloc(i_size);
-	if (!i_ptr)
-		goto err;
-
-	p = i_ptr;
-	for (i = 0; i < pix_height; ++i) {
-		for (j = 0; j < pix_width; ++j) {
-			adv_pixel pixel;
-
-			pixel = cpu_uint_read(pix_ptr, pix_pixel);
-
-			p[0] = rgb_ptr[pixel].red;
-			p[1] = rgb_ptr[pixel].green;
-			p[2] = rgb_ptr[pixel].blue;
+	*pal_size = 0;
 
-			p += 3;
-			pix_ptr += pix_pixel_pitch;
+	if (type == adv_color_type_palette) {
+		if (rgb_max <= 256) {
+			mode = convert_pal;
+			for (i = 0; i < rgb_max; ++i) {
+				pal_ptr[i * 3] = rgb_ptr[i].red;
+				pal_ptr[i * 3 + 1] = rgb_ptr[i].green;
+				pal_ptr[i * 3 + 2] = rgb_ptr[i].blue;
+			}
+			*pal_size = rgb_max * 3;
+		} else {
+			mode = convert_paltorgb;
 		}
-		pix_ptr += pix_scanline_pitch - pix_pixel_pitch * pix_width;
-	}
-
-	if (adv_png_write_raw(pix_width, pix_height, 3, i_ptr, 3, 3 * pix_width, 0, 0, 0, 0, fast, f, count) != 0) {
-		goto err_free;
+	} else if (adv_png_color_def_is_valid(pix_def)) {
+		mode = convert_copy;
+	} else {
+		mode = convert_rgb;
+		def.ordinal = pix_def;
+		rgb_shiftmask_get(&red_shift, &red_mask, def.nibble.red_len, def.nibble.red_pos);
+		rgb_shiftmask_get(&green_shift, &green_mask, def.nibble.green_len, def.nibble.green_pos);
+		rgb_shiftmask_get(&blue_shift, &blue_mask, def.nibble.blue_len, def.nibble.blue_pos);
 	}
 
-	free(i_ptr);
-	return 0;
+	p = dst_ptr;
+	for (i = 0; i < pix_height; ++i) {
+		const uint8* s = pix_ptr;
+
+		if (dst_filter)
+			*p++ = 0; /* filter byte */
+
+		switch (mode) {
+		case convert_pal :
+			for (j = 0; j < pix_width; ++j) {
+				p[0] = cpu_uint_read(s, pix_pixel);
+				p += 1;
+				s += pix_pixel_pitch;
+			}
+			break;
+		case convert_paltorgb :
+			for (j = 0; j < pix_width; ++j) {
+				adv_pixel pixel = cpu_uint_read(s, pix_pixel);
+				p[0] = rgb_ptr[pixel].red;
+				p[1] = rgb_ptr[pixel].green;
+				p[2] = rgb_ptr[pixel].blue;
+				p += 3;
+				s += pix_pixel_pitch;
+			}
+			break;
+		case convert_copy :
+			if (pix_pixel_pitch == (int)pix_pixel) {
+				memcpy(p, s, pix_width * pix_pixel);
+				p += pix_width * pix_pixel;
+			} else {
+				for (j = 0; j < pix_width; ++j) {
+					memcpy(p, s, pix_pixel);
+					p += pix_pixel;
+					s += pix_pixel_pitch;
+				}
+			}
+			break;
+		case convert_rgb :
+			for (j = 0; j < pix_width; ++j) {
+				adv_pixel pixel = cpu_uint_read(s, pix_pixel);
+				p[0] = rgb_nibble_extract(pixel, red_shift, red_mask);
+				p[1] = rgb_nibble_extract(pixel, green_shift, green_mask);
+				p[2] = rgb_nibble_extract(pixel, blue_shift, blue_mask);
+				p += 3;
+				s += pix_pixel_pitch;
+			}
+			break;
+		}
 
-err_free:
-	free(i_ptr);
-err:
-	return -1;
+		pix_ptr += pix_scanline_pitch;
+	}
 }
 
-static adv_error png_write_raw_rgb(
+adv_error adv_png_write_raw_def(
 	unsigned pix_width, unsigned pix_height, adv_color_def pix_def,
 	const unsigned char* pix_ptr, int pix_pixel_pitch, int pix_scanline_pitch,
+	adv_color_rgb* rgb_ptr, unsigned rgb_max,
 	adv_bool fast,
 	adv_fz* f, unsigned* count)
 {
+	uint8 palette[3 * 256];
+	unsigned palette_size;
 	uint8* i_ptr;
-	unsigned i_size;
-	uint8* p;
-	unsigned i, j;
-	unsigned pix_pixel = color_def_bytes_per_pixel_get(pix_def);
-	union adv_color_def_union def;
-	int red_shift, green_shift, blue_shift;
-	unsigned red_mask, green_mask, blue_mask;
+	unsigned pixel;
 
-	i_size = pix_height * (pix_width * 3);
-	i_ptr = (uint8*)malloc(i_size);
-	if (!i_ptr)
+	pixel = adv_png_convert_pixel_get(pix_def, rgb_max);
+	if (!pixel)
 		goto err;
 
-	def.ordinal = pix_def;
-	rgb_shiftmask_get(&red_shift, &red_mask, def.nibble.red_len, def.nibble.red_pos);
-	rgb_shiftmask_get(&green_shift, &green_mask, def.nibble.green_len, def.nibble.green_pos);
-	rgb_shiftmask_get(&blue_shift, &blue_mask, def.nibble.blue_len, def.nibble.blue_pos);
-
-	p = i_ptr;
-	for (i = 0; i < pix_height; ++i) {
-		for (j = 0; j < pix_width; ++j) {
-			adv_pixel pixel;
-
-			pixel = cpu_uint_read(pix_ptr, pix_pixel);
-
-			p[0] = rgb_nibble_extract(pixel, red_shift, red_mask);
-			p[1] = rgb_nibble_extract(pixel, green_shift, green_mask);
-			p[2] = rgb_nibble_extract(pixel, blue_shift, blue_mask);
+	if (color_def_type_get(pix_def) == adv_color_type_rgb && adv_png_color_def_is_valid(pix_def)) {
+		/* write rgb image */
+		return adv_png_write_raw(pix_width, pix_height, pixel, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, 0, 0, 0, 0, fast, f, count);
+	}
 
-			p += 3;
-			pix_ptr += pix_pixel_pitch;
-		}
+	i_ptr = malloc(pix_height * pix_width * pixel);
+	if (!i_ptr)
+		goto err;
 
-		pix_ptr += pix_scanline_pitch - pix_pixel_pitch * pix_width;
-	}
+	adv_png_convert_def(pix_width, pix_height, pix_def, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, rgb_ptr, rgb_max, i_ptr, 0, palette, &palette_size);
 
-	if (adv_png_write_raw(pix_width, pix_height, 3, i_ptr, 3, 3 * pix_width, 0, 0, 0, 0, fast, f, count) != 0) {
+	if (adv_png_write_raw(pix_width, pix_height, pixel, i_ptr, pixel, pixel * pix_width, palette, palette_size, 0, 0, fast, f, count) != 0) {
 		goto err_free;
 	}
 
@@ -227,40 +242,6 @@ err:
 	return -1;
 }
 
-adv_error adv_png_write_raw_def(
-	unsigned pix_width, unsigned pix_height, adv_color_def pix_def,
-	const unsigned char* pix_ptr, int pix_pixel_pitch, int pix_scanline_pitch,
-	adv_color_rgb* rgb_ptr, unsigned rgb_max,
-	adv_bool fast,
-	adv_fz* f, unsigned* count)
-{
-	adv_color_type type;
-	unsigned pixel;
-
-	type = color_def_type_get(pix_def);
-	pixel = color_def_bytes_per_pixel_get(pix_def);
-
-	if (type == adv_color_type_palette) {
-		if (rgb_max <= 256) {
-			/* write palette image */
-			return png_write_raw_pal(pix_width, pix_height, pixel, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, rgb_ptr, rgb_max, fast, f, count);
-		} else {
-			/* convert from palette to 24 bit rgb */
-			return png_write_raw_paltorgb(pix_width, pix_height, pixel, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, rgb_ptr, rgb_max, fast, f, count);
-		}
-	} else if (type == adv_color_type_rgb) {
-		if (adv_png_color_def_is_valid(pix_def)) {
-			/* write rgb image */
-			return adv_png_write_raw(pix_width, pix_height, pixel, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, 0, 0, 0, 0, fast, f, count);
-		} else {
-			/* convert from generic rgb to 24 bit rgb */
-			return png_write_raw_rgb(pix_width, pix_height, pix_def, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, fast, f, count);
-		}
-	} else {
-		return -1;
-	}
-}
-
 /**
  * Save a complete PNG image, eventually converting it.
  * \param pix_width Image width.
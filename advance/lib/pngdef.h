@@ -43,6 +43,15 @@
 extern "C" {
 #endif
 
+unsigned adv_png_convert_pixel_get(adv_color_def pix_def, unsigned rgb_max);
+void adv_png_convert_def(
+	unsigned pix_width, unsigned pix_height, adv_color_def pix_def,
+	const unsigned char* pix_ptr, int pix_pixel_pitch, int pix_scanline_pitch,
+	adv_color_rgb* rgb_ptr, unsigned rgb_max,
+	unsigned char* dst_ptr, adv_bool dst_filter,
+	unsigned char* pal_ptr, unsigned* pal_size
+);
+
 adv_error adv_png_write_raw_def(
 	unsigned pix_width, unsigned pix_height, adv_color_def pix_def,
 	const unsigned char* pix_ptr, int pix_pixel_pitch, int pix_scanline_pitch,
@@ -212,6 +212,12 @@ static inline int rpl_lrint(double x)
 #endif
 #define lrint rpl_lrint
 
+/* AVX2 code compiled with the gcc target pragma and selected at runtime */
+/* Not for Windows, where gcc doesn't align the stack for the AVX registers */
+#if defined(__GNUC__) && (__GNUC__ >= 5) && (defined(__x86_64__) || defined(__i386__)) && !defined(__MSDOS__) && !defined(__WIN32__)
+#define USE_BLIT_AVX2
+#endif
+
 /* 64 bit IO */
 #ifdef __WIN32__
 #define off_t off64_t /* This must be after including stdio.h */
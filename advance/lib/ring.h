@@ -0,0 +1,169 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2017 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * In addition, as a special exception, Andrea Mazzoleni
+ * gives permission to link the code of this program with
+ * the MAME library (or with modified versions of MAME that use the
+ * same license as MAME), and distribute linked combinations including
+ * the two.  You must obey the GNU General Public License in all
+ * respects for all of the code used other than MAME.  If you modify
+ * this file, you may extend this exception to your version of the
+ * file, but you are not obligated to do so.  If you do not wish to
+ * do so, delete this exception statement from your version.
+ */
+
+/** \file
+ * Lock free ring buffer of sound samples.
+ *
+ * The ring supports one producer and one consumer running in
+ * different threads without any lock.
+ * The write position is changed only by the producer, the read
+ * position only by the consumer. Both are free running counters,
+ * and their difference is the number of stored samples.
+ */
+
+/** \addtogroup Sound */
+/*@{*/
+
+#ifndef __RING_H
+#define __RING_H
+
+#include "extra.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))
+#define ring_load_acquire(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define ring_store_release(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#else
+#define ring_load_acquire(p) (__sync_synchronize(), *(volatile unsigned*)(p))
+#define ring_store_release(p, v) do { __sync_synchronize(); *(volatile unsigned*)(p) = (v); } while (0)
+#endif
+
+/**
+ * Ring buffer.
+ */
+typedef struct adv_ring_struct {
+	short* map; /**< Samples. */
+	unsigned size; /**< Number of samples, a power of 2. */
+	unsigned head; /**< Write position. Changed only by the producer. */
+	unsigned tail; /**< Read position. Changed only by the consumer. */
+} adv_ring;
+
+/**
+ * Initialize the ring.
+ * \param ring Ring to initialize.
+ * \param size Minimum number of samples. It's rounded up to a power of 2.
+ */
+static inline adv_error ring_init(adv_ring* ring, unsigned size)
+{
+	ring->size = 1;
+	while (ring->size < size)
+		ring->size *= 2;
+
+	ring->map = malloc(ring->size * sizeof(short));
+	if (!ring->map)
+		return -1;
+
+	ring->head = 0;
+	ring->tail = 0;
+
+	return 0;
+}
+
+/**
+ * Deinitialize the ring.
+ */
+static inline void ring_done(adv_ring* ring)
+{
+	free(ring->map);
+	ring->map = 0;
+}
+
+/**
+ * Number of samples stored.
+ * It can be called by both the producer and the consumer.
+ */
+static inline unsigned ring_count(adv_ring* ring)
+{
+	unsigned tail = ring_load_acquire(&ring->tail);
+	unsigned head = ring_load_acquire(&ring->head);
+
+	return head - tail;
+}
+
+/**
+ * Write samples in the ring.
+ * It must be called only by the producer.
+ * \param volume Volume adjustment. 32768 is the full volume.
+ * \return Number of samples written, less than the requested if the ring is full.
+ */
+static inline unsigned ring_write(adv_ring* ring, const short* sample_map, unsigned sample_count, int volume)
+{
+	unsigned head = ring->head;
+	unsigned space = ring->size - (head - ring_load_acquire(&ring->tail));
+	unsigned i;
+
+	if (sample_count > space)
+		sample_count = space;
+
+	if (volume == 32768) {
+		for (i = 0; i < sample_count; ++i)
+			ring->map[(head + i) & (ring->size - 1)] = sample_map[i];
+	} else {
+		for (i = 0; i < sample_count; ++i)
+			ring->map[(head + i) & (ring->size - 1)] = (int)sample_map[i] * volume / 32768;
+	}
+
+	ring_store_release(&ring->head, head + sample_count);
+
+	return sample_count;
+}
+
+/**
+ * Read samples from the ring.
+ * It must be called only by the consumer.
+ * \return Number of samples read, less than the requested if the ring is empty.
+ */
+static inline unsigned ring_read(adv_ring* ring, short* sample_map, unsigned sample_count)
+{
+	unsigned tail = ring->tail;
+	unsigned avail = ring_load_acquire(&ring->head) - tail;
+	unsigned i;
+
+	if (sample_count > avail)
+		sample_count = avail;
+
+	for (i = 0; i < sample_count; ++i)
+		sample_map[i] = ring->map[(tail + i) & (ring->size - 1)];
+
+	ring_store_release(&ring->tail, tail + sample_count);
+
+	return sample_count;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/*@}*/
@@ -89,7 +89,7 @@ void soundb_none_play(const short* sample_map, unsigned sample_count)
 
 unsigned soundb_none_flags(void)
 {
-	return 0;
+	return SOUND_DRIVER_FLAGS_NOBLOCK;
 }
 
 int soundb_none_load(adv_conf* context)
@@ -116,6 +116,7 @@ soundb_driver soundb_none_driver = {
 	soundb_none_buffered,
 	soundb_none_start,
 	soundb_none_stop,
-	soundb_none_volume
+	soundb_none_volume,
+	0
 };
 
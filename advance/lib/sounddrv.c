@@ -35,8 +35,115 @@
 #include "error.h"
 #include "snstring.h"
 
+#ifdef USE_SMP
+#include "ring.h"
+
+#include <pthread.h>
+#include <semaphore.h>
+#endif
+
 struct soundb_state_struct soundb_state;
 
+#ifdef USE_SMP
+/***************************************************************************/
+/* Output thread */
+
+/**
+ * Max number of samples for every channel sent at the driver in a single call.
+ */
+#define SOUNDB_THREAD_CHUNK 1024
+
+/**
+ * Output thread.
+ * The samples are stored in a lock free ring by soundb_play(), and
+ * sent to the driver by this thread. The driver may block waiting
+ * for free space without stalling the emulation.
+ * The driver buffered() function is still called by the main thread,
+ * concurrently with the play() function called by this thread.
+ * This is safe for OSS, where the state is in the kernel, and for ALSA,
+ * that locks the PCM internally.
+ */
+struct soundb_thread_struct {
+	adv_bool active_flag; /**< If the thread is running. */
+	unsigned exit_flag; /**< Exit request. */
+	pthread_t id; /**< Thread ID. */
+	sem_t wake; /**< Posted for every write and for the exit request. */
+	adv_ring ring; /**< Samples to play. */
+	unsigned channel; /**< Number of channels. */
+	unsigned size; /**< Size of the ring in samples for every channel. */
+	unsigned overrun; /**< Number of samples discarded because the ring was full. */
+};
+
+static struct soundb_thread_struct soundb_thread;
+
+static void* soundb_thread_proc(void* arg)
+{
+	adv_sample buf[SOUNDB_THREAD_CHUNK * 2];
+
+	while (!ring_load_acquire(&soundb_thread.exit_flag)) {
+		unsigned count = ring_read(&soundb_thread.ring, buf, SOUNDB_THREAD_CHUNK * soundb_thread.channel);
+
+		if (count) {
+			soundb_state.driver_current->play(buf, count / soundb_thread.channel);
+		} else {
+			/* wait for the next write */
+			sem_wait(&soundb_thread.wake);
+		}
+	}
+
+	return 0;
+}
+
+static adv_error soundb_thread_start(void)
+{
+	soundb_thread.active_flag = 0;
+	soundb_thread.exit_flag = 0;
+	soundb_thread.overrun = 0;
+
+	if (ring_init(&soundb_thread.ring, soundb_thread.size * soundb_thread.channel) != 0) {
+		log_std(("ERROR:sound: error allocating the ring buffer\n"));
+		return -1;
+	}
+
+	if (sem_init(&soundb_thread.wake, 0, 0) != 0) {
+		log_std(("ERROR:sound: error calling sem_init()\n"));
+		ring_done(&soundb_thread.ring);
+		return -1;
+	}
+
+	if (pthread_create(&soundb_thread.id, NULL, soundb_thread_proc, 0) != 0) {
+		log_std(("ERROR:sound: error calling pthread_create()\n"));
+		sem_destroy(&soundb_thread.wake);
+		ring_done(&soundb_thread.ring);
+		return -1;
+	}
+
+	log_std(("sound: output thread with a ring of %u samples\n", soundb_thread.ring.size / soundb_thread.channel));
+
+	soundb_thread.active_flag = 1;
+
+	return 0;
+}
+
+static void soundb_thread_stop(void)
+{
+	if (!soundb_thread.active_flag)
+		return;
+
+	ring_store_release(&soundb_thread.exit_flag, 1);
+	sem_post(&soundb_thread.wake);
+
+	pthread_join(soundb_thread.id, NULL);
+
+	log_std(("sound: output thread stopped, %u samples discarded for overrun\n", soundb_thread.overrun));
+
+	sem_destroy(&soundb_thread.wake);
+	ring_done(&soundb_thread.ring);
+
+	soundb_thread.active_flag = 0;
+}
+#endif
+
 void soundb_default(void)
 {
 	soundb_state.is_initialized_flag = 1;
@@ -133,6 +240,13 @@ adv_error soundb_init(unsigned* rate, adv_bool stereo_flag, double buffer_time)
 
 	log_std(("sound: select driver %s\n", soundb_state.driver_current->name));
 
+#ifdef USE_SMP
+	soundb_thread.channel = stereo_flag ? 2 : 1;
+	soundb_thread.size = *rate * buffer_time;
+	if (soundb_thread.size < SOUNDB_THREAD_CHUNK)
+		soundb_thread.size = SOUNDB_THREAD_CHUNK;
+#endif
+
 	soundb_state.is_active_flag = 1;
 
 	return 0;
@@ -162,20 +276,67 @@ void soundb_play(const adv_sample* sample_map, unsigned sample_count)
 {
 	assert(soundb_state.is_active_flag && soundb_state.is_playing_flag);
 
+#ifdef USE_SMP
+	if (soundb_thread.active_flag) {
+		unsigned count = sample_count * soundb_thread.channel;
+		unsigned written = ring_write(&soundb_thread.ring, sample_map, count, 32768);
+
+		if (written < count)
+			soundb_thread.overrun += (count - written) / soundb_thread.channel;
+
+		sem_post(&soundb_thread.wake);
+		return;
+	}
+#endif
+
 	soundb_state.driver_current->play(sample_map, sample_count);
 }
 
 unsigned soundb_buffered(void)
 {
+	unsigned buffered;
+
 	assert(soundb_state.is_active_flag && soundb_state.is_playing_flag);
 
-	return soundb_state.driver_current->buffered();
+	buffered = soundb_state.driver_current->buffered();
+
+#ifdef USE_SMP
+	if (soundb_thread.active_flag)
+		buffered += ring_count(&soundb_thread.ring) / soundb_thread.channel;
+#endif
+
+	return buffered;
+}
+
+unsigned soundb_underrun(void)
+{
+	assert(soundb_state.is_active_flag);
+
+	if (soundb_state.driver_current->underrun)
+		return soundb_state.driver_current->underrun();
+	else
+		return 0;
+}
+
+unsigned soundb_overrun(void)
+{
+	assert(soundb_state.is_active_flag);
+
+#ifdef USE_SMP
+	return soundb_thread.overrun;
+#else
+	return 0;
+#endif
 }
 
 void soundb_stop(void)
 {
 	assert(soundb_state.is_active_flag && soundb_state.is_playing_flag);
 
+#ifdef USE_SMP
+	soundb_thread_stop();
+#endif
+
 	soundb_state.driver_current->stop();
 
 	soundb_state.is_playing_flag = 0;
@@ -188,6 +349,12 @@ adv_error soundb_start(double silence_time)
 	if (soundb_state.driver_current->start(silence_time) != 0)
 		return -1;
 
+#ifdef USE_SMP
+	/* if the thread cannot be started the driver is called directly */
+	if ((soundb_flags() & SOUND_DRIVER_FLAGS_NOBLOCK) == 0)
+		soundb_thread_start();
+#endif
+
 	soundb_state.is_playing_flag = 1;
 
 	return 0;
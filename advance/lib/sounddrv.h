@@ -53,6 +53,7 @@ extern "C" {
  */
 /*@{*/
 #define SOUND_DRIVER_FLAGS_VOLUME_SAMPLE 0x1 /**< Fake volume control made changing the samples. */
+#define SOUND_DRIVER_FLAGS_NOBLOCK 0x2 /**< The play() function never blocks. The output thread isn't used. */
 /*@}*/
 
 #define SOUND_DRIVER_FLAGS_USER_BIT0 0x10000
@@ -87,6 +88,7 @@ typedef struct soundb_driver_struct {
 	adv_error (*start)(double silence_time);
 	void (*stop)(void);
 	void (*volume)(double v);
+	unsigned (*underrun)(void); /**< Get the number of underruns of the output buffer. It may be 0. */
 } soundb_driver;
 
 #define SOUND_DRIVER_MAX 8
@@ -127,6 +129,9 @@ unsigned soundb_flags(void);
 
 /**
  * Play the specified samples.
+ * If the driver play() function may block, and the threads are available,
+ * the samples are stored in a lock free ring buffer, and an output thread
+ * sends them to the driver. In this case this function never blocks.
  * \param sample_map Samples to play.
  * \param sample_count Number of samples to play. If stereo is enable sample_map must contains the 2*sample_count samples.
  */
@@ -134,9 +139,23 @@ void soundb_play(const adv_sample* sample_map, unsigned sample_count);
 
 /**
  * Return the number of buffered samples.
+ * It includes the samples in the ring buffer of the output thread.
  */
 unsigned soundb_buffered(void);
 
+/**
+ * Return the number of underruns of the output buffer.
+ * It's a counter incremented every time the output device played
+ * all the buffered samples.
+ */
+unsigned soundb_underrun(void);
+
+/**
+ * Return the number of samples discarded because the output
+ * buffer was full.
+ */
+unsigned soundb_overrun(void);
+
 /**
  * Stop the playing.
  */
@@ -0,0 +1,397 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2017 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * In addition, as a special exception, Andrea Mazzoleni
+ * gives permission to link the code of this program with
+ * the MAME library (or with modified versions of MAME that use the
+ * same license as MAME), and distribute linked combinations including
+ * the two.  You must obey the GNU General Public License in all
+ * respects for all of the code used other than MAME.  If you modify
+ * this file, you may extend this exception to your version of the
+ * file, but you are not obligated to do so.  If you do not wish to
+ * do so, delete this exception statement from your version.
+ */
+
+#include "portable.h"
+
+#include "soundfx.h"
+#include "slice.h"
+
+/**
+ * Initialize the processing context.
+ * At the startup the volume is full, and the equalizer is disabled.
+ * \param channel Number of input channels, 1 or 2.
+ * \param mix Channel mixing.
+ */
+void soundfx_init(adv_soundfx* fx, unsigned channel, adv_soundfx_mix mix)
+{
+	assert(channel == 1 || channel == 2);
+
+	memset(fx, 0, sizeof(adv_soundfx));
+
+	fx->channel = channel;
+	fx->mix = mix;
+	fx->mult = SOUNDFX_MULT_BASE;
+	fx->equalizer_flag = 0;
+	fx->map = 0;
+	fx->map_max = 0;
+	fx->overflow = 0;
+}
+
+/**
+ * Deinitialize the processing context.
+ */
+void soundfx_done(adv_soundfx* fx)
+{
+	free(fx->map);
+	fx->map = 0;
+	fx->map_max = 0;
+}
+
+/**
+ * Set the volume.
+ * \param mult Volume multiplier. SOUNDFX_MULT_BASE is the full volume.
+ */
+void soundfx_volume_set(adv_soundfx* fx, int mult)
+{
+	fx->mult = mult;
+}
+
+/**
+ * Set the equalizer.
+ * \param band_map Vector of SOUNDFX_BAND_MAX IIR filters, one for every band.
+ * \param factor_map Vector of SOUNDFX_BAND_MAX amplification factors. Use 0 to disable a band.
+ * \param reset If the previous values of the filters must be cleared.
+ */
+void soundfx_equalizer_set(adv_soundfx* fx, const adv_filter* band_map, const double* factor_map, adv_bool reset)
+{
+	unsigned x_max, y_max;
+	unsigned b, c, k;
+
+	/* the lanes are padded to the longest filter */
+	x_max = 0;
+	y_max = 0;
+	for (b = 0; b < SOUNDFX_BAND_MAX; ++b) {
+		const struct adv_filter_struct_iir* iir = &band_map[b].data.iir;
+
+		assert(band_map[b].model != adv_filter_fir_windowedsinc);
+
+		if (x_max < iir->M + 1)
+			x_max = iir->M + 1;
+		if (y_max < iir->N)
+			y_max = iir->N;
+	}
+
+	if (!fx->equalizer_flag || x_max != fx->x_max || y_max != fx->y_max)
+		reset = 1;
+
+	fx->x_max = x_max;
+	fx->y_max = y_max;
+
+	/* clear also the padding lanes */
+	for (k = 0; k < SOUNDFX_TAP_MAX; ++k) {
+		for (b = 0; b < SOUNDFX_LANE_MAX; ++b) {
+			fx->xcoeffs[k][b] = 0;
+			fx->ycoeffs[k][b] = 0;
+		}
+	}
+	for (b = 0; b < SOUNDFX_LANE_MAX; ++b) {
+		fx->gain[b] = 1;
+		fx->factor[b] = 0;
+	}
+
+	for (c = 0; c < fx->channel; ++c) {
+		for (b = 0; b < SOUNDFX_BAND_MAX; ++b) {
+			const struct adv_filter_struct_iir* iir = &band_map[b].data.iir;
+			unsigned lane = c * SOUNDFX_BAND_MAX + b;
+			unsigned x_off = x_max - (iir->M + 1);
+			unsigned y_off = y_max - iir->N;
+
+			/* align the coefficients of x[0] and y[-1], the zeros are at the start */
+			for (k = 0; k < iir->M + 1; ++k)
+				fx->xcoeffs[x_off + k][lane] = iir->xcoeffs[k];
+			for (k = 0; k < iir->N; ++k)
+				fx->ycoeffs[y_off + k][lane] = iir->ycoeffs[k];
+
+			fx->gain[lane] = iir->gain;
+			fx->factor[lane] = factor_map[b];
+		}
+	}
+
+	if (reset) {
+		for (k = 0; k < SOUNDFX_TAP_MAX + SOUNDFX_BLOCK; ++k) {
+			for (b = 0; b < SOUNDFX_LANE_MAX; ++b) {
+				fx->x_map[k][b] = 0;
+				fx->y_map[k][b] = 0;
+			}
+		}
+	}
+
+	fx->equalizer_flag = 1;
+}
+
+/**
+ * Disable the equalizer.
+ */
+void soundfx_equalizer_disable(adv_soundfx* fx)
+{
+	fx->equalizer_flag = 0;
+}
+
+/**
+ * Equalize a block of samples.
+ * All the lanes are computed together with the same operations of filter_iir_insert(),
+ * and in the same order, to get the same result.
+ * \param v Samples of the block, SOUNDFX_BLOCK rows of two channels.
+ * \param count Number of samples in the block.
+ */
+static inline void soundfx_equalizer(adv_soundfx* fx, int (*v)[2], unsigned count, unsigned channel, unsigned lanes, unsigned* overflow)
+{
+	double acc[SOUNDFX_BLOCK][SOUNDFX_LANE_MAX];
+	double (*xh)[SOUNDFX_LANE_MAX];
+	double (*yh)[SOUNDFX_LANE_MAX];
+	unsigned x_max = fx->x_max;
+	unsigned y_max = fx->y_max;
+	unsigned b, c, f, k, l;
+
+	/* the history is followed by the block */
+	xh = fx->x_map;
+	yh = fx->y_map;
+
+	/* set x[0] of every sample, the padding lanes are 0 */
+	for (f = 0; f < count; ++f) {
+		double* x = xh[x_max - 1 + f];
+
+		for (l = 0; l < lanes; ++l)
+			x[l] = 0;
+		for (c = 0; c < channel; ++c)
+			for (b = 0; b < SOUNDFX_BAND_MAX; ++b)
+				x[c * SOUNDFX_BAND_MAX + b] = v[f][c];
+		for (l = 0; l < lanes; ++l)
+			x[l] = x[l] / fx->gain[l];
+	}
+
+	/* x, sum from x[-M] to x[0] */
+	/* it doesn't depend on the previous results, and it's computed for all the block */
+	for (f = 0; f < count; ++f) {
+		for (l = 0; l < lanes; ++l)
+			acc[f][l] = 0;
+		for (k = 0; k < x_max; ++k)
+			for (l = 0; l < lanes; ++l)
+				acc[f][l] += fx->xcoeffs[k][l] * xh[f + k][l];
+	}
+
+	for (f = 0; f < count; ++f) {
+		double y[SOUNDFX_LANE_MAX];
+
+		for (l = 0; l < lanes; ++l)
+			y[l] = acc[f][l];
+
+		/* y, sum from y[-N] to y[-1] */
+		for (k = 0; k < y_max; ++k)
+			for (l = 0; l < lanes; ++l)
+				y[l] += fx->ycoeffs[k][l] * yh[f + k][l];
+
+		/* decrease the precision of very small values, see filter_iir_insert() */
+		for (l = 0; l < lanes; ++l) {
+			y[l] += 1E-12;
+			y[l] -= 1E-12;
+			yh[y_max + f][l] = y[l];
+		}
+
+		for (c = 0; c < channel; ++c) {
+			double vr = 0;
+			int vi;
+
+			for (b = 0; b < SOUNDFX_BAND_MAX; ++b)
+				vr += fx->factor[c * SOUNDFX_BAND_MAX + b] * y[c * SOUNDFX_BAND_MAX + b];
+
+			/* lrint is potentially faster than a cast to int */
+			vi = lrint(vr);
+
+			if (vi > 32767) {
+				++*overflow;
+				vi = 32767;
+			}
+			if (vi < -32768) {
+				++*overflow;
+				vi = -32768;
+			}
+
+			v[f][c] = vi;
+		}
+	}
+
+	/* keep the history for the next block */
+	memmove(xh[0], xh[count], (x_max - 1) * sizeof(xh[0]));
+	memmove(yh[0], yh[count], y_max * sizeof(yh[0]));
+}
+
+/**
+ * Process all the samples.
+ * Specialized by the compiler for the number of channels and lanes.
+ */
+static inline void soundfx_loop(adv_soundfx* fx, const short* input_sample, unsigned input_count, short* output_sample, unsigned output_count, short* tap_sample, unsigned channel, unsigned lanes)
+{
+	unsigned output_channel = soundfx_output_channel(fx);
+	const unsigned* map = input_count != output_count ? fx->map : 0;
+	int mult = fx->mult;
+	unsigned overflow = 0;
+	unsigned base, count;
+	unsigned i, j, f, c;
+
+	i = 0;
+	for (base = 0; base < input_count; base += count) {
+		int v[SOUNDFX_BLOCK][2];
+
+		count = input_count - base;
+		if (count > SOUNDFX_BLOCK)
+			count = SOUNDFX_BLOCK;
+
+		for (f = 0; f < count; ++f) {
+			for (c = 0; c < channel; ++c)
+				v[f][c] = input_sample[(base + f) * channel + c];
+			for (; c < 2; ++c)
+				v[f][c] = 0;
+		}
+
+		/* volume */
+		if (mult != SOUNDFX_MULT_BASE) {
+			for (f = 0; f < count; ++f) {
+				for (c = 0; c < channel; ++c) {
+					int s = v[f][c] * mult / SOUNDFX_MULT_BASE;
+					if (s > 32767) {
+						++overflow;
+						s = 32767;
+					}
+					if (s < -32768) {
+						++overflow;
+						s = -32768;
+					}
+					v[f][c] = s;
+				}
+			}
+		}
+
+		/* equalizer */
+		if (fx->equalizer_flag)
+			soundfx_equalizer(fx, v, count, channel, lanes, &overflow);
+
+		if (tap_sample) {
+			for (f = 0; f < count; ++f)
+				for (c = 0; c < channel; ++c)
+					tap_sample[(base + f) * channel + c] = v[f][c];
+		}
+
+		for (f = 0; f < count; ++f) {
+			int o[2];
+
+			/* channels */
+			switch (fx->mix) {
+			case soundfx_mix_mono_stereo :
+				o[0] = v[f][0];
+				o[1] = v[f][0];
+				break;
+			case soundfx_mix_mono_surround :
+				if (v[f][0] == -32768) { /* prevent overflow */
+					o[0] = -32768;
+					o[1] = 32767;
+				} else {
+					o[0] = v[f][0];
+					o[1] = -v[f][0];
+				}
+				break;
+			case soundfx_mix_stereo_mono :
+				o[0] = (v[f][0] + v[f][1]) / 2;
+				break;
+			case soundfx_mix_stereo_surround :
+				o[0] = (3 * v[f][0] - v[f][1]) / 4;
+				o[1] = (3 * v[f][1] - v[f][0]) / 4;
+				break;
+			default :
+				o[0] = v[f][0];
+				o[1] = v[f][1];
+				break;
+			}
+
+			/* resample */
+			j = base + f;
+			if (map) {
+				while (i < output_count && map[i] == j) {
+					for (c = 0; c < output_channel; ++c)
+						output_sample[i * output_channel + c] = o[c];
+					++i;
+				}
+			} else {
+				for (c = 0; c < output_channel; ++c)
+					output_sample[j * output_channel + c] = o[c];
+			}
+		}
+	}
+
+	fx->overflow += overflow;
+}
+
+/**
+ * Process a block of samples.
+ * The samples are adjusted in volume, equalized, mixed to the output
+ * channels and resampled to the output count. All in a single pass.
+ * The input and output buffers can be the same only if the number
+ * of channels and of samples doesn't change.
+ * \param input_sample Input samples, interleaved if stereo.
+ * \param input_count Number of input samples, not multiplied by the channels.
+ * \param output_sample Output samples, interleaved if stereo.
+ * \param output_count Number of output samples, not multiplied by the channels.
+ * \param tap_sample If not 0, where to store a copy of the equalized samples before the mixing and resampling.
+ * \return 0 on success, or -1 if out of memory. On error the output is silence.
+ */
+adv_error soundfx_process(adv_soundfx* fx, const short* input_sample, unsigned input_count, short* output_sample, unsigned output_count, short* tap_sample)
+{
+	if (input_count == 0) {
+		memset(output_sample, 0, output_count * soundfx_output_channel(fx) * sizeof(short));
+		return 0;
+	}
+
+	if (input_count != output_count) {
+		if (fx->map_max < output_count) {
+			unsigned* map = realloc(fx->map, output_count * sizeof(unsigned));
+			if (!map) {
+				/* keep the previous map for the next calls */
+				memset(output_sample, 0, output_count * soundfx_output_channel(fx) * sizeof(short));
+				return -1;
+			}
+			fx->map = map;
+			fx->map_max = output_count;
+		}
+
+		/* a single output sample is not supported by slice_vector() */
+		if (output_count == 1)
+			fx->map[0] = 0;
+		else if (output_count != 0)
+			slice_vector(fx->map, input_count, output_count);
+	}
+
+	if (fx->channel == 1)
+		soundfx_loop(fx, input_sample, input_count, output_sample, output_count, tap_sample, 1, SOUNDFX_LANE_MAX / 2);
+	else
+		soundfx_loop(fx, input_sample, input_count, output_sample, output_count, tap_sample, 2, SOUNDFX_LANE_MAX);
+
+	return 0;
+}
+
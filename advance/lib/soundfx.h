@@ -0,0 +1,153 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2017 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * In addition, as a special exception, Andrea Mazzoleni
+ * gives permission to link the code of this program with
+ * the MAME library (or with modified versions of MAME that use the
+ * same license as MAME), and distribute linked combinations including
+ * the two.  You must obey the GNU General Public License in all
+ * respects for all of the code used other than MAME.  If you modify
+ * this file, you may extend this exception to your version of the
+ * file, but you are not obligated to do so.  If you do not wish to
+ * do so, delete this exception statement from your version.
+ */
+
+/** \file
+ * Sound post processing chain.
+ *
+ * Volume adjustment, equalizer, channel mixing and resampling of a block
+ * of samples computed in a single pass.
+ *
+ * The equalizer runs all the bands of all the channels together. Every
+ * band of every channel is a lane of a vector, and the filters are
+ * padded to the same number of coefficients. In this way the inner loops
+ * have a constant length and the compiler is able to vectorize them.
+ * The samples are processed in blocks. The X part of the filters doesn't
+ * depend on the previous results, and it's computed for the whole block
+ * before the recursive Y part.
+ * The result is the same of the adv_filter_insert() and adv_filter_extract()
+ * functions called band by band.
+ */
+
+#ifndef __SOUNDFX_H
+#define __SOUNDFX_H
+
+#include "extra.h"
+#include "filter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Base of the volume multiplier. */
+#define SOUNDFX_MULT_BASE 4096
+
+/** Number of equalizer bands. */
+#define SOUNDFX_BAND_MAX 3
+
+/** Number of lanes. All the bands of two channels, rounded up to a power of 2. */
+#define SOUNDFX_LANE_MAX 8
+
+/** Max number of coefficients of an equalizer band. */
+#define SOUNDFX_TAP_MAX FILTER_POLE_MAX
+
+/** Number of samples processed together. */
+#define SOUNDFX_BLOCK 64
+
+/**
+ * Channel mixing.
+ */
+typedef enum adv_soundfx_mix_enum {
+	soundfx_mix_none, /**< Output like the input. */
+	soundfx_mix_mono_stereo, /**< Mono input to stereo output. */
+	soundfx_mix_mono_surround, /**< Mono input to surround output. */
+	soundfx_mix_stereo_mono, /**< Stereo input to mono output. */
+	soundfx_mix_stereo_surround /**< Stereo input to surround output. */
+} adv_soundfx_mix;
+
+/**
+ * Sound post processing context.
+ */
+typedef struct adv_soundfx_struct {
+	unsigned channel; /**< Number of input channels, 1 or 2. */
+	adv_soundfx_mix mix; /**< Channel mixing. */
+
+	int mult; /**< Volume multiplier. SOUNDFX_MULT_BASE is the full volume. */
+
+	adv_bool equalizer_flag; /**< Equalizer active. */
+	unsigned x_max; /**< Number of X coefficients of all the lanes. */
+	unsigned y_max; /**< Number of Y coefficients of all the lanes. */
+	double gain[SOUNDFX_LANE_MAX]; /**< Gain of every lane. */
+	double factor[SOUNDFX_LANE_MAX]; /**< Amplification of every lane. 0 if the band is disabled. */
+	double xcoeffs[SOUNDFX_TAP_MAX][SOUNDFX_LANE_MAX]; /**< X coefficients. From x[-M] to x[0]. */
+	double ycoeffs[SOUNDFX_TAP_MAX][SOUNDFX_LANE_MAX]; /**< Y coefficients. From y[-N] to y[-1]. */
+	double x_map[SOUNDFX_TAP_MAX + SOUNDFX_BLOCK][SOUNDFX_LANE_MAX]; /**< Previous X values followed by the ones of the current block. */
+	double y_map[SOUNDFX_TAP_MAX + SOUNDFX_BLOCK][SOUNDFX_LANE_MAX]; /**< Previous Y values followed by the ones of the current block. */
+
+	unsigned* map; /**< Resample map. For every output sample the index of the input sample. */
+	unsigned map_max; /**< Size of the resample map. */
+
+	unsigned overflow; /**< Number of clipped samples. */
+} adv_soundfx;
+
+/** \addtogroup Sound */
+/*@{*/
+
+void soundfx_init(adv_soundfx* fx, unsigned channel, adv_soundfx_mix mix);
+void soundfx_done(adv_soundfx* fx);
+void soundfx_volume_set(adv_soundfx* fx, int mult);
+void soundfx_equalizer_set(adv_soundfx* fx, const adv_filter* band_map, const double* factor_map, adv_bool reset);
+void soundfx_equalizer_disable(adv_soundfx* fx);
+adv_error soundfx_process(adv_soundfx* fx, const short* input_sample, unsigned input_count, short* output_sample, unsigned output_count, short* tap_sample);
+
+/**
+ * Get the number of output channels.
+ */
+static inline unsigned soundfx_output_channel(adv_soundfx* fx)
+{
+	switch (fx->mix) {
+	case soundfx_mix_mono_stereo :
+	case soundfx_mix_mono_surround :
+	case soundfx_mix_stereo_surround :
+		return 2;
+	case soundfx_mix_stereo_mono :
+		return 1;
+	default :
+		return fx->channel;
+	}
+}
+
+/**
+ * Check if the processing doesn't change the samples.
+ * In such case the input can be used directly as output, if the number
+ * of samples doesn't change.
+ */
+static inline adv_bool soundfx_is_identity(adv_soundfx* fx)
+{
+	return fx->mult == SOUNDFX_MULT_BASE && !fx->equalizer_flag && fx->mix == soundfx_mix_none;
+}
+
+/*@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -62,6 +62,7 @@ struct soundb_alsa_context {
 	int volume; /**< Volume adjustement. ALSA_VOLUME_BASE == full volume. */
 	snd_pcm_uframes_t buffer_size; /**< ALSA buffer size in frames. */
 	snd_pcm_uframes_t period_size; /**< ALSA period size in frames. */
+	unsigned underrun; /**< Number of underruns. */
 };
 
 static struct soundb_alsa_context alsa_state;
@@ -131,6 +132,7 @@ adv_error soundb_alsa_init(int sound_id, unsigned* rate, adv_bool stereo_flag, d
 	log_std(("sound:alsa: device_alsa_mixed %s\n", alsa_option.mixer_buffer));
 
 	alsa_state.volume = ALSA_VOLUME_BASE;
+	alsa_state.underrun = 0;
 
 	if (stereo_flag) {
 		alsa_state.sample_length = 4;
@@ -455,16 +457,21 @@ void soundb_alsa_play(const adv_sample* sample_map, unsigned sample_count)
 
 		if (r < 0) {
 			if (r == -EAGAIN) {
-				/* audio buffer full, it should never happen */
-				log_std(("WARNING:sound:alsa: snd_pcm_writei() failed: internal buffer full\n"));
+				/* audio buffer full, it happens only with the output thread */
+				/* or if the latency is too big, wait for some free space */
+				r = snd_pcm_wait(alsa_state.handle, 100);
+				if (r < 0)
+					log_std(("ERROR:sound:alsa: snd_pcm_wait() failed: %s\n", snd_strerror(r)));
 				/* retry */
 				continue;
 			}
 
-			if (r == -EPIPE)
+			if (r == -EPIPE) {
+				++alsa_state.underrun;
 				log_std(("ERROR:sound:alsa: snd_pcm_writei() failed: %s. Increase the latency with -sound_latency.\n", snd_strerror(r)));
-			else
+			} else {
 				log_std(("ERROR:sound:alsa: snd_pcm_writei() failed: %s (%d)\n", snd_strerror(r), r));
+			}
 
 			if (r < 0) {
 				r = snd_pcm_prepare(alsa_state.handle);
@@ -508,6 +515,11 @@ adv_error soundb_alsa_start(double silence_time)
 	return 0;
 }
 
+unsigned soundb_alsa_underrun(void)
+{
+	return alsa_state.underrun;
+}
+
 unsigned soundb_alsa_flags(void)
 {
 	unsigned flags = 0;
@@ -556,6 +568,7 @@ soundb_driver soundb_alsa_driver = {
 	soundb_alsa_buffered,
 	soundb_alsa_start,
 	soundb_alsa_stop,
-	soundb_alsa_volume
+	soundb_alsa_volume,
+	soundb_alsa_underrun
 };
 
@@ -35,6 +35,7 @@
 #include "error.h"
 
 #include <sys/soundcard.h>
+#include <poll.h>
 
 #if HAVE_SYS_IOCTL_H
 #include <sys/ioctl.h>
@@ -51,6 +52,8 @@ struct soundb_oss_context {
 	unsigned sample_length;
 	int handle;
 	int volume; /**< Volume adjustement. OSS_VOLUME_BASE == full volume. */
+	adv_bool started_flag; /**< If the initial silence was written. */
+	unsigned underrun; /**< Number of underruns. */
 };
 
 static struct soundb_oss_context oss_state;
@@ -76,6 +79,8 @@ adv_error soundb_oss_init(int sound_id, unsigned* rate, adv_bool stereo_flag, do
 	}
 
 	oss_state.volume = OSS_VOLUME_BASE;
+	oss_state.started_flag = 0;
+	oss_state.underrun = 0;
 
 	oss_state.handle = open("/dev/dsp", O_WRONLY | O_NONBLOCK, 0);
 	if (!oss_state.handle) {
@@ -182,6 +187,10 @@ void soundb_oss_play(const adv_sample* sample_map, unsigned sample_count)
 
 	log_debug(("sound:oss: soundb_oss_play(count:%d)\n", sample_count));
 
+	/* OSS doesn't report underruns, detect them checking for an empty buffer */
+	if (oss_state.started_flag && sample_count != 0 && soundb_oss_buffered() == 0)
+		++oss_state.underrun;
+
 	/* calling write with a 0 size result in wrong output */
 	while (sample_count) {
 		unsigned channel_length = oss_state.sample_length / oss_state.channel;
@@ -207,8 +216,15 @@ void soundb_oss_play(const adv_sample* sample_map, unsigned sample_count)
 
 		if (r < 0) {
 			if (errno == EAGAIN) {
-				/* audio buffer full, it should never happen */
-				log_std(("WARNING:sound:oss: write() failed: internal buffer full\n"));
+				struct pollfd pfd;
+
+				/* audio buffer full, it happens only with the output thread */
+				/* or if the latency is too big, wait for some free space */
+				pfd.fd = oss_state.handle;
+				pfd.events = POLLOUT;
+				pfd.revents = 0;
+				if (poll(&pfd, 1, 100) < 0 && errno != EINTR)
+					log_std(("ERROR:sound:oss: poll() failed\n"));
 				/* retry */
 				continue;
 			}
@@ -244,9 +260,16 @@ adv_error soundb_oss_start(double silence_time)
 		soundb_oss_play(buf, run / oss_state.channel);
 	}
 
+	oss_state.started_flag = 1;
+
 	return 0;
 }
 
+unsigned soundb_oss_underrun(void)
+{
+	return oss_state.underrun;
+}
+
 unsigned soundb_oss_flags(void)
 {
 	return SOUND_DRIVER_FLAGS_VOLUME_SAMPLE;
@@ -276,6 +299,7 @@ soundb_driver soundb_oss_driver = {
 	soundb_oss_buffered,
 	soundb_oss_start,
 	soundb_oss_stop,
-	soundb_oss_volume
+	soundb_oss_volume,
+	soundb_oss_underrun
 };
 
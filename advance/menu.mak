@@ -21,6 +21,7 @@ MENUOBJS += \
 	$(MENUOBJ)/menu/common.o \
 	$(MENUOBJ)/menu/crc.o \
 	$(MENUOBJ)/menu/emulator.o \
+	$(MENUOBJ)/menu/emudb.o \
 	$(MENUOBJ)/menu/emuxml.o \
 	$(MENUOBJ)/menu/game.o \
 	$(MENUOBJ)/menu/mconfig.o \
@@ -134,6 +135,13 @@ MENUOBJS += \
 	$(MENUOBJ)/linux/file.o \
 	$(MENUOBJ)/linux/target.o \
 	$(MENUOBJ)/linux/os.o
+ifeq ($(CONF_LIB_PTHREAD),yes)
+MENUCFLAGS += \
+	-D_REENTRANT \
+	-DUSE_BACKDROP_THREAD \
+	-DUSE_ERROR_THREAD
+MENULIBS += -lpthread
+endif
 ifeq ($(CONF_LIB_SVGALIB),yes)
 MENUCFLAGS += \
 	-DUSE_VIDEO_SVGALIB \
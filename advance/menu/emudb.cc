@@ -0,0 +1,559 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2018 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "portable.h"
+
+#include "emulator.h"
+#include "game.h"
+
+#include "advance.h"
+
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#include <string>
+#include <vector>
+#include <map>
+
+using namespace std;
+
+/****************************************************************************/
+/* Database */
+
+/*
+ * Binary snapshot of the games read from the -listxml output.
+ *
+ * The file contains a header, the game records sorted by name, the
+ * device records, the device extensions and a pool of strings
+ * terminated by zero. All the references are indexes in the arrays
+ * or offsets in the string pool. The file is mapped in memory, if
+ * possible, and the games are created directly from it without any
+ * parsing.
+ *
+ * The parent of every clone is precomputed, and the games with the
+ * cloneof and romof references already checked are marked, so
+ * game_set::cache() doesn't need to search them again.
+ *
+ * The snapshot is valid only if the emulator and the xml file have
+ * the same size and modification time stored in the header.
+ */
+
+/**
+ * Magic string at the begin of the file.
+ */
+#define DB_MAGIC "ADVMDB\r\n"
+
+/**
+ * Version of the file format.
+ */
+#define DB_VERSION 1
+
+/**
+ * Null reference.
+ */
+#define DB_NONE 0xFFFFFFFFU
+
+/**
+ * Games with the cloneof and romof references checked.
+ */
+#define DB_FLAG_LINKED 0x1
+
+/**
+ * Flags of the game stored in the file.
+ */
+#define DB_FLAG_GAME (emulator::flag_derived_vector | emulator::flag_derived_vertical | emulator::flag_derived_resource)
+
+/**
+ * File header.
+ */
+struct db_header {
+	char magic[8]; /**< DB_MAGIC. */
+	uint32 version; /**< DB_VERSION. */
+	uint32 endian; /**< 0x01020304 in the byte order of the writer. */
+	uint32 exe_size; /**< Size of the emulator. */
+	uint32 exe_mtime; /**< Modification time of the emulator. */
+	uint32 xml_size; /**< Size of the xml file. */
+	uint32 xml_mtime; /**< Modification time of the xml file. */
+	uint32 game_count; /**< Number of game records. */
+	uint32 device_count; /**< Number of device records. */
+	uint32 ext_count; /**< Number of device extensions. */
+	uint32 pool_size; /**< Size of the string pool. */
+};
+
+/**
+ * Game record.
+ * The names are stored without the emulator prefix.
+ */
+struct db_game {
+	uint32 name; /**< Name. */
+	uint32 description; /**< Description. */
+	uint32 manufacturer; /**< Manufacturer. */
+	uint32 year; /**< Year. */
+	uint32 cloneof; /**< Clone of. */
+	uint32 romof; /**< Rom of. */
+	uint32 parent; /**< Index of the parent game, or DB_NONE. */
+	uint32 db_flag; /**< DB_FLAG_* flags. */
+	uint32 flag; /**< Game flags, only the ones in DB_FLAG_GAME. */
+	uint32 play; /**< Playability. */
+	uint32 size; /**< Size of the roms. */
+	uint32 sizex; /**< Screen width. */
+	uint32 sizey; /**< Screen height. */
+	uint32 aspectx; /**< Screen aspect. */
+	uint32 aspecty; /**< Screen aspect. */
+	uint32 device_begin; /**< First device record. */
+	uint32 device_count; /**< Number of device records. */
+};
+
+/**
+ * Device record.
+ */
+struct db_device {
+	uint32 name; /**< Name of the device option. */
+	uint32 ext_begin; /**< First extension. */
+	uint32 ext_count; /**< Number of extensions. */
+};
+
+/**
+ * Pool of strings used to write the file.
+ * Every string is stored only once.
+ */
+class db_pool {
+	string data;
+	map<string, uint32> index;
+public:
+	uint32 insert(const string& s);
+	const string& data_get() const { return data; }
+};
+
+uint32 db_pool::insert(const string& s)
+{
+	map<string, uint32>::const_iterator i = index.find(s);
+	if (i != index.end())
+		return i->second;
+
+	uint32 offset = data.length();
+	data.append(s);
+	data.push_back(0);
+	index[s] = offset;
+
+	return offset;
+}
+
+string mame_info::db_file_get()
+{
+	return path_abs(path_import(file_config_file_home((user_name_get() + ".db").c_str())), dir_cwd());
+}
+
+/**
+ * Get the size and the modification time of the emulator and of the xml file.
+ */
+bool mame_info::db_stat(uint32& exe_size, uint32& exe_mtime, uint32& xml_size, uint32& xml_mtime)
+{
+	struct stat st_exe;
+	struct stat st_xml;
+
+	string xml_file = path_abs(path_import(file_config_file_home((user_name_get() + ".xml").c_str())), dir_cwd());
+
+	if (stat(cpath_export(config_exe_path_get()), &st_exe) != 0)
+		return false;
+	if (stat(cpath_export(xml_file), &st_xml) != 0)
+		return false;
+
+	exe_size = st_exe.st_size;
+	exe_mtime = st_exe.st_mtime;
+	xml_size = st_xml.st_size;
+	xml_mtime = st_xml.st_mtime;
+
+	return true;
+}
+
+/**
+ * Remove the emulator prefix from a game name.
+ */
+static string db_name_strip(const string& prefix, const string& name)
+{
+	if (name.length() >= prefix.length() && name.compare(0, prefix.length(), prefix) == 0)
+		return name.substr(prefix.length());
+	return name;
+}
+
+bool mame_info::save_game_db(const game_set& gar)
+{
+	string db_file = db_file_get();
+	string tmp_file = db_file + ".tmp";
+	string prefix = user_name_get() + "/";
+	db_header header;
+	vector<const game*> game_map;
+	vector<db_game> record_map;
+	vector<db_device> device_map;
+	vector<uint32> ext_map;
+	db_pool pool;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, DB_MAGIC, sizeof(header.magic));
+	header.version = DB_VERSION;
+	header.endian = 0x01020304;
+
+	if (!db_stat(header.exe_size, header.exe_mtime, header.xml_size, header.xml_mtime))
+		return false;
+
+	// the games of this emulator, already sorted by name
+	for (game_set::const_iterator i = gar.begin(); i != gar.end(); ++i)
+		if (i->emulator_get() == this)
+			game_map.push_back(&*i);
+
+	// index of every game name
+	map<string, uint32> name_map;
+	for (uint32 i = 0; i < game_map.size(); ++i)
+		name_map[game_map[i]->name_get()] = i;
+
+	for (uint32 i = 0; i < game_map.size(); ++i) {
+		const game& g = *game_map[i];
+		db_game r;
+
+		r.name = pool.insert(db_name_strip(prefix, g.name_get()));
+		r.description = pool.insert(g.description_get());
+		r.manufacturer = pool.insert(g.manufacturer_get());
+		r.year = pool.insert(g.year_get());
+		r.cloneof = pool.insert(db_name_strip(prefix, g.cloneof_get()));
+		r.romof = pool.insert(db_name_strip(prefix, g.romof_get()));
+		r.flag = 0;
+		if (g.flag_get(emulator::flag_derived_vector))
+			r.flag |= emulator::flag_derived_vector;
+		if (g.flag_get(emulator::flag_derived_vertical))
+			r.flag |= emulator::flag_derived_vertical;
+		if (g.flag_get(emulator::flag_derived_resource))
+			r.flag |= emulator::flag_derived_resource;
+		r.play = g.play_get();
+		r.size = g.size_get();
+		r.sizex = g.sizex_get();
+		r.sizey = g.sizey_get();
+		r.aspectx = g.aspectx_get();
+		r.aspecty = g.aspecty_get();
+
+		// resolve the parent and check the references like game_set::cache()
+		bool linked = true;
+
+		r.parent = DB_NONE;
+		if (g.cloneof_get().length() != 0) {
+			map<string, uint32>::const_iterator j = name_map.find(g.cloneof_get());
+			if (j == name_map.end()) {
+				linked = false;
+			} else {
+				r.parent = j->second;
+
+				// check for a circular reference
+				uint32 k = j->second;
+				unsigned n = 0;
+				while (linked && n <= game_map.size()) {
+					if (k == i) {
+						linked = false;
+						break;
+					}
+					if (game_map[k]->cloneof_get().length() == 0)
+						break;
+					map<string, uint32>::const_iterator l = name_map.find(game_map[k]->cloneof_get());
+					if (l == name_map.end())
+						break;
+					k = l->second;
+					++n;
+				}
+				if (n > game_map.size())
+					linked = false;
+			}
+		}
+
+		if (linked && g.romof_get().length() != 0) {
+			map<string, uint32>::const_iterator j = name_map.find(g.romof_get());
+			if (j == name_map.end()) {
+				linked = false;
+			} else {
+				// check for a circular reference
+				uint32 k = j->second;
+				unsigned n = 0;
+				while (n <= game_map.size()) {
+					if (k == i) {
+						linked = false;
+						break;
+					}
+					if (game_map[k]->romof_get().length() == 0)
+						break;
+					map<string, uint32>::const_iterator l = name_map.find(game_map[k]->romof_get());
+					if (l == name_map.end())
+						break;
+					k = l->second;
+					++n;
+				}
+				if (n > game_map.size())
+					linked = false;
+			}
+		}
+
+		// without the check, the errors are reported by game_set::cache()
+		r.db_flag = linked ? DB_FLAG_LINKED : 0;
+
+		r.device_begin = device_map.size();
+		r.device_count = 0;
+		for (machinedevice_container::const_iterator j = g.machinedevice_bag_get().begin(); j != g.machinedevice_bag_get().end(); ++j) {
+			db_device d;
+			d.name = pool.insert(j->name);
+			d.ext_begin = ext_map.size();
+			d.ext_count = 0;
+			for (machinedevice_ext_container::const_iterator k = j->ext_bag.begin(); k != j->ext_bag.end(); ++k) {
+				ext_map.push_back(pool.insert(*k));
+				++d.ext_count;
+			}
+			device_map.push_back(d);
+			++r.device_count;
+		}
+
+		record_map.push_back(r);
+	}
+
+	header.game_count = record_map.size();
+	header.device_count = device_map.size();
+	header.ext_count = ext_map.size();
+	header.pool_size = pool.data_get().length();
+
+	FILE* f = fopen(cpath_export(tmp_file), "wb");
+	if (!f) {
+		log_std(("menu:emudb: failed creating %s\n", cpath_export(tmp_file)));
+		return false;
+	}
+
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+	if (ok && record_map.size())
+		ok = fwrite(&record_map[0], sizeof(db_game), record_map.size(), f) == record_map.size();
+	if (ok && device_map.size())
+		ok = fwrite(&device_map[0], sizeof(db_device), device_map.size(), f) == device_map.size();
+	if (ok && ext_map.size())
+		ok = fwrite(&ext_map[0], sizeof(uint32), ext_map.size(), f) == ext_map.size();
+	if (ok && pool.data_get().length())
+		ok = fwrite(pool.data_get().data(), pool.data_get().length(), 1, f) == 1;
+
+	if (fclose(f) != 0)
+		ok = false;
+
+	if (!ok || rename(cpath_export(tmp_file), cpath_export(db_file)) != 0) {
+		log_std(("menu:emudb: failed writing %s\n", cpath_export(db_file)));
+		remove(cpath_export(tmp_file));
+		return false;
+	}
+
+	log_std(("menu:emudb: saved %s, %u games, %u bytes of strings\n", cpath_export(db_file), header.game_count, header.pool_size));
+
+	return true;
+}
+
+/**
+ * Check that a string offset is inside the pool.
+ */
+static inline bool db_string_check(const db_header* header, uint32 offset)
+{
+	return offset < header->pool_size;
+}
+
+bool mame_info::load_game_db(game_set& gar)
+{
+	string db_file = db_file_get();
+	string prefix = user_name_get() + "/";
+	uint32 exe_size, exe_mtime, xml_size, xml_mtime;
+	struct stat st;
+	unsigned char* data;
+	bool mapped;
+	int f;
+
+	if (!db_stat(exe_size, exe_mtime, xml_size, xml_mtime))
+		return false;
+
+	int flags = O_RDONLY;
+#ifdef O_BINARY
+	flags |= O_BINARY;
+#endif
+	f = open(cpath_export(db_file), flags);
+	if (f == -1)
+		return false;
+
+	if (fstat(f, &st) != 0 || st.st_size < (off_t)sizeof(db_header)) {
+		close(f);
+		return false;
+	}
+
+	data = 0;
+	mapped = false;
+#if HAVE_SYS_MMAN_H
+	void* map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, f, 0);
+	if (map != MAP_FAILED) {
+		data = static_cast<unsigned char*>(map);
+		mapped = true;
+	}
+#endif
+	if (!data) {
+		data = static_cast<unsigned char*>(malloc(st.st_size));
+		if (!data || read(f, data, st.st_size) != st.st_size) {
+			free(data);
+			close(f);
+			return false;
+		}
+	}
+
+	close(f);
+
+	const db_header* header = reinterpret_cast<const db_header*>(data);
+	const db_game* record_map = 0;
+	const db_device* device_map = 0;
+	const uint32* ext_map = 0;
+	const char* pool = 0;
+	size_t remaining = st.st_size - sizeof(db_header);
+	bool ok = true;
+
+	// check the header
+	if (memcmp(header->magic, DB_MAGIC, sizeof(header->magic)) != 0
+		|| header->version != DB_VERSION
+		|| header->endian != 0x01020304)
+		ok = false;
+
+	// check every count against the remaining size before using it
+	if (ok && header->game_count <= remaining / sizeof(db_game)) {
+		record_map = reinterpret_cast<const db_game*>(header + 1);
+		remaining -= header->game_count * sizeof(db_game);
+	} else
+		ok = false;
+	if (ok && header->device_count <= remaining / sizeof(db_device)) {
+		device_map = reinterpret_cast<const db_device*>(record_map + header->game_count);
+		remaining -= header->device_count * sizeof(db_device);
+	} else
+		ok = false;
+	if (ok && header->ext_count <= remaining / sizeof(uint32)) {
+		ext_map = reinterpret_cast<const uint32*>(device_map + header->device_count);
+		remaining -= header->ext_count * sizeof(uint32);
+	} else
+		ok = false;
+	if (ok && header->pool_size != 0 && header->pool_size == remaining) {
+		pool = reinterpret_cast<const char*>(ext_map + header->ext_count);
+		if (pool[header->pool_size - 1] != 0)
+			ok = false;
+	} else
+		ok = false;
+
+	if (!ok)
+		log_std(("menu:emudb: invalid %s\n", cpath_export(db_file)));
+
+	// check the emulator and the xml file
+	if (ok && (header->exe_size != exe_size || header->exe_mtime != exe_mtime
+		|| header->xml_size != xml_size || header->xml_mtime != xml_mtime)) {
+		log_std(("menu:emudb: outdated %s\n", cpath_export(db_file)));
+		ok = false;
+	}
+
+	// check all the references
+	for (uint32 i = 0; ok && i < header->game_count; ++i) {
+		const db_game* r = &record_map[i];
+		if (!db_string_check(header, r->name) || !db_string_check(header, r->description)
+			|| !db_string_check(header, r->manufacturer) || !db_string_check(header, r->year)
+			|| !db_string_check(header, r->cloneof) || !db_string_check(header, r->romof)
+			|| (r->parent != DB_NONE && r->parent >= header->game_count)
+			|| r->play > play_preliminary
+			|| r->device_begin > header->device_count || r->device_count > header->device_count - r->device_begin)
+			ok = false;
+	}
+	for (uint32 i = 0; ok && i < header->device_count; ++i) {
+		const db_device* d = &device_map[i];
+		if (!db_string_check(header, d->name)
+			|| d->ext_begin > header->ext_count || d->ext_count > header->ext_count - d->ext_begin)
+			ok = false;
+	}
+	for (uint32 i = 0; ok && i < header->ext_count; ++i) {
+		if (!db_string_check(header, ext_map[i]))
+			ok = false;
+	}
+
+	if (ok) {
+		vector<game_set::iterator> it_map(header->game_count);
+		game_set::iterator hint;
+
+		// the records are sorted by name, insert them at the same position
+		if (header->game_count)
+			hint = gar.lower_bound(game(prefix + (pool + record_map[0].name)));
+
+		for (uint32 i = 0; i < header->game_count; ++i) {
+			const db_game* r = &record_map[i];
+			game g;
+
+			g.emulator_set(this);
+			g.name_set(prefix + (pool + r->name));
+			g.auto_description_set(pool + r->description);
+			g.manufacturer_set(pool + r->manufacturer);
+			g.year_set(pool + r->year);
+			if (pool[r->cloneof])
+				g.cloneof_set(prefix + (pool + r->cloneof));
+			if (pool[r->romof])
+				g.romof_set(prefix + (pool + r->romof));
+			g.flag_set(true, r->flag & DB_FLAG_GAME);
+			g.play_set(static_cast<play_t>(r->play));
+			g.size_set(r->size);
+			g.sizex_set(r->sizex);
+			g.sizey_set(r->sizey);
+			g.aspectx_set(r->aspectx);
+			g.aspecty_set(r->aspecty);
+
+			for (uint32 j = 0; j < r->device_count; ++j) {
+				const db_device* d = &device_map[r->device_begin + j];
+				machinedevice m;
+				m.name = pool + d->name;
+				for (uint32 k = 0; k < d->ext_count; ++k)
+					m.ext_bag.insert(m.ext_bag.end(), string(pool + ext_map[d->ext_begin + k]));
+				g.machinedevice_bag_get().insert(g.machinedevice_bag_get().end(), m);
+			}
+
+			hint = gar.insert(hint, g);
+			it_map[i] = hint;
+			++hint;
+		}
+
+		// set the precomputed parents
+		for (uint32 i = 0; i < header->game_count; ++i) {
+			const db_game* r = &record_map[i];
+			if ((r->db_flag & DB_FLAG_LINKED) == 0)
+				continue;
+			// the game may be already defined by another emulator
+			if (it_map[i]->emulator_get() != this)
+				continue;
+			if (r->parent != DB_NONE) {
+				if (it_map[r->parent]->emulator_get() != this)
+					continue;
+				it_map[i]->parent_set(&*it_map[r->parent]);
+			}
+			it_map[i]->linked_set(true);
+		}
+
+		log_std(("menu:emudb: loaded %s, %u games\n", cpath_export(db_file), header->game_count));
+	}
+
+#if HAVE_SYS_MMAN_H
+	if (mapped)
+		munmap(data, st.st_size);
+	else
+#endif
+		free(data);
+
+	return ok;
+}
@@ -738,17 +738,31 @@ bool mame_info::is_present_xml()
 	return access(cpath_export(xml_file), R_OK) == 0;
 }
 
+bool mame_info::load_game_cache(game_set& gar)
+{
+	// use the binary snapshot if it's updated
+	if (load_game_db(gar))
+		return true;
+
+	if (!load_game_xml(gar))
+		return false;
+
+	save_game_db(gar);
+
+	return true;
+}
+
 bool mame_info::load_game(game_set& gar, bool quiet)
 {
 	if (file_ext(config_exe_path_get()) == ".bat") {
 		if (is_present_xml()) {
-			return load_game_xml(gar);
+			return load_game_cache(gar);
 		}
 
 		target_err("Impossible to generate the '%s' information file with a BAT file.\n", user_name_get().c_str());
 	} else {
 		if (update_xml()) {
-			return load_game_xml(gar);
+			return load_game_cache(gar);
 		}
 
 		target_err("Error generating the '%s' information file with -listxml.\n", user_name_get().c_str());
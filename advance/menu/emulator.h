@@ -190,6 +190,11 @@ protected:
 
 	bool load_xml(std::istream& is, game_set& gar);
 	bool load_game_xml(game_set& gar);
+	std::string db_file_get();
+	bool db_stat(uint32& exe_size, uint32& exe_mtime, uint32& xml_size, uint32& xml_mtime);
+	bool load_game_db(game_set& gar);
+	bool save_game_db(const game_set& gar);
+	bool load_game_cache(game_set& gar);
 	bool update_xml();
 	bool is_update_xml();
 	bool is_present_xml();
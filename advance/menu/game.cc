@@ -405,6 +405,10 @@ void game_set::cache(merge_t merge)
 		// erase the clone list
 		i->clone_bag_erase();
 
+		// parent and romof already computed and checked
+		if (i->linked_get())
+			continue;
+
 		// test cloneof and compute the parent
 		if (i->cloneof_get().length() != 0) {
 			iterator j = find(game(i->cloneof_get()));
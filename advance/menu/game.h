@@ -88,6 +88,7 @@ class game {
 	static const unsigned flag_tree_present = 0x40;
 	static const unsigned flag_duplicate = 0x80;
 	static const unsigned flag_filled = 0x100;
+	static const unsigned flag_linked = 0x200;
 
 	friend class game_set;
 
@@ -202,6 +203,8 @@ public:
 	bool software_get() const { return flag_get(flag_software); }
 	void filled_set(bool A) const { flag_set(A, flag_filled); }
 	bool filled_get() const { return flag_get(flag_filled); }
+	void linked_set(bool A) const { flag_set(A, flag_linked); }
+	bool linked_get() const { return flag_get(flag_linked); }
 	void time_set(unsigned A) const { flag |= flag_time_set; time = A; }
 	bool is_time_set() const { return flag_get(flag_time_set); }
 
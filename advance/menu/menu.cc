@@ -659,6 +659,30 @@ void backdrop_index_set(unsigned pos, menu_array& gc, unsigned back_pos, listpre
 	backdrop_game_set(effective_game, back_pos, preview, current, highlight, clip, rs);
 }
 
+void backdrop_index_prefetch(unsigned pos, menu_array& gc, unsigned back_pos, listpreview_t preview, const config_state& rs)
+{
+	const game* effective_game;
+
+	if (pos < gc.size() && gc[pos]->has_game())
+		effective_game = &gc[pos]->game_get().clone_best_get();
+	else
+		return;
+
+	resource backdrop_res;
+	unsigned aspectx;
+	unsigned aspecty;
+	if (preview == preview_snap || preview == preview_title) {
+		aspectx = effective_game->aspectx_get();
+		aspecty = effective_game->aspecty_get();
+	} else {
+		aspectx = 0;
+		aspecty = 0;
+	}
+
+	if (backdrop_find_preview_default(backdrop_res, aspectx, aspecty, preview, effective_game, rs))
+		int_backdrop_prefetch(back_pos, backdrop_res, aspectx, aspecty);
+}
+
 //--------------------------------------------------------------------------
 // Menu run
 
@@ -1637,6 +1661,22 @@ static int run_menu_user(config_state& rs, bool flipxy, menu_array& gc, sort_ite
 
 		int_update(rs.mode_get() != mode_full_mixed && rs.mode_get() != mode_list_mixed);
 
+		// decode in background the previews of the next and previous games
+		// in the mixed modes the cells layout depends on the game, and they are not prefetched
+		if (int_backdrop_prefetch_is_active() && rs.mode_get() != mode_full_mixed && rs.mode_get() != mode_list_mixed) {
+			if (backdrop_mac == 1) {
+				backdrop_index_prefetch(pos_base + pos_rel + 1, gc, 0, effective_preview, rs);
+				if (pos_base + pos_rel > 0)
+					backdrop_index_prefetch(pos_base + pos_rel - 1, gc, 0, effective_preview, rs);
+			} else if (backdrop_mac > 1 && pos_rel_max <= backdrop_mac) {
+				for (int i = 0; i < coln; ++i) {
+					backdrop_index_prefetch(pos_base + pos_rel_max + i, gc, pos_rel_max - coln + i, effective_preview, rs);
+					if (pos_base >= coln)
+						backdrop_index_prefetch(pos_base - coln + i, gc, i, effective_preview, rs);
+				}
+			}
+		}
+
 		log_std(("menu: wait begin\n"));
 
 		int_idle_0_enable(rs.current_game && rs.current_game->emulator_get()->is_runnable());
@@ -35,6 +35,10 @@
 #include <deque>
 #include <cmath>
 
+#ifdef USE_BACKDROP_THREAD
+#include <pthread.h>
+#endif
+
 using namespace std;
 
 // -------------------------------------------------------------------------
@@ -1047,6 +1051,29 @@ void int_clear_overlay(void)
 // -------------------------------------------------------------------------
 // Cell Position
 
+// Video state used to draw the images.
+// It's captured by the main thread, because the decoder thread must not read the video globals
+struct video_state_t {
+	adv_color_def def; // color format
+	unsigned orientation; // orientation flags
+	unsigned size_x; // screen size
+	unsigned size_y;
+
+	static video_state_t current();
+};
+
+video_state_t video_state_t::current()
+{
+	video_state_t state;
+
+	state.def = video_color_def();
+	state.orientation = int_orientation;
+	state.size_x = video_size_x();
+	state.size_y = video_size_y();
+
+	return state;
+}
+
 class cell_pos_t {
 public:
 	// Position of the cell in the screen
@@ -1061,7 +1088,7 @@ public:
 	int real_dx;
 	int real_dy;
 
-	void compute_size(unsigned* rx, unsigned* ry, const adv_bitmap* bitmap, unsigned aspectx, unsigned aspecty, double aspect_expand);
+	void compute_size(unsigned* rx, unsigned* ry, const adv_bitmap* bitmap, unsigned aspectx, unsigned aspecty, double aspect_expand, const video_state_t& video) const;
 	void draw_backdrop(const adv_bitmap* map, const adv_color_rgb& background);
 	void draw_clip(const adv_bitmap* map, adv_color_rgb* rgb_map, unsigned rgb_max, unsigned aspectx, unsigned aspecty, double aspect_expand, const adv_color_rgb& background, bool clear, int resizeeffect);
 	void clear(const adv_color_rgb& background);
@@ -1078,9 +1105,9 @@ void cell_pos_t::redraw()
 	video_write_unlock(real_x, real_y, real_dx, real_dy, 0);
 }
 
-void cell_pos_t::compute_size(unsigned* rx, unsigned* ry, const adv_bitmap* bitmap, unsigned aspectx, unsigned aspecty, double aspect_expand)
+void cell_pos_t::compute_size(unsigned* rx, unsigned* ry, const adv_bitmap* bitmap, unsigned aspectx, unsigned aspecty, double aspect_expand, const video_state_t& video) const
 {
-	if (int_orientation & ADV_ORIENTATION_FLIP_XY) {
+	if (video.orientation & ADV_ORIENTATION_FLIP_XY) {
 		unsigned t = aspectx;
 		aspectx = aspecty;
 		aspecty = t;
@@ -1096,8 +1123,8 @@ void cell_pos_t::compute_size(unsigned* rx, unsigned* ry, const adv_bitmap* bitm
 		aspecty = 1;
 	}
 
-	aspectx *= 3 * video_size_x();
-	aspecty *= 4 * video_size_y();
+	aspectx *= 3 * video.size_x;
+	aspecty *= 4 * video.size_y;
 
 	if (aspectx * real_dy > aspecty * real_dx) {
 		*rx = real_dx;
@@ -1193,7 +1220,7 @@ void cell_pos_t::draw_clip(const adv_bitmap* bitmap, adv_color_rgb* rgb_map, uns
 	// compute the size of the bitmap
 	unsigned rel_dx;
 	unsigned rel_dy;
-	compute_size(&rel_dx, &rel_dy, bitmap, aspectx, aspecty, aspect_expand);
+	compute_size(&rel_dx, &rel_dy, bitmap, aspectx, aspecty, aspect_expand, video_state_t::current());
 
 	// adjust the destination range if too big
 	if (dst_dx > rel_dx) {
@@ -1354,9 +1381,28 @@ class backdrop_data {
 	unsigned aspectx;
 	unsigned aspecty;
 
+	// Background decoding, protected by the lock of the backdrop_cache
+	friend class backdrop_cache;
+	enum job_t {
+		job_none, ///< Nothing to do.
+		job_queued, ///< Waiting in the decoder queue.
+		job_running, ///< Decoding in progress.
+		job_done ///< Decoded, the bitmap is in job_map.
+	} job;
+	bool job_prefetch; ///< Requested by a prefetch, it's cancelled when the cursor moves.
+	bool job_failed; ///< The decoding failed, don't retry it.
+	bool job_orphan; ///< Destroyed while running, it's deleted by the decoder thread.
+	adv_bitmap* job_map; ///< Result of the decoding.
+	cell_pos_t job_pos; ///< Parameters of the decoding.
+	adv_color_rgb job_background;
+	double job_aspect_expand;
+	int job_resizeeffect;
+	video_state_t job_video;
+
 	void icon_apply(adv_bitmap* bitmap, adv_bitmap* bitmap_mask, adv_color_rgb* rgb, unsigned* rgb_max, const adv_color_rgb& background);
 	adv_bitmap* image_load(const resource& res, adv_color_rgb* rgb, unsigned* rgb_max, const adv_color_rgb& background);
-	adv_bitmap* adapt(adv_bitmap* bitmap, adv_color_rgb* rgb, unsigned* rgb_max, unsigned dst_dx, unsigned dst_dy, int resizeeffect);
+	adv_bitmap* adapt(adv_bitmap* bitmap, adv_color_rgb* rgb, unsigned* rgb_max, unsigned dst_dx, unsigned dst_dy, int resizeeffect, const video_state_t& video);
+	adv_bitmap* decode(const cell_pos_t* cell, const adv_color_rgb& background, double aspect_expand, int resizeeffect, const video_state_t& video);
 
 public:
 	backdrop_data(const resource& Ares, unsigned Atarget_dx, unsigned Atarget_dy, unsigned Aaspectx, unsigned Aaspecty);
@@ -1370,6 +1416,8 @@ public:
 	unsigned target_dy_get() const { return target_dy; }
 	unsigned aspectx_get() const { return aspectx; }
 	unsigned aspecty_get() const { return aspecty; }
+	unsigned memory_get() const { return map ? map->size_y * map->bytes_per_scanline : 0; }
+	unsigned job_memory_get() const;
 
 	void load(struct cell_pos_t* cell, const adv_color_rgb& background, double aspect_expand, int resizeeffect);
 };
@@ -1378,12 +1426,33 @@ backdrop_data::backdrop_data(const resource& Ares, unsigned Atarget_dx, unsigned
 	: res(Ares), target_dx(Atarget_dx), target_dy(Atarget_dy), aspectx(Aaspectx), aspecty(Aaspecty)
 {
 	map = 0;
+	job = job_none;
+	job_prefetch = false;
+	job_failed = false;
+	job_orphan = false;
+	job_map = 0;
 }
 
 backdrop_data::~backdrop_data()
 {
 	if (map)
 		adv_bitmap_free(map);
+	if (job_map)
+		adv_bitmap_free(job_map);
+}
+
+// Memory used by the decoding, the size of the target if it's not yet known
+unsigned backdrop_data::job_memory_get() const
+{
+	switch (job) {
+	case job_queued:
+	case job_running:
+		return target_dx * target_dy * color_def_bytes_per_pixel_get(job_video.def);
+	case job_done:
+		return job_map ? job_map->size_y * job_map->bytes_per_scanline : 0;
+	default:
+		return 0;
+	}
 }
 
 void backdrop_data::icon_apply(adv_bitmap* bitmap, adv_bitmap* bitmap_mask, adv_color_rgb* rgb, unsigned* rgb_max, const adv_color_rgb& background)
@@ -1530,7 +1599,9 @@ adv_bitmap* backdrop_data::image_load(const resource& res, adv_color_rgb* rgb, u
 	return 0;
 }
 
-adv_bitmap* backdrop_data::adapt(adv_bitmap* bitmap, adv_color_rgb* rgb_map, unsigned* rgb_max, unsigned dst_dx, unsigned dst_dy, int resizeeffect)
+// The pipelines use their own buffers, and the video state is passed by the caller,
+// because it's called also by the decoder thread
+adv_bitmap* backdrop_data::adapt(adv_bitmap* bitmap, adv_color_rgb* rgb_map, unsigned* rgb_max, unsigned dst_dx, unsigned dst_dy, int resizeeffect, const video_state_t& video)
 {
 	// source range and steps
 	unsigned char* ptr = bitmap->ptr;
@@ -1540,7 +1611,7 @@ adv_bitmap* backdrop_data::adapt(adv_bitmap* bitmap, adv_color_rgb* rgb_map, uns
 	int dy = bitmap->size_y;
 
 	// set the correct orientation
-	if (int_orientation & ADV_ORIENTATION_FLIP_XY) {
+	if (video.orientation & ADV_ORIENTATION_FLIP_XY) {
 		int t;
 		t = dp;
 		dp = dw;
@@ -1549,16 +1620,16 @@ adv_bitmap* backdrop_data::adapt(adv_bitmap* bitmap, adv_color_rgb* rgb_map, uns
 		dx = dy;
 		dy = t;
 	}
-	if (int_orientation & ADV_ORIENTATION_FLIP_X) {
+	if (video.orientation & ADV_ORIENTATION_FLIP_X) {
 		ptr = ptr + (dx - 1) * dp;
 		dp = -dp;
 	}
-	if (int_orientation & ADV_ORIENTATION_FLIP_Y) {
+	if (video.orientation & ADV_ORIENTATION_FLIP_Y) {
 		ptr = ptr + (dy - 1) * dw;
 		dw = -dw;
 	}
 
-	adv_bitmap* raw = adv_bitmap_alloc(dst_dx, dst_dy, video_bytes_per_pixel());
+	adv_bitmap* raw = adv_bitmap_alloc(dst_dx, dst_dy, color_def_bytes_per_pixel_get(video.def));
 
 	if (resizeeffect != COMBINE_NONE && dst_dx >= 2 * dx && dst_dy >= 2 * dy) {
 		struct video_pipeline_struct pipeline;
@@ -1577,7 +1648,7 @@ adv_bitmap* backdrop_data::adapt(adv_bitmap* bitmap, adv_color_rgb* rgb_map, uns
 			sdy = 2 * dy;
 		}
 
-		adv_color_def scaled_def = video_color_def();
+		adv_color_def scaled_def = video.def;
 		adv_bitmap* scaled = adv_bitmap_alloc(sdx, sdy, color_def_bytes_per_pixel_get(scaled_def));
 
 		// blit the bitmap on a scaled one with effect
@@ -1590,7 +1661,11 @@ adv_bitmap* backdrop_data::adapt(adv_bitmap* bitmap, adv_color_rgb* rgb_map, uns
 		default: combine = VIDEO_COMBINE_Y_NONE; break;
 		}
 
-		video_pipeline_init(&pipeline);
+		if (video_pipeline_init_private(&pipeline) != 0) {
+			adv_bitmap_free(scaled);
+			adv_bitmap_free(raw);
+			return 0;
+		}
 
 		video_pipeline_target(&pipeline, scaled->ptr, scaled->bytes_per_scanline, scaled_def);
 
@@ -1599,7 +1674,7 @@ adv_bitmap* backdrop_data::adapt(adv_bitmap* bitmap, adv_color_rgb* rgb_map, uns
 		uint8 palette8[256];
 		if (bitmap->bytes_per_pixel == 1) {
 			for (unsigned i = 0; i < *rgb_max; ++i) {
-				adv_pixel p = video_pixel_get(rgb_map[i].red, rgb_map[i].green, rgb_map[i].blue);
+				adv_pixel p = pixel_make_from_def(rgb_map[i].red, rgb_map[i].green, rgb_map[i].blue, video.def);
 				palette32[i] = p;
 				palette16[i] = p;
 				palette8[i] = p;
@@ -1622,9 +1697,13 @@ adv_bitmap* backdrop_data::adapt(adv_bitmap* bitmap, adv_color_rgb* rgb_map, uns
 		dy = scaled->size_y;
 		combine = VIDEO_COMBINE_Y_NONE;
 
-		video_pipeline_init(&pipeline);
+		if (video_pipeline_init_private(&pipeline) != 0) {
+			adv_bitmap_free(scaled);
+			adv_bitmap_free(raw);
+			return 0;
+		}
 
-		video_pipeline_target(&pipeline, raw->ptr, raw->bytes_per_scanline, video_color_def());
+		video_pipeline_target(&pipeline, raw->ptr, raw->bytes_per_scanline, video.def);
 
 		video_pipeline_direct(&pipeline, dst_dx, dst_dy, dx, dy, dw, dp, scaled_def, combine);
 
@@ -1642,16 +1721,19 @@ adv_bitmap* backdrop_data::adapt(adv_bitmap* bitmap, adv_color_rgb* rgb_map, uns
 		if (dst_dy < dy)
 			combine |= VIDEO_COMBINE_Y_MEAN;
 
-		video_pipeline_init(&pipeline);
+		if (video_pipeline_init_private(&pipeline) != 0) {
+			adv_bitmap_free(raw);
+			return 0;
+		}
 
-		video_pipeline_target(&pipeline, raw->ptr, raw->bytes_per_scanline, video_color_def());
+		video_pipeline_target(&pipeline, raw->ptr, raw->bytes_per_scanline, video.def);
 
 		uint32 palette32[256];
 		uint16 palette16[256];
 		uint8 palette8[256];
 		if (bitmap->bytes_per_pixel == 1) {
 			for (unsigned i = 0; i < *rgb_max; ++i) {
-				adv_pixel p = video_pixel_get(rgb_map[i].red, rgb_map[i].green, rgb_map[i].blue);
+				adv_pixel p = pixel_make_from_def(rgb_map[i].red, rgb_map[i].green, rgb_map[i].blue, video.def);
 				palette32[i] = p;
 				palette16[i] = p;
 				palette8[i] = p;
@@ -1670,70 +1752,271 @@ adv_bitmap* backdrop_data::adapt(adv_bitmap* bitmap, adv_color_rgb* rgb_map, uns
 	return raw;
 }
 
-void backdrop_data::load(struct cell_pos_t* cell, const adv_color_rgb& background, double aspect_expand, int resizeeffect)
+// Load and resize the image without changing the object, it's called also by the decoder thread
+adv_bitmap* backdrop_data::decode(const cell_pos_t* cell, const adv_color_rgb& background, double aspect_expand, int resizeeffect, const video_state_t& video)
 {
-	if (map)
-		return; // already loaded
-
 	adv_color_rgb rgb[256];
 	unsigned rgb_max;
 
-	adv_bitmap* bitmap = image_load(res_get(), rgb, &rgb_max, background);
+	adv_bitmap* bitmap = image_load(res, rgb, &rgb_max, background);
 	if (!bitmap)
-		return;
+		return 0;
 
 	// compute the size of the bitmap
 	unsigned dst_dx;
 	unsigned dst_dy;
 
-	cell->compute_size(&dst_dx, &dst_dy, bitmap, aspectx, aspecty, aspect_expand);
+	cell->compute_size(&dst_dx, &dst_dy, bitmap, aspectx, aspecty, aspect_expand, video);
 
-	adv_bitmap* scaled_bitmap = adapt(bitmap, rgb, &rgb_max, dst_dx, dst_dy, resizeeffect);
+	adv_bitmap* scaled_bitmap = adapt(bitmap, rgb, &rgb_max, dst_dx, dst_dy, resizeeffect, video);
 
 	adv_bitmap_free(bitmap);
 
-	if (!scaled_bitmap)
-		return;
+	return scaled_bitmap;
+}
 
-	map = scaled_bitmap;
+void backdrop_data::load(struct cell_pos_t* cell, const adv_color_rgb& background, double aspect_expand, int resizeeffect)
+{
+	if (map)
+		return; // already loaded
+
+	map = decode(cell, background, aspect_expand, resizeeffect, video_state_t::current());
 }
 
 // -------------------------------------------------------------------------
 // Backdrop Cache
 
+// Max memory used by the images in the cache
+#define BACKDROP_CACHE_MEMORY (64 * 1024 * 1024)
+
+// The cache also decodes the images in a background thread.
+// The images requested are queued, the ones of the visible cells
+// before the ones prefetched. The decoded bitmap is moved in the
+// backdrop_data only by the main thread, calling complete().
 class backdrop_cache {
-	unsigned max;
+	unsigned max; // max number of images
+	unsigned memory_max; // max memory of the images
 	list<backdrop_data*> bag;
+
+#ifdef USE_BACKDROP_THREAD
+	bool thread_active;
+	bool thread_quit;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t job_cond; // signaled when a job is queued
+	pthread_cond_t done_cond; // signaled when a job is completed
+	list<backdrop_data*> queue; // jobs to decode, the first is the next
+
+	static void* thread_func(void* arg);
+	void thread_run();
+	void complete(backdrop_data* data);
+	void dequeue(backdrop_data* data);
+#endif
+
+	void wait(backdrop_data* data);
+	unsigned memory_get(backdrop_data* data);
+
 public:
-	backdrop_cache(unsigned Amax);
+	backdrop_cache(unsigned Amax, unsigned Amemory_max);
 	~backdrop_cache();
 
+	bool is_async() const;
+
 	void reduce();
 	void free(backdrop_data* data);
+	void destroy(backdrop_data* data);
 	backdrop_data* alloc(const resource& res, unsigned dx, unsigned dy, unsigned aspectx, unsigned aspecty);
+
+	void load(backdrop_data* data, cell_pos_t* cell, const adv_color_rgb& background, double aspect_expand, int resizeeffect);
+	void request(backdrop_data* data, const cell_pos_t* cell, const adv_color_rgb& background, double aspect_expand, int resizeeffect, bool prefetch);
+	bool collect(backdrop_data* data);
+	void prefetch(const resource& res, const cell_pos_t* cell, unsigned aspectx, unsigned aspecty, const adv_color_rgb& background, double aspect_expand, int resizeeffect);
+	void prefetch_cancel();
 };
 
-backdrop_cache::backdrop_cache(unsigned Amax)
+backdrop_cache::backdrop_cache(unsigned Amax, unsigned Amemory_max)
 {
 	max = Amax;
+	memory_max = Amemory_max;
+
+#ifdef USE_BACKDROP_THREAD
+	thread_quit = false;
+	pthread_mutex_init(&lock, 0);
+	pthread_cond_init(&job_cond, 0);
+	pthread_cond_init(&done_cond, 0);
+
+	thread_active = pthread_create(&thread, 0, thread_func, this) == 0;
+	if (!thread_active) {
+		log_std(("ERROR:text: backdrop thread creation failed, decode synchronously\n"));
+	}
+#endif
 }
 
 backdrop_cache::~backdrop_cache()
 {
+#ifdef USE_BACKDROP_THREAD
+	if (thread_active) {
+		pthread_mutex_lock(&lock);
+		thread_quit = true;
+		for (list<backdrop_data*>::iterator i = queue.begin(); i != queue.end(); ++i)
+			(*i)->job = backdrop_data::job_none;
+		queue.clear();
+		pthread_cond_signal(&job_cond);
+		pthread_mutex_unlock(&lock);
+
+		pthread_join(thread, 0);
+	}
+
+	pthread_cond_destroy(&done_cond);
+	pthread_cond_destroy(&job_cond);
+	pthread_mutex_destroy(&lock);
+#endif
+
 	for (list<backdrop_data*>::iterator i = bag.begin(); i != bag.end(); ++i)
 		delete *i;
 }
 
+#ifdef USE_BACKDROP_THREAD
+void* backdrop_cache::thread_func(void* arg)
+{
+	static_cast<backdrop_cache*>(arg)->thread_run();
+	return 0;
+}
+
+void backdrop_cache::thread_run()
+{
+	pthread_mutex_lock(&lock);
+
+	while (true) {
+		while (!thread_quit && queue.empty())
+			pthread_cond_wait(&job_cond, &lock);
+
+		if (thread_quit)
+			break;
+
+		backdrop_data* data = queue.front();
+		queue.pop_front();
+		data->job = backdrop_data::job_running;
+
+		pthread_mutex_unlock(&lock);
+
+		// the job parameters are not changed while running,
+		// and the errors are stored in the buffers of this thread
+		error_reset();
+		adv_bitmap* bitmap = data->decode(&data->job_pos, data->job_background, data->job_aspect_expand, data->job_resizeeffect, data->job_video);
+		if (!bitmap)
+			log_std(("text: backdrop decoding of %s failed, %s\n", data->res_get().path_get().c_str(), error_get()));
+
+		pthread_mutex_lock(&lock);
+
+		if (data->job_orphan) {
+			// destroyed by the main thread while running
+			if (bitmap)
+				adv_bitmap_free(bitmap);
+			delete data;
+			continue;
+		}
+
+		data->job_map = bitmap;
+		data->job_failed = bitmap == 0;
+		data->job = backdrop_data::job_done;
+
+		pthread_cond_broadcast(&done_cond);
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+// Move the decoded bitmap in the image. The lock must be held
+void backdrop_cache::complete(backdrop_data* data)
+{
+	if (data->job == backdrop_data::job_done) {
+		if (!data->map) {
+			data->map = data->job_map;
+			data->job_map = 0;
+		}
+		data->job = backdrop_data::job_none;
+	}
+}
+
+// Remove the image from the queue if not yet started. The lock must be held
+void backdrop_cache::dequeue(backdrop_data* data)
+{
+	if (data->job == backdrop_data::job_queued) {
+		queue.remove(data);
+		data->job = backdrop_data::job_none;
+	}
+}
+#endif
+
+bool backdrop_cache::is_async() const
+{
+#ifdef USE_BACKDROP_THREAD
+	return thread_active;
+#else
+	return false;
+#endif
+}
+
+// Wait the decoding of the image if it's already running, used only when the image is needed now
+void backdrop_cache::wait(backdrop_data* data)
+{
+#ifdef USE_BACKDROP_THREAD
+	if (!thread_active)
+		return;
+
+	pthread_mutex_lock(&lock);
+
+	dequeue(data);
+
+	while (data->job == backdrop_data::job_running)
+		pthread_cond_wait(&done_cond, &lock);
+
+	complete(data);
+
+	pthread_mutex_unlock(&lock);
+#endif
+}
+
+// Memory used by the image, including the decoding in progress
+unsigned backdrop_cache::memory_get(backdrop_data* data)
+{
+	unsigned memory;
+
+#ifdef USE_BACKDROP_THREAD
+	if (thread_active) {
+		pthread_mutex_lock(&lock);
+
+		complete(data);
+
+		memory = data->memory_get() + data->job_memory_get();
+
+		pthread_mutex_unlock(&lock);
+
+		return memory;
+	}
+#endif
+
+	memory = data->memory_get();
+
+	return memory;
+}
+
 // Reduce the size of the cache
 void backdrop_cache::reduce()
 {
-	// limit the cache size
-	while (bag.size() > max) {
+	unsigned memory = 0;
+	for (list<backdrop_data*>::iterator i = bag.begin(); i != bag.end(); ++i)
+		memory += memory_get(*i);
+
+	// limit the cache size and memory
+	while (bag.size() > max || (bag.size() && memory > memory_max)) {
 		list<backdrop_data*>::iterator i = bag.end();
 		--i;
 		backdrop_data* data = *i;
 		bag.erase(i);
-		delete data;
+		memory -= memory_get(data);
+		destroy(data);
 	}
 }
 
@@ -1741,7 +2024,23 @@ void backdrop_cache::reduce()
 void backdrop_cache::free(backdrop_data* data)
 {
 	if (data) {
-		if (data->is_active()) {
+		bool running = false;
+
+#ifdef USE_BACKDROP_THREAD
+		if (thread_active) {
+			pthread_mutex_lock(&lock);
+
+			// the cursor moved away, don't start the decoding
+			dequeue(data);
+			complete(data);
+
+			running = data->job == backdrop_data::job_running;
+
+			pthread_mutex_unlock(&lock);
+		}
+#endif
+
+		if (data->is_active() || running) {
 			// insert the image in the cache
 			bag.insert(bag.begin(), data);
 		} else {
@@ -1750,6 +2049,30 @@ void backdrop_cache::free(backdrop_data* data)
 	}
 }
 
+// Delete the backdrop image not in the cache.
+// If it's being decoded, the decoder thread deletes it at the end, without waiting for it
+void backdrop_cache::destroy(backdrop_data* data)
+{
+	bool running = false;
+
+#ifdef USE_BACKDROP_THREAD
+	if (thread_active) {
+		pthread_mutex_lock(&lock);
+
+		dequeue(data);
+
+		running = data->job == backdrop_data::job_running;
+		if (running)
+			data->job_orphan = true;
+
+		pthread_mutex_unlock(&lock);
+	}
+#endif
+
+	if (!running)
+		delete data;
+}
+
 backdrop_data* backdrop_cache::alloc(const resource& res, unsigned dx, unsigned dy, unsigned aspectx, unsigned aspecty)
 {
 	// search in the cache
@@ -1771,6 +2094,140 @@ backdrop_data* backdrop_cache::alloc(const resource& res, unsigned dx, unsigned
 	return new backdrop_data(res, dx, dy, aspectx, aspecty);
 }
 
+// Load the image, waiting for the decoder thread if it's already running
+void backdrop_cache::load(backdrop_data* data, cell_pos_t* cell, const adv_color_rgb& background, double aspect_expand, int resizeeffect)
+{
+	wait(data);
+
+	data->load(cell, background, aspect_expand, resizeeffect);
+}
+
+// Queue the image for the decoder thread
+void backdrop_cache::request(backdrop_data* data, const cell_pos_t* cell, const adv_color_rgb& background, double aspect_expand, int resizeeffect, bool prefetch)
+{
+#ifdef USE_BACKDROP_THREAD
+	if (!thread_active)
+		return;
+
+	pthread_mutex_lock(&lock);
+
+	complete(data);
+
+	if (!data->map && !data->job_failed) {
+		if (data->job == backdrop_data::job_none) {
+			data->job = backdrop_data::job_queued;
+			data->job_prefetch = prefetch;
+			data->job_pos = *cell;
+			data->job_background = background;
+			data->job_aspect_expand = aspect_expand;
+			data->job_resizeeffect = resizeeffect;
+			data->job_video = video_state_t::current();
+			if (prefetch)
+				queue.push_back(data);
+			else
+				queue.push_front(data);
+			pthread_cond_signal(&job_cond);
+		} else if (data->job == backdrop_data::job_queued && data->job_prefetch && !prefetch) {
+			// now it's visible, decode it before the others
+			queue.remove(data);
+			queue.push_front(data);
+			data->job_prefetch = false;
+		}
+	}
+
+	pthread_mutex_unlock(&lock);
+#endif
+}
+
+// Get the image decoded by the thread. Return false if the decoding is still pending
+bool backdrop_cache::collect(backdrop_data* data)
+{
+	bool ready = true;
+
+#ifdef USE_BACKDROP_THREAD
+	if (thread_active) {
+		pthread_mutex_lock(&lock);
+
+		complete(data);
+
+		ready = data->job == backdrop_data::job_none;
+
+		pthread_mutex_unlock(&lock);
+	}
+#endif
+
+	return ready;
+}
+
+// Decode in background an image not yet displayed
+void backdrop_cache::prefetch(const resource& res, const cell_pos_t* cell, unsigned aspectx, unsigned aspecty, const adv_color_rgb& background, double aspect_expand, int resizeeffect)
+{
+	if (!is_async())
+		return;
+
+	// search in the cache
+	for (list<backdrop_data*>::iterator i = bag.begin(); i != bag.end(); ++i) {
+		if ((*i)->res_get() == res
+			&& cell->dx == (*i)->target_dx_get()
+			&& cell->dy == (*i)->target_dy_get()) {
+
+			// move it as the most recent
+			backdrop_data* data = *i;
+			bag.erase(i);
+			bag.insert(bag.begin(), data);
+
+			request(data, cell, background, aspect_expand, resizeeffect, true);
+			return;
+		}
+	}
+
+	backdrop_data* data = new backdrop_data(res, cell->dx, cell->dy, aspectx, aspecty);
+
+	bag.insert(bag.begin(), data);
+
+	request(data, cell, background, aspect_expand, resizeeffect, true);
+}
+
+// Cancel all the prefetch not yet started
+void backdrop_cache::prefetch_cancel()
+{
+#ifdef USE_BACKDROP_THREAD
+	if (!thread_active)
+		return;
+
+	set<backdrop_data*> cancelled;
+
+	pthread_mutex_lock(&lock);
+
+	list<backdrop_data*>::iterator i = queue.begin();
+	while (i != queue.end()) {
+		if ((*i)->job_prefetch) {
+			(*i)->job = backdrop_data::job_none;
+			cancelled.insert(*i);
+			i = queue.erase(i);
+		} else {
+			++i;
+		}
+	}
+
+	pthread_mutex_unlock(&lock);
+
+	if (cancelled.empty())
+		return;
+
+	// remove the images never decoded
+	list<backdrop_data*>::iterator j = bag.begin();
+	while (j != bag.end()) {
+		if (cancelled.find(*j) != cancelled.end() && !(*j)->is_active()) {
+			delete *j;
+			j = bag.erase(j);
+		} else {
+			++j;
+		}
+	}
+#endif
+}
+
 // -------------------------------------------------------------------------
 // Clip
 
@@ -2073,6 +2530,9 @@ public:
 	void backdrop_box();
 	bool is_box_flashing();
 	void backdrop_redraw_all();
+	void backdrop_prefetch(int index, const resource& res, unsigned aspectx, unsigned aspecty);
+	void backdrop_prefetch_cancel();
+	bool backdrop_prefetch_is_active();
 
 	void clip_set(int index, const resource& res, unsigned aspectx, unsigned aspecty, bool restart);
 	void clip_clear(int index);
@@ -2098,7 +2558,8 @@ cell_manager::cell_manager(const int_color& Abackdrop_missing_color, const int_c
 	backdrop_expand_factor = expand_factor;
 	backdrop_mac = Amac;
 
-	int_backdrop_cache = new backdrop_cache(backdrop_mac * 2 + Ainc + 1);
+	// keep also the prefetched images of the previous and next row
+	int_backdrop_cache = new backdrop_cache(backdrop_mac * 2 + Ainc + 1 + 2 * (Ainc ? Ainc : 1), BACKDROP_CACHE_MEMORY);
 
 	multiclip = Amulticlip;
 	if (multiclip)
@@ -2123,7 +2584,7 @@ cell_manager::~cell_manager()
 {
 	for (int i = 0; i < backdrop_mac; ++i) {
 		if (backdrop_map[i].data)
-			delete backdrop_map[i].data;
+			int_backdrop_cache->destroy(backdrop_map[i].data);
 		backdrop_map[i].data = 0;
 		if (backdrop_map[i].cdata)
 			delete backdrop_map[i].cdata;
@@ -2266,8 +2727,12 @@ void cell_manager::backdrop_update(int index)
 	assert(index >= 0 && index < backdrop_mac);
 
 	if (back->data) {
-		if (!fast_exit_handler())
-			back->data->load(&back->pos, backdrop_missing_color.background, backdrop_expand_factor, resizeeffect);
+		if (int_backdrop_cache->is_async() && !int_wait_for_backdrop) {
+			// decode in background, it's drawn by idle() when ready
+			int_backdrop_cache->request(back->data, &back->pos, backdrop_missing_color.background, backdrop_expand_factor, resizeeffect, false);
+		} else if (!fast_exit_handler()) {
+			int_backdrop_cache->load(back->data, &back->pos, backdrop_missing_color.background, backdrop_expand_factor, resizeeffect);
+		}
 	}
 
 	if (back->redraw) {
@@ -2289,6 +2754,34 @@ void cell_manager::backdrop_update(int index)
 	}
 }
 
+// Decode in background the image of a not yet visible game
+void cell_manager::backdrop_prefetch(int index, const resource& res, unsigned aspectx, unsigned aspecty)
+{
+	assert(index >= 0 && index < backdrop_mac);
+
+	// skip if already displayed
+	for (int i = 0; i < backdrop_mac; ++i) {
+		backdrop_data* data = backdrop_map[i].data;
+		if (data
+			&& data->res_get() == res
+			&& data->target_dx_get() == backdrop_map[index].pos.dx
+			&& data->target_dy_get() == backdrop_map[index].pos.dy)
+			return;
+	}
+
+	int_backdrop_cache->prefetch(res, &backdrop_map[index].pos, aspectx, aspecty, backdrop_missing_color.background, backdrop_expand_factor, resizeeffect);
+}
+
+void cell_manager::backdrop_prefetch_cancel()
+{
+	int_backdrop_cache->prefetch_cancel();
+}
+
+bool cell_manager::backdrop_prefetch_is_active()
+{
+	return int_backdrop_cache->is_async();
+}
+
 void cell_manager::reduce()
 {
 	if (int_backdrop_cache)
@@ -2339,6 +2832,15 @@ bool cell_manager::idle()
 {
 	bool late = false;
 
+	// draw the images decoded in background
+	for (unsigned i = 0; i < backdrop_mac; ++i) {
+		cell_t* cell = backdrop_map + i;
+		if (cell->redraw && cell->data && int_backdrop_cache->collect(cell->data) && cell->data->bitmap_get()) {
+			backdrop_update(i);
+			cell->pos.redraw();
+		}
+	}
+
 	if (multiclip) {
 		int highlight_index = -1;
 
@@ -2500,6 +3002,16 @@ void int_backdrop_clear(int index, bool highlight)
 	int_cell->backdrop_clear(index, highlight);
 }
 
+void int_backdrop_prefetch(int index, const resource& res, unsigned aspectx, unsigned aspecty)
+{
+	int_cell->backdrop_prefetch(index, res, aspectx, aspecty);
+}
+
+bool int_backdrop_prefetch_is_active()
+{
+	return int_cell && int_cell->backdrop_prefetch_is_active();
+}
+
 void int_clip_set(int index, const resource& res, unsigned aspectx, unsigned aspecty, bool restart)
 {
 	int_cell->clip_set(index, res, aspectx, aspecty, restart);
@@ -3042,6 +3554,9 @@ unsigned int_update_pre(bool progressive)
 			int_cell->backdrop_update(i);
 		}
 
+		// the cursor moved, the old prefetch are not needed
+		int_cell->backdrop_prefetch_cancel();
+
 		int_cell->reduce();
 	}
 
@@ -43,6 +43,9 @@
 #include "crtcbag.h"
 #include "blit.h"
 #include "filter.h"
+#include "soundfx.h"
+#include "thread.h"
+#include "trace.h"
 #include "dft.h"
 #include "font.h"
 #include "joy.h"
@@ -404,10 +407,45 @@ struct advance_record_config_context {
 	unsigned video_interlace; /**< Interlace factor for the video recording. */
 };
 
+/** Number of recorded frames that can wait for the encoder. */
+#define RECORD_VIDEO_QUEUE_MAX 8
+
+/**
+ * Frame of the video recording.
+ * The image is stored in the PNG raw format, with the filter byte at the
+ * start of every row, and it's encoded as a delta of the previous frame.
+ */
+struct advance_record_frame {
+	struct advance_record_context* context; /**< Recording context. */
+	const struct advance_record_frame* prev; /**< Previous frame, or 0 if it's the first one. */
+	osd_work_item* item; /**< Encoder work item, or 0 if encoded synchronously. */
+	adv_bool encoded_flag; /**< If the encoding is completed. Protected by video_lock. */
+	adv_error encoded_error; /**< Result of the encoding. */
+
+	unsigned width; /**< Width of the image. */
+	unsigned height; /**< Height of the image. */
+	unsigned pixel; /**< Bytes per pixel of the image, 1, 3 or 4. */
+	unsigned char* raw_ptr; /**< Image data. */
+	unsigned raw_max; /**< Allocated size of the image data. */
+	unsigned char pal_ptr[3 * 256]; /**< Palette. */
+	unsigned pal_size; /**< Size of the palette in bytes. 0 for RGB images. */
+	unsigned tick; /**< Duration of the frame in MNG ticks. */
+
+	unsigned char dhdr_ptr[20]; /**< DHDR chunk. */
+	unsigned dhdr_size; /**< Size of the DHDR chunk. 0 for a full PNG frame. */
+	adv_bool pal_flag; /**< If the palette must be written also in a delta frame. */
+	unsigned char* dlt_ptr; /**< Delta of the changed rectangle. */
+	unsigned dlt_max; /**< Allocated size of the delta. */
+	unsigned char* z_ptr; /**< Compressed data of the IDAT chunk. */
+	unsigned z_size; /**< Size of the compressed data. 0 for no IDAT chunk. */
+	unsigned z_max; /**< Allocated size of the compressed data. */
+};
+
 struct advance_record_state_context {
 #ifdef USE_SMP
 	pthread_mutex_t access_mutex;
 #endif
+	osd_lock* video_lock; /**< Lock of the encoding state of the frames. */
 
 	adv_bool sound_active_flag; /**< Main activation flag for sound recording. */
 	adv_bool video_active_flag; /**< Main activation flag for video recording. */
@@ -424,6 +462,10 @@ struct advance_record_state_context {
 	unsigned video_freq_step; /**< Frequency base value. */
 	unsigned video_freq_base; /**< Frequency step value. */
 	adv_bool video_stopped_flag; /**< If the video recording is stopped. */
+	struct advance_record_frame video_frame_map[RECORD_VIDEO_QUEUE_MAX + 1]; /**< Ring of frames. One more for the previous frame already written. */
+	unsigned video_frame_head; /**< Counter of the frames queued. */
+	unsigned video_frame_tail; /**< Counter of the frames written. */
+	unsigned video_frame_dropped; /**< Number of frames dropped because the queue was full. */
 
 	char sound_file_buffer[FILE_MAXPATH]; /**< Sound file */
 	FILE* sound_f; /**< Sound handle */
@@ -498,7 +540,7 @@ void advance_estimate_common_end(struct advance_estimate_context* context, adv_b
 /**
  * Base for the sample gain adjustment.
  */
-#define SAMPLE_MULT_BASE 4096
+#define SAMPLE_MULT_BASE SOUNDFX_MULT_BASE
 
 /**
  * Range in dB for the power initialization.
@@ -526,6 +568,8 @@ struct advance_sound_state_context {
 	double time; /**< Estimate of play time. */
 
 	unsigned overflow; /**< Overflow in samples. */
+	unsigned underrun; /**< Number of output underruns already reported. */
+	unsigned overrun; /**< Number of output samples discarded already reported. */
 
 	unsigned latency_min; /**< Expected minum latency in samples. */
 	unsigned latency_max; /**< Maximum latency, limitated by the lower driver buffer. */
@@ -549,15 +593,12 @@ struct advance_sound_state_context {
 	adv_bool disabled_flag; /**< Mute state for disable mode from OSD. */
 
 	adv_bool equalizer_flag; /**< Main equalizer flag. */
-	adv_filter equalizer_low;
-	adv_filter equalizer_mid;
-	adv_filter equalizer_high;
-	adv_filter_state equalizer_low_state[2];
-	adv_filter_state equalizer_mid_state[2];
-	adv_filter_state equalizer_high_state[2];
-	double equalizer_low_factor;
-	double equalizer_mid_factor;
-	double equalizer_high_factor;
+
+	adv_soundfx fx; /**< Volume, equalizer, channel mixing and resampling. */
+	short* fx_buffer; /**< Output buffer of the processing. */
+	unsigned fx_buffer_max; /**< Size of the output buffer in bytes. */
+	short* tap_buffer; /**< Equalized samples for the DFT of the menu. */
+	unsigned tap_buffer_max; /**< Size of the equalized samples buffer in bytes. */
 
 	/* Menu state */
 	adv_bool menu_sub_flag; /**< If the sub menu is active. */
@@ -586,6 +627,8 @@ void advance_sound_done(struct advance_sound_context* context);
 adv_error advance_sound_config_load(struct advance_sound_context* context, adv_conf* cfg_context, struct mame_option* game_options);
 int advance_sound_latency_diff(struct advance_sound_context* context, double extra_latency);
 int advance_sound_latency(struct advance_sound_context* context, double extra_latency);
+unsigned advance_sound_underrun(struct advance_sound_context* context);
+unsigned advance_sound_overrun(struct advance_sound_context* context);
 void advance_sound_reconfigure(struct advance_sound_context* context, struct advance_sound_config_context* config);
 void advance_sound_config_save(struct advance_sound_context* context, const char* section);
 
@@ -699,8 +742,11 @@ struct advance_video_config_context {
 	char section_resolutionclock_buffer[256]; /**< Section used to store the option for the resolution/freq. */
 	char section_orientation_buffer[256]; /**< Section used to store the option for the orientation. */
 	adv_bool smp_flag; /**< Use threads */
+	unsigned smp_thread; /**< Number of worker threads for osd_parallelize(). 0 for automatic. */
+	adv_bool smp_band_flag; /**< Split the blit in bands processed by the worker threads. */
 	adv_bool crash_flag; /**< If enable the crash menu entry. */
 	adv_bool rawsound_flag; /**< Force the generation of all the sound samples. */
+	char trace_buffer[FILE_MAXPATH]; /**< File where to save the trace, or "none". */
 	unsigned monitor_aspect_x; /**< Horizontal aspect of the monitor (4 for a standard monitor) */
 	unsigned monitor_aspect_y; /**< Vertical aspect of the monitor (3 for a standard monitor) */
 
@@ -719,6 +765,15 @@ struct advance_video_config_context {
 
 #define PIPELINE_MEASURE_MAX 13
 #define PIPELINE_BLIT_MAX 2 /**< Number of pipelines to create. 0 for buffered, 1 for direct write. */
+#define PIPELINE_BLIT_TOTAL (PIPELINE_BLIT_MAX * VIDEO_SIMD_MAX) /**< Number of pipelines, one set for every SIMD level. */
+#define PIPELINE_TUNE_MAX 12 /**< Max number of pipeline configurations to measure. */
+
+/** Configuration of the blit measured by the pipeline tuner. */
+struct advance_video_tune {
+	unsigned pipeline; /**< Pipeline to use. 0 for buffered, 1 for direct write. */
+	unsigned simd; /**< SIMD level. One of VIDEO_SIMD_*. */
+	unsigned band; /**< Number of bands. 1 for no band. */
+};
 
 /** State for the video part. */
 struct advance_video_state_context {
@@ -842,7 +897,7 @@ struct advance_video_state_context {
 	int blit_src_dw; /**< Source row step of the game bitmap. */
 	int blit_src_offset; /**< Pointer at the first pixel of the game bitmap. */
 	adv_bool blit_pipeline_flag; /**< !=0 if blit_pipeline is computed. */
-	struct video_pipeline_struct blit_pipeline[PIPELINE_BLIT_MAX]; /**< Put pipeline to video. */
+	struct video_pipeline_struct blit_pipeline[PIPELINE_BLIT_TOTAL]; /**< Put pipeline to video, built with the SIMD level of pipeline_simd(). */
 	unsigned blit_pipeline_index; /**< Pipeline to use. */
 
 	/* Buffer info */
@@ -873,11 +928,18 @@ struct advance_video_state_context {
 	unsigned game_visible_pos_x_increment;
 
 	adv_bool pipeline_measure_flag; /**< !=0 if the time measure is active. */
-	double pipeline_measure_map[PIPELINE_BLIT_MAX][PIPELINE_MEASURE_MAX]; /**< Single measure. */
-	double pipeline_measure_result[PIPELINE_BLIT_MAX]; /**< Selected measure. */
+	double pipeline_measure_map[PIPELINE_TUNE_MAX][PIPELINE_MEASURE_MAX]; /**< Single measure. */
+	double pipeline_measure_result[PIPELINE_TUNE_MAX]; /**< Selected measure. */
 	unsigned pipeline_measure_i;
 	unsigned pipeline_measure_j;
 
+	struct advance_video_tune pipeline_tune_map[PIPELINE_TUNE_MAX]; /**< Configurations to measure. */
+	unsigned pipeline_tune_mac; /**< Number of configurations. */
+	unsigned pipeline_tune_index; /**< Selected configuration. */
+	adv_bool pipeline_tune_cache_flag; /**< !=0 if the configuration was read from the tune file. */
+	char pipeline_tune_key[256]; /**< Key of the configuration in the tune file. */
+	unsigned pipeline_tune_simd; /**< Global SIMD level before the tune, restored with the pipeline. */
+
 	double pipeline_timing_map[PIPELINE_MEASURE_MAX]; /**< Continuous measure of pipeline timing. */
 	unsigned pipeline_timing_i; /**< Index of the measure. */
 	double pipeline_timing_max; /**< Maximum time used to pipeline. */
@@ -1013,6 +1075,9 @@ void advance_global_done(struct advance_global_context* context);
 struct advance_fileio_state_context {
 	adv_fz* diff_handle; /**< Diff file handle. */
 	char diff_file_buffer[FILE_MAXPATH]; /**< Diff file path. */
+	struct _osd_lock* lock; /**< Lock of the file_abs() static buffer and of the rom hash cache. */
+	struct fileio_hash** hash_map; /**< Hash table of the rom hash cache. 0 if not yet loaded. */
+	adv_bool hash_modified_flag; /**< If the rom hash cache has to be saved. */
 };
 
 struct advance_fileio_context {
@@ -31,6 +31,7 @@
 #include "portable.h"
 
 #include "emu.h"
+#include "thread.h"
 
 #include "glueint.h"
 
@@ -49,6 +50,25 @@ struct fileio_handle {
 	int is_crc_set; /**< If the crc was computed. */
 };
 
+/** Name of the file used to store the hash of the rom files. */
+#define FILEIO_HASH_FILE "romhash.dat"
+
+/** Size of the hash table of the rom hash cache. */
+#define FILEIO_HASH_SIZE 4096
+
+/** Max length of a hash string. */
+#define FILEIO_HASH_MAX 256
+
+/** Hash of a rom file computed in a previous run. */
+struct fileio_hash {
+	char* key; /**< Absolute path of the file, a tab, and the entry in the zip. */
+	unsigned long long size; /**< Size of the file. */
+	unsigned long long mtime; /**< Modification time of the file. */
+	unsigned length; /**< Length of the data. */
+	char hash[FILEIO_HASH_MAX]; /**< Hash of the data. */
+	struct fileio_hash* next; /**< Next entry in the same bucket. */
+};
+
 /** Directory handle used by all the osd_dir_* functions. */
 struct dirio_handle {
 	DIR* h; /**< Dir opened. */
@@ -124,6 +144,24 @@ int osd_get_path_count(int pathtype)
 	return i->dir_mac;
 }
 
+/**
+ * Get the absolute path of a file.
+ * The roms are loaded by many threads at the same time, and file_abs()
+ * returns a static buffer.
+ */
+static void fileio_abs(char* path_buffer, unsigned path_size, const char* dir, const char* file)
+{
+	struct advance_fileio_context* context = &CONTEXT.fileio;
+
+	if (context->state.lock)
+		osd_lock_acquire(context->state.lock);
+
+	sncpy(path_buffer, path_size, file_abs(dir, file));
+
+	if (context->state.lock)
+		osd_lock_release(context->state.lock);
+}
+
 int osd_get_path_info(int pathtype, int pathindex, const char* filename)
 {
 	struct fileio_item* i;
@@ -138,7 +176,7 @@ int osd_get_path_info(int pathtype, int pathindex, const char* filename)
 		return PATH_NOT_FOUND;
 	}
 
-	sncpy(path_buffer, sizeof(path_buffer), file_abs(i->dir_map[pathindex], filename));
+	fileio_abs(path_buffer, sizeof(path_buffer), i->dir_map[pathindex], filename);
 
 	log_std(("osd: osd_get_path_info() try %s\n", path_buffer));
 
@@ -159,6 +197,255 @@ int osd_get_path_info(int pathtype, int pathindex, const char* filename)
 	return PATH_NOT_FOUND;
 }
 
+/***************************************************************************/
+/* Rom hash cache */
+
+/*
+ * The hash of the rom files computed at the load is saved in the
+ * romhash.dat file in the home directory, with the size and the
+ * modification time of the file or zip containing it. The next time
+ * the same file is loaded the hash is taken from the cache, if the
+ * file is unchanged.
+ * The functions are called by the threads loading the roms, and all
+ * the accesses are done with the lock.
+ */
+
+static unsigned fileio_hash_bucket(const char* key)
+{
+	unsigned h = 0;
+	while (*key) {
+		h = h * 31 + (unsigned char)*key;
+		++key;
+	}
+	return h % FILEIO_HASH_SIZE;
+}
+
+static struct fileio_hash* fileio_hash_find(struct advance_fileio_context* context, const char* key)
+{
+	struct fileio_hash* h;
+
+	for (h = context->state.hash_map[fileio_hash_bucket(key)]; h; h = h->next)
+		if (strcmp(h->key, key) == 0)
+			return h;
+
+	return 0;
+}
+
+static struct fileio_hash* fileio_hash_insert(struct advance_fileio_context* context, const char* key)
+{
+	struct fileio_hash* h;
+	unsigned bucket;
+
+	h = fileio_hash_find(context, key);
+	if (h)
+		return h;
+
+	h = malloc(sizeof(struct fileio_hash));
+	if (!h)
+		return 0;
+	h->key = strdup(key);
+	if (!h->key) {
+		free(h);
+		return 0;
+	}
+
+	bucket = fileio_hash_bucket(key);
+	h->next = context->state.hash_map[bucket];
+	context->state.hash_map[bucket] = h;
+
+	return h;
+}
+
+/**
+ * Load the rom hash cache at the first use.
+ * Every line is: mtime size length hash path<tab>entry
+ */
+static void fileio_hash_load(struct advance_fileio_context* context)
+{
+	char buffer[FILE_MAXPATH * 2 + FILEIO_HASH_MAX + 64];
+	FILE* f;
+
+	context->state.hash_map = calloc(FILEIO_HASH_SIZE, sizeof(struct fileio_hash*));
+	if (!context->state.hash_map)
+		return;
+
+	context->state.hash_modified_flag = 0;
+
+	f = fopen(file_config_file_home(FILEIO_HASH_FILE), "rt");
+	if (!f)
+		return;
+
+	while (fgets(buffer, sizeof(buffer), f)) {
+		unsigned long long mtime;
+		unsigned long long size;
+		unsigned length;
+		char hash[FILEIO_HASH_MAX];
+		struct fileio_hash* h;
+		int pos;
+		char* key;
+		char* end;
+
+		if (sscanf(buffer, "%llu %llu %u %255s %n", &mtime, &size, &length, hash, &pos) != 4)
+			continue;
+
+		key = buffer + pos;
+		end = strchr(key, '\n');
+		if (end)
+			*end = 0;
+		if (!strchr(key, '\t'))
+			continue;
+
+		h = fileio_hash_insert(context, key);
+		if (!h)
+			break;
+
+		h->mtime = mtime;
+		h->size = size;
+		h->length = length;
+		sncpy(h->hash, sizeof(h->hash), hash);
+	}
+
+	fclose(f);
+
+	log_std(("osd: rom hash cache loaded\n"));
+}
+
+/**
+ * Save and free the rom hash cache.
+ */
+static void fileio_hash_done(struct advance_fileio_context* context)
+{
+	FILE* f;
+	unsigned i;
+
+	if (!context->state.hash_map)
+		return;
+
+	f = 0;
+	if (context->state.hash_modified_flag) {
+		f = fopen(file_config_file_home(FILEIO_HASH_FILE), "wt");
+		if (!f)
+			log_std(("ERROR:osd: error saving the rom hash cache\n"));
+	}
+
+	for (i = 0; i < FILEIO_HASH_SIZE; ++i) {
+		struct fileio_hash* h = context->state.hash_map[i];
+		while (h) {
+			struct fileio_hash* next = h->next;
+			if (f)
+				fprintf(f, "%llu %llu %u %s %s\n", h->mtime, h->size, h->length, h->hash, h->key);
+			free(h->key);
+			free(h);
+			h = next;
+		}
+	}
+
+	if (f)
+		fclose(f);
+
+	free(context->state.hash_map);
+	context->state.hash_map = 0;
+}
+
+/**
+ * Compute the key of a file and get its size and modification time.
+ * \return 0 on success.
+ */
+static int fileio_hash_key(int pathtype, int pathindex, const char* filename, const char* entry, char* key, unsigned key_size, unsigned long long* size, unsigned long long* mtime)
+{
+	struct fileio_item* i;
+	char path_buffer[FILE_MAXPATH];
+	struct stat st;
+
+	i = fileio_find(pathtype);
+	if (!i || pathindex >= i->dir_mac)
+		return -1;
+
+	fileio_abs(path_buffer, sizeof(path_buffer), i->dir_map[pathindex], filename);
+
+	if (stat(path_buffer, &st) != 0 || !S_ISREG(st.st_mode))
+		return -1;
+
+	snprintf(key, key_size, "%s\t%s", path_buffer, entry ? entry : "");
+	*size = st.st_size;
+	*mtime = st.st_mtime;
+
+	return 0;
+}
+
+int osd_hash_cache_get(int pathtype, int pathindex, const char* filename, const char* entry, UINT64 length, char* hash)
+{
+	struct advance_fileio_context* context = &CONTEXT.fileio;
+	char key[FILE_MAXPATH * 2];
+	unsigned long long size;
+	unsigned long long mtime;
+	struct fileio_hash* h;
+	int r;
+
+	if (!context->state.lock)
+		return -1;
+
+	if (fileio_hash_key(pathtype, pathindex, filename, entry, key, sizeof(key), &size, &mtime) != 0)
+		return -1;
+
+	osd_lock_acquire(context->state.lock);
+
+	if (!context->state.hash_map)
+		fileio_hash_load(context);
+
+	r = -1;
+	if (context->state.hash_map) {
+		h = fileio_hash_find(context, key);
+		if (h && h->size == size && h->mtime == mtime && h->length == length) {
+			strcpy(hash, h->hash);
+			r = 0;
+		}
+	}
+
+	osd_lock_release(context->state.lock);
+
+	return r;
+}
+
+void osd_hash_cache_set(int pathtype, int pathindex, const char* filename, const char* entry, UINT64 length, const char* hash)
+{
+	struct advance_fileio_context* context = &CONTEXT.fileio;
+	char key[FILE_MAXPATH * 2];
+	unsigned long long size;
+	unsigned long long mtime;
+	struct fileio_hash* h;
+
+	if (!context->state.lock)
+		return;
+
+	if (strlen(hash) >= FILEIO_HASH_MAX || strchr(hash, ' ') != 0)
+		return;
+
+	if (fileio_hash_key(pathtype, pathindex, filename, entry, key, sizeof(key), &size, &mtime) != 0)
+		return;
+
+	osd_lock_acquire(context->state.lock);
+
+	if (!context->state.hash_map)
+		fileio_hash_load(context);
+
+	if (context->state.hash_map) {
+		h = fileio_hash_insert(context, key);
+		if (h) {
+			h->size = size;
+			h->mtime = mtime;
+			h->length = length;
+			sncpy(h->hash, sizeof(h->hash), hash);
+			context->state.hash_modified_flag = 1;
+		}
+	}
+
+	osd_lock_release(context->state.lock);
+}
+
+/***************************************************************************/
+/* File */
+
 static int partialequal(const char* zipfile, const char* file)
 {
 	const char* s1 = file;
@@ -227,7 +514,7 @@ osd_file* osd_fopen(int pathtype, int pathindex, const char* filename, const cha
 	}
 #endif
 
-	sncpy(path_buffer, sizeof(path_buffer), file_abs(i->dir_map[pathindex], filename));
+	fileio_abs(path_buffer, sizeof(path_buffer), i->dir_map[pathindex], filename);
 
 	split = strchr(path_buffer, '=');
 	if (split != 0) {
@@ -417,7 +704,7 @@ int osd_create_directory(int pathtype, int pathindex, const char *dirname)
 		return -1;
 	}
 
-	sncpy(path_buffer, sizeof(path_buffer), file_abs(i->dir_map[pathindex], dirname));
+	fileio_abs(path_buffer, sizeof(path_buffer), i->dir_map[pathindex], dirname);
 
 	log_std(("osd: osd_create_directory() -> %s\n", path_buffer));
 
@@ -738,6 +1025,11 @@ adv_error advance_fileio_init(struct advance_fileio_context* context, adv_conf*
 	}
 
 	context->state.diff_handle = 0;
+	context->state.hash_map = 0;
+
+	context->state.lock = osd_lock_alloc();
+	if (!context->state.lock)
+		return -1;
 
 #ifdef MESS
 	conf_string_register_default(cfg_context, "dir_crc", file_config_dir_singledir("crc"));
@@ -755,6 +1047,11 @@ void advance_fileio_done(struct advance_fileio_context* context)
 	if (context->state.diff_handle) {
 		fzclose(context->state.diff_handle);
 	}
+	fileio_hash_done(context);
+	if (context->state.lock) {
+		osd_lock_free(context->state.lock);
+		context->state.lock = 0;
+	}
 }
 
 static void dir_create(const char* dir)
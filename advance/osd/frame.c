@@ -32,6 +32,7 @@
 
 #include "emu.h"
 #include "input.h"
+#include "thread.h"
 
 #include "advance.h"
 
@@ -483,10 +484,13 @@ static void video_done_pipeline(struct advance_video_context* context)
 	/* destroy the pipeline */
 	if (context->state.blit_pipeline_flag) {
 		unsigned i;
-		for (i = 0; i < PIPELINE_BLIT_MAX; ++i)
+		for (i = 0; i < PIPELINE_BLIT_TOTAL; ++i)
 			video_pipeline_done(&context->state.blit_pipeline[i]);
 		video_pipeline_done(&context->state.buffer_pipeline_video);
 		context->state.blit_pipeline_flag = 0;
+
+		/* the SIMD level is global, restore it also if the tune was interrupted */
+		video_blit_simd_set(context->state.pipeline_tune_simd);
 	}
 
 	if (context->state.buffer_ptr_alloc) {
@@ -1676,12 +1680,185 @@ static void video_buffer_clear(struct advance_video_context* context)
 
 static unsigned pipeline_combine(unsigned p)
 {
-	if (p == 0)
+	if (p % PIPELINE_BLIT_MAX == 0)
 		return VIDEO_COMBINE_BUFFER;
 	else
 		return 0;
 }
 
+/**
+ * SIMD level used to build a pipeline.
+ * The horizontal stages bind the SIMD implementation when the pipeline
+ * is built, so every level has its own set of pipelines.
+ */
+static unsigned pipeline_simd(unsigned p)
+{
+	return p / PIPELINE_BLIT_MAX;
+}
+
+/** Name of the file used to store the result of the pipeline tuning. */
+#define PIPELINE_TUNE_FILE "pipeline.dat"
+
+/**
+ * Select one of the pipeline configurations.
+ */
+static void video_tune_set(struct advance_video_context* context, unsigned index)
+{
+	const struct advance_video_tune* tune = &context->state.pipeline_tune_map[index];
+
+	context->state.pipeline_tune_index = index;
+	context->state.blit_pipeline_index = tune->simd * PIPELINE_BLIT_MAX + tune->pipeline;
+
+	video_blit_simd_set(tune->simd);
+}
+
+/**
+ * Compute the list of pipeline configurations to measure.
+ * The first one is the default, used if no measure is done.
+ */
+static void video_tune_enumerate(struct advance_video_context* context)
+{
+	unsigned band_max;
+	unsigned p;
+	unsigned s;
+	unsigned b;
+
+	band_max = video_pipeline_band_max(&context->state.blit_pipeline[0]);
+
+	context->state.pipeline_tune_mac = 0;
+	for (p = 0; p < PIPELINE_BLIT_MAX; ++p) {
+		for (s = VIDEO_SIMD_MAX; s > 0; --s) {
+			if (!video_blit_simd_supported(s - 1))
+				continue;
+			for (b = 0; b < 2; ++b) {
+				struct advance_video_tune* tune;
+				unsigned band = b == 0 ? band_max : 1;
+
+				/* skip the duplicate without bands */
+				if (b != 0 && band_max <= 1)
+					continue;
+
+				if (context->state.pipeline_tune_mac == PIPELINE_TUNE_MAX)
+					continue;
+
+				tune = &context->state.pipeline_tune_map[context->state.pipeline_tune_mac];
+				tune->pipeline = p;
+				tune->simd = s - 1;
+				tune->band = band;
+				++context->state.pipeline_tune_mac;
+			}
+		}
+	}
+}
+
+/**
+ * Load the result of a previous tuning with the same key.
+ * \return !=0 if found and selected.
+ */
+static adv_bool video_tune_load(struct advance_video_context* context)
+{
+	const char* key = context->state.pipeline_tune_key;
+	unsigned len = strlen(key);
+	char buffer[512];
+	FILE* f;
+
+	f = fopen(file_config_file_home(PIPELINE_TUNE_FILE), "rt");
+	if (!f)
+		return 0;
+
+	while (fgets(buffer, sizeof(buffer), f)) {
+		char write[16];
+		char simd[16];
+		unsigned band;
+		unsigned i;
+
+		if (strncmp(buffer, key, len) != 0 || strncmp(buffer + len, " = ", 3) != 0)
+			continue;
+
+		if (sscanf(buffer + len + 3, "%15s %15s %u", write, simd, &band) != 3)
+			continue;
+
+		for (i = 0; i < context->state.pipeline_tune_mac; ++i) {
+			const struct advance_video_tune* tune = &context->state.pipeline_tune_map[i];
+			if (strcmp(write, tune->pipeline == 0 ? "buffer" : "direct") == 0
+				&& strcmp(simd, video_blit_simd_name(tune->simd)) == 0
+				&& band == tune->band) {
+				fclose(f);
+				video_tune_set(context, i);
+				return 1;
+			}
+		}
+	}
+
+	fclose(f);
+
+	return 0;
+}
+
+/**
+ * Save the result of the tuning, replacing any previous result with the same key.
+ */
+static void video_tune_save(struct advance_video_context* context)
+{
+	const char* key = context->state.pipeline_tune_key;
+	const struct advance_video_tune* tune = &context->state.pipeline_tune_map[context->state.pipeline_tune_index];
+	const char* file = file_config_file_home(PIPELINE_TUNE_FILE);
+	unsigned len = strlen(key);
+	char* data;
+	char* line;
+	long size;
+	FILE* f;
+
+	/* read the previous content */
+	data = 0;
+	size = 0;
+	f = fopen(file, "rb");
+	if (f) {
+		if (fseek(f, 0, SEEK_END) == 0)
+			size = ftell(f);
+		if (size < 0)
+			size = 0;
+		data = malloc(size + 1);
+		if (!data) {
+			/* don't lose the other entries rewriting the file */
+			log_std(("WARNING:emu:video: low memory saving the tune file %s\n", file));
+			fclose(f);
+			return;
+		}
+		if (fseek(f, 0, SEEK_SET) != 0 || fread(data, size, 1, f) != 1)
+			size = 0;
+		data[size] = 0;
+		fclose(f);
+	}
+
+	f = fopen(file, "wt");
+	if (!f) {
+		log_std(("WARNING:emu:video: error writing the tune file %s\n", file));
+		free(data);
+		return;
+	}
+
+	/* copy the other entries */
+	line = data;
+	while (line && *line) {
+		char* next = strchr(line, '\n');
+		if (next)
+			*next++ = 0;
+
+		if (*line && (strncmp(line, key, len) != 0 || strncmp(line + len, " = ", 3) != 0))
+			fprintf(f, "%s\n", line);
+
+		line = next;
+	}
+
+	fprintf(f, "%s = %s %s %u\n", key, tune->pipeline == 0 ? "buffer" : "direct", video_blit_simd_name(tune->simd), tune->band);
+
+	fclose(f);
+	free(data);
+
+	log_std(("emu:video: tune saved in %s\n", file));
+}
+
 static void video_recompute_pipeline(struct advance_video_context* context, const struct osd_bitmap* bitmap)
 {
 	unsigned combine;
@@ -1860,11 +2037,14 @@ static void video_recompute_pipeline(struct advance_video_context* context, cons
 
 	free(context->state.buffer_ptr_alloc);
 
-	for (p = 0; p < PIPELINE_BLIT_MAX; ++p)
+	for (p = 0; p < PIPELINE_BLIT_TOTAL; ++p)
 		video_pipeline_init(&context->state.blit_pipeline[p]);
 	video_pipeline_init(&context->state.buffer_pipeline_video);
 	context->state.blit_pipeline_flag = 1;
 
+	/* the SIMD level is global, and it's changed to build the pipelines */
+	context->state.pipeline_tune_simd = video_blit_simd_get();
+
 	context->state.buffer_bytes_per_scanline = context->state.buffer_size_x * color_def_bytes_per_pixel_get(context->state.buffer_def);
 
 	context->state.buffer_bytes_per_scanline = ALIGN_UNSIGNED(context->state.buffer_bytes_per_scanline, ALIGN);
@@ -1880,20 +2060,29 @@ static void video_recompute_pipeline(struct advance_video_context* context, cons
 	video_pipeline_target(&context->state.buffer_pipeline_video, context->state.buffer_ptr, context->state.buffer_bytes_per_scanline, context->state.buffer_def);
 
 	if (context->state.game_rgb_flag) {
-		for (p = 0; p < PIPELINE_BLIT_MAX; ++p)
+		for (p = 0; p < PIPELINE_BLIT_TOTAL; ++p) {
+			video_blit_simd_set(pipeline_simd(p));
 			video_pipeline_direct(&context->state.blit_pipeline[p], context->state.mode_visible_size_x, context->state.mode_visible_size_y, context->state.game_visible_size_x, context->state.game_visible_size_y, context->state.blit_src_dw, context->state.blit_src_dp, context->state.game_color_def, combine_video | pipeline_combine(p));
+		}
+		video_blit_simd_set(context->state.pipeline_tune_simd);
 		video_pipeline_direct(&context->state.buffer_pipeline_video, intermediate_mode_visible_size_x, intermediate_mode_visible_size_y, intermediate_game_visible_size_x, intermediate_game_visible_size_y, context->state.buffer_src_dw, context->state.buffer_src_dp, context->state.game_color_def, combine_buffer);
 	} else {
 		if (context->state.mode_index == MODE_FLAGS_INDEX_PALETTE8) {
 			assert(context->state.game_bytes_per_pixel == 2);
-			for (p = 0; p < PIPELINE_BLIT_MAX; ++p)
+			for (p = 0; p < PIPELINE_BLIT_TOTAL; ++p) {
+				video_blit_simd_set(pipeline_simd(p));
 				video_pipeline_palette16hw(&context->state.blit_pipeline[p], context->state.mode_visible_size_x, context->state.mode_visible_size_y, context->state.game_visible_size_x, context->state.game_visible_size_y, context->state.blit_src_dw, context->state.blit_src_dp, combine_video | pipeline_combine(p));
+			}
+			video_blit_simd_set(context->state.pipeline_tune_simd);
 			video_pipeline_palette16hw(&context->state.buffer_pipeline_video, intermediate_mode_visible_size_x, intermediate_mode_visible_size_y, intermediate_game_visible_size_x, intermediate_game_visible_size_y, context->state.buffer_src_dw, context->state.buffer_src_dp, combine_buffer);
 		} else {
 			switch (context->state.game_bytes_per_pixel) {
 			case 1:
-				for (p = 0; p < PIPELINE_BLIT_MAX; ++p)
+				for (p = 0; p < PIPELINE_BLIT_TOTAL; ++p) {
+					video_blit_simd_set(pipeline_simd(p));
 					video_pipeline_palette8(&context->state.blit_pipeline[p], context->state.mode_visible_size_x, context->state.mode_visible_size_y, context->state.game_visible_size_x, context->state.game_visible_size_y, context->state.blit_src_dw, context->state.blit_src_dp, context->state.palette_index8_map, context->state.palette_index16_map, context->state.palette_index32_map, combine_video | pipeline_combine(p));
+				}
+				video_blit_simd_set(context->state.pipeline_tune_simd);
 				/* use the alternate palette only if required */
 				if (context->state.buffer_def != video_color_def())
 					video_pipeline_palette8(&context->state.buffer_pipeline_video, intermediate_mode_visible_size_x, intermediate_mode_visible_size_y, intermediate_game_visible_size_x, intermediate_game_visible_size_y, context->state.buffer_src_dw, context->state.buffer_src_dp, context->state.buffer_index8_map, context->state.buffer_index16_map, context->state.buffer_index32_map, combine_buffer);
@@ -1901,8 +2090,11 @@ static void video_recompute_pipeline(struct advance_video_context* context, cons
 					video_pipeline_palette8(&context->state.buffer_pipeline_video, intermediate_mode_visible_size_x, intermediate_mode_visible_size_y, intermediate_game_visible_size_x, intermediate_game_visible_size_y, context->state.buffer_src_dw, context->state.buffer_src_dp, context->state.palette_index8_map, context->state.palette_index16_map, context->state.palette_index32_map, combine_buffer);
 				break;
 			case 2:
-				for (p = 0; p < PIPELINE_BLIT_MAX; ++p)
+				for (p = 0; p < PIPELINE_BLIT_TOTAL; ++p) {
+					video_blit_simd_set(pipeline_simd(p));
 					video_pipeline_palette16(&context->state.blit_pipeline[p], context->state.mode_visible_size_x, context->state.mode_visible_size_y, context->state.game_visible_size_x, context->state.game_visible_size_y, context->state.blit_src_dw, context->state.blit_src_dp, context->state.palette_index8_map, context->state.palette_index16_map, context->state.palette_index32_map, combine_video | pipeline_combine(p));
+				}
+				video_blit_simd_set(context->state.pipeline_tune_simd);
 				/* use the alternate palette only if required */
 				if (context->state.buffer_def != video_color_def())
 					video_pipeline_palette16(&context->state.buffer_pipeline_video, intermediate_mode_visible_size_x, intermediate_mode_visible_size_y, intermediate_game_visible_size_x, intermediate_game_visible_size_y, context->state.buffer_src_dw, context->state.buffer_src_dp, context->state.buffer_index8_map, context->state.buffer_index16_map, context->state.buffer_index32_map, combine_buffer);
@@ -1916,6 +2108,13 @@ static void video_recompute_pipeline(struct advance_video_context* context, cons
 		}
 	}
 
+	/* allocate the bands for the parallel blit */
+	if (context->config.smp_band_flag && thread_pool_size() > 1) {
+		for (p = 0; p < PIPELINE_BLIT_TOTAL; ++p)
+			video_pipeline_band(&context->state.blit_pipeline[p], thread_pool_size());
+		video_pipeline_band(&context->state.buffer_pipeline_video, thread_pool_size());
+	}
+
 	/* print the pipelines */
 	{
 		int i;
@@ -1924,8 +2123,8 @@ static void video_recompute_pipeline(struct advance_video_context* context, cons
 
 		log_std(("emu:video: pipeline scale from %dx%d to %dx%d\n", context->state.game_visible_size_x, context->state.game_visible_size_y, context->state.mode_visible_size_x, context->state.mode_visible_size_y));
 
-		for (p = 0; p < PIPELINE_BLIT_MAX; ++p) {
-			log_std(("emu:video: pipeline_video %d\n", p));
+		for (p = 0; p < PIPELINE_BLIT_TOTAL; ++p) {
+			log_std(("emu:video: pipeline_video %d, simd %s\n", p, video_blit_simd_name(pipeline_simd(p))));
 			for (i = 1, stage = video_pipeline_begin(&context->state.blit_pipeline[p]); stage != video_pipeline_end(&context->state.blit_pipeline[p]); ++stage, ++i) {
 				if (stage == video_pipeline_pivot(&context->state.blit_pipeline[p])) {
 					snprintf(buffer, sizeof(buffer), "(%d) %s", i, pipe_name(video_pipeline_vert(&context->state.blit_pipeline[p])->type));
@@ -1965,11 +2164,78 @@ static void video_recompute_pipeline(struct advance_video_context* context, cons
 		}
 	}
 
+	/* the tune key identifies the game, the video mode, the effects and the hardware */
+	video_tune_enumerate(context);
+
+	snprintf(context->state.pipeline_tune_key, sizeof(context->state.pipeline_tune_key), "%s %dx%dx%d %dx%dx%d %x %x %u %s",
+		video_name(),
+		context->state.game_visible_size_x, context->state.game_visible_size_y, context->state.game_bytes_per_pixel * 8,
+		context->state.mode_visible_size_x, context->state.mode_visible_size_y, video_bytes_per_pixel() * 8,
+		combine_video, context->config.blit_orientation,
+		video_pipeline_band_max(&context->state.blit_pipeline[0]),
+		video_blit_simd_name(context->state.pipeline_tune_map[0].simd)
+	);
+
+	log_std(("emu:video: tune key '%s' with %u configurations\n", context->state.pipeline_tune_key, context->state.pipeline_tune_mac));
+
 	/* initialize the pipepeline measure */
-	context->state.pipeline_measure_flag = 1;
 	context->state.pipeline_measure_i = 0;
 	context->state.pipeline_measure_j = 0;
-	context->state.blit_pipeline_index = 0;
+
+	if (video_tune_load(context)) {
+		const struct advance_video_tune* tune = &context->state.pipeline_tune_map[context->state.pipeline_tune_index];
+
+		log_std(("emu:video: tune loaded, pipeline %u, simd %s, band %u\n", tune->pipeline, video_blit_simd_name(tune->simd), tune->band));
+
+		context->state.pipeline_tune_cache_flag = 1;
+		context->state.pipeline_measure_flag = 0;
+	} else {
+		context->state.pipeline_tune_cache_flag = 0;
+		context->state.pipeline_measure_flag = 1;
+		video_tune_set(context, 0);
+	}
+}
+
+/** Arguments of a band blit. */
+struct video_band_struct {
+	const struct video_pipeline_struct* pipeline;
+	unsigned x;
+	unsigned y;
+	const void* src;
+};
+
+/**
+ * Callback for the osd_parallelize() function.
+ */
+static void video_frame_band(void* arg, int num, int max)
+{
+	struct video_band_struct* band = arg;
+
+	osd_trace_begin("Blit band");
+	video_pipeline_blit_band(band->pipeline, band->x, band->y, band->src, num, max);
+	osd_trace_end();
+}
+
+/**
+ * Blit the pipeline, splitting it in at most the specified number of bands.
+ */
+static void video_frame_pipeline_blit(const struct video_pipeline_struct* pipeline, unsigned max, unsigned x, unsigned y, const void* src)
+{
+	struct video_band_struct band;
+
+	if (max > video_pipeline_band_max(pipeline))
+		max = video_pipeline_band_max(pipeline);
+	if (max <= 1) {
+		video_pipeline_blit(pipeline, x, y, src);
+		return;
+	}
+
+	band.pipeline = pipeline;
+	band.x = x;
+	band.y = y;
+	band.src = src;
+
+	osd_parallelize(video_frame_band, &band, max);
 }
 
 static void video_frame_put(struct advance_video_context* context, struct advance_ui_context* ui_context, const struct osd_bitmap* bitmap, unsigned x, unsigned y)
@@ -2048,7 +2314,7 @@ static void video_frame_put(struct advance_video_context* context, struct advanc
 
 		/* draw the game image in the buffer */
 		/* the image is rotated to be correctly orientated in this stage to allow an easy ui update */
-		video_pipeline_blit(&context->state.buffer_pipeline_video, dst_x, dst_y, (unsigned char*)bitmap->ptr + src_offset);
+		video_frame_pipeline_blit(&context->state.buffer_pipeline_video, video_pipeline_band_max(&context->state.buffer_pipeline_video), dst_x, dst_y, (unsigned char*)bitmap->ptr + src_offset);
 
 		/* draw the user interface */
 		if (ui_buffer_active) {
@@ -2109,7 +2375,7 @@ static void video_frame_put(struct advance_video_context* context, struct advanc
 		src_offset = context->state.blit_src_offset + context->state.game_visible_pos_y * context->state.blit_src_dw + context->state.game_visible_pos_x * context->state.blit_src_dp;
 
 		/* blit directly on the video */
-		video_pipeline_blit(&context->state.blit_pipeline[context->state.blit_pipeline_index], dst_x + x, dst_y + y, (unsigned char*)bitmap->ptr + src_offset);
+		video_frame_pipeline_blit(&context->state.blit_pipeline[context->state.blit_pipeline_index], context->state.pipeline_tune_map[context->state.pipeline_tune_index].band, dst_x + x, dst_y + y, (unsigned char*)bitmap->ptr + src_offset);
 	}
 
 	/* no buffering is used */
@@ -2123,22 +2389,23 @@ static void video_frame_put(struct advance_video_context* context, struct advanc
 			context->state.pipeline_measure_map[context->state.pipeline_measure_i][context->state.pipeline_measure_j] = stop;
 			++context->state.pipeline_measure_i;
 
-			if (context->state.pipeline_measure_i == PIPELINE_BLIT_MAX) {
+			if (context->state.pipeline_measure_i == context->state.pipeline_tune_mac) {
 				context->state.pipeline_measure_i = 0;
 				++context->state.pipeline_measure_j;
 
 				if (context->state.pipeline_measure_j == PIPELINE_MEASURE_MAX) {
 					unsigned i;
 
-					for (i = 0; i < PIPELINE_BLIT_MAX; ++i) {
+					for (i = 0; i < context->state.pipeline_tune_mac; ++i) {
+						const struct advance_video_tune* tune = &context->state.pipeline_tune_map[i];
 						context->state.pipeline_measure_result[i] = adv_measure_median(0.00001, 0.5, context->state.pipeline_measure_map[i], PIPELINE_MEASURE_MAX);
-						log_std(("emu:video: pipeline %d -> time %g\n", i, context->state.pipeline_measure_result[i]));
+						log_std(("emu:video: pipeline %u, simd %s, band %u -> time %g\n", tune->pipeline, video_blit_simd_name(tune->simd), tune->band, context->state.pipeline_measure_result[i]));
 					}
 
 					context->state.pipeline_measure_i = 0;
 
 					/* The first one is selected, then next one is selected only if a 3% gain is measured */
-					for (i = 1; i < PIPELINE_BLIT_MAX; ++i) {
+					for (i = 1; i < context->state.pipeline_tune_mac; ++i) {
 						if (context->state.pipeline_measure_result[i] < 0.97 * context->state.pipeline_measure_result[context->state.pipeline_measure_i]) {
 							context->state.pipeline_measure_i = i;
 						}
@@ -2148,10 +2415,14 @@ static void video_frame_put(struct advance_video_context* context, struct advanc
 
 					/* end the measure process */
 					context->state.pipeline_measure_flag = 0;
+
+					video_tune_set(context, context->state.pipeline_measure_i);
+					video_tune_save(context);
 				}
 			}
 
-			context->state.blit_pipeline_index = context->state.pipeline_measure_i;
+			if (context->state.pipeline_measure_flag)
+				video_tune_set(context, context->state.pipeline_measure_i);
 		}
 
 		context->state.pipeline_timing_map[context->state.pipeline_timing_i] = stop;
@@ -2171,7 +2442,9 @@ static void video_frame_screen(struct advance_video_context* context, struct adv
 {
 	video_recompute_pipeline(context, bitmap);
 
+	osd_trace_begin("Blit");
 	video_frame_put(context, ui_context, bitmap, update_x_get(), update_y_get());
+	osd_trace_end();
 }
 
 static void video_frame_palette(struct advance_video_context* context)
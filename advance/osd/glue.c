@@ -615,6 +615,18 @@ int mame_game_run(struct advance_context* context, const struct mame_option* adv
 	options.skip_warnings = context->global.config.quiet_flag;
 	options.samplerate = advance->samplerate;
 	options.use_samples = advance->samples_flag;
+#ifndef MESS
+	options.sound_resample_sinc = advance->resample_sinc_flag;
+	options.chd_cache = advance->chd_cache;
+	options.chd_readahead = advance->chd_readahead;
+	options.memory_benchmark = advance->memory_benchmark_flag;
+	options.memory_specialize = advance->memory_specialize_flag;
+	options.cpu_benchmark = advance->cpu_benchmark_flag;
+	options.cpu_parallel = advance->cpu_parallel_flag;
+	options.sound_parallel = advance->sound_parallel_flag;
+	options.cpu_idle = advance->cpu_idle_flag;
+	options.state_hash_frame = advance->state_hash_frame;
+#endif
 	options.brightness = advance->brightness;
 	options.pause_bright = context->global.config.pause_brightness;
 	options.gamma = advance->gamma;
@@ -3051,6 +3063,18 @@ adv_error mame_init(struct advance_context* context)
 
 	conf_string_register_default(context->cfg, "misc_bios", "default");
 
+#ifndef MESS
+	conf_int_register_limit_default(context->cfg, "misc_chdcache", 0, 1024, 4);
+	conf_int_register_limit_default(context->cfg, "misc_chdreadahead", 0, 256, 8);
+	conf_bool_register_default(context->cfg, "debug_memorybench", 0);
+	conf_bool_register_default(context->cfg, "misc_memspecialize", 1);
+	conf_bool_register_default(context->cfg, "debug_cpubench", 0);
+	conf_bool_register_default(context->cfg, "misc_cpuparallel", 0);
+	conf_bool_register_default(context->cfg, "misc_soundparallel", 0);
+	conf_bool_register_default(context->cfg, "misc_idleskip", 0);
+	conf_int_register_limit_default(context->cfg, "debug_statehash", 0, 1000000, 0);
+#endif
+
 #ifdef MESS
 	mess_init(context->cfg);
 #endif
@@ -3104,6 +3128,18 @@ adv_error mame_config_load(adv_conf* cfg_context, struct mame_option* option)
 
 	sncpy(option->bios_buffer, sizeof(option->bios_buffer), conf_string_get_default(cfg_context, "misc_bios"));
 
+#ifndef MESS
+	option->chd_cache = conf_int_get_default(cfg_context, "misc_chdcache") * 1024 * 1024;
+	option->chd_readahead = conf_int_get_default(cfg_context, "misc_chdreadahead");
+	option->memory_benchmark_flag = conf_bool_get_default(cfg_context, "debug_memorybench");
+	option->memory_specialize_flag = conf_bool_get_default(cfg_context, "misc_memspecialize");
+	option->cpu_benchmark_flag = conf_bool_get_default(cfg_context, "debug_cpubench");
+	option->cpu_parallel_flag = conf_bool_get_default(cfg_context, "misc_cpuparallel");
+	option->sound_parallel_flag = conf_bool_get_default(cfg_context, "misc_soundparallel");
+	option->cpu_idle_flag = conf_bool_get_default(cfg_context, "misc_idleskip");
+	option->state_hash_frame = conf_int_get_default(cfg_context, "debug_statehash");
+#endif
+
 	/* convert the dir separator char to ';'. */
 	/* the cheat system use always this char in all the operating system */
 	for (s = option->cheat_file_buffer; *s; ++s)
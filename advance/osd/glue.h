@@ -64,6 +64,17 @@ struct mame_option {
 
 	int samplerate;
 	int samples_flag;
+	int resample_sinc_flag;
+
+	unsigned chd_cache;
+	unsigned chd_readahead;
+	int memory_benchmark_flag;
+	int memory_specialize_flag;
+	int cpu_benchmark_flag;
+	int cpu_parallel_flag;
+	int sound_parallel_flag;
+	int cpu_idle_flag;
+	int state_hash_frame;
 
 	int vector_width;
 	int vector_height;
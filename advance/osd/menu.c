@@ -159,20 +159,27 @@ static int video_pipeline_menu(struct advance_video_context* context, struct adv
 		snprintf(buffer, sizeof(buffer), "Last write %.2f (ms)", timing * 1000);
 		advance_ui_menu_text_insert(&menu, buffer);
 
-		for (i = 0; i < PIPELINE_BLIT_MAX; ++i) {
-			const char* desc;
-			const char* select;
-			if (context->state.blit_pipeline_index == i)
-				select = "-> ";
-			else
-				select = "";
-			switch (i) {
-			case 0: desc = "Buffer"; break;
-			case 1: desc = "Direct"; break;
-			default: desc = "Unknown"; break;
-			}
-			snprintf(buffer, sizeof(buffer), "%s%s write %.2f (ms)", select, desc, context->state.pipeline_measure_result[i] * 1000);
+		if (context->state.pipeline_tune_cache_flag) {
+			const struct advance_video_tune* tune = &context->state.pipeline_tune_map[context->state.pipeline_tune_index];
+			snprintf(buffer, sizeof(buffer), "-> %s %s band %u (saved)", tune->pipeline == 0 ? "Buffer" : "Direct", video_blit_simd_name(tune->simd), tune->band);
 			advance_ui_menu_text_insert(&menu, buffer);
+		} else {
+			for (i = 0; i < context->state.pipeline_tune_mac; ++i) {
+				const struct advance_video_tune* tune = &context->state.pipeline_tune_map[i];
+				const char* desc;
+				const char* select;
+				if (context->state.pipeline_tune_index == i)
+					select = "-> ";
+				else
+					select = "";
+				switch (tune->pipeline) {
+				case 0: desc = "Buffer"; break;
+				case 1: desc = "Direct"; break;
+				default: desc = "Unknown"; break;
+				}
+				snprintf(buffer, sizeof(buffer), "%s%s %s band %u write %.2f (ms)", select, desc, video_blit_simd_name(tune->simd), tune->band, context->state.pipeline_measure_result[i] * 1000);
+				advance_ui_menu_text_insert(&menu, buffer);
+			}
 		}
 	}
 
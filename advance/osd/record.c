@@ -205,6 +205,357 @@ static void png_orientation(const uint8** ptr, unsigned* width, unsigned* height
 	}
 }
 
+/*************************************************************************************/
+/* Video encoder */
+
+/*
+ * The frames are converted in the PNG raw format by the emulation thread,
+ * and then compressed by the worker threads of osd_work_item_queue().
+ * Every frame is encoded as a delta of the previous one, using only the
+ * rectangle that changed. The encoded frames are written in order in the
+ * next video_update() call.
+ * If all the frames of the ring are waiting for the encoder, the new frame
+ * is dropped, and the previous one lasts longer.
+ */
+
+#define VIDEO_FRAME_MAX (RECORD_VIDEO_QUEUE_MAX + 1)
+
+/**
+ * Import a frame in the PNG raw format.
+ */
+static adv_error video_frame_import(struct advance_record_frame* frame, const uint8* pix_ptr, unsigned pix_width, unsigned pix_height, int pix_pixel_pitch, int pix_scanline_pitch, adv_color_def color_def, adv_color_rgb* palette_map, unsigned palette_max)
+{
+	unsigned raw_size;
+
+	frame->pixel = adv_png_convert_pixel_get(color_def, palette_max);
+	if (!frame->pixel)
+		return -1;
+
+	frame->width = pix_width;
+	frame->height = pix_height;
+
+	raw_size = pix_height * (pix_width * frame->pixel + 1);
+	if (raw_size > frame->raw_max) {
+		free(frame->raw_ptr);
+		frame->raw_max = 0;
+		frame->raw_ptr = malloc(raw_size);
+		if (!frame->raw_ptr)
+			return -1;
+		frame->raw_max = raw_size;
+	}
+
+	adv_png_convert_def(pix_width, pix_height, color_def, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, palette_map, palette_max, frame->raw_ptr, 1, frame->pal_ptr, &frame->pal_size);
+
+	return 0;
+}
+
+/**
+ * Compress the data of the IDAT chunk.
+ */
+static adv_error video_frame_deflate(struct advance_record_frame* frame, const unsigned char* ptr, unsigned size)
+{
+	uLongf z_size = compressBound(size);
+
+	if (z_size > frame->z_max) {
+		free(frame->z_ptr);
+		frame->z_max = 0;
+		frame->z_ptr = malloc(z_size);
+		if (!frame->z_ptr)
+			return -1;
+		frame->z_max = z_size;
+	}
+
+	if (compress2(frame->z_ptr, &z_size, ptr, size, Z_DEFAULT_COMPRESSION) != Z_OK)
+		return -1;
+
+	frame->z_size = z_size;
+
+	return 0;
+}
+
+/**
+ * Encode a frame.
+ * It's called by the worker threads, and it accesses only the frame
+ * and the previous one.
+ */
+static adv_error video_frame_encode(struct advance_record_frame* frame)
+{
+	const struct advance_record_frame* prev = frame->prev;
+	unsigned line = frame->width * frame->pixel + 1;
+	unsigned x0, x1, y0, y1;
+	unsigned dlt_line;
+	unsigned dlt_size;
+	unsigned char* d;
+	unsigned i, j;
+
+	frame->dhdr_size = 0;
+	frame->pal_flag = 0;
+	frame->z_size = 0;
+
+	/* a full frame if the previous one has a different format */
+	if (!prev
+		|| prev->width != frame->width
+		|| prev->height != frame->height
+		|| prev->pixel != frame->pixel
+		|| (prev->pal_size != 0) != (frame->pal_size != 0))
+		return video_frame_deflate(frame, frame->raw_ptr, frame->height * line);
+
+	frame->pal_flag = frame->pal_size != prev->pal_size || memcmp(frame->pal_ptr, prev->pal_ptr, frame->pal_size) != 0;
+
+	be_uint16_write(frame->dhdr_ptr, 1); /* object id */
+	frame->dhdr_ptr[2] = 1; /* PNG stream without IHDR header */
+
+	/* rectangle that changed, in bytes for x */
+	x0 = line;
+	x1 = 0;
+	y0 = frame->height;
+	y1 = 0;
+	for (i = 0; i < frame->height; ++i) {
+		const unsigned char* p0 = prev->raw_ptr + i * line + 1;
+		const unsigned char* p1 = frame->raw_ptr + i * line + 1;
+		unsigned l, r;
+
+		if (memcmp(p0, p1, line - 1) == 0)
+			continue;
+
+		l = 0;
+		while (p0[l] == p1[l])
+			++l;
+		r = line - 1;
+		while (p0[r - 1] == p1[r - 1])
+			--r;
+
+		if (y0 > i)
+			y0 = i;
+		y1 = i + 1;
+		if (x0 > l)
+			x0 = l;
+		if (x1 < r)
+			x1 = r;
+	}
+
+	if (y1 == 0) {
+		/* no change */
+		frame->dhdr_ptr[3] = 7;
+		frame->dhdr_size = 4;
+		return 0;
+	}
+
+	/* round to whole pixels */
+	x0 = x0 / frame->pixel;
+	x1 = (x1 + frame->pixel - 1) / frame->pixel;
+
+	frame->dhdr_ptr[3] = 1; /* pixel addition */
+	be_uint32_write(frame->dhdr_ptr + 4, x1 - x0);
+	be_uint32_write(frame->dhdr_ptr + 8, y1 - y0);
+	be_uint32_write(frame->dhdr_ptr + 12, x0);
+	be_uint32_write(frame->dhdr_ptr + 16, y0);
+	frame->dhdr_size = 20;
+
+	dlt_line = (x1 - x0) * frame->pixel + 1;
+	dlt_size = (y1 - y0) * dlt_line;
+	if (dlt_size > frame->dlt_max) {
+		free(frame->dlt_ptr);
+		frame->dlt_max = 0;
+		frame->dlt_ptr = malloc(dlt_size);
+		if (!frame->dlt_ptr)
+			return -1;
+		frame->dlt_max = dlt_size;
+	}
+
+	d = frame->dlt_ptr;
+	for (i = y0; i < y1; ++i) {
+		const unsigned char* p0 = prev->raw_ptr + i * line + 1 + x0 * frame->pixel;
+		const unsigned char* p1 = frame->raw_ptr + i * line + 1 + x0 * frame->pixel;
+
+		*d++ = 0; /* filter byte */
+		for (j = 0; j < dlt_line - 1; ++j)
+			*d++ = p1[j] - p0[j];
+	}
+
+	return video_frame_deflate(frame, frame->dlt_ptr, dlt_size);
+}
+
+static void video_frame_encode_proc(void* arg)
+{
+	struct advance_record_frame* frame = arg;
+	adv_error r;
+
+	osd_trace_begin("Record encode");
+	r = video_frame_encode(frame);
+	osd_trace_end();
+
+	osd_lock_acquire(frame->context->state.video_lock);
+	frame->encoded_error = r;
+	frame->encoded_flag = 1;
+	osd_lock_release(frame->context->state.video_lock);
+}
+
+static adv_error video_frame_write(struct advance_record_context* context, const struct advance_record_frame* frame)
+{
+	adv_fz* f = context->state.video_f;
+
+	if (adv_mng_write_fram(frame->tick, f, 0) != 0)
+		return -1;
+
+	if (frame->dhdr_size == 0) {
+		unsigned type;
+
+		if (frame->pixel == 1)
+			type = frame->pal_size != 0 ? 3 : 0;
+		else if (frame->pixel == 3)
+			type = 2;
+		else
+			type = 6;
+
+		/* the full frame is the concrete object 1, target of the next deltas */
+		if (adv_mng_write_defi(1, f, 0) != 0)
+			return -1;
+
+		if (adv_png_write_ihdr(frame->width, frame->height, 8, type, f, 0) != 0)
+			return -1;
+	} else {
+		if (adv_png_write_chunk(f, ADV_MNG_CN_DHDR, frame->dhdr_ptr, frame->dhdr_size, 0) != 0)
+			return -1;
+	}
+
+	if (frame->dhdr_size == 0 || frame->pal_flag) {
+		if (frame->pal_size != 0 && adv_png_write_chunk(f, ADV_PNG_CN_PLTE, frame->pal_ptr, frame->pal_size, 0) != 0)
+			return -1;
+	}
+
+	if (frame->z_size != 0) {
+		if (adv_png_write_chunk(f, ADV_PNG_CN_IDAT, frame->z_ptr, frame->z_size, 0) != 0)
+			return -1;
+	}
+
+	if (adv_png_write_iend(f, 0) != 0)
+		return -1;
+
+	return 0;
+}
+
+/**
+ * Write the encoded frames in order.
+ * \param wait If it has to wait for all the queued frames.
+ */
+static adv_error video_queue_flush(struct advance_record_context* context, adv_bool wait)
+{
+	while (context->state.video_frame_tail != context->state.video_frame_head) {
+		struct advance_record_frame* frame = &context->state.video_frame_map[context->state.video_frame_tail % VIDEO_FRAME_MAX];
+
+		if (frame->item) {
+			if (!wait) {
+				adv_bool encoded;
+
+				osd_lock_acquire(context->state.video_lock);
+				encoded = frame->encoded_flag;
+				osd_lock_release(context->state.video_lock);
+
+				if (!encoded)
+					break;
+			}
+
+			osd_work_item_wait(frame->item);
+			frame->item = 0;
+		}
+
+		++context->state.video_frame_tail;
+
+		if (frame->encoded_error != 0) {
+			log_std(("ERROR: encoding image frame in file %s\n", context->state.video_file_buffer));
+			return -1;
+		}
+
+		if (video_frame_write(context, frame) != 0) {
+			log_std(("ERROR: writing image frame in file %s\n", context->state.video_file_buffer));
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Wait for the encoder and free all the frames.
+ */
+static void video_queue_done(struct advance_record_context* context)
+{
+	unsigned i;
+
+	for (i = 0; i < VIDEO_FRAME_MAX; ++i) {
+		struct advance_record_frame* frame = &context->state.video_frame_map[i];
+
+		if (frame->item) {
+			osd_work_item_wait(frame->item);
+			frame->item = 0;
+		}
+
+		free(frame->raw_ptr);
+		frame->raw_ptr = 0;
+		frame->raw_max = 0;
+		free(frame->z_ptr);
+		frame->z_ptr = 0;
+		frame->z_max = 0;
+		free(frame->dlt_ptr);
+		frame->dlt_ptr = 0;
+		frame->dlt_max = 0;
+	}
+
+	if (context->state.video_frame_dropped != 0)
+		log_std(("record: video recording dropped %u frames\n", context->state.video_frame_dropped));
+}
+
+/**
+ * Queue a frame for the encoder.
+ */
+static adv_error video_queue_push(struct advance_record_context* context, const uint8* pix_ptr, unsigned pix_width, unsigned pix_height, int pix_pixel_pitch, int pix_scanline_pitch, adv_color_def color_def, adv_color_rgb* palette_map, unsigned palette_max)
+{
+	unsigned head = context->state.video_frame_head;
+	struct advance_record_frame* frame;
+
+	if (video_queue_flush(context, 0) != 0)
+		return -1;
+
+	if (head - context->state.video_frame_tail >= RECORD_VIDEO_QUEUE_MAX) {
+		/* the previous frame is not yet written, extend it */
+		context->state.video_frame_map[(head - 1) % VIDEO_FRAME_MAX].tick += context->state.video_freq_step;
+
+		if (context->state.video_frame_dropped == 0) {
+			log_std(("WARNING:record: the video encoder is too slow, dropping frames\n"));
+			advance_global_message(&CONTEXT.global, "Video recording is dropping frames");
+		}
+		++context->state.video_frame_dropped;
+
+		return 0;
+	}
+
+	/* the slot is not used, nor as the previous frame of a queued one */
+	frame = &context->state.video_frame_map[head % VIDEO_FRAME_MAX];
+
+	if (video_frame_import(frame, pix_ptr, pix_width, pix_height, pix_pixel_pitch, pix_scanline_pitch, color_def, palette_map, palette_max) != 0) {
+		log_std(("ERROR: converting image frame in file %s\n", context->state.video_file_buffer));
+		return -1;
+	}
+
+	frame->context = context;
+	frame->prev = head != 0 ? &context->state.video_frame_map[(head - 1) % VIDEO_FRAME_MAX] : 0;
+	frame->tick = context->state.video_freq_step;
+	frame->encoded_flag = 0;
+	frame->encoded_error = 0;
+
+	context->state.video_frame_head = head + 1;
+
+	frame->item = osd_work_item_queue(video_frame_encode_proc, frame);
+	if (!frame->item) {
+		/* no worker thread, encode now */
+		frame->encoded_error = video_frame_encode(frame);
+		frame->encoded_flag = 1;
+	}
+
+	return video_queue_flush(context, 0);
+}
+
 /*************************************************************************************/
 /* Video */
 
@@ -216,6 +567,8 @@ static void video_cancel(struct advance_record_context* context)
 
 	context->state.video_active_flag = 0;
 
+	video_queue_done(context);
+
 	fzclose(context->state.video_f);
 	remove(context->state.video_file_buffer);
 }
@@ -261,6 +614,9 @@ static adv_error video_start(struct advance_record_context* context, const char*
 	context->state.video_frequency = frequency;
 	context->state.video_sample_counter = 0;
 	context->state.video_stopped_flag = 0;
+	context->state.video_frame_head = 0;
+	context->state.video_frame_tail = 0;
+	context->state.video_frame_dropped = 0;
 
 	sncpy(context->state.video_file_buffer, sizeof(context->state.video_file_buffer), file);
 
@@ -287,7 +643,8 @@ static adv_error video_start(struct advance_record_context* context, const char*
 
 	png_orientation_size(&pix_width, &pix_height, orientation);
 
-	if (adv_mng_write_mhdr(pix_width, pix_height, context->state.video_freq_base, 1, context->state.video_f, 0) != 0) {
+	/* not LC, the frames are stored with Delta-PNG */
+	if (adv_mng_write_mhdr(pix_width, pix_height, context->state.video_freq_base, 0, context->state.video_f, 0) != 0) {
 		log_std(("ERROR: writing header in file %s\n", context->state.video_file_buffer));
 		fzclose(context->state.video_f);
 		remove(context->state.video_file_buffer);
@@ -339,13 +696,7 @@ static adv_error video_update(struct advance_record_context* context, const void
 
 	png_orientation(&pix_ptr, &pix_width, &pix_height, &pix_pixel_pitch, &pix_scanline_pitch, orientation);
 
-	if (adv_mng_write_fram(context->state.video_freq_step, context->state.video_f, 0) != 0) {
-		log_std(("ERROR: writing image frame in file %s\n", context->state.video_file_buffer));
-		goto err;
-	}
-
-	if (adv_png_write_raw_def(pix_width, pix_height, color_def, pix_ptr, pix_pixel_pitch, pix_scanline_pitch, palette_map, palette_max, 1, context->state.video_f, 0) != 0) {
-		log_std(("ERROR: writing image data in file %s\n", context->state.video_file_buffer));
+	if (video_queue_push(context, pix_ptr, pix_width, pix_height, pix_pixel_pitch, pix_scanline_pitch, color_def, palette_map, palette_max) != 0) {
 		goto err;
 	}
 
@@ -364,6 +715,12 @@ static adv_error video_stop(struct advance_record_context* context, unsigned* ti
 
 	context->state.video_active_flag = 0;
 
+	if (video_queue_flush(context, 1) != 0) {
+		goto err;
+	}
+
+	video_queue_done(context);
+
 	if (adv_mng_write_mend(context->state.video_f, 0) != 0) {
 		goto err;
 	}
@@ -376,6 +733,7 @@ static adv_error video_stop(struct advance_record_context* context, unsigned* ti
 
 err:
 	log_std(("ERROR: closing file %s\n", context->state.video_file_buffer));
+	video_queue_done(context);
 	fzclose(context->state.video_f);
 	remove(context->state.video_file_buffer);
 	return -1;
@@ -699,6 +1057,10 @@ adv_error advance_record_init(struct advance_record_context* context, adv_conf*
 		return -1;
 #endif
 
+	context->state.video_lock = osd_lock_alloc();
+	if (!context->state.video_lock)
+		return -1;
+
 	return 0;
 }
 
@@ -707,6 +1069,8 @@ void advance_record_done(struct advance_record_context* context)
 	sound_cancel(context);
 	video_cancel(context);
 
+	osd_lock_free(context->state.video_lock);
+
 #ifdef USE_SMP
 	pthread_mutex_destroy(&context->state.access_mutex);
 #endif
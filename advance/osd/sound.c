@@ -107,6 +107,8 @@ static void sound_volume_update(struct advance_sound_context* context)
 		mult = 0;
 
 	context->state.sample_mult = mult;
+
+	soundfx_volume_set(&context->state.fx, mult);
 }
 
 static void sound_dft_normalize(struct advance_sound_context* context, double* X)
@@ -307,295 +309,66 @@ static void sound_dft_post(struct advance_sound_context* context, unsigned chann
 	sound_dft(context, channel, sample, sample_count, context->state.dft_post_x, context->state.dft_post_X, &context->state.dft_post_counter, 0);
 }
 
-/* Adjust the sound volume */
-static void sound_adjust(struct advance_sound_context* context, unsigned channel, const short* input_sample, short* output_sample, unsigned sample_count)
+/* Adjust the volume, equalize, mix the channels and resample in a single pass */
+static void sound_play(struct advance_sound_context* context, const short* sample_buffer, unsigned sample_count, unsigned sample_recount, adv_bool normal_speed)
 {
-	unsigned i;
-	int mult;
-	unsigned count;
-
-	count = channel * sample_count;
-
-	mult = context->state.sample_mult;
-
-	assert(mult != SAMPLE_MULT_BASE);
-
-	for (i = 0; i < count; ++i) {
-		int v = input_sample[i];
-
-		v = v * mult / SAMPLE_MULT_BASE;
-
-		if (v > 32767) {
-			++context->state.overflow;
-			v = 32767;
-		}
-		if (v < -32768) {
-			++context->state.overflow;
-			v = -32768;
-		}
+	unsigned input_channel = context->state.input_mode != SOUND_MODE_MONO ? 2 : 1;
+	unsigned size;
+	short* sample_tap;
 
-		output_sample[i] = v;
+	if (context->config.normalize_flag) {
+		sound_dft_pre(context, input_channel, sample_buffer, sample_count);
 	}
-}
 
-static void sound_equalizer(struct advance_sound_context* context, unsigned channel, const short* input_sample, short* output_sample, unsigned sample_count)
-{
-	unsigned i, j;
-	int mult;
-
-	for (j = 0; j < channel; ++j) {
-		unsigned off = j;
-		for (i = 0; i < sample_count; ++i) {
-			double v, vl, vm, vh, vr;
-			int vi;
-
-			v = input_sample[off];
-
-			vr = 0;
-
-			if (context->config.equalizer_low > -40) {
-				adv_filter_insert(&context->state.equalizer_low, &context->state.equalizer_low_state[j], v);
-				vr += context->state.equalizer_low_factor * adv_filter_extract(&context->state.equalizer_low, &context->state.equalizer_low_state[j]);
-			}
-
-			if (context->config.equalizer_mid > -40) {
-				adv_filter_insert(&context->state.equalizer_mid, &context->state.equalizer_mid_state[j], v);
-				vr += context->state.equalizer_mid_factor * adv_filter_extract(&context->state.equalizer_mid, &context->state.equalizer_mid_state[j]);
-			}
-
-			if (context->config.equalizer_high > -40) {
-				adv_filter_insert(&context->state.equalizer_high, &context->state.equalizer_high_state[j], v);
-				vr += context->state.equalizer_high_factor * adv_filter_extract(&context->state.equalizer_high, &context->state.equalizer_high_state[j]);
-			}
-
-			/* lrint is potentially faster than a cast to int */
-			vi = lrint(vr);
-
-			if (vi > 32767) {
-				++context->state.overflow;
-				vi = 32767;
-			}
-			if (vi < -32768) {
-				++context->state.overflow;
-				vi = -32768;
-			}
+	/* if nothing changes, play directly the input */
+	if (sample_count == sample_recount && soundfx_is_identity(&context->state.fx)) {
+		/* compute the DFT only if the menu is active */
+		if (context->state.menu_sub_flag)
+			sound_dft_post(context, input_channel, sample_buffer, sample_count);
 
-			output_sample[off] = vi;
-			off += channel;
-		}
+		soundb_play(sample_buffer, sample_count);
+		return;
 	}
-}
 
-/* Resample */
-static void sound_scale(struct advance_sound_context* context, unsigned channel, const short* input_sample, short* output_sample, unsigned sample_count, unsigned sample_recount)
-{
-	adv_slice slice;
-
-	slice_set(&slice, sample_count, sample_recount);
-
-	if (channel == 1) {
-		if (sample_count < sample_recount) {
-			/* expansion */
-			int count = slice.count;
-			int error = slice.error;
-			while (count) {
-				unsigned run = slice.whole;
-				if ((error += slice.up) > 0) {
-					++run;
-					error -= slice.down;
-				}
-
-				while (run) {
-					output_sample[0] = input_sample[0];
-					output_sample += 1;
-					--run;
-				}
-				input_sample += 1;
-
-				--count;
-			}
-		} else {
-			/* reduction */
-			int count = slice.count;
-			int error = slice.error;
-			while (count) {
-				unsigned run = slice.whole;
-				if ((error += slice.up) > 0) {
-					++run;
-					error -= slice.down;
-				}
-
-				output_sample[0] = input_sample[0];
-				output_sample += 1;
-				input_sample += run;
-
-				--count;
-			}
+	/* the buffers are reused for all the frames */
+	size = sample_recount * context->state.output_bytes_per_sample;
+	if (context->state.fx_buffer_max < size) {
+		short* buffer = (short*)realloc(context->state.fx_buffer, size);
+		if (!buffer) {
+			log_std(("ERROR:sound: low memory, frame not played\n"));
+			return;
 		}
-	} else if (channel == 2) {
-		if (sample_count < sample_recount) {
-			/* expansion */
-			int count = slice.count;
-			int error = slice.error;
-			while (count) {
-				unsigned run = slice.whole;
-				if ((error += slice.up) > 0) {
-					++run;
-					error -= slice.down;
-				}
-
-				while (run) {
-					output_sample[0] = input_sample[0];
-					output_sample[1] = input_sample[1];
-					output_sample += 2;
-					--run;
-				}
-				input_sample += 2;
-
-				--count;
-			}
-		} else {
-			/* reduction */
-			int count = slice.count;
-			int error = slice.error;
-			while (count) {
-				unsigned run = slice.whole;
-				if ((error += slice.up) > 0) {
-					++run;
-					error -= slice.down;
-				}
-
-				output_sample[0] = input_sample[0];
-				output_sample[1] = input_sample[1];
-				output_sample += 2;
-				input_sample += 2 * run;
-
-				--count;
-			}
-		}
-	}
-}
-
-static void sound_play_recount(struct advance_sound_context* context, const short* sample_buffer, unsigned sample_count, unsigned sample_recount)
-{
-	unsigned output_channel = context->state.output_mode != SOUND_MODE_MONO ? 2 : 1;
-
-	if (sample_count != sample_recount) {
-		short* sample_re = (short*)malloc(sample_recount * context->state.output_bytes_per_sample);
-
-		sound_scale(context, output_channel, sample_buffer, sample_re, sample_count, sample_recount);
-
-		soundb_play(sample_re, sample_recount);
-
-		free(sample_re);
-	} else {
-		soundb_play(sample_buffer, sample_count);
+		context->state.fx_buffer = buffer;
+		context->state.fx_buffer_max = size;
 	}
-}
 
-static void sound_play_effect(struct advance_sound_context* context, const short* sample_buffer, unsigned sample_count, unsigned sample_recount)
-{
-	unsigned input_channel = context->state.input_mode != SOUND_MODE_MONO ? 2 : 1;
-
-	/* compute the DFT only if the menu is active */
-	if (context->state.menu_sub_flag)
-		sound_dft_post(context, input_channel, sample_buffer, sample_count);
-
-	if (context->state.input_mode != context->state.output_mode) {
-		short* sample_mix = (short*)malloc(sample_count * context->state.output_bytes_per_sample);
-
-		if (context->state.input_mode == SOUND_MODE_MONO && context->state.output_mode == SOUND_MODE_STEREO) {
-			unsigned i;
-			const short* sample_mono = sample_buffer;
-			short* sample_stereo = sample_mix;
-			for (i = 0; i < sample_count; ++i) {
-				sample_stereo[0] = sample_mono[0];
-				sample_stereo[1] = sample_mono[0];
-				sample_mono += 1;
-				sample_stereo += 2;
-			}
-		} else if (context->state.input_mode == SOUND_MODE_MONO && context->state.output_mode == SOUND_MODE_SURROUND) {
-			unsigned i;
-			const short* sample_mono = sample_buffer;
-			short* sample_surround = sample_mix;
-			for (i = 0; i < sample_count; ++i) {
-				if (sample_mono[0] == -32768) { /* prevent overflow */
-					sample_surround[0] = -32768;
-					sample_surround[1] = 32767;
-				} else {
-					sample_surround[0] = sample_mono[0];
-					sample_surround[1] = -sample_mono[0];
-				}
-				sample_mono += 1;
-				sample_surround += 2;
-			}
-		} else if (context->state.input_mode == SOUND_MODE_STEREO && context->state.output_mode == SOUND_MODE_MONO) {
-			unsigned i;
-			const short* sample_stereo = sample_buffer;
-			short* sample_mono = sample_mix;
-			for (i = 0; i < sample_count; ++i) {
-				sample_mono[0] = (sample_stereo[0] + sample_stereo[1]) / 2;
-				sample_mono += 1;
-				sample_stereo += 2;
+	/* the DFT uses the equalized samples before the mixing */
+	sample_tap = 0;
+	if (context->state.menu_sub_flag) {
+		size = sample_count * context->state.input_bytes_per_sample;
+		if (context->state.tap_buffer_max < size) {
+			short* buffer = (short*)realloc(context->state.tap_buffer, size);
+			if (buffer) {
+				context->state.tap_buffer = buffer;
+				context->state.tap_buffer_max = size;
 			}
-		} else if (context->state.input_mode == SOUND_MODE_STEREO && context->state.output_mode == SOUND_MODE_SURROUND) {
-			unsigned i;
-			const short* sample_stereo = sample_buffer;
-			short* sample_surround = sample_mix;
-			for (i = 0; i < sample_count; ++i) {
-				sample_surround[0] = (3 * sample_stereo[0] - sample_stereo[1]) / 4;
-				sample_surround[1] = (3 * sample_stereo[1] - sample_stereo[0]) / 4;
-				sample_surround += 2;
-				sample_stereo += 2;
-			}
-		} else {
-			memset(sample_mix, 0, sample_count * context->state.output_bytes_per_sample);
 		}
-
-		sound_play_recount(context, sample_mix, sample_count, sample_recount);
-
-		free(sample_mix);
-	} else {
-		sound_play_recount(context, sample_buffer, sample_count, sample_recount);
-	}
-}
-
-static void sound_play_equalizer(struct advance_sound_context* context, const short* sample_buffer, unsigned sample_count, unsigned sample_recount)
-{
-	unsigned input_channel = context->state.input_mode != SOUND_MODE_MONO ? 2 : 1;
-
-	if (context->state.equalizer_flag) {
-		short* sample_mix = (short*)malloc(sample_count * context->state.input_bytes_per_sample);
-
-		sound_equalizer(context, input_channel, sample_buffer, sample_mix, sample_count);
-
-		sound_play_effect(context, sample_mix, sample_count, sample_recount);
-
-		free(sample_mix);
-	} else {
-		sound_play_effect(context, sample_buffer, sample_count, sample_recount);
+		if (context->state.tap_buffer_max >= size)
+			sample_tap = context->state.tap_buffer;
 	}
-}
 
-static void sound_play_adjust(struct advance_sound_context* context, const short* sample_buffer, unsigned sample_count, unsigned sample_recount, adv_bool normal_speed)
-{
-	unsigned input_channel = context->state.input_mode != SOUND_MODE_MONO ? 2 : 1;
-
-	if (context->config.normalize_flag) {
-		sound_dft_pre(context, input_channel, sample_buffer, sample_count);
+	if (soundfx_process(&context->state.fx, sample_buffer, sample_count, context->state.fx_buffer, sample_recount, sample_tap) != 0) {
+		log_std(("ERROR:sound: low memory, frame muted\n"));
+		sample_tap = 0;
 	}
 
-	if (context->state.sample_mult != SAMPLE_MULT_BASE) {
-		short* sample_mix = (short*)malloc(sample_count * context->state.input_bytes_per_sample);
+	context->state.overflow += context->state.fx.overflow;
+	context->state.fx.overflow = 0;
 
-		sound_adjust(context, input_channel, sample_buffer, sample_mix, sample_count);
+	if (sample_tap)
+		sound_dft_post(context, input_channel, sample_tap, sample_count);
 
-		sound_play_equalizer(context, sample_mix, sample_count, sample_recount);
-
-		free(sample_mix);
-	} else {
-		sound_play_equalizer(context, sample_buffer, sample_count, sample_recount);
-	}
+	soundb_play(context->state.fx_buffer, sample_recount);
 }
 
 /**
@@ -639,7 +412,7 @@ void advance_sound_frame(struct advance_sound_context* context, struct advance_r
 
 	start = advance_timer();
 
-	sound_play_adjust(context, sample_buffer, sample_count, sample_recount, normal_speed);
+	sound_play(context, sample_buffer, sample_count, sample_recount, normal_speed);
 
 	stop = advance_timer();
 
@@ -683,6 +456,54 @@ int advance_sound_latency_diff(struct advance_sound_context* context, double ext
 	}
 }
 
+/**
+ * Return the number of new underruns of the sound output.
+ * After an underrun the output buffer restarts empty, and the
+ * previous latency measures are not valid anymore.
+ * \return Number of underruns since the previous call.
+ */
+unsigned advance_sound_underrun(struct advance_sound_context* context)
+{
+	unsigned underrun;
+	unsigned diff;
+
+	if (!context->state.active_flag || !soundb_is_active())
+		return 0;
+
+	underrun = soundb_underrun();
+	diff = underrun - context->state.underrun;
+	context->state.underrun = underrun;
+
+	return diff;
+}
+
+/**
+ * Return the number of samples discarded by the sound output.
+ * The samples are discarded when the output buffer is full, and
+ * the sound skips.
+ * 
+eturn Number of samples discarded since the previous call.
+ */
+unsigned advance_sound_overrun(struct advance_sound_context* context)
+{
+	unsigned overrun;
+	unsigned diff;
+
+	if (!context->state.active_flag || !soundb_is_active())
+		return 0;
+
+	overrun = soundb_overrun();
+	diff = overrun - context->state.overrun;
+	context->state.overrun = overrun;
+
+	return diff;
+}
+
+static adv_conf_enum_int OPTION_RESAMPLE[] = {
+	{ "linear", 0 },
+	{ "sinc", 1 }
+};
+
 static adv_conf_enum_int OPTION_CHANNELS[] = {
 	{ "auto", SOUND_MODE_AUTO },
 	{ "mono", SOUND_MODE_MONO },
@@ -700,6 +521,7 @@ adv_error advance_sound_init(struct advance_sound_context* context, adv_conf* cf
 	conf_string_register_default(cfg_context, "sound_adjust", "auto");
 	conf_int_register_limit_default(cfg_context, "sound_samplerate", 5000, 96000, 44100);
 	conf_bool_register_default(cfg_context, "sound_normalize", 1);
+	conf_int_register_enum_default(cfg_context, "sound_resample", conf_enum(OPTION_RESAMPLE), 0);
 	conf_float_register_limit_default(cfg_context, "sound_latency", 0.0, 2.0, 0.05);
 
 	soundb_reg(cfg_context, 1);
@@ -752,6 +574,7 @@ adv_error advance_sound_config_load(struct advance_sound_context* context, adv_c
 	context->config.mutedemo_flag = conf_bool_get_default(cfg_context, "misc_mutedemo");
 	context->config.mutestartup_flag = 1;
 	option->samplerate = conf_int_get_default(cfg_context, "sound_samplerate");
+	option->resample_sinc_flag = conf_int_get_default(cfg_context, "sound_resample");
 
 	context->config.equalizer_low = conf_int_get_default(cfg_context, "sound_equalizer_lowvolume");
 	context->config.equalizer_mid = conf_int_get_default(cfg_context, "sound_equalizer_midvolume");
@@ -838,27 +661,25 @@ static void sound_equalizer_update(struct advance_sound_context* context)
 		&& context->config.equalizer_mid == 0
 		&& context->config.equalizer_high == 0) {
 		context->state.equalizer_flag = 0;
+
+		soundfx_equalizer_disable(&context->state.fx);
 	} else {
-		adv_bool reset = !context->state.equalizer_flag;
+		adv_filter band[SOUNDFX_BAND_MAX];
+		double factor[SOUNDFX_BAND_MAX];
 
 		context->state.equalizer_flag = 1;
 
-		adv_filter_lp_chebyshev_set(&context->state.equalizer_low, context->config.eql_cut1, 5, -1);
-		adv_filter_bp_chebyshev_set(&context->state.equalizer_mid, context->config.eql_cut1, context->config.eql_cut2, 5, -1);
-		adv_filter_hp_chebyshev_set(&context->state.equalizer_high, context->config.eql_cut2, 5, -1);
+		adv_filter_lp_chebyshev_set(&band[0], context->config.eql_cut1, 5, -1);
+		adv_filter_bp_chebyshev_set(&band[1], context->config.eql_cut1, context->config.eql_cut2, 5, -1);
+		adv_filter_hp_chebyshev_set(&band[2], context->config.eql_cut2, 5, -1);
 
-		if (reset) {
-			unsigned i;
-			for (i = 0; i < 2; ++i) {
-				adv_filter_state_reset(&context->state.equalizer_low, &context->state.equalizer_low_state[i]);
-				adv_filter_state_reset(&context->state.equalizer_mid, &context->state.equalizer_mid_state[i]);
-				adv_filter_state_reset(&context->state.equalizer_high, &context->state.equalizer_high_state[i]);
-			}
-		}
+		/* the bands at the minimum are disabled */
+		factor[0] = context->config.equalizer_low > -40 ? pow(10, (double)context->config.equalizer_low / 20) : 0;
+		factor[1] = context->config.equalizer_mid > -40 ? pow(10, (double)context->config.equalizer_mid / 20) : 0;
+		factor[2] = context->config.equalizer_high > -40 ? pow(10, (double)context->config.equalizer_high / 20) : 0;
 
-		context->state.equalizer_low_factor = pow(10, (double)context->config.equalizer_low / 20);
-		context->state.equalizer_mid_factor = pow(10, (double)context->config.equalizer_mid / 20);
-		context->state.equalizer_high_factor = pow(10, (double)context->config.equalizer_high / 20);
+		/* the filter state is cleared when the equalizer is enabled */
+		soundfx_equalizer_set(&context->state.fx, band, factor, 0);
 	}
 }
 
@@ -870,6 +691,24 @@ static void sound_normalize_update(struct advance_sound_context* context)
 		context->config.adjust = 0;
 }
 
+static void sound_mix_update(struct advance_sound_context* context)
+{
+	adv_soundfx_mix mix;
+
+	if (context->state.input_mode == SOUND_MODE_MONO && context->state.output_mode == SOUND_MODE_STEREO)
+		mix = soundfx_mix_mono_stereo;
+	else if (context->state.input_mode == SOUND_MODE_MONO && context->state.output_mode == SOUND_MODE_SURROUND)
+		mix = soundfx_mix_mono_surround;
+	else if (context->state.input_mode == SOUND_MODE_STEREO && context->state.output_mode == SOUND_MODE_MONO)
+		mix = soundfx_mix_stereo_mono;
+	else if (context->state.input_mode == SOUND_MODE_STEREO && context->state.output_mode == SOUND_MODE_SURROUND)
+		mix = soundfx_mix_stereo_surround;
+	else
+		mix = soundfx_mix_none;
+
+	context->state.fx.mix = mix;
+}
+
 static adv_error sound_mode_update(struct advance_sound_context* context)
 {
 	int new_mode;
@@ -904,6 +743,10 @@ static adv_error sound_mode_update(struct advance_sound_context* context)
 			return -1;
 		}
 
+		/* the underrun and overrun counters restart with the driver */
+		context->state.underrun = 0;
+		context->state.overrun = 0;
+
 		soundb_start(0);
 	}
 
@@ -911,6 +754,8 @@ static adv_error sound_mode_update(struct advance_sound_context* context)
 	context->state.output_mode = new_mode;
 	context->state.output_bytes_per_sample = context->state.output_mode != SOUND_MODE_MONO ? 4 : 2;
 
+	sound_mix_update(context);
+
 	return 0;
 }
 
@@ -1151,6 +996,15 @@ int osd2_sound_init(unsigned* sample_rate, int stereo_flag)
 		context->config.eql_cut2 = 0.5;
 
 	context->state.overflow = 0;
+	context->state.underrun = 0;
+	context->state.overrun = 0;
+
+	soundfx_init(&context->state.fx, context->state.input_mode != SOUND_MODE_MONO ? 2 : 1, soundfx_mix_none);
+	context->state.fx_buffer = 0;
+	context->state.fx_buffer_max = 0;
+	context->state.tap_buffer = 0;
+	context->state.tap_buffer_max = 0;
+	sound_mix_update(context);
 
 	soundb_start(context->config.latency_time);
 
@@ -1181,5 +1035,9 @@ void osd2_sound_done(void)
 	free(context->state.dft_window);
 	free(context->state.dft_equal_loudness);
 	free(context->state.adjust_power_history_map);
+
+	soundfx_done(&context->state.fx);
+	free(context->state.fx_buffer);
+	free(context->state.tap_buffer);
 }
 
@@ -443,6 +443,7 @@ void advance_video_sync(struct advance_video_context* context, struct advance_so
 {
 	if (!skip_flag) {
 		double delay;
+		unsigned overrun;
 
 		if (!context->state.fastest_flag
 			&& !context->state.measure_flag
@@ -457,6 +458,24 @@ void advance_video_sync(struct advance_video_context* context, struct advance_so
 		delay = context->state.skip_step;
 
 		context->state.latency_diff = advance_sound_latency_diff(sound_context, delay);
+
+		/* after an underrun the sound buffer restarted empty, the previous */
+		/* measures are obsolete and the correction must start immediately */
+		if (advance_sound_underrun(sound_context) != 0) {
+			unsigned i;
+
+			log_std(("WARNING:advance:sync: sound underrun, latency error %d samples. Try increasing the 'sound_latency' option.\n", context->state.latency_diff));
+
+			for (i = 0; i < AUDIOVIDEO_MEASURE_MAX; ++i)
+				context->state.av_sync_map[i] = context->state.latency_diff;
+		}
+
+		/* the samples discarded because the output buffer was full */
+		/* are lost, the latency correction is too slow to prevent them */
+		overrun = advance_sound_overrun(sound_context);
+		if (overrun != 0) {
+			log_std(("WARNING:advance:sync: sound overrun, %u samples discarded, latency error %d samples. Try decreasing the 'sound_latency' option.\n", overrun, context->state.latency_diff));
+		}
 	} else {
 		++context->state.sync_skip_counter;
 	}
@@ -46,3 +46,48 @@ void thread_done(void)
 {
 }
 
+int thread_pool_init(unsigned count)
+{
+	return 0;
+}
+
+void thread_pool_done(void)
+{
+}
+
+unsigned thread_pool_size(void)
+{
+	return 1;
+}
+
+/** Lock. Without threads it doesn't need any state. */
+struct _osd_lock {
+	int dummy;
+};
+
+osd_work_item* osd_work_item_queue(void (*func)(void* arg), void* arg)
+{
+	return 0;
+}
+
+void osd_work_item_wait(osd_work_item* item)
+{
+}
+
+osd_lock* osd_lock_alloc(void)
+{
+	return malloc(sizeof(osd_lock));
+}
+
+void osd_lock_acquire(osd_lock* lock)
+{
+}
+
+void osd_lock_release(osd_lock* lock)
+{
+}
+
+void osd_lock_free(osd_lock* lock)
+{
+	free(lock);
+}
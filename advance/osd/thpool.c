@@ -0,0 +1,455 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2001, 2002, 2003 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * In addition, as a special exception, Andrea Mazzoleni
+ * gives permission to link the code of this program with
+ * the MAME library (or with modified versions of MAME that use the
+ * same license as MAME), and distribute linked combinations including
+ * the two.  You must obey the GNU General Public License in all
+ * respects for all of the code used other than MAME.  If you modify
+ * this file, you may extend this exception to your version of the
+ * file, but you are not obligated to do so.  If you do not wish to
+ * do so, delete this exception statement from your version.
+ */
+
+#include "portable.h"
+
+#include "thread.h"
+#include "trace.h"
+
+#include "log.h"
+#include "target.h"
+
+/** \file
+ * A pthread implementation of the osd_parallelize function.
+ *
+ * This implementation supports a N processor system and reentrant calls.
+ *
+ * A pool of worker threads is created at the startup. Every call of
+ * osd_parallelize() splits the work in slices, queues all of them except
+ * the first, and runs the first on the calling thread.
+ * While waiting for the completion the calling thread also runs any
+ * other queued slice. In this way a reentrant call never blocks all the
+ * workers and it doesn't need to fall back to a serial execution.
+ *
+ * The workers also run the asynchronous work items of osd_work_item_queue()
+ * when no slice is waiting. The items are never run by a thread waiting
+ * in osd_parallelize(), because they may take a long time.
+ */
+
+#include <pthread.h>
+
+/** Max number of worker threads. */
+#define THREAD_MAX 64
+
+/** Group of slices of the same osd_parallelize() call. */
+struct thread_group {
+	unsigned count; /**< Number of slices not yet completed. */
+};
+
+/** Slice of work. */
+struct thread_work {
+	struct thread_group* group; /**< Group of the slice. */
+	void (*func)(void*, int, int); /**< Function to call. */
+	void* arg; /**< Argument of the function. */
+	int num; /**< Index of the slice. */
+	int max; /**< Number of slices. */
+	struct thread_work* next; /**< Next slice in the queue. */
+};
+
+/** Asynchronous work item. */
+struct _osd_work_item {
+	void (*func)(void*); /**< Function to call. */
+	void* arg; /**< Argument of the function. */
+	int done; /**< Item completed. */
+	struct _osd_work_item* next; /**< Next item in the queue. */
+};
+
+/** Lock. */
+struct _osd_lock {
+	pthread_mutex_t mutex; /**< Mutex of the lock. */
+};
+
+/** Worker thread. */
+struct thread_worker {
+	pthread_t id; /**< ID of the thread. */
+	target_clock_t busy; /**< Time spent running slices. */
+	unsigned count; /**< Number of slices run. */
+};
+
+static pthread_mutex_t thread_mutex; /**< Access mutex. */
+static pthread_cond_t thread_work_cond; /**< Work available condition. */
+static pthread_cond_t thread_done_cond; /**< Group completed condition. */
+static struct thread_work* thread_head; /**< First slice in the queue. */
+static struct thread_work* thread_tail; /**< Last slice in the queue. */
+static osd_work_item* thread_item_head; /**< First work item in the queue. */
+static osd_work_item* thread_item_tail; /**< Last work item in the queue. */
+static int thread_exit; /**< Thread exit requested. */
+static struct thread_worker thread_map[THREAD_MAX]; /**< Worker threads. */
+static unsigned thread_max; /**< Number of worker threads. */
+static target_clock_t thread_start; /**< Start time of the pool. */
+
+/** Number of processors online. */
+static unsigned thread_cpu(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	if (n >= 1)
+		return n;
+#endif
+	return 2;
+}
+
+/** Push a slice in the queue. The mutex must be locked. */
+static void thread_push(struct thread_work* work)
+{
+	work->next = 0;
+	if (thread_tail)
+		thread_tail->next = work;
+	else
+		thread_head = work;
+	thread_tail = work;
+}
+
+/** Pop a slice from the queue. The mutex must be locked. */
+static struct thread_work* thread_pop(void)
+{
+	struct thread_work* work = thread_head;
+
+	if (work) {
+		thread_head = work->next;
+		if (!thread_head)
+			thread_tail = 0;
+	}
+
+	return work;
+}
+
+/**
+ * Run a slice.
+ * The mutex must be locked, and it's unlocked during the execution.
+ */
+static void thread_run(struct thread_work* work, struct thread_worker* worker)
+{
+	target_clock_t start;
+	struct thread_group* group = work->group;
+
+	pthread_mutex_unlock(&thread_mutex);
+
+	start = target_clock();
+
+	work->func(work->arg, work->num, work->max);
+
+	if (worker) {
+		worker->busy += target_clock() - start;
+		++worker->count;
+	}
+
+	pthread_mutex_lock(&thread_mutex);
+
+	if (--group->count == 0)
+		pthread_cond_broadcast(&thread_done_cond);
+}
+
+/** Pop a work item from the queue. The mutex must be locked. */
+static osd_work_item* thread_item_pop(void)
+{
+	osd_work_item* item = thread_item_head;
+
+	if (item) {
+		thread_item_head = item->next;
+		if (!thread_item_head)
+			thread_item_tail = 0;
+	}
+
+	return item;
+}
+
+/**
+ * Run a work item.
+ * The mutex must be locked, and it's unlocked during the execution.
+ */
+static void thread_item_run(osd_work_item* item, struct thread_worker* worker)
+{
+	target_clock_t start;
+
+	pthread_mutex_unlock(&thread_mutex);
+
+	start = target_clock();
+
+	item->func(item->arg);
+
+	if (worker) {
+		worker->busy += target_clock() - start;
+		++worker->count;
+	}
+
+	pthread_mutex_lock(&thread_mutex);
+
+	item->done = 1;
+	pthread_cond_broadcast(&thread_done_cond);
+}
+
+static void* thread_proc(void* arg)
+{
+	struct thread_worker* worker = arg;
+	char name[32];
+
+	snprintf(name, sizeof(name), "Worker %u", (unsigned)(worker - thread_map));
+	trace_thread(name);
+
+	pthread_mutex_lock(&thread_mutex);
+
+	while (1) {
+		/* wait for a slice or a work item */
+		while (!thread_head && !thread_item_head && !thread_exit)
+			pthread_cond_wait(&thread_work_cond, &thread_mutex);
+
+		if (thread_exit)
+			break;
+
+		/* the slices have the precedence */
+		if (thread_head)
+			thread_run(thread_pop(), worker);
+		else
+			thread_item_run(thread_item_pop(), worker);
+	}
+
+	pthread_mutex_unlock(&thread_mutex);
+
+	pthread_exit(0);
+	return 0;
+}
+
+int thread_init(void)
+{
+	thread_exit = 0;
+	thread_max = 0;
+	thread_head = 0;
+	thread_tail = 0;
+	thread_item_head = 0;
+	thread_item_tail = 0;
+
+	if (pthread_mutex_init(&thread_mutex, NULL) != 0)
+		return -1;
+	if (pthread_cond_init(&thread_work_cond, NULL) != 0)
+		return -1;
+	if (pthread_cond_init(&thread_done_cond, NULL) != 0)
+		return -1;
+
+	return 0;
+}
+
+void thread_done(void)
+{
+	thread_pool_done();
+
+	pthread_mutex_destroy(&thread_mutex);
+	pthread_cond_destroy(&thread_work_cond);
+	pthread_cond_destroy(&thread_done_cond);
+}
+
+int thread_pool_init(unsigned count)
+{
+	unsigned i;
+
+	/* the calling thread is always used */
+	if (count == 0)
+		count = thread_cpu() - 1;
+	if (count > THREAD_MAX)
+		count = THREAD_MAX;
+
+	log_std(("thread: pool with %u workers\n", count));
+
+	thread_exit = 0;
+	thread_start = target_clock();
+
+	for (i = 0; i < count; ++i) {
+		thread_map[i].busy = 0;
+		thread_map[i].count = 0;
+		if (pthread_create(&thread_map[i].id, NULL, thread_proc, &thread_map[i]) != 0) {
+			log_std(("ERROR:thread: error calling pthread_create()\n"));
+			break;
+		}
+		thread_max = i + 1;
+	}
+
+	if (thread_max != count) {
+		thread_pool_done();
+		return -1;
+	}
+
+	return 0;
+}
+
+void thread_pool_done(void)
+{
+	target_clock_t elapsed;
+	unsigned i;
+
+	if (!thread_max)
+		return;
+
+	pthread_mutex_lock(&thread_mutex);
+	thread_exit = 1;
+	pthread_cond_broadcast(&thread_work_cond);
+	pthread_mutex_unlock(&thread_mutex);
+
+	for (i = 0; i < thread_max; ++i)
+		pthread_join(thread_map[i].id, NULL);
+
+	/* complete the work items not yet started */
+	pthread_mutex_lock(&thread_mutex);
+	while (thread_item_head)
+		thread_item_run(thread_item_pop(), 0);
+	pthread_mutex_unlock(&thread_mutex);
+
+	elapsed = target_clock() - thread_start;
+	if (elapsed <= 0)
+		elapsed = 1;
+
+	for (i = 0; i < thread_max; ++i) {
+		log_std(("thread: worker %u busy %.3f s (%.1f%%) with %u slices\n", i, thread_map[i].busy / (double)TARGET_CLOCKS_PER_SEC, thread_map[i].busy * 100.0 / elapsed, thread_map[i].count));
+	}
+
+	thread_max = 0;
+}
+
+unsigned thread_pool_size(void)
+{
+	return thread_max + 1;
+}
+
+void osd_parallelize(void (*func)(void* arg, int num, int max), void* arg, int max)
+{
+	struct thread_work work[THREAD_MAX + 1];
+	struct thread_group group;
+	int i;
+
+	if (!thread_is_active()) {
+		func(arg, 0, 1);
+		return;
+	}
+
+	/* one slice for every worker and one for the calling thread */
+	if (max > (int)thread_max + 1)
+		max = thread_max + 1;
+
+	if (max <= 1) {
+		func(arg, 0, 1);
+		return;
+	}
+
+	group.count = max - 1;
+
+	pthread_mutex_lock(&thread_mutex);
+	for (i = 1; i < max; ++i) {
+		work[i].group = &group;
+		work[i].func = func;
+		work[i].arg = arg;
+		work[i].num = i;
+		work[i].max = max;
+		thread_push(&work[i]);
+	}
+	pthread_cond_broadcast(&thread_work_cond);
+	pthread_mutex_unlock(&thread_mutex);
+
+	/* call the primary slice */
+	func(arg, 0, max);
+
+	/* help the workers until the group completes */
+	pthread_mutex_lock(&thread_mutex);
+	while (group.count != 0) {
+		struct thread_work* pending = thread_pop();
+		if (pending)
+			thread_run(pending, 0);
+		else
+			pthread_cond_wait(&thread_done_cond, &thread_mutex);
+	}
+	pthread_mutex_unlock(&thread_mutex);
+}
+
+osd_work_item* osd_work_item_queue(void (*func)(void* arg), void* arg)
+{
+	osd_work_item* item;
+
+	if (!thread_is_active() || !thread_max)
+		return 0;
+
+	item = malloc(sizeof(osd_work_item));
+	if (!item)
+		return 0;
+
+	item->func = func;
+	item->arg = arg;
+	item->done = 0;
+	item->next = 0;
+
+	pthread_mutex_lock(&thread_mutex);
+	if (thread_item_tail)
+		thread_item_tail->next = item;
+	else
+		thread_item_head = item;
+	thread_item_tail = item;
+	pthread_cond_signal(&thread_work_cond);
+	pthread_mutex_unlock(&thread_mutex);
+
+	return item;
+}
+
+void osd_work_item_wait(osd_work_item* item)
+{
+	pthread_mutex_lock(&thread_mutex);
+	while (!item->done)
+		pthread_cond_wait(&thread_done_cond, &thread_mutex);
+	pthread_mutex_unlock(&thread_mutex);
+
+	free(item);
+}
+
+osd_lock* osd_lock_alloc(void)
+{
+	osd_lock* lock = malloc(sizeof(osd_lock));
+
+	if (!lock)
+		return 0;
+
+	if (pthread_mutex_init(&lock->mutex, NULL) != 0) {
+		free(lock);
+		return 0;
+	}
+
+	return lock;
+}
+
+void osd_lock_acquire(osd_lock* lock)
+{
+	pthread_mutex_lock(&lock->mutex);
+}
+
+void osd_lock_release(osd_lock* lock)
+{
+	pthread_mutex_unlock(&lock->mutex);
+}
+
+void osd_lock_free(osd_lock* lock)
+{
+	pthread_mutex_destroy(&lock->mutex);
+	free(lock);
+}
@@ -41,6 +41,25 @@ int thread_init(void);
  */
 void thread_done(void);
 
+/**
+ * Start the pool of worker threads used by osd_parallelize().
+ * \param count Number of worker threads. If 0 it's computed from
+ * the number of processors, reserving one for the calling thread.
+ */
+int thread_pool_init(unsigned count);
+
+/**
+ * Stop the pool of worker threads.
+ * The busy time of every worker is reported in the log.
+ */
+void thread_pool_done(void);
+
+/**
+ * Return the max number of slices in which osd_parallelize() splits the work.
+ * It's the number of worker threads plus the calling thread.
+ */
+unsigned thread_pool_size(void);
+
 /**
  * Callback used to enable and disable the thread support at runtime.
  * This function is called every time a thread need to be started.
@@ -51,5 +70,61 @@ void thread_done(void);
  */
 int thread_is_active(void);
 
+/**
+ * Run a function splitting the work in slices.
+ * The function is called with num from 0 to max - 1, and max may be
+ * reduced at the number of slices really used.
+ * \param func Function to call.
+ * \param arg Argument of the function.
+ * \param max Max number of slices.
+ */
+void osd_parallelize(void (*func)(void* arg, int num, int max), void* arg, int max);
+
+/**
+ * Lock.
+ */
+typedef struct _osd_lock osd_lock;
+
+/**
+ * Allocate a lock.
+ * \return The lock, or 0 on error.
+ */
+osd_lock* osd_lock_alloc(void);
+
+/**
+ * Acquire a lock, waiting if it's owned by another thread.
+ */
+void osd_lock_acquire(osd_lock* lock);
+
+/**
+ * Release a lock.
+ */
+void osd_lock_release(osd_lock* lock);
+
+/**
+ * Free a lock.
+ */
+void osd_lock_free(osd_lock* lock);
+
+/**
+ * Asynchronous work item.
+ */
+typedef struct _osd_work_item osd_work_item;
+
+/**
+ * Run a function asynchronously in one of the worker threads.
+ * The slices of osd_parallelize() have the precedence over the work items.
+ * \param func Function to call.
+ * \param arg Argument of the function.
+ * \return The work item, or 0 if no worker thread is available. In
+ * such case the function is not called.
+ */
+osd_work_item* osd_work_item_queue(void (*func)(void* arg), void* arg);
+
+/**
+ * Wait the completion of a work item and free it.
+ */
+void osd_work_item_wait(osd_work_item* item);
+
 #endif
 
@@ -0,0 +1,372 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2006 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * In addition, as a special exception, Andrea Mazzoleni
+ * gives permission to link the code of this program with
+ * the MAME library (or with modified versions of MAME that use the
+ * same license as MAME), and distribute linked combinations including
+ * the two.  You must obey the GNU General Public License in all
+ * respects for all of the code used other than MAME.  If you modify
+ * this file, you may extend this exception to your version of the
+ * file, but you are not obligated to do so.  If you do not wish to
+ * do so, delete this exception statement from your version.
+ */
+
+
+#include "portable.h"
+
+#include "osdepend.h"
+#include "osd_tool.h"
+
+/** \file
+ * The OS dependent functions of the tools, like chdman.
+ *
+ * The files are accessed with the C stream functions, and the physical
+ * drives are not supported.
+ *
+ * With the thread support every osd_parallelize() call starts a thread
+ * for every slice except the first, and every work item runs in its own
+ * thread. The tools call them only for big blocks of work, like a batch of
+ * CHD hunks, so the cost of starting the threads isn't relevant, and no
+ * pool has to be started and stopped by the tools.
+ */
+
+#ifdef USE_SMP
+#include <pthread.h>
+#endif
+
+#ifdef __WIN32__
+#define fseeko fseeko64
+#define ftello ftello64
+#endif
+
+/** Max number of slices of osd_parallelize(). */
+#define TOOL_SLICE_MAX 64
+
+/***************************************************************************/
+/* Log */
+
+void CLIB_DECL logerror(const char* text, ...)
+{
+	/* the tools have no log file */
+	(void)text;
+}
+
+/***************************************************************************/
+/* Timer */
+
+cycles_t osd_cycles(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+
+	return (cycles_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+cycles_t osd_cycles_per_second(void)
+{
+	return 1000000;
+}
+
+/***************************************************************************/
+/* File */
+
+struct _osd_tool_file {
+	FILE* f; /**< Stream of the file. */
+};
+
+int osd_is_physical_drive(const char* filename)
+{
+	(void)filename;
+	return 0;
+}
+
+int osd_get_physical_drive_geometry(const char* filename, UINT32* cylinders, UINT32* heads, UINT32* sectors, UINT32* bps)
+{
+	(void)filename;
+	(void)cylinders;
+	(void)heads;
+	(void)sectors;
+	(void)bps;
+	return 0;
+}
+
+UINT64 osd_get_file_size(const char* filename)
+{
+	osd_tool_file* file;
+	UINT64 size;
+
+	file = osd_tool_fopen(filename, "rb");
+	if (!file)
+		return 0;
+
+	size = osd_tool_flength(file);
+
+	osd_tool_fclose(file);
+
+	return size;
+}
+
+osd_tool_file* osd_tool_fopen(const char* filename, const char* mode)
+{
+	osd_tool_file* file = malloc(sizeof(osd_tool_file));
+
+	if (!file)
+		return 0;
+
+	file->f = fopen(filename, mode);
+	if (!file->f) {
+		free(file);
+		return 0;
+	}
+
+	return file;
+}
+
+void osd_tool_fclose(osd_tool_file* file)
+{
+	fclose(file->f);
+	free(file);
+}
+
+UINT32 osd_tool_fread(osd_tool_file* file, UINT64 offset, UINT32 count, void* buffer)
+{
+	if (fseeko(file->f, offset, SEEK_SET) != 0)
+		return 0;
+
+	return fread(buffer, 1, count, file->f);
+}
+
+UINT32 osd_tool_fwrite(osd_tool_file* file, UINT64 offset, UINT32 count, const void* buffer)
+{
+	if (fseeko(file->f, offset, SEEK_SET) != 0)
+		return 0;
+
+	return fwrite(buffer, 1, count, file->f);
+}
+
+UINT64 osd_tool_flength(osd_tool_file* file)
+{
+	if (fseeko(file->f, 0, SEEK_END) != 0)
+		return 0;
+
+	return ftello(file->f);
+}
+
+/***************************************************************************/
+/* Thread */
+
+#ifdef USE_SMP
+
+/** Slice of work. */
+struct tool_slice {
+	pthread_t id; /**< ID of the thread. */
+	void (*func)(void*, int, int); /**< Function to call. */
+	void* arg; /**< Argument of the function. */
+	int num; /**< Index of the slice. */
+	int max; /**< Number of slices. */
+};
+
+/** Asynchronous work item. */
+struct _osd_work_item {
+	pthread_t id; /**< ID of the thread. */
+	void (*func)(void*); /**< Function to call. */
+	void* arg; /**< Argument of the function. */
+};
+
+/** Lock. */
+struct _osd_lock {
+	pthread_mutex_t mutex; /**< Mutex of the lock. */
+};
+
+/** Number of processors online. */
+static int tool_cpu(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	if (n >= 1)
+		return n;
+#endif
+	return 2;
+}
+
+static void* tool_slice_proc(void* arg)
+{
+	struct tool_slice* slice = arg;
+
+	slice->func(slice->arg, slice->num, slice->max);
+
+	return 0;
+}
+
+static void* tool_item_proc(void* arg)
+{
+	osd_work_item* item = arg;
+
+	item->func(item->arg);
+
+	return 0;
+}
+
+void osd_parallelize(void (*func)(void* arg, int num, int max), void* arg, int max)
+{
+	struct tool_slice slice[TOOL_SLICE_MAX];
+	int cpu = tool_cpu();
+	int i;
+
+	/* one slice for every processor */
+	if (max > cpu)
+		max = cpu;
+	if (max > TOOL_SLICE_MAX)
+		max = TOOL_SLICE_MAX;
+
+	if (max <= 1) {
+		func(arg, 0, 1);
+		return;
+	}
+
+	for (i = 1; i < max; ++i) {
+		slice[i].func = func;
+		slice[i].arg = arg;
+		slice[i].num = i;
+		slice[i].max = max;
+		if (pthread_create(&slice[i].id, NULL, tool_slice_proc, &slice[i]) != 0) {
+			/* without a thread the slice runs in the calling thread */
+			slice[i].func = 0;
+		}
+	}
+
+	/* call the primary slice */
+	func(arg, 0, max);
+
+	for (i = 1; i < max; ++i) {
+		if (slice[i].func)
+			pthread_join(slice[i].id, NULL);
+		else
+			func(arg, i, max);
+	}
+}
+
+osd_work_item* osd_work_item_queue(void (*func)(void* arg), void* arg)
+{
+	osd_work_item* item;
+
+	if (tool_cpu() <= 1)
+		return 0;
+
+	item = malloc(sizeof(osd_work_item));
+	if (!item)
+		return 0;
+
+	item->func = func;
+	item->arg = arg;
+
+	if (pthread_create(&item->id, NULL, tool_item_proc, item) != 0) {
+		free(item);
+		return 0;
+	}
+
+	return item;
+}
+
+void osd_work_item_wait(osd_work_item* item)
+{
+	pthread_join(item->id, NULL);
+
+	free(item);
+}
+
+osd_lock* osd_lock_alloc(void)
+{
+	osd_lock* lock = malloc(sizeof(osd_lock));
+
+	if (!lock)
+		return 0;
+
+	if (pthread_mutex_init(&lock->mutex, NULL) != 0) {
+		free(lock);
+		return 0;
+	}
+
+	return lock;
+}
+
+void osd_lock_acquire(osd_lock* lock)
+{
+	pthread_mutex_lock(&lock->mutex);
+}
+
+void osd_lock_release(osd_lock* lock)
+{
+	pthread_mutex_unlock(&lock->mutex);
+}
+
+void osd_lock_free(osd_lock* lock)
+{
+	pthread_mutex_destroy(&lock->mutex);
+	free(lock);
+}
+
+#else
+
+/** Dummy lock. */
+struct _osd_lock {
+	int dummy; /**< Unused. */
+};
+
+void osd_parallelize(void (*func)(void* arg, int num, int max), void* arg, int max)
+{
+	(void)max;
+	func(arg, 0, 1);
+}
+
+osd_work_item* osd_work_item_queue(void (*func)(void* arg), void* arg)
+{
+	(void)func;
+	(void)arg;
+	return 0;
+}
+
+void osd_work_item_wait(osd_work_item* item)
+{
+	(void)item;
+}
+
+osd_lock* osd_lock_alloc(void)
+{
+	return malloc(sizeof(osd_lock));
+}
+
+void osd_lock_acquire(osd_lock* lock)
+{
+	(void)lock;
+}
+
+void osd_lock_release(osd_lock* lock)
+{
+	(void)lock;
+}
+
+void osd_lock_free(osd_lock* lock)
+{
+	free(lock);
+}
+
+#endif
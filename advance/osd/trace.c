@@ -0,0 +1,367 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2018 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * In addition, as a special exception, Andrea Mazzoleni
+ * gives permission to link the code of this program with
+ * the MAME library (or with modified versions of MAME that use the
+ * same license as MAME), and distribute linked combinations including
+ * the two.  You must obey the GNU General Public License in all
+ * respects for all of the code used other than MAME.  If you modify
+ * this file, you may extend this exception to your version of the
+ * file, but you are not obligated to do so.  If you do not wish to
+ * do so, delete this exception statement from your version.
+ */
+
+#include "portable.h"
+
+#include "trace.h"
+#include "thread.h"
+
+#include "log.h"
+#include "target.h"
+#include "snstring.h"
+
+/** \file
+ * Trace of named scopes.
+ *
+ * Every thread records the scopes in its own ring buffer, without any
+ * locking. Only the first event of a thread takes the lock to register
+ * the new buffer. At the end all the buffers are saved in the Chrome
+ * trace JSON format, viewable with chrome://tracing or ui.perfetto.dev.
+ */
+
+#ifdef USE_SMP
+#include <pthread.h>
+#endif
+
+/** Max number of threads traced. */
+#define TRACE_THREAD_MAX 80
+
+/** Event of the trace. */
+struct trace_event {
+	const char* name; /**< Name of the scope. */
+	int arg; /**< Argument of the scope, or -1 if none. */
+	target_clock_t begin; /**< Start time. */
+	target_clock_t end; /**< Stop time. */
+};
+
+/** Scope not yet completed. */
+struct trace_scope {
+	const char* name; /**< Name of the scope. */
+	target_clock_t begin; /**< Start time. */
+};
+
+/** Trace of a thread. */
+struct trace_ring {
+	char name[32]; /**< Name of the thread. */
+	struct trace_event* map; /**< Ring buffer of events. */
+	unsigned pos; /**< Number of events recorded. */
+	struct trace_scope stack[TRACE_DEPTH_MAX]; /**< Scopes started. */
+	unsigned depth; /**< Number of scopes started, also over the max. */
+};
+
+/**
+ * If the trace is active.
+ * It's read by all the threads without locking, so it's changed only by
+ * trace_init() before starting the other threads, and by trace_done()
+ * after joining them. The thread creation and join order the change with
+ * the reads, and no thread can see it change while running.
+ */
+static int trace_active;
+static osd_lock* trace_lock; /**< Lock for the registration of the threads. */
+static struct trace_ring* trace_map[TRACE_THREAD_MAX]; /**< Traced threads. */
+static unsigned trace_max; /**< Number of traced threads. */
+static target_clock_t trace_start; /**< Start time of the trace. */
+static target_clock_t trace_frame_last; /**< Time of the last frame mark. */
+static int trace_frame_counter; /**< Number of frames. */
+
+#ifdef USE_SMP
+static pthread_key_t trace_key; /**< Trace of the current thread. */
+
+static struct trace_ring* trace_self(void)
+{
+	return pthread_getspecific(trace_key);
+}
+
+static void trace_self_set(struct trace_ring* ring)
+{
+	pthread_setspecific(trace_key, ring);
+}
+#else
+static struct trace_ring* trace_single;
+
+static struct trace_ring* trace_self(void)
+{
+	return trace_single;
+}
+
+static void trace_self_set(struct trace_ring* ring)
+{
+	trace_single = ring;
+}
+#endif
+
+/**
+ * Get the trace of the current thread, allocating it at the first use.
+ * \return The trace, or 0 if no more threads can be traced.
+ */
+static struct trace_ring* trace_get(void)
+{
+	struct trace_ring* ring = trace_self();
+
+	if (ring)
+		return ring;
+
+	ring = malloc(sizeof(struct trace_ring));
+	if (!ring)
+		return 0;
+	ring->map = malloc(TRACE_EVENT_MAX * sizeof(struct trace_event));
+	if (!ring->map) {
+		free(ring);
+		return 0;
+	}
+	ring->pos = 0;
+	ring->depth = 0;
+
+	osd_lock_acquire(trace_lock);
+	if (trace_max < TRACE_THREAD_MAX) {
+		snprintf(ring->name, sizeof(ring->name), "Thread %u", trace_max);
+		trace_map[trace_max++] = ring;
+	} else {
+		free(ring->map);
+		free(ring);
+		ring = 0;
+	}
+	osd_lock_release(trace_lock);
+
+	if (ring)
+		trace_self_set(ring);
+
+	return ring;
+}
+
+static void trace_push(struct trace_ring* ring, const char* name, int arg, target_clock_t begin, target_clock_t end)
+{
+	struct trace_event* event = &ring->map[ring->pos % TRACE_EVENT_MAX];
+
+	event->name = name;
+	event->arg = arg;
+	event->begin = begin;
+	event->end = end;
+
+	++ring->pos;
+}
+
+int trace_init(void)
+{
+	trace_max = 0;
+	trace_frame_counter = 0;
+
+	trace_lock = osd_lock_alloc();
+	if (!trace_lock)
+		return -1;
+
+#ifdef USE_SMP
+	if (pthread_key_create(&trace_key, 0) != 0) {
+		osd_lock_free(trace_lock);
+		return -1;
+	}
+#endif
+	trace_self_set(0);
+
+	trace_start = target_clock();
+	trace_frame_last = trace_start;
+	trace_active = 1;
+
+	trace_thread("Main");
+
+	log_std(("trace: start\n"));
+
+	return 0;
+}
+
+/** Save a string in JSON format. */
+static void trace_string(FILE* f, const char* s)
+{
+	fputc('"', f);
+	for (; *s; ++s) {
+		if (*s == '"' || *s == '\\')
+			fputc('\\', f);
+		fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+static int trace_save(const char* file)
+{
+	FILE* f;
+	unsigned i, j;
+	int first;
+	double scale;
+
+	f = fopen(file, "w");
+	if (!f)
+		return -1;
+
+	fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	/* the trace format wants the times in microseconds */
+	scale = 1000000.0 / TARGET_CLOCKS_PER_SEC;
+
+	first = 1;
+	for (i = 0; i < trace_max; ++i) {
+		struct trace_ring* ring = trace_map[i];
+		unsigned count;
+		unsigned start;
+
+		if (!first)
+			fprintf(f, ",\n");
+		first = 0;
+		fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", i);
+		trace_string(f, ring->name);
+		fprintf(f, "}}");
+
+		/* only the most recent events are still in the ring */
+		if (ring->pos > TRACE_EVENT_MAX) {
+			count = TRACE_EVENT_MAX;
+			start = ring->pos - TRACE_EVENT_MAX;
+			log_std(("WARNING:trace: %s lost %u events\n", ring->name, start));
+		} else {
+			count = ring->pos;
+			start = 0;
+		}
+
+		for (j = 0; j < count; ++j) {
+			struct trace_event* event = &ring->map[(start + j) % TRACE_EVENT_MAX];
+
+			fprintf(f, ",\n{\"name\":");
+			trace_string(f, event->name);
+			fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f", i, (event->begin - trace_start) * scale, (event->end - event->begin) * scale);
+			if (event->arg >= 0)
+				fprintf(f, ",\"args\":{\"n\":%d}", event->arg);
+			fprintf(f, "}");
+		}
+	}
+
+	fprintf(f, "\n]}\n");
+
+	if (fclose(f) != 0)
+		return -1;
+
+	return 0;
+}
+
+void trace_done(const char* file)
+{
+	unsigned i;
+
+	if (!trace_active)
+		return;
+
+	trace_active = 0;
+
+	log_std(("trace: save %s\n", file));
+
+	if (trace_save(file) != 0) {
+		log_std(("ERROR:trace: error saving %s\n", file));
+	}
+
+	for (i = 0; i < trace_max; ++i) {
+		free(trace_map[i]->map);
+		free(trace_map[i]);
+	}
+	trace_max = 0;
+
+#ifdef USE_SMP
+	pthread_key_delete(trace_key);
+#endif
+	trace_self_set(0);
+
+	osd_lock_free(trace_lock);
+}
+
+void trace_thread(const char* name)
+{
+	struct trace_ring* ring;
+
+	if (!trace_active)
+		return;
+
+	ring = trace_get();
+	if (!ring)
+		return;
+
+	sncpy(ring->name, sizeof(ring->name), name);
+}
+
+void trace_frame(void)
+{
+	struct trace_ring* ring;
+	target_clock_t now;
+
+	if (!trace_active)
+		return;
+
+	ring = trace_get();
+	if (!ring)
+		return;
+
+	now = target_clock();
+
+	trace_push(ring, "Frame", trace_frame_counter, trace_frame_last, now);
+
+	trace_frame_last = now;
+	++trace_frame_counter;
+}
+
+void osd_trace_begin(const char* name)
+{
+	struct trace_ring* ring;
+
+	if (!trace_active)
+		return;
+
+	ring = trace_get();
+	if (!ring)
+		return;
+
+	if (ring->depth < TRACE_DEPTH_MAX) {
+		ring->stack[ring->depth].name = name;
+		ring->stack[ring->depth].begin = target_clock();
+	}
+
+	++ring->depth;
+}
+
+void osd_trace_end(void)
+{
+	struct trace_ring* ring;
+
+	if (!trace_active)
+		return;
+
+	ring = trace_self();
+	if (!ring || ring->depth == 0)
+		return;
+
+	--ring->depth;
+
+	if (ring->depth < TRACE_DEPTH_MAX)
+		trace_push(ring, ring->stack[ring->depth].name, -1, ring->stack[ring->depth].begin, target_clock());
+}
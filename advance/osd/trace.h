@@ -0,0 +1,82 @@
+/*
+ * This file is part of the Advance project.
+ *
+ * Copyright (C) 2018 Andrea Mazzoleni
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ * In addition, as a special exception, Andrea Mazzoleni
+ * gives permission to link the code of this program with
+ * the MAME library (or with modified versions of MAME that use the
+ * same license as MAME), and distribute linked combinations including
+ * the two.  You must obey the GNU General Public License in all
+ * respects for all of the code used other than MAME.  If you modify
+ * this file, you may extend this exception to your version of the
+ * file, but you are not obligated to do so.  If you do not wish to
+ * do so, delete this exception statement from your version.
+ */
+
+#ifndef __TRACE_H
+#define __TRACE_H
+
+/**
+ * Max number of events kept for every thread.
+ * When the limit is reached the oldest events are overwritten.
+ */
+#define TRACE_EVENT_MAX (128 * 1024)
+
+/**
+ * Max nesting of the scopes.
+ */
+#define TRACE_DEPTH_MAX 32
+
+/**
+ * Start the trace.
+ * It must be called by the main thread before starting any other thread.
+ * \return 0 on success.
+ */
+int trace_init(void);
+
+/**
+ * Stop the trace and save it.
+ * It must be called after all the other threads are terminated.
+ * \param file File where to save the trace in the Chrome trace JSON format.
+ */
+void trace_done(const char* file);
+
+/**
+ * Set the name of the current thread in the trace.
+ */
+void trace_thread(const char* name);
+
+/**
+ * Mark the start of a new frame.
+ * The time elapsed from the previous mark is recorded as a "Frame" scope.
+ */
+void trace_frame(void);
+
+/**
+ * Start a named scope in the trace of the current thread.
+ * The scopes can be nested. If the trace is not active, nothing is done.
+ * \param name Name of the scope. It must be a static string.
+ */
+void osd_trace_begin(const char* name);
+
+/**
+ * End the last scope started by the current thread.
+ */
+void osd_trace_end(void);
+
+#endif
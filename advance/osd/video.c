@@ -549,7 +549,9 @@ static void video_frame_update_now(struct advance_video_context* context, struct
 	target_yield();
 
 	/* the frame syncronization is out of the time estimation */
+	osd_trace_begin("Sync");
 	advance_video_sync(context, sound_context, estimate_context, skip_flag);
+	osd_trace_end();
 
 	/* start updating */
 	video_frame_start(context);
@@ -558,16 +560,22 @@ static void video_frame_update_now(struct advance_video_context* context, struct
 	advance_estimate_osd_begin(estimate_context);
 
 	/* update the video for the new frame */
+	osd_trace_begin("OSD video");
 	advance_video_frame(context, record_context, ui_context, game, debug, debug_palette, debug_palette_size, skip_flag);
+	osd_trace_end();
 
 	/* update the audio buffer for the new frame */
+	osd_trace_begin("OSD sound");
 	advance_sound_frame(sound_context, record_context, context, safequit_context, sample_buffer, sample_count, sample_recount, context->config.rawsound_flag || video_is_normal_speed(context));
+	osd_trace_end();
 
 	/* estimate the time */
 	advance_estimate_osd_end(estimate_context, skip_flag);
 
 	/* stop updating, this may include a vsync and it's out of the time estimation */
+	osd_trace_begin("Vsync");
 	video_frame_stop(context);
+	osd_trace_end();
 }
 
 /**
@@ -576,6 +584,8 @@ static void video_frame_update_now(struct advance_video_context* context, struct
 void advance_video_thread_wait(struct advance_video_context* context)
 {
 #ifdef USE_SMP
+	osd_trace_begin("Video wait");
+
 	/* wait until the thread is ready */
 	pthread_mutex_lock(&context->state.thread_video_mutex);
 
@@ -585,6 +595,8 @@ void advance_video_thread_wait(struct advance_video_context* context)
 	}
 
 	pthread_mutex_unlock(&context->state.thread_video_mutex);
+
+	osd_trace_end();
 #else
 	/* nothing */
 #endif
@@ -735,6 +747,8 @@ static void* video_thread(void* void_context)
 
 	log_std(("advance:thread: start\n"));
 
+	trace_thread("Video");
+
 	pthread_mutex_lock(&context->state.thread_video_mutex);
 
 	while (1) {
@@ -1278,6 +1292,9 @@ int osd2_frame(const struct osd_bitmap* game, const struct osd_bitmap* debug, co
 
 	adv_bool normal_speed = video_is_normal_speed(&CONTEXT.video);
 
+	/* mark the start of the new frame in the trace */
+	trace_frame();
+
 	/* store the current audio video syncronization error measured in sound samples */
 	context->state.av_sync_map[context->state.av_sync_mac] = context->state.latency_diff;
 
@@ -1525,6 +1542,7 @@ adv_error advance_video_init(struct advance_video_context* context, adv_conf* cf
 	conf_float_register_limit_default(cfg_context, "sync_turbospeed", 0.1, 30.0, 3.0);
 	conf_bool_register_default(cfg_context, "debug_crash", 0);
 	conf_bool_register_default(cfg_context, "debug_rawsound", 0);
+	conf_string_register_default(cfg_context, "debug_trace", "none");
 	conf_string_register_default(cfg_context, "sync_startuptime", "auto");
 	conf_int_register_limit_default(cfg_context, "misc_timetorun", 0, 3600, 0);
 	conf_string_register_default(cfg_context, "display_mode", "auto");
@@ -1536,6 +1554,8 @@ adv_error advance_video_init(struct advance_video_context* context, adv_conf* cf
 #ifdef USE_SMP
 	/* SMP always enabled by default */
 	conf_bool_register_default(cfg_context, "misc_smp", 1);
+	conf_string_register_default(cfg_context, "misc_smpthread", "auto");
+	conf_bool_register_default(cfg_context, "misc_smpband", 1);
 #endif
 
 	conf_int_register_enum_default(cfg_context, "sync_resample", conf_enum(OPTION_RESAMPLE), -1);
@@ -1843,6 +1863,7 @@ adv_error advance_video_config_load(struct advance_video_context* context, adv_c
 	context->config.measure_time = conf_int_get_default(cfg_context, "misc_timetorun");
 	context->config.crash_flag = conf_bool_get_default(cfg_context, "debug_crash");
 	context->config.rawsound_flag = conf_bool_get_default(cfg_context, "debug_rawsound");
+	sncpy(context->config.trace_buffer, sizeof(context->config.trace_buffer), conf_string_get_default(cfg_context, "debug_trace"));
 
 	s = conf_string_get_default(cfg_context, "display_mode");
 	sncpy(context->config.resolution_buffer, sizeof(context->config.resolution_buffer), s);
@@ -1868,8 +1889,22 @@ adv_error advance_video_config_load(struct advance_video_context* context, adv_c
 
 #ifdef USE_SMP
 	context->config.smp_flag = conf_bool_get_default(cfg_context, "misc_smp");
+	s = conf_string_get_default(cfg_context, "misc_smpthread");
+	if (strcmp(s, "auto") == 0) {
+		context->config.smp_thread = 0;
+	} else {
+		char* e;
+		context->config.smp_thread = strtol(s, &e, 10);
+		if (context->config.smp_thread < 1 || context->config.smp_thread > 64 || *e) {
+			target_err("Invalid argument '%s' for option 'misc_smpthread'.\n", s);
+			return -1;
+		}
+	}
+	context->config.smp_band_flag = conf_bool_get_default(cfg_context, "misc_smpband");
 #else
 	context->config.smp_flag = 0;
+	context->config.smp_thread = 0;
+	context->config.smp_band_flag = 0;
 #endif
 
 	i = conf_int_get_default(cfg_context, "sync_resample");
@@ -1965,6 +2000,24 @@ adv_error advance_video_inner_init(struct advance_video_context* context, struct
 		return -1;
 	}
 
+	/* the trace must start before the worker threads */
+	if (strcmp(context->config.trace_buffer, "none") != 0) {
+		if (trace_init() != 0) {
+			video_blit_done();
+			adv_video_done();
+			target_err("Error initializing the trace.\n");
+			return -1;
+		}
+	}
+
+	if (thread_pool_init(context->config.smp_thread) != 0) {
+		trace_done(context->config.trace_buffer);
+		video_blit_done();
+		adv_video_done();
+		target_err("Error initializing the thread pool.\n");
+		return -1;
+	}
+
 	advance_video_mode_preinit(context, option);
 
 	return 0;
@@ -1972,6 +2025,8 @@ adv_error advance_video_inner_init(struct advance_video_context* context, struct
 
 void advance_video_inner_done(struct advance_video_context* context)
 {
+	thread_pool_done();
+	trace_done(context->config.trace_buffer);
 	video_blit_done();
 	adv_video_done();
 }
@@ -38,6 +38,7 @@
 #include "log.h"
 #include "endianrw.h"
 #include "error.h"
+#include "ring.h"
 
 #include "ossdl.h"
 
@@ -62,11 +63,11 @@ struct soundb_sdl_context {
 
 	SDL_AudioSpec info;
 
-	unsigned fifo_pos;
-	unsigned fifo_mac;
-	adv_sample fifo_map[FIFO_MAX];
+	adv_ring ring; /**< Lock free ring between soundb_sdl_play() and the SDL callback. */
 
-	adv_bool underflow_flag;
+	adv_bool playing_flag; /**< If the callback is playing the samples. */
+	unsigned underrun; /**< Number of underruns. Changed only by the callback. */
+	unsigned underrun_last; /**< Number of underruns already reported. */
 
 	int volume; /**< Volume adjustement. SDL_VOLUME_BASE == full volume. */
 };
@@ -90,17 +91,37 @@ static void soundb_sdl_callback(void *userdata, Uint8 *stream, int len)
 	samples_buffer = stream;
 
 	while (samples_count) {
-		if (state->fifo_mac) {
-			le_uint16_write(samples_buffer, state->fifo_map[state->fifo_pos]);
-			state->fifo_pos = (state->fifo_pos + 1) % FIFO_MAX;
-			--state->fifo_mac;
-		} else {
-			le_uint16_write(samples_buffer, state->info.silence);
-			state->underflow_flag = 1; /* signal the underflow */
+		adv_sample buf[256];
+		unsigned run = samples_count;
+		unsigned count;
+		unsigned i;
+
+		if (run > 256)
+			run = 256;
+
+		count = ring_read(&state->ring, buf, run);
+
+		for (i = 0; i < count; ++i) {
+			le_uint16_write(samples_buffer, buf[i]);
+			samples_buffer += 2;
 		}
 
-		samples_buffer += 2;
-		--samples_count;
+		samples_count -= count;
+
+		if (count < run)
+			break;
+	}
+
+	if (samples_count) {
+		/* signal the underflow */
+		if (state->playing_flag)
+			++state->underrun;
+
+		while (samples_count) {
+			le_uint16_write(samples_buffer, state->info.silence);
+			samples_buffer += 2;
+			--samples_count;
+		}
 	}
 }
 
@@ -120,14 +141,19 @@ adv_error soundb_sdl_init(int sound_id, unsigned* rate, adv_bool stereo_flag, do
 
 	log_std(("sound:sdl device_sdl_samples %u\n", sdl_option.samples));
 
-	sdl_state.underflow_flag = 0;
-	sdl_state.fifo_pos = 0;
-	sdl_state.fifo_mac = 0;
+	sdl_state.playing_flag = 0;
+	sdl_state.underrun = 0;
+	sdl_state.underrun_last = 0;
 	sdl_state.volume = SDL_VOLUME_BASE;
 
+	if (ring_init(&sdl_state.ring, FIFO_MAX) != 0) {
+		error_set("Low memory.\n");
+		goto err;
+	}
+
 	if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0) {
 		error_set("Function SDL_InitSubSystem(SDL_INIT_AUDIO) failed, %s.\n", SDL_GetError());
-		goto err;
+		goto err_ring;
 	}
 
 #if SDL_MAJOR_VERSION == 1
@@ -160,6 +186,8 @@ adv_error soundb_sdl_init(int sound_id, unsigned* rate, adv_bool stereo_flag, do
 
 err_quit:
 	SDL_QuitSubSystem(SDL_INIT_AUDIO);
+err_ring:
+	ring_done(&sdl_state.ring);
 err:
 	return -1;
 }
@@ -172,6 +200,7 @@ void soundb_sdl_done(void)
 		sdl_state.active_flag = 0;
 		SDL_CloseAudio();
 		SDL_QuitSubSystem(SDL_INIT_AUDIO);
+		ring_done(&sdl_state.ring);
 	}
 }
 
@@ -180,11 +209,13 @@ void soundb_sdl_stop(void)
 	log_std(("sound:sdl: soundb_sdl_stop()\n"));
 
 	SDL_PauseAudio(1);
+
+	sdl_state.playing_flag = 0;
 }
 
 unsigned soundb_sdl_buffered(void)
 {
-	return sdl_state.fifo_mac / sdl_state.info.channels;
+	return ring_count(&sdl_state.ring) / sdl_state.info.channels;
 }
 
 void soundb_sdl_volume(double volume)
@@ -200,46 +231,22 @@ void soundb_sdl_volume(double volume)
 
 void soundb_sdl_play(const adv_sample* sample_map, unsigned sample_count)
 {
-	unsigned i;
 	unsigned count = sample_count * sdl_state.info.channels;
+	unsigned written;
 
-	SDL_LockAudio();
-
-	log_debug(("sound:sdl: soundb_sdl_play(count:%d), stored %d\n", sample_count, sdl_state.fifo_mac / sdl_state.info.channels));
+	log_debug(("sound:sdl: soundb_sdl_play(count:%d), stored %d\n", sample_count, ring_count(&sdl_state.ring) / sdl_state.info.channels));
 
-	if (sdl_state.underflow_flag) {
-		sdl_state.underflow_flag = 0;
+	if (sdl_state.underrun != sdl_state.underrun_last) {
+		sdl_state.underrun_last = sdl_state.underrun;
 		log_std(("ERROR: sound buffer fifo underflow\n"));
 	}
 
-	if (sdl_state.fifo_mac + count > FIFO_MAX) {
-		sdl_state.fifo_mac = 0;
-		sdl_state.fifo_pos = 0;
-		log_std(("ERROR: sound buffer fifo overflow, reset the buffer\n"));
-	}
-
-	i = (sdl_state.fifo_pos + sdl_state.fifo_mac) % FIFO_MAX;
-	sdl_state.fifo_mac += count;
+	/* the ring is lock free, the SDL audio lock isn't needed */
+	written = ring_write(&sdl_state.ring, sample_map, count, sdl_state.volume);
 
-	if (sdl_state.volume == SDL_VOLUME_BASE) {
-		while (count) {
-			sdl_state.fifo_map[i] = *sample_map;
-			i = (i + 1) % FIFO_MAX;
-			--count;
-			++sample_map;
-		}
-	} else {
-		while (count) {
-			sdl_state.fifo_map[i] = (int)*sample_map * sdl_state.volume / SDL_VOLUME_BASE;
-			i = (i + 1) % FIFO_MAX;
-			--count;
-			++sample_map;
-		}
+	if (written < count) {
+		log_std(("ERROR: sound buffer fifo overflow, %d samples discarded\n", (count - written) / sdl_state.info.channels));
 	}
-
-	log_debug(("sound:sdl: soundb_sdl_play() return stored %d\n", sdl_state.fifo_mac / sdl_state.info.channels));
-
-	SDL_UnlockAudio();
 }
 
 adv_error soundb_sdl_start(double silence_time)
@@ -265,14 +272,21 @@ adv_error soundb_sdl_start(double silence_time)
 		soundb_sdl_play(buf, run / sdl_state.info.channels);
 	}
 
+	sdl_state.playing_flag = 1;
+
 	SDL_PauseAudio(0);
 
 	return 0;
 }
 
+unsigned soundb_sdl_underrun(void)
+{
+	return sdl_state.underrun;
+}
+
 unsigned soundb_sdl_flags(void)
 {
-	return SOUND_DRIVER_FLAGS_VOLUME_SAMPLE;
+	return SOUND_DRIVER_FLAGS_VOLUME_SAMPLE | SOUND_DRIVER_FLAGS_NOBLOCK;
 }
 
 static adv_conf_enum_int OPTION[] = {
@@ -338,6 +352,7 @@ soundb_driver soundb_sdl_driver = {
 	soundb_sdl_buffered,
 	soundb_sdl_start,
 	soundb_sdl_stop,
-	soundb_sdl_volume
+	soundb_sdl_volume,
+	soundb_sdl_underrun
 };
 
@@ -8,6 +8,8 @@
 ***************************************************************************/
 
 #include "chd.h"
+#include "osdepend.h"
+#include "mame.h"
 #include "md5.h"
 #include "sha1.h"
 #include <zlib.h>
@@ -36,6 +38,12 @@
 #define OLD_MAP_ENTRY_SIZE			8			/* V1-V2 */
 #define METADATA_HEADER_SIZE		16			/* metadata header size */
 #define CRCMAP_HASH_SIZE			4095		/* number of CRC hashtable entries */
+#define CACHE_HASH_SIZE				1024		/* number of hunk cache hashtable entries */
+#define CACHE_DEFAULT_BYTES			(4*1024*1024) /* default hunk cache size of a parent/child chain */
+#define CACHE_DEFAULT_READAHEAD		8			/* default number of hunks to read ahead */
+#define BATCH_HUNKS					64			/* hunks compressed or verified together */
+#define BATCH_THREAD_MAX			64			/* max number of parallel slices of a batch */
+#define BATCH_INFLATE				(-1)		/* hunk read, but still to decompress */
 
 #define MAP_ENTRY_FLAG_TYPE_MASK	0x000f		/* what type of hunk */
 #define MAP_ENTRY_FLAG_NO_CRC		0x0010		/* no CRC is present */
@@ -103,6 +111,81 @@ struct _metadata_entry
 typedef struct _metadata_entry metadata_entry;
 
 
+struct _cache_entry
+{
+	struct _cache_entry *	prev;			/* previous entry in the LRU list, more recently used */
+	struct _cache_entry *	next;			/* next entry in the LRU list, less recently used */
+	struct _cache_entry *	hashnext;		/* next entry in the same hashtable bucket */
+	struct _chd_file *		chd;			/* file of the hunk */
+	UINT32					hunknum;		/* hunk number */
+	UINT32					bytes;			/* size of the data */
+	int						readahead;		/* loaded by the read-ahead and not yet used */
+	UINT8 *					data;			/* decompressed data */
+};
+typedef struct _cache_entry cache_entry;
+
+
+struct _hunk_cache
+{
+	osd_lock *				lock;			/* lock of the entries and of the read-ahead state */
+	osd_lock *				iolock;			/* lock of the reads and of the decompression of the files */
+	UINT32					refcount;		/* number of files using the cache */
+
+	cache_entry *			head;			/* most recently used entry */
+	cache_entry *			tail;			/* least recently used entry */
+	cache_entry *			hash[CACHE_HASH_SIZE]; /* hashtable of the entries */
+	UINT64					bytes;			/* bytes used by the entries */
+	UINT64					maxbytes;		/* max bytes used by the entries */
+	UINT32					readahead;		/* max number of hunks to read ahead */
+
+	osd_work_item *			raitem;			/* read-ahead work item, or NULL */
+	int						rabusy;			/* read-ahead running */
+	int						racancel;		/* read-ahead cancel request */
+	int						iowait;			/* reads on request waiting the file access */
+	struct _chd_file *		rachd;			/* file of the read-ahead */
+	UINT32					rastart;		/* first hunk of the read-ahead */
+	UINT32					ranext;			/* next hunk to read ahead */
+	UINT32					raend;			/* end of the hunks to read ahead */
+
+	UINT32					hits;			/* hunks found in the cache */
+	UINT32					misses;			/* hunks decompressed on request */
+	UINT32					raloads;		/* hunks decompressed by the read-ahead */
+	UINT32					rahits;			/* hunks of the read-ahead used */
+};
+typedef struct _hunk_cache hunk_cache;
+
+
+struct _hunk_batch
+{
+	UINT32					first;			/* first hunk of the batch */
+	UINT32					count;			/* number of hunks of the batch */
+	UINT8 *					data;			/* raw data of the hunks */
+	UINT8 *					compressed;		/* compressed data of the hunks */
+	UINT32					crc[BATCH_HUNKS]; /* CRC of the raw data */
+	UINT32					length[BATCH_HUNKS]; /* length of the compressed data, 0 if not compressed */
+	int						err[BATCH_HUNKS]; /* result of the read */
+	UINT32					hashbytes;		/* bytes of the raw data to add to the MD5/SHA1 */
+};
+typedef struct _hunk_batch hunk_batch;
+
+
+struct _batch_state
+{
+	struct _chd_file *		chd;			/* file compressed or verified */
+	int						compress;		/* compressing or verifying */
+	int						err;			/* error of the slices */
+	hunk_batch				batch[2];		/* one batch is processed while the previous is hashed */
+	hunk_batch *			cur;			/* batch processed by the slices */
+	z_stream				stream[BATCH_THREAD_MAX]; /* zlib stream of every slice */
+	UINT8					streamvalid[BATCH_THREAD_MAX]; /* zlib stream initialized */
+	struct MD5Context		md5;			/* MD5 of the raw data */
+	struct sha1_ctx			sha;			/* SHA1 of the raw data */
+	hunk_batch *			hashbatch;		/* batch being hashed */
+	osd_work_item *			hashitem;		/* work item of the hash, or NULL */
+};
+typedef struct _batch_state batch_state;
+
+
 struct _chd_file
 {
 	UINT32					cookie;			/* cookie, should equal COOKIE_VALUE */
@@ -115,9 +198,12 @@ struct _chd_file
 
 	map_entry *				map;			/* array of map entries */
 
-	UINT8 *					cache;			/* hunk cache pointer */
+	UINT8 *					cache;			/* hunk buffer for compress and verify */
 	UINT32					cachehunk;		/* index of currently cached hunk */
 
+	hunk_cache *			hcache;			/* hunk cache shared with the parent/child chain */
+	UINT32					lasthunk;		/* last hunk read, to detect sequential access */
+
 	UINT8 *					compare;		/* hunk compare pointer */
 	UINT32					comparehunk;	/* index of current compare data */
 
@@ -162,6 +248,11 @@ static chd_interface cur_interface;
 static chd_file *first_file;
 static int last_error;
 
+static UINT32 cache_bytes = CACHE_DEFAULT_BYTES;
+static UINT32 cache_readahead = CACHE_DEFAULT_READAHEAD;
+
+static UINT32 batch_threads = BATCH_THREAD_MAX;
+
 static const UINT8 nullmd5[CHD_MD5_BYTES] = { 0 };
 static const UINT8 nullsha1[CHD_SHA1_BYTES] = { 0 };
 
@@ -177,6 +268,7 @@ static int validate_header(const chd_header *header);
 static int read_hunk_into_memory(chd_file *chd, UINT32 hunknum, UINT8 *dest);
 static int read_hunk_into_cache(chd_file *chd, UINT32 hunknum);
 static int write_hunk_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *src);
+static int write_hunk_prepared(chd_file *chd, UINT32 hunknum, const UINT8 *src, UINT32 crc, const UINT8 *compressed, UINT32 complength);
 static int read_header(chd_interface_file *file, chd_header *header);
 static int write_header(chd_interface_file *file, const chd_header *header);
 static int read_hunk_map(chd_file *chd);
@@ -185,6 +277,21 @@ static void add_to_crcmap(chd_file *chd, UINT32 hunknum);
 static UINT32 find_matching_hunk(chd_file *chd, UINT32 hunknum, UINT32 crc, const UINT8 *rawdata);
 static int find_metadata_entry(chd_file *chd, UINT32 metatag, UINT32 metaindex, metadata_entry *metaentry);
 
+static int cache_attach(chd_file *chd);
+static void cache_detach(chd_file *chd);
+static void cache_sync(chd_file *chd);
+static cache_entry *cache_find(hunk_cache *cache, chd_file *chd, UINT32 hunknum);
+static cache_entry *cache_load(chd_file *chd, UINT32 hunknum, int *err);
+static cache_entry *cache_insert(hunk_cache *cache, cache_entry *entry);
+static void cache_invalidate(chd_file *chd, UINT32 hunknum);
+static void cache_readahead_start(chd_file *chd, UINT32 hunknum);
+
+static batch_state *batch_alloc(chd_file *chd, int compress);
+static void batch_free(batch_state *state);
+static void batch_run(batch_state *state, hunk_batch *batch);
+static void batch_hash(batch_state *state, hunk_batch *batch);
+static void batch_hash_wait(batch_state *state);
+
 static int init_codec(chd_file *chd);
 static void free_codec(chd_file *chd);
 
@@ -310,6 +417,35 @@ void chd_save_interface(chd_interface *interface_save)
 
 
 
+/*************************************
+ *
+ *  Hunk cache setup
+ *
+ *************************************/
+
+void chd_set_cache(UINT32 cachebytes, UINT32 readahead)
+{
+	cache_bytes = cachebytes;
+	cache_readahead = readahead;
+}
+
+
+
+/*************************************
+ *
+ *  Compress/verify threads setup
+ *
+ *************************************/
+
+void chd_set_threads(UINT32 threads)
+{
+	if (threads == 0 || threads > BATCH_THREAD_MAX)
+		threads = BATCH_THREAD_MAX;
+	batch_threads = threads;
+}
+
+
+
 /*************************************
  *
  *  Create a new data file
@@ -573,6 +709,7 @@ chd_file *chd_open(const char *filename, int writeable, chd_file *parent)
 		SET_ERROR_AND_CLEANUP(CHDERR_OUT_OF_MEMORY);
 	chd.cachehunk = ~0;
 	chd.comparehunk = ~0;
+	chd.lasthunk = ~0;
 
 	/* allocate the temporary compressed buffer */
 	chd.compressed = malloc(chd.header.hunkbytes);
@@ -590,6 +727,14 @@ chd_file *chd_open(const char *filename, int writeable, chd_file *parent)
 		SET_ERROR_AND_CLEANUP(CHDERR_OUT_OF_MEMORY);
 	*finalchd = chd;
 
+	/* join the hunk cache of the parent, or create a new one */
+	err = cache_attach(finalchd);
+	if (err != CHDERR_NONE)
+	{
+		free(finalchd);
+		SET_ERROR_AND_CLEANUP(err);
+	}
+
 	/* hook us into the global list */
 	finalchd->cookie = COOKIE_VALUE;
 	finalchd->next = first_file;
@@ -630,6 +775,9 @@ void chd_close(chd_file *chd)
 	if (!chd || chd->cookie != COOKIE_VALUE)
 		return;
 
+	/* stop the read-ahead and drop our hunks from the cache */
+	cache_detach(chd);
+
 	/* deinit the codec */
 	if (chd->codecdata)
 		free_codec(chd);
@@ -702,6 +850,9 @@ UINT32 chd_get_metadata(chd_file *chd, UINT32 *metatag, UINT32 metaindex, void *
 	metadata_entry metaentry;
 	UINT32 count;
 
+	/* the read-ahead uses the same file */
+	cache_sync(chd);
+
 	/* if we didn't find it, just return */
 	last_error = find_metadata_entry(chd, *metatag, metaindex, &metaentry);
 	if (last_error != CHDERR_NONE)
@@ -767,6 +918,9 @@ int chd_set_metadata(chd_file *chd, UINT32 metatag, UINT32 metaindex, const void
 	if (inputlen < 1 || inputlen > CHD_MAX_METADATA_SIZE)
 		return CHDERR_INVALID_METADATA_SIZE;
 
+	/* the read-ahead uses the same file */
+	cache_sync(chd);
+
 	/* if the entry fits within the previous entry, just overwrite it */
 	last_error = (metaindex != CHD_METAINDEX_APPEND) ? find_metadata_entry(chd, metatag, metaindex, &metaentry) : CHDERR_METADATA_NOT_FOUND;
 	if (last_error == CHDERR_NONE && inputlen <= metaentry.length)
@@ -854,6 +1008,8 @@ int chd_set_metadata(chd_file *chd, UINT32 metatag, UINT32 metaindex, const void
 
 UINT32 chd_read(chd_file *chd, UINT32 hunknum, UINT32 hunkcount, void *buffer)
 {
+	hunk_cache *cache;
+	cache_entry *entry;
 	int err;
 
 	last_error = CHDERR_NONE;
@@ -880,15 +1036,45 @@ UINT32 chd_read(chd_file *chd, UINT32 hunknum, UINT32 hunkcount, void *buffer)
 		chd->maxhunk = hunknum;
 
 	/* if the hunk is not cached, load and decompress it */
-	if (chd->cachehunk != hunknum)
+	cache = chd->hcache;
+	osd_lock_acquire(cache->lock);
+	entry = cache_find(cache, chd, hunknum);
+	if (entry)
 	{
-		err = read_hunk_into_cache(chd, hunknum);
-		if (err != CHDERR_NONE)
+		cache->hits++;
+		if (entry->readahead)
+		{
+			cache->rahits++;
+			entry->readahead = 0;
+		}
+	}
+	else
+	{
+		cache->misses++;
+
+		/* don't hold the cache while decompressing */
+		cache->iowait++;
+		osd_lock_release(cache->lock);
+		entry = cache_load(chd, hunknum, &err);
+		osd_lock_acquire(cache->lock);
+		cache->iowait--;
+		if (!entry)
+		{
+			osd_lock_release(cache->lock);
 			SET_ERROR_AND_CLEANUP(err);
+		}
+		entry = cache_insert(cache, entry);
 	}
 
 	/* now copy the data from the cache */
-	memcpy(buffer, chd->cache, chd->header.hunkbytes);
+	memcpy(buffer, entry->data, chd->header.hunkbytes);
+
+	/* on sequential access decompress the next hunks in background */
+	if (hunknum == chd->lasthunk + 1)
+		cache_readahead_start(chd, hunknum + 1);
+	chd->lasthunk = hunknum;
+
+	osd_lock_release(cache->lock);
 	return 1;
 
 cleanup:
@@ -930,6 +1116,9 @@ UINT32 chd_write(chd_file *chd, UINT32 hunknum, UINT32 hunkcount, const void *bu
 	if (hunknum > chd->maxhunk)
 		chd->maxhunk = hunknum;
 
+	/* the read-ahead uses the same file and buffers */
+	cache_sync(chd);
+
 	/* then write out the hunk */
 	err = write_hunk_from_memory(chd, hunknum, buffer);
 	if (err != CHDERR_NONE)
@@ -1052,11 +1241,10 @@ cleanup:
 int chd_compress(chd_file *chd, const char *rawfile, UINT32 offset, void (*progress)(const char *, ...))
 {
 	chd_interface_file *sourcefile = NULL;
+	batch_state *state = NULL;
 	UINT64 sourceoffset = 0;
-	struct MD5Context md5;
-	struct sha1_ctx sha;
 	clock_t lastupdate;
-	int err, hunknum;
+	int err, hunknum, i;
 
 	/* punt if no interface */
 	if (!cur_interface.open)
@@ -1066,11 +1254,19 @@ int chd_compress(chd_file *chd, const char *rawfile, UINT32 offset, void (*progr
 	if (!chd || !rawfile)
 		SET_ERROR_AND_CLEANUP(CHDERR_INVALID_PARAMETER);
 
+	/* the read-ahead uses the same file and buffers */
+	cache_sync(chd);
+
 	/* open the raw file */
 	sourcefile = multi_open(rawfile, "rb");
 	if (!sourcefile)
 		SET_ERROR_AND_CLEANUP(CHDERR_FILE_NOT_FOUND);
 
+	/* allocate the batches, and init the MD5/SHA1 computations */
+	state = batch_alloc(chd, 1);
+	if (!state)
+		SET_ERROR_AND_CLEANUP(CHDERR_OUT_OF_MEMORY);
+
 	/* mark the CHD writeable and write the updated header */
 	chd->header.flags |= CHDFLAGS_IS_WRITEABLE;
 	err = write_header(chd->file, &chd->header);
@@ -1082,22 +1278,25 @@ int chd_compress(chd_file *chd, const char *rawfile, UINT32 offset, void (*progr
 	if (chd->parent)
 		init_crcmap(chd->parent, 1);
 
-	/* init the MD5/SHA1 computations */
-	MD5Init(&md5);
-	sha1_init(&sha);
-
 	/* loop over source hunks until we run out */
+	/* the hunks are read and written in order, but compressed in parallel */
 	lastupdate = 0;
-	for (hunknum = 0; hunknum < chd->header.totalhunks; hunknum++)
+	for (hunknum = 0; hunknum < chd->header.totalhunks; hunknum += BATCH_HUNKS)
 	{
+		hunk_batch *batch = &state->batch[(hunknum / BATCH_HUNKS) & 1];
 		clock_t curtime = clock();
-		UINT32 bytestochecksum;
+		UINT32 bytestoread;
 		UINT32 bytesread;
 
 		/* read the data */
-		bytesread = multi_read(sourcefile, sourceoffset + offset, chd->header.hunkbytes, chd->cache);
-		if (bytesread < chd->header.hunkbytes)
-			memset(&chd->cache[bytesread], 0, chd->header.hunkbytes - bytesread);
+		batch->first = hunknum;
+		batch->count = chd->header.totalhunks - hunknum;
+		if (batch->count > BATCH_HUNKS)
+			batch->count = BATCH_HUNKS;
+		bytestoread = batch->count * chd->header.hunkbytes;
+		bytesread = multi_read(sourcefile, sourceoffset + offset, bytestoread, batch->data);
+		if (bytesread < bytestoread)
+			memset(&batch->data[bytesread], 0, bytestoread - bytesread);
 
 		/* progress */
 		if (curtime - lastupdate > CLOCKS_PER_SEC / 2)
@@ -1108,39 +1307,48 @@ int chd_compress(chd_file *chd, const char *rawfile, UINT32 offset, void (*progr
 			lastupdate = curtime;
 		}
 
-		/* update the MD5/SHA1 */
-		bytestochecksum = chd->header.hunkbytes;
-		if (sourceoffset + chd->header.hunkbytes > chd->header.logicalbytes)
+		/* compute the CRC and compress all the hunks */
+		batch_run(state, batch);
+		if (state->err != CHDERR_NONE)
+			SET_ERROR_AND_CLEANUP(state->err);
+
+		/* write out the hunks */
+		for (i = 0; i < batch->count; i++)
 		{
-			if (sourceoffset >= chd->header.logicalbytes)
-				bytestochecksum = 0;
-			else
-				bytestochecksum = chd->header.logicalbytes - sourceoffset;
+			UINT32 curhunk = hunknum + i;
+
+			err = write_hunk_prepared(chd, curhunk, &batch->data[i * chd->header.hunkbytes], batch->crc[i], &batch->compressed[i * chd->header.hunkbytes], batch->length[i]);
+			if (err != CHDERR_NONE)
+				SET_ERROR_AND_CLEANUP(err);
+
+			/* update our CRC map */
+			if ((chd->map[curhunk].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_SELF_HUNK &&
+				(chd->map[curhunk].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_PARENT_HUNK)
+				add_to_crcmap(chd, curhunk);
 		}
-		if (bytestochecksum)
+
+		/* update the MD5/SHA1, while the next batch is processed */
+		batch->hashbytes = bytestoread;
+		if (sourceoffset + bytestoread > chd->header.logicalbytes)
 		{
-			MD5Update(&md5, chd->cache, bytestochecksum);
-			sha1_update(&sha, bytestochecksum, chd->cache);
+			if (sourceoffset >= chd->header.logicalbytes)
+				batch->hashbytes = 0;
+			else
+				batch->hashbytes = chd->header.logicalbytes - sourceoffset;
 		}
+		batch_hash(state, batch);
 
-		/* write out the hunk */
-		err = write_hunk_from_memory(chd, hunknum, chd->cache);
-		if (err != CHDERR_NONE)
-			SET_ERROR_AND_CLEANUP(err);
-
-		/* update our CRC map */
-		if ((chd->map[hunknum].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_SELF_HUNK &&
-			(chd->map[hunknum].flags & MAP_ENTRY_FLAG_TYPE_MASK) != MAP_ENTRY_TYPE_PARENT_HUNK)
-			add_to_crcmap(chd, hunknum);
-
-		/* prepare for the next hunk */
-		sourceoffset += chd->header.hunkbytes;
+		/* prepare for the next batch */
+		sourceoffset += bytestoread;
 	}
+	if (hunknum > chd->header.totalhunks)
+		hunknum = chd->header.totalhunks;
 
 	/* compute the final MD5/SHA1 values */
-	MD5Final(chd->header.md5, &md5);
-	sha1_final(&sha);
-	sha1_digest(&sha, SHA1_DIGEST_SIZE, chd->header.sha1);
+	batch_hash_wait(state);
+	MD5Final(chd->header.md5, &state->md5);
+	sha1_final(&state->sha);
+	sha1_digest(&state->sha, SHA1_DIGEST_SIZE, chd->header.sha1);
 
 	/* turn off the writeable flag and re-write the header */
 	chd->header.flags &= ~CHDFLAGS_IS_WRITEABLE;
@@ -1157,10 +1365,13 @@ int chd_compress(chd_file *chd, const char *rawfile, UINT32 offset, void (*progr
 	}
 
 	/* close the file */
+	batch_free(state);
 	multi_close(sourcefile);
 	return CHDERR_NONE;
 
 cleanup:
+	if (state)
+		batch_free(state);
 	if (sourcefile)
 		multi_close(sourcefile);
 	return last_error;
@@ -1174,10 +1385,9 @@ cleanup:
 
 int chd_verify(chd_file *chd, void (*progress)(const char *, ...), UINT8 actualmd5[CHD_MD5_BYTES], UINT8 actualsha1[CHD_SHA1_BYTES])
 {
-	struct MD5Context md5;
-	struct sha1_ctx sha;
+	batch_state *state = NULL;
 	UINT64 sourceoffset = 0;
-	int err, prev_err = CHDERR_NONE, hunknum = 0;
+	int prev_err = CHDERR_NONE, hunknum = 0, i;
 	clock_t lastupdate;
 
 	/* punt if no interface */
@@ -1192,14 +1402,20 @@ int chd_verify(chd_file *chd, void (*progress)(const char *, ...), UINT8 actualm
 	if (chd->header.flags & CHDFLAGS_IS_WRITEABLE)
 		SET_ERROR_AND_CLEANUP(CHDERR_CANT_VERIFY);
 
-	/* init the MD5/SHA1 computations */
-	MD5Init(&md5);
-	sha1_init(&sha);
+	/* the read-ahead uses the same file and buffers */
+	cache_sync(chd);
+
+	/* allocate the batches, and init the MD5/SHA1 computations */
+	state = batch_alloc(chd, 0);
+	if (!state)
+		SET_ERROR_AND_CLEANUP(CHDERR_OUT_OF_MEMORY);
 
 	/* loop over source hunks until we run out */
+	/* the hunks are read in order, but decompressed in parallel */
 	lastupdate = 0;
-	for (hunknum = 0; hunknum < chd->header.totalhunks; hunknum++)
+	for (hunknum = 0; hunknum < chd->header.totalhunks; hunknum += BATCH_HUNKS)
 	{
+		hunk_batch *batch = &state->batch[(hunknum / BATCH_HUNKS) & 1];
 		clock_t curtime = clock();
 		UINT32 bytestochecksum;
 
@@ -1211,49 +1427,79 @@ int chd_verify(chd_file *chd, void (*progress)(const char *, ...), UINT8 actualm
 			lastupdate = curtime;
 		}
 
-		/* read the hunk into the cache */
-		err = read_hunk_into_cache(chd, hunknum);
-		if (err == CHDERR_DECOMPRESSION_ERROR)
+		/* read the hunks, only the compressed ones are left to decompress */
+		batch->first = hunknum;
+		batch->count = chd->header.totalhunks - hunknum;
+		if (batch->count > BATCH_HUNKS)
+			batch->count = BATCH_HUNKS;
+		for (i = 0; i < batch->count; i++)
 		{
-			prev_err = CHDERR_DECOMPRESSION_ERROR;
-			if (progress)
-				(*progress)("Bad hunk %d/%d.        \r\n", hunknum, chd->header.totalhunks);
+			map_entry *entry = &chd->map[hunknum + i];
+
+			if ((entry->flags & MAP_ENTRY_FLAG_TYPE_MASK) == MAP_ENTRY_TYPE_COMPRESSED)
+			{
+				if (entry->length > chd->header.hunkbytes)
+					batch->err[i] = CHDERR_DECOMPRESSION_ERROR;
+				else if (multi_read(chd->file, entry->offset, entry->length, &batch->compressed[i * chd->header.hunkbytes]) != entry->length)
+					batch->err[i] = CHDERR_READ_ERROR;
+				else
+					batch->err[i] = BATCH_INFLATE;
+			}
+			else
+				batch->err[i] = read_hunk_into_memory(chd, hunknum + i, &batch->data[i * chd->header.hunkbytes]);
 		}
-		else if (err != CHDERR_NONE)
-			SET_ERROR_AND_CLEANUP(err);
 
-		/* update the MD5/SHA1 */
-		bytestochecksum = chd->header.hunkbytes;
-		if (sourceoffset + chd->header.hunkbytes > chd->header.logicalbytes)
+		/* decompress and check the CRC */
+		batch_run(state, batch);
+		if (state->err != CHDERR_NONE)
+			SET_ERROR_AND_CLEANUP(state->err);
+
+		/* report the bad hunks */
+		for (i = 0; i < batch->count; i++)
+		{
+			if (batch->err[i] == CHDERR_DECOMPRESSION_ERROR)
+			{
+				prev_err = CHDERR_DECOMPRESSION_ERROR;
+				if (progress)
+					(*progress)("Bad hunk %d/%d.        \r\n", hunknum + i, chd->header.totalhunks);
+			}
+			else if (batch->err[i] != CHDERR_NONE)
+				SET_ERROR_AND_CLEANUP(batch->err[i]);
+		}
+
+		/* update the MD5/SHA1, while the next batch is processed */
+		bytestochecksum = batch->count * chd->header.hunkbytes;
+		if (sourceoffset + bytestochecksum > chd->header.logicalbytes)
 		{
 			if (sourceoffset >= chd->header.logicalbytes)
 				bytestochecksum = 0;
 			else
 				bytestochecksum = chd->header.logicalbytes - sourceoffset;
 		}
-		if (bytestochecksum)
-		{
-			MD5Update(&md5, chd->cache, bytestochecksum);
-			sha1_update(&sha, bytestochecksum, chd->cache);
-		}
+		batch->hashbytes = bytestochecksum;
+		batch_hash(state, batch);
 
-		/* prepare for the next hunk */
-		sourceoffset += chd->header.hunkbytes;
+		/* prepare for the next batch */
+		sourceoffset += batch->count * chd->header.hunkbytes;
 	}
+	batch_hash_wait(state);
 	if (prev_err == CHDERR_DECOMPRESSION_ERROR)
 		SET_ERROR_AND_CLEANUP(prev_err);
 
 	/* compute the final MD5 */
-	MD5Final(actualmd5, &md5);
-	sha1_final(&sha);
-	sha1_digest(&sha, SHA1_DIGEST_SIZE, actualsha1);
+	MD5Final(actualmd5, &state->md5);
+	sha1_final(&state->sha);
+	sha1_digest(&state->sha, SHA1_DIGEST_SIZE, actualsha1);
 
 	/* final progress update */
 	if (progress)
 		(*progress)("Verification complete                                  \n");
+	batch_free(state);
 	return CHDERR_NONE;
 
 cleanup:
+	if (state)
+		batch_free(state);
 	return last_error;
 }
 
@@ -1429,6 +1675,12 @@ static int read_hunk_into_cache(chd_file *chd, UINT32 hunknum)
  *************************************/
 
 static int write_hunk_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *src)
+{
+	return write_hunk_prepared(chd, hunknum, src, crc32(0, &src[0], chd->header.hunkbytes), NULL, 0);
+}
+
+
+static int write_hunk_prepared(chd_file *chd, UINT32 hunknum, const UINT8 *src, UINT32 crc, const UINT8 *compressed, UINT32 complength)
 {
 	map_entry *entry = &chd->map[hunknum];
 	map_entry newentry;
@@ -1436,8 +1688,11 @@ static int write_hunk_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *sr
 	const void *data = src;
 	UINT32 bytes, match;
 
-	/* first compute the CRC */
-	newentry.crc = crc32(0, &src[0], chd->header.hunkbytes);
+	/* drop the old data from the hunk cache */
+	cache_invalidate(chd, hunknum);
+
+	/* the CRC is computed by the caller */
+	newentry.crc = crc;
 
 	/* some extra stuff for zlib+ compression */
 	if (chd->header.compression == CHDCOMPRESSION_ZLIB_PLUS)
@@ -1485,8 +1740,19 @@ static int write_hunk_from_memory(chd_file *chd, UINT32 hunknum, const UINT8 *sr
 	newentry.length = chd->header.hunkbytes;
 	newentry.flags = MAP_ENTRY_TYPE_UNCOMPRESSED;
 
+	/* if already compressed by the caller, use it if smaller */
+	if (compressed)
+	{
+		if (complength != 0 && complength < newentry.length)
+		{
+			data = compressed;
+			newentry.length = complength;
+			newentry.flags = MAP_ENTRY_TYPE_COMPRESSED;
+		}
+	}
+
 	/* now try compressing the data */
-	switch (chd->header.compression)
+	else switch (chd->header.compression)
 	{
 		case CHDCOMPRESSION_ZLIB:
 		case CHDCOMPRESSION_ZLIB_PLUS:
@@ -1948,6 +2214,9 @@ chd_exfile *chd_start_compress_ex(chd_file *chd)
 	if (!chd)
 		SET_ERROR_AND_CLEANUP(CHDERR_INVALID_PARAMETER);
 
+	/* the read-ahead uses the same file and buffers */
+	cache_sync(chd);
+
 	/* mark the CHD writeable and write the updated header */
 	chd->header.flags |= CHDFLAGS_IS_WRITEABLE;
 	err = write_header(chd->file, &chd->header);
@@ -2178,6 +2447,561 @@ static void fast_free(voidpf opaque, voidpf address)
 
 
 
+/*************************************
+ *
+ *  Parallel compress/verify
+ *
+ *************************************/
+
+static batch_state *batch_alloc(chd_file *chd, int compress)
+{
+	UINT32 bytes = BATCH_HUNKS * chd->header.hunkbytes;
+	batch_state *state;
+	int i;
+
+	state = malloc(sizeof(batch_state));
+	if (!state)
+		return NULL;
+	memset(state, 0, sizeof(batch_state));
+
+	state->chd = chd;
+	state->compress = compress;
+	for (i = 0; i < 2; i++)
+	{
+		state->batch[i].data = malloc(bytes);
+		state->batch[i].compressed = malloc(bytes);
+		if (!state->batch[i].data || !state->batch[i].compressed)
+		{
+			batch_free(state);
+			return NULL;
+		}
+	}
+
+	MD5Init(&state->md5);
+	sha1_init(&state->sha);
+	return state;
+}
+
+
+static void batch_free(batch_state *state)
+{
+	int i;
+
+	batch_hash_wait(state);
+
+	for (i = 0; i < BATCH_THREAD_MAX; i++)
+		if (state->streamvalid[i])
+		{
+			if (state->compress)
+				deflateEnd(&state->stream[i]);
+			else
+				inflateEnd(&state->stream[i]);
+		}
+
+	for (i = 0; i < 2; i++)
+	{
+		free(state->batch[i].data);
+		free(state->batch[i].compressed);
+	}
+	free(state);
+}
+
+
+static z_stream *batch_stream(batch_state *state, int num)
+{
+	z_stream *stream = &state->stream[num];
+	int err;
+
+	/* every slice has its own stream, initialized on the first use */
+	if (state->streamvalid[num])
+		return stream;
+
+	memset(stream, 0, sizeof(*stream));
+	if (state->compress)
+		err = deflateInit2(stream, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+	else
+		err = inflateInit2(stream, -MAX_WBITS);
+	if (err != Z_OK)
+	{
+		state->err = (err == Z_MEM_ERROR) ? CHDERR_OUT_OF_MEMORY : CHDERR_CODEC_ERROR;
+		return NULL;
+	}
+
+	state->streamvalid[num] = 1;
+	return stream;
+}
+
+
+static void batch_compress_slice(void *param, int num, int max)
+{
+	batch_state *state = param;
+	hunk_batch *batch = state->cur;
+	UINT32 hunkbytes = state->chd->header.hunkbytes;
+	z_stream *stream = NULL;
+	int i;
+
+	if (state->chd->header.compression != CHDCOMPRESSION_NONE)
+	{
+		stream = batch_stream(state, num);
+		if (!stream)
+			return;
+	}
+
+	for (i = num; i < batch->count; i += max)
+	{
+		UINT8 *src = &batch->data[i * hunkbytes];
+
+		batch->crc[i] = crc32(0, src, hunkbytes);
+		batch->length[i] = 0;
+
+		/* same settings of the codec, to get the same result of the serial compression */
+		if (stream)
+		{
+			stream->next_in = src;
+			stream->avail_in = hunkbytes;
+			stream->total_in = 0;
+			stream->next_out = &batch->compressed[i * hunkbytes];
+			stream->avail_out = hunkbytes;
+			stream->total_out = 0;
+			if (deflateReset(stream) != Z_OK)
+			{
+				state->err = CHDERR_COMPRESSION_ERROR;
+				return;
+			}
+
+			if (deflate(stream, Z_FINISH) == Z_STREAM_END)
+				batch->length[i] = stream->total_out;
+		}
+	}
+}
+
+
+static void batch_inflate_slice(void *param, int num, int max)
+{
+	batch_state *state = param;
+	hunk_batch *batch = state->cur;
+	chd_file *chd = state->chd;
+	UINT32 hunkbytes = chd->header.hunkbytes;
+	z_stream *stream = NULL;
+	int i;
+
+	for (i = num; i < batch->count; i += max)
+	{
+		map_entry *entry = &chd->map[batch->first + i];
+		UINT8 *dest = &batch->data[i * hunkbytes];
+
+		if (batch->err[i] != BATCH_INFLATE)
+			continue;
+
+		if (!stream)
+		{
+			stream = batch_stream(state, num);
+			if (!stream)
+				return;
+		}
+
+		stream->next_in = &batch->compressed[i * hunkbytes];
+		stream->avail_in = entry->length;
+		stream->total_in = 0;
+		stream->next_out = dest;
+		stream->avail_out = hunkbytes;
+		stream->total_out = 0;
+		if (inflateReset(stream) != Z_OK)
+		{
+			batch->err[i] = CHDERR_DECOMPRESSION_ERROR;
+			continue;
+		}
+
+		inflate(stream, Z_FINISH);
+		if (stream->total_out != hunkbytes)
+			batch->err[i] = CHDERR_DECOMPRESSION_ERROR;
+		else if (!(entry->flags & MAP_ENTRY_FLAG_NO_CRC) && entry->crc != crc32(0, dest, hunkbytes))
+			batch->err[i] = CHDERR_DECOMPRESSION_ERROR;
+		else
+			batch->err[i] = CHDERR_NONE;
+	}
+}
+
+
+static void batch_run(batch_state *state, hunk_batch *batch)
+{
+	int max = (batch->count < batch_threads) ? batch->count : batch_threads;
+
+	state->cur = batch;
+	state->err = CHDERR_NONE;
+	osd_parallelize(state->compress ? batch_compress_slice : batch_inflate_slice, state, max);
+}
+
+
+static void batch_hash_proc(void *param)
+{
+	batch_state *state = param;
+	hunk_batch *batch = state->hashbatch;
+
+	if (batch->hashbytes)
+	{
+		MD5Update(&state->md5, batch->data, batch->hashbytes);
+		sha1_update(&state->sha, batch->hashbytes, batch->data);
+	}
+}
+
+
+static void batch_hash(batch_state *state, hunk_batch *batch)
+{
+	/* the MD5/SHA1 must see the batches in order */
+	batch_hash_wait(state);
+
+	state->hashbatch = batch;
+	if (batch_threads > 1)
+		state->hashitem = osd_work_item_queue(batch_hash_proc, state);
+	if (!state->hashitem)
+		batch_hash_proc(state);
+}
+
+
+static void batch_hash_wait(batch_state *state)
+{
+	if (state->hashitem)
+	{
+		osd_work_item_wait(state->hashitem);
+		state->hashitem = NULL;
+	}
+}
+
+
+
+/*************************************
+ *
+ *  Hunk cache
+ *
+ *************************************/
+
+static int cache_attach(chd_file *chd)
+{
+	hunk_cache *cache;
+
+	/* the files of a parent/child chain share the same cache and budget */
+	if (chd->parent)
+	{
+		chd->hcache = chd->parent->hcache;
+		chd->hcache->refcount++;
+		return CHDERR_NONE;
+	}
+
+	cache = malloc(sizeof(hunk_cache));
+	if (!cache)
+		return CHDERR_OUT_OF_MEMORY;
+	memset(cache, 0, sizeof(hunk_cache));
+
+	cache->lock = osd_lock_alloc();
+	if (!cache->lock)
+	{
+		free(cache);
+		return CHDERR_OUT_OF_MEMORY;
+	}
+
+	cache->iolock = osd_lock_alloc();
+	if (!cache->iolock)
+	{
+		osd_lock_free(cache->lock);
+		free(cache);
+		return CHDERR_OUT_OF_MEMORY;
+	}
+
+	cache->refcount = 1;
+	cache->maxbytes = cache_bytes;
+	cache->readahead = cache_readahead;
+
+	chd->hcache = cache;
+	return CHDERR_NONE;
+}
+
+
+static void cache_unlink(hunk_cache *cache, cache_entry *entry)
+{
+	cache_entry **prev;
+
+	/* remove from the LRU list */
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		cache->head = entry->next;
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		cache->tail = entry->prev;
+
+	/* remove from the hashtable */
+	for (prev = &cache->hash[entry->hunknum % CACHE_HASH_SIZE]; *prev; prev = &(*prev)->hashnext)
+		if (*prev == entry)
+		{
+			*prev = entry->hashnext;
+			break;
+		}
+
+	cache->bytes -= entry->bytes;
+}
+
+
+static void cache_link(hunk_cache *cache, cache_entry *entry)
+{
+	UINT32 hash = entry->hunknum % CACHE_HASH_SIZE;
+
+	/* add at the head of the LRU list */
+	entry->prev = NULL;
+	entry->next = cache->head;
+	if (cache->head)
+		cache->head->prev = entry;
+	else
+		cache->tail = entry;
+	cache->head = entry;
+
+	/* add to the hashtable */
+	entry->hashnext = cache->hash[hash];
+	cache->hash[hash] = entry;
+
+	cache->bytes += entry->bytes;
+}
+
+
+static void cache_detach(chd_file *chd)
+{
+	hunk_cache *cache = chd->hcache;
+	cache_entry *entry, *next;
+
+	if (!cache)
+		return;
+
+	cache_sync(chd);
+
+	/* free our entries */
+	for (entry = cache->head; entry; entry = next)
+	{
+		next = entry->next;
+		if (entry->chd == chd)
+		{
+			cache_unlink(cache, entry);
+			free(entry);
+		}
+	}
+
+	chd->hcache = NULL;
+	if (--cache->refcount != 0)
+		return;
+
+	/* report the statistics of the whole chain */
+	logerror("chd: cache hits %u, misses %u, read-ahead %u, read-ahead used %u\n", cache->hits, cache->misses, cache->raloads, cache->rahits);
+
+	osd_lock_free(cache->iolock);
+	osd_lock_free(cache->lock);
+	free(cache);
+}
+
+
+static void cache_sync(chd_file *chd)
+{
+	hunk_cache *cache = chd->hcache;
+	osd_work_item *item;
+
+	if (!cache)
+		return;
+
+	/* stop the read-ahead, and wait until it's really stopped */
+	osd_lock_acquire(cache->lock);
+	cache->racancel = 1;
+	item = cache->raitem;
+	cache->raitem = NULL;
+	osd_lock_release(cache->lock);
+
+	if (item)
+		osd_work_item_wait(item);
+
+	osd_lock_acquire(cache->lock);
+	cache->racancel = 0;
+	cache->rachd = NULL;
+	osd_lock_release(cache->lock);
+}
+
+
+static cache_entry *cache_find(hunk_cache *cache, chd_file *chd, UINT32 hunknum)
+{
+	cache_entry *entry;
+
+	for (entry = cache->hash[hunknum % CACHE_HASH_SIZE]; entry; entry = entry->hashnext)
+		if (entry->hunknum == hunknum && entry->chd == chd)
+		{
+			/* move at the head of the LRU list */
+			if (entry != cache->head)
+			{
+				cache_unlink(cache, entry);
+				cache_link(cache, entry);
+			}
+			return entry;
+		}
+
+	return NULL;
+}
+
+
+static cache_entry *cache_load(chd_file *chd, UINT32 hunknum, int *err)
+{
+	hunk_cache *cache = chd->hcache;
+	UINT32 bytes = chd->header.hunkbytes;
+	cache_entry *entry;
+
+	/* the entry is private until inserted, only the file access is locked */
+	entry = malloc(sizeof(cache_entry) + bytes);
+	if (!entry)
+	{
+		*err = CHDERR_OUT_OF_MEMORY;
+		return NULL;
+	}
+	entry->data = (UINT8 *)(entry + 1);
+
+	/* read and decompress */
+	osd_lock_acquire(cache->iolock);
+	*err = read_hunk_into_memory(chd, hunknum, entry->data);
+	osd_lock_release(cache->iolock);
+	if (*err != CHDERR_NONE)
+	{
+		free(entry);
+		return NULL;
+	}
+
+	entry->chd = chd;
+	entry->hunknum = hunknum;
+	entry->bytes = bytes;
+	entry->readahead = 0;
+	return entry;
+}
+
+
+static cache_entry *cache_insert(hunk_cache *cache, cache_entry *entry)
+{
+	cache_entry *found;
+
+	/* the same hunk may have been loaded in the meantime */
+	found = cache_find(cache, entry->chd, entry->hunknum);
+	if (found)
+	{
+		free(entry);
+		return found;
+	}
+
+	/* evict the least recently used entries to stay in the budget */
+	while (cache->tail && cache->bytes + entry->bytes > cache->maxbytes)
+	{
+		cache_entry *victim = cache->tail;
+		cache_unlink(cache, victim);
+		free(victim);
+	}
+
+	cache_link(cache, entry);
+	return entry;
+}
+
+
+static void cache_invalidate(chd_file *chd, UINT32 hunknum)
+{
+	hunk_cache *cache = chd->hcache;
+	cache_entry *entry;
+
+	/* the compare and verify buffer */
+	if (chd->cachehunk == hunknum)
+		chd->cachehunk = ~0;
+
+	if (!cache)
+		return;
+
+	osd_lock_acquire(cache->lock);
+	entry = cache_find(cache, chd, hunknum);
+	if (entry)
+	{
+		cache_unlink(cache, entry);
+		free(entry);
+	}
+	osd_lock_release(cache->lock);
+}
+
+
+static void cache_readahead_proc(void *param)
+{
+	hunk_cache *cache = param;
+	int err;
+
+	osd_lock_acquire(cache->lock);
+
+	/* a read on request waiting the file access stops the read-ahead */
+	while (!cache->racancel && !cache->iowait && cache->ranext < cache->raend)
+	{
+		chd_file *chd = cache->rachd;
+		UINT32 hunknum = cache->ranext++;
+		cache_entry *entry;
+
+		if (cache_find(cache, chd, hunknum))
+			continue;
+
+		/* the emulation accesses the cache while the hunk is decompressed */
+		osd_lock_release(cache->lock);
+		entry = cache_load(chd, hunknum, &err);
+		osd_lock_acquire(cache->lock);
+
+		/* errors are reported by the read on request */
+		if (!entry)
+			break;
+
+		if (cache_insert(cache, entry) == entry)
+		{
+			entry->readahead = 1;
+			cache->raloads++;
+		}
+	}
+
+	cache->rabusy = 0;
+
+	osd_lock_release(cache->lock);
+}
+
+
+static void cache_readahead_start(chd_file *chd, UINT32 hunknum)
+{
+	hunk_cache *cache = chd->hcache;
+	UINT32 count = cache->readahead;
+
+	/* don't use more than half of the cache, to not evict the hunks in use */
+	if (count > cache->maxbytes / 2 / chd->header.hunkbytes)
+		count = cache->maxbytes / 2 / chd->header.hunkbytes;
+	if (count == 0 || cache->rabusy)
+		return;
+
+	/* wait for the next read-ahead until half of the previous one is used */
+	if (cache->rachd == chd && hunknum >= cache->rastart && hunknum + count / 2 < cache->raend)
+		return;
+
+	/* free the completed work item */
+	if (cache->raitem)
+	{
+		osd_work_item_wait(cache->raitem);
+		cache->raitem = NULL;
+	}
+
+	cache->rachd = chd;
+	cache->rastart = hunknum;
+	cache->ranext = hunknum;
+	cache->raend = hunknum + count;
+	if (cache->raend > chd->header.totalhunks)
+		cache->raend = chd->header.totalhunks;
+	if (cache->ranext >= cache->raend)
+		return;
+
+	cache->rabusy = 1;
+	cache->raitem = osd_work_item_queue(cache_readahead_proc, cache);
+	if (!cache->raitem)
+		cache->rabusy = 0;
+}
+
+
+
 /*************************************
  *
  *  Compression init
@@ -189,6 +189,8 @@ typedef struct _chd_interface chd_interface;
 
 void chd_set_interface(chd_interface *new_interface);
 void chd_save_interface(chd_interface *interface_save);
+void chd_set_cache(UINT32 cachebytes, UINT32 readahead);
+void chd_set_threads(UINT32 threads);
 
 int chd_create(const char *filename, UINT64 logicalbytes, UINT32 hunkbytes, UINT32 compression, chd_file *parent);
 chd_file *chd_open(const char *filename, int writeable, chd_file *parent);
@@ -8,6 +8,7 @@
 ***************************************************************************/
 
 #include "osd_tool.h"
+#include "osdepend.h"
 #include "chdcd.h"
 #include "md5.h"
 #include "sha1.h"
@@ -157,6 +158,22 @@ static void progress(const char *fmt, ...)
 }
 
 
+/*-------------------------------------------------
+    report_speed - display the processing speed
+-------------------------------------------------*/
+
+static void report_speed(UINT64 bytes, cycles_t start)
+{
+	double elapsed = (double)(osd_cycles() - start) / (double)osd_cycles_per_second();
+
+	/* avoid a division by zero with a very small input */
+	if (elapsed < 0.001)
+		elapsed = 0.001;
+
+	printf("Speed:        %.1f MB/s (%s bytes in %.3f seconds)\n", bytes / elapsed / (1024 * 1024), big_int_string(bytes), elapsed);
+}
+
+
 /*-------------------------------------------------
     error_string - return an error sting
 -------------------------------------------------*/
@@ -193,6 +210,8 @@ static void error(void)
 	printf("   or: chdman -merge parent.chd diff.chd output.chd\n");
 	printf("   or: chdman -diff parent.chd compare.chd diff.chd\n");
 	printf("   or: chdman -setchs inout.chd cylinders heads sectors\n");
+	printf("\n");
+	printf("options: -threads count (before the command) max threads to compress and verify\n");
 	exit(1);
 }
 
@@ -372,6 +391,7 @@ static void do_createhd(int argc, char *argv[])
 	chd_file *chd;
 	char metadata[256];
 	int offset, err;
+	cycles_t start;
 
 	/* require 4-5, or 8-10 args total */
 	if (argc != 4 && argc != 5 && argc != 8 && argc != 9 && argc != 10)
@@ -447,6 +467,7 @@ static void do_createhd(int argc, char *argv[])
 	}
 
 	/* compress the hard drive */
+	start = osd_cycles();
 	err = chd_compress(chd, inputfile, offset, progress);
 	if (err != CHDERR_NONE)
 	{
@@ -455,6 +476,7 @@ static void do_createhd(int argc, char *argv[])
 		remove(outputfile);
 		return;
 	}
+	report_speed((UINT64)totalsectors * (UINT64)sectorsize, start);
 
 	/* success */
 	chd_close(chd);
@@ -1172,6 +1194,7 @@ static void do_verify(int argc, char *argv[], int fix)
 	const char *inputfile;
 	chd_file *chd;
 	int err, fixed = 0;
+	cycles_t start;
 
 	/* require 3 args total */
 	if (argc != 3)
@@ -1193,6 +1216,7 @@ static void do_verify(int argc, char *argv[], int fix)
 	header = *chd_get_header(chd);
 
 	/* verify the CHD data */
+	start = osd_cycles();
 	err = chd_verify(chd, progress, actualmd5, actualsha1);
 	if (err != CHDERR_NONE)
 	{
@@ -1203,6 +1227,7 @@ static void do_verify(int argc, char *argv[], int fix)
 		chd_close(chd);
 		return;
 	}
+	report_speed(header.logicalbytes, start);
 
 	/* verify the MD5 */
 	if (!memcmp(header.md5, actualmd5, sizeof(header.md5)))
@@ -1483,6 +1508,7 @@ static void do_merge_update_chomp(int argc, char *argv[], int operation)
 	UINT8 metadata[CHD_MAX_METADATA_SIZE];
 	UINT32 metatag, metasize, metaindex;
 	UINT32 maxhunk = ~0;
+	cycles_t start;
 	int err;
 
 	/* require 4-5 args total */
@@ -1580,9 +1606,12 @@ static void do_merge_update_chomp(int argc, char *argv[], int operation)
 
 	/* do the compression; our interface will route reads for us */
 	special_chd_init(inputchd, (operation == OPERATION_CHOMP) ? ((UINT64)(maxhunk + 1) * (UINT64)inputheader->hunkbytes) : inputheader->logicalbytes);
+	start = osd_cycles();
 	err = chd_compress(outputchd, SPECIAL_CHD_NAME, 0, progress);
 	if (err != CHDERR_NONE)
 		printf("Error during compression: %s\n", error_string(err));
+	else
+		report_speed(special_logicalbytes, start);
 	special_chd_finished();
 
 error:
@@ -1960,6 +1989,16 @@ int main(int argc, char **argv)
 	if (argc < 2)
 		error();
 
+	/* handle the options before the command */
+	while (argc >= 3 && !strcmp(argv[1], "-threads"))
+	{
+		chd_set_threads(atoi(argv[2]));
+		argc -= 2;
+		argv += 2;
+	}
+	if (argc < 2)
+		error();
+
 	/* set the interface for everyone */
 	chd_set_interface(&chdman_interface);
 
@@ -58,6 +58,7 @@ COREOBJS = \
 	$(OBJ)/video.o \
 	$(OBJ)/xmlfile.o \
 	$(OBJ)/sound/filter.o \
+	$(OBJ)/sound/resample.o \
 	$(OBJ)/sound/flt_vol.o \
 	$(OBJ)/sound/flt_rc.o \
 	$(OBJ)/sound/wavwrite.o \
@@ -328,6 +328,9 @@ unsigned int m68k_get_context(void* dst);
 /* set the current cpu context */
 void m68k_set_context(void* dst);
 
+/* use directly the given cpu context, without copying it */
+void m68k_select_context(void* dst);
+
 /* Register the CPU state information */
 void m68k_state_register(const char *type, int index);
 
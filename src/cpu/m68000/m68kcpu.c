@@ -72,7 +72,8 @@ const char* m68ki_cpu_names[] =
 #endif /* M68K_LOG_ENABLE */
 
 /* The CPU core */
-m68ki_cpu_core m68ki_cpu = {0};
+static m68ki_cpu_core m68ki_default_context;
+m68ki_cpu_core* m68ki_cpu_context = &m68ki_default_context;
 
 #if M68K_EMULATE_ADDRESS_ERROR
 jmp_buf m68ki_aerr_trap;
@@ -943,13 +944,18 @@ unsigned int m68k_context_size()
 
 unsigned int m68k_get_context(void* dst)
 {
-	if(dst) *(m68ki_cpu_core*)dst = m68ki_cpu;
+	if(dst && dst != m68ki_cpu_context) *(m68ki_cpu_core*)dst = m68ki_cpu;
 	return sizeof(m68ki_cpu_core);
 }
 
 void m68k_set_context(void* src)
 {
-	if(src) m68ki_cpu = *(m68ki_cpu_core*)src;
+	if(src && src != m68ki_cpu_context) m68ki_cpu = *(m68ki_cpu_core*)src;
+}
+
+void m68k_select_context(void* src)
+{
+	m68ki_cpu_context = src ? (m68ki_cpu_core*)src : &m68ki_default_context;
 }
 
 
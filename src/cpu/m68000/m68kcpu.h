@@ -897,7 +897,8 @@ typedef struct
 } m68ki_cpu_core;
 
 
-extern m68ki_cpu_core m68ki_cpu;
+extern m68ki_cpu_core* m68ki_cpu_context;
+#define m68ki_cpu (*m68ki_cpu_context) /* the core of the active CPU */
 extern sint           m68ki_remaining_cycles;
 extern uint           m68ki_tracing;
 extern uint8          m68ki_shift_8_table[];
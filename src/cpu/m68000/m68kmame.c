@@ -260,6 +260,13 @@ static void m68000_set_context(void *src)
 	m68k_set_context(src);
 }
 
+static void m68000_select_context(void *src)
+{
+	if (m68k_memory_intf.read8 != program_read_byte_16be)
+		m68k_memory_intf = interface_d16;
+	m68k_select_context(src);
+}
+
 static offs_t m68000_dasm(char *buffer, offs_t pc, UINT8 *oprom, UINT8 *opram, int bytes)
 {
 	M68K_SET_PC_CALLBACK(pc);
@@ -312,6 +319,13 @@ static void m68008_set_context(void *src)
 	m68k_set_context(src);
 }
 
+static void m68008_select_context(void *src)
+{
+	if (m68k_memory_intf.read8 != program_read_byte_8)
+		m68k_memory_intf = interface_d8;
+	m68k_select_context(src);
+}
+
 static offs_t m68008_dasm(char *buffer, offs_t pc, UINT8 *oprom, UINT8 *opram, int bytes)
 {
 	M68K_SET_PC_CALLBACK(pc);
@@ -437,6 +451,13 @@ static void m68020_set_context(void *src)
 	m68k_set_context(src);
 }
 
+static void m68020_select_context(void *src)
+{
+	if (m68k_memory_intf.read8 != program_read_byte_32be)
+		m68k_memory_intf = interface_d32;
+	m68k_select_context(src);
+}
+
 static offs_t m68020_dasm(char *buffer, offs_t pc, UINT8 *oprom, UINT8 *opram, int bytes)
 {
 	M68K_SET_PC_CALLBACK(pc);
@@ -544,6 +565,13 @@ static void m68040_set_context(void *src)
 	m68k_set_context(src);
 }
 
+static void m68040_select_context(void *src)
+{
+	if (m68k_memory_intf.read8 != program_read_byte_32be)
+		m68k_memory_intf = interface_d32;
+	m68k_select_context(src);
+}
+
 static offs_t m68040_dasm(char *buffer, offs_t pc, UINT8 *oprom, UINT8 *opram, int bytes)
 {
 	M68K_SET_PC_CALLBACK(pc);
@@ -683,6 +711,7 @@ void m68000_get_info(UINT32 state, union cpuinfo *info)
 		case CPUINFO_PTR_SET_INFO:						info->setinfo = m68000_set_info;		break;
 		case CPUINFO_PTR_GET_CONTEXT:					info->getcontext = m68000_get_context;	break;
 		case CPUINFO_PTR_SET_CONTEXT:					info->setcontext = m68000_set_context;	break;
+		case CPUINFO_PTR_SELECT_CONTEXT:				info->selectcontext = m68000_select_context;	break;
 		case CPUINFO_PTR_INIT:							info->init = m68000_init;				break;
 		case CPUINFO_PTR_RESET:							info->reset = m68000_reset;				break;
 		case CPUINFO_PTR_EXIT:							info->exit = m68000_exit;				break;
@@ -862,6 +891,7 @@ void m68008_get_info(UINT32 state, union cpuinfo *info)
 		case CPUINFO_PTR_SET_INFO:						info->setinfo = m68008_set_info;		break;
 		case CPUINFO_PTR_GET_CONTEXT:					info->getcontext = m68008_get_context;	break;
 		case CPUINFO_PTR_SET_CONTEXT:					info->setcontext = m68008_set_context;	break;
+		case CPUINFO_PTR_SELECT_CONTEXT:				info->selectcontext = m68008_select_context;	break;
 		case CPUINFO_PTR_INIT:							info->init = m68008_init;				break;
 		case CPUINFO_PTR_RESET:							info->reset = m68008_reset;				break;
 		case CPUINFO_PTR_EXIT:							info->exit = m68008_exit;				break;
@@ -1113,6 +1143,7 @@ void m68020_get_info(UINT32 state, union cpuinfo *info)
 		case CPUINFO_PTR_SET_INFO:						info->setinfo = m68020_set_info;		break;
 		case CPUINFO_PTR_GET_CONTEXT:					info->getcontext = m68020_get_context;	break;
 		case CPUINFO_PTR_SET_CONTEXT:					info->setcontext = m68020_set_context;	break;
+		case CPUINFO_PTR_SELECT_CONTEXT:				info->selectcontext = m68020_select_context;	break;
 		case CPUINFO_PTR_INIT:							info->init = m68020_init;				break;
 		case CPUINFO_PTR_RESET:							info->reset = m68020_reset;				break;
 		case CPUINFO_PTR_EXIT:							info->exit = m68020_exit;				break;
@@ -1359,6 +1390,7 @@ void m68040_get_info(UINT32 state, union cpuinfo *info)
 		case CPUINFO_PTR_SET_INFO:						info->setinfo = m68040_set_info;		break;
 		case CPUINFO_PTR_GET_CONTEXT:					info->getcontext = m68040_get_context;	break;
 		case CPUINFO_PTR_SET_CONTEXT:					info->setcontext = m68040_set_context;	break;
+		case CPUINFO_PTR_SELECT_CONTEXT:				info->selectcontext = m68040_select_context;	break;
 		case CPUINFO_PTR_INIT:							info->init = m68040_init;				break;
 		case CPUINFO_PTR_RESET:							info->reset = m68040_reset;				break;
 		case CPUINFO_PTR_EXIT:							info->exit = m68040_exit;				break;
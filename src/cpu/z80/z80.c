@@ -208,7 +208,9 @@ typedef struct
 #define HALT Z80.halt
 
 static int z80_ICount;
-static Z80_Regs Z80;
+static Z80_Regs z80_default_context;
+static Z80_Regs *z80_context = &z80_default_context;
+#define Z80 (*z80_context)		/* the registers of the active CPU */
 static UINT32 EA;
 static int after_EI = 0;
 
@@ -3928,7 +3930,7 @@ static void z80_burn(int cycles)
  ****************************************************************************/
 static void z80_get_context (void *dst)
 {
-	if( dst )
+	if( dst && dst != z80_context )
 		*(Z80_Regs*)dst = Z80;
 }
 
@@ -3937,11 +3939,20 @@ static void z80_get_context (void *dst)
  ****************************************************************************/
 static void z80_set_context (void *src)
 {
-	if( src )
+	if( src && src != z80_context )
 		Z80 = *(Z80_Regs*)src;
 	change_pc(PCD);
 }
 
+/****************************************************************************
+ * Use the registers in the given buffer, without copying them
+ ****************************************************************************/
+static void z80_select_context (void *src)
+{
+	z80_context = src ? (Z80_Regs*)src : &z80_default_context;
+	change_pc(PCD);
+}
+
 /****************************************************************************
  * Set IRQ line state
  ****************************************************************************/
@@ -4170,6 +4181,11 @@ void z80_get_info(UINT32 state, union cpuinfo *info)
 			info->i = 0;
 			break;
 
+		/* AdvanceMAME: R changes in every instruction, also in the idle loops */
+		case CPUINFO_INT_REFRESH_REGISTER:
+			info->i = Z80_R;
+			break;
+
 		case CPUINFO_INT_INPUT_STATE + INPUT_LINE_NMI:
 			info->i = Z80.nmi_state;
 			break;
@@ -4273,6 +4289,9 @@ void z80_get_info(UINT32 state, union cpuinfo *info)
 		case CPUINFO_PTR_SET_CONTEXT:
 			info->setcontext = z80_set_context;
 			break;
+		case CPUINFO_PTR_SELECT_CONTEXT:
+			info->selectcontext = z80_select_context;
+			break;
 		case CPUINFO_PTR_INIT:
 			info->init = z80_init;
 			break;
@@ -119,8 +119,16 @@ static UINT8 vblank;
 static UINT32 current_frame;
 static INT32 watchdog_counter;
 
-static int cycles_running;
-static int cycles_stolen;
+/* AdvanceMAME: private of every thread, as the parallel CPU runs in another thread */
+static THREAD_LOCAL int cycles_running;
+static THREAD_LOCAL int cycles_stolen;
+static THREAD_LOCAL int cycles_aborted;
+
+/* names of the scopes in the OSD trace */
+static const char *cpu_trace_name[MAX_CPU] =
+{
+	"CPU 1", "CPU 2", "CPU 3", "CPU 4", "CPU 5", "CPU 6", "CPU 7", "CPU 8"
+};
 
 
 
@@ -153,6 +161,65 @@ static mame_timer *watchdog_timer;
 
 
 
+/*************************************
+ *
+ *  AdvanceMAME: parallel execution
+ *  variables
+ *
+ *************************************/
+
+#define PARALLEL_CHUNKS		4				/* chunks of the timeslice */
+
+static int parallel_cpu = -1;				/* CPU running in parallel with the others, or -1 */
+static osd_lock *parallel_lock[PARALLEL_CHUNKS]; /* released when the serial CPU completes a chunk */
+static mame_time parallel_chunk_end[PARALLEL_CHUNKS]; /* end time of the chunks */
+static mame_time parallel_base;				/* base time of the current timeslice */
+static mame_time parallel_target;			/* target reached by the parallel CPU */
+
+static int parallel_conflict;				/* state read by the parallel CPU changed by the others */
+
+/* the thread running the parallel CPU has to wait the other CPUs before changing a shared state */
+THREAD_LOCAL int cpuexec_parallel_pending;
+
+/* the thread running the other CPUs can't wait the parallel CPU, and it has to report its changes */
+THREAD_LOCAL int cpuexec_parallel_active;
+
+
+
+/*************************************
+ *
+ *  AdvanceMAME: idle loop variables
+ *
+ *************************************/
+
+#define IDLE_INSTRUCTIONS	16				/* max instructions of an idle loop */
+#define IDLE_BYTES			32				/* max distance of the instructions of an idle loop */
+#define IDLE_CHUNKS			8				/* chunks of the timeslice of a CPU that has idle loops */
+#define IDLE_LOGGED			16				/* max idle loops logged for every CPU */
+
+typedef struct _cpuexec_idle cpuexec_idle;
+struct _cpuexec_idle
+{
+	size_t	size;					/* size of the context, 0 if the CPU isn't checked */
+	int		refresh;				/* register changed by every instruction, or 0 */
+	UINT8 *	context;				/* context at the start of the loop */
+	UINT8 *	current;				/* context after an iteration of the loop */
+	UINT8 *	mask;					/* bytes of the context holding the refresh register */
+	offs_t	pc;						/* PC at the previous check */
+	offs_t	loop_first;				/* lowest PC of the last idle loop found */
+	offs_t	loop_last;				/* highest PC of the last idle loop found */
+	int		loop_cycles;			/* cycles of an iteration of the last idle loop found, or 0 */
+	int		found;					/* the CPU has been found in an idle loop */
+	UINT64	skipped;				/* cycles skipped in the idle loops */
+	int		logged;					/* number of idle loops logged */
+	offs_t	log[IDLE_LOGGED];		/* lowest PC of the idle loops logged */
+};
+
+static int idle_enabled;					/* look for the idle loops to skip */
+static cpuexec_idle idle_data[MAX_CPU];
+
+
+
 /*************************************
  *
  *  Static prototypes
@@ -169,6 +236,12 @@ static void cpu_updatecallback(int param);
 static void end_interleave_boost(int param);
 static void compute_perfect_interleave(void);
 static void watchdog_setup(int alloc_new);
+static void cpuexec_parallel_init(int totalcpu);
+static void cpuexec_parallel_exit(void);
+static int cpuexec_parallel_timeslice(int cpunum, mame_time *target, mame_time base);
+static void cpuexec_idle_init(int totalcpu);
+static void cpuexec_idle_exit(void);
+static int cpuexec_idle_execute(int cpunum, int cycles);
 
 
 
@@ -262,6 +335,14 @@ int cpuexec_init(void)
 	add_reset_callback(cpuexec_reset);
 	add_exit_callback(cpuexec_exit);
 
+	/* AdvanceMAME: check if the last CPU can run in parallel */
+	if (options.cpu_parallel)
+		cpuexec_parallel_init(cpunum);
+
+	/* AdvanceMAME: prepare the detection of the idle loops */
+	if (options.cpu_idle)
+		cpuexec_idle_init(cpunum);
+
 	/* compute the perfect interleave factor */
 	compute_perfect_interleave();
 
@@ -333,6 +414,9 @@ static void cpuexec_exit(void)
 	/* shut down the CPU cores */
 	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
 		cpuintrf_exit_cpu(cpunum);
+
+	cpuexec_parallel_exit();
+	cpuexec_idle_exit();
 }
 
 
@@ -413,6 +497,8 @@ static void watchdog_setup(int alloc_new)
 
 void watchdog_reset(void)
 {
+	cpuexec_serialize();
+
 	if (watchdog_counter == WATCHDOG_IS_TIMER_BASED)
 	{
 		timer_reset(watchdog_timer, Machine->drv->watchdog_time);
@@ -439,6 +525,8 @@ void watchdog_reset(void)
 
 void watchdog_enable(int enable)
 {
+	cpuexec_serialize();
+
 	if (!enable)
 	{
 		// Disable all timers
@@ -461,6 +549,90 @@ void watchdog_enable(int enable)
 #pragma mark CPU SCHEDULING
 #endif
 
+/*************************************
+ *
+ *  AdvanceMAME: execute a CPU for the
+ *  requested cycles, and account the
+ *  cycles run
+ *
+ *************************************/
+
+INLINE int cpuexec_execute(int cpunum, int cycles)
+{
+	int ran;
+
+	cycles_running = cycles;
+	cycles_stolen = 0;
+	ran = cpunum_execute(cpunum, cycles);
+
+#ifdef MAME_DEBUG
+	if (ran < cycles_stolen)
+		fatalerror("Negative CPU cycle count!");
+#endif /* MAME_DEBUG */
+
+	ran -= cycles_stolen;
+
+	/* account for these cycles */
+	cpu[cpunum].totalcycles += ran;
+	cpu[cpunum].localtime = add_mame_times(cpu[cpunum].localtime, MAME_TIME_IN_CYCLES(ran, cpunum));
+
+	return ran;
+}
+
+
+
+/*************************************
+ *
+ *  Execute a CPU until the target
+ *  time, moving back the target if
+ *  the CPU doesn't reach it. Return
+ *  1 if the CPU aborted the timeslice,
+ *  also without cycles left to skip.
+ *
+ *************************************/
+
+INLINE int cpuexec_run(int cpunum, mame_time *target, mame_time base)
+{
+	int cycles, ran;
+
+	/* compute how long to run */
+	cycles = MAME_TIME_TO_CYCLES(cpunum, sub_mame_times(*target, cpu[cpunum].localtime));
+	LOG(("  cpu %d: %d cycles\n", cpunum, cycles));
+
+	/* run for the requested number of cycles */
+	cycles_aborted = FALSE;
+	if (cycles > 0)
+	{
+		profiler_mark(PROFILER_CPU1 + cpunum);
+		osd_trace_begin(cpu_trace_name[cpunum]);
+
+		/* AdvanceMAME: skip the iterations of the idle loops */
+		if (idle_enabled)
+			ran = cpuexec_idle_execute(cpunum, cycles);
+		else
+			ran = cpuexec_execute(cpunum, cycles);
+
+		osd_trace_end();
+		profiler_mark(PROFILER_END);
+
+		LOG(("         %d ran, %d total, time = %.9f\n", ran, (INT32)cpu[cpunum].totalcycles, mame_time_to_double(cpu[cpunum].localtime)));
+
+		/* if the new local CPU time is less than our target, move the target up */
+		if (compare_mame_times(cpu[cpunum].localtime, *target) < 0)
+		{
+			if (compare_mame_times(cpu[cpunum].localtime, base) > 0)
+				*target = cpu[cpunum].localtime;
+			else
+				*target = base;
+			LOG(("         (new target)\n"));
+		}
+	}
+
+	return cycles_aborted;
+}
+
+
+
 /*************************************
  *
  *  Execute all the CPUs for one
@@ -472,7 +644,7 @@ void cpuexec_timeslice(void)
 {
 	mame_time target = mame_timer_next_fire_time();
 	mame_time base = mame_timer_get_time();
-	int cpunum, ran;
+	int cpunum;
 
 	LOG(("------------------\n"));
 	LOG(("cpu_timeslice: target = %.9f\n", mame_time_to_double(target)));
@@ -492,40 +664,11 @@ void cpuexec_timeslice(void)
 		/* only process if we're not suspended */
 		if (!cpu[cpunum].suspend)
 		{
-			/* compute how long to run */
-			cycles_running = MAME_TIME_TO_CYCLES(cpunum, sub_mame_times(target, cpu[cpunum].localtime));
-			LOG(("  cpu %d: %d cycles\n", cpunum, cycles_running));
-
-			/* run for the requested number of cycles */
-			if (cycles_running > 0)
-			{
-				profiler_mark(PROFILER_CPU1 + cpunum);
-				cycles_stolen = 0;
-				ran = cpunum_execute(cpunum, cycles_running);
-
-#ifdef MAME_DEBUG
-				if (ran < cycles_stolen)
-					fatalerror("Negative CPU cycle count!");
-#endif /* MAME_DEBUG */
-
-				ran -= cycles_stolen;
-				profiler_mark(PROFILER_END);
-
-				/* account for these cycles */
-				cpu[cpunum].totalcycles += ran;
-				cpu[cpunum].localtime = add_mame_times(cpu[cpunum].localtime, MAME_TIME_IN_CYCLES(ran, cpunum));
-				LOG(("         %d ran, %d total, time = %.9f\n", ran, (INT32)cpu[cpunum].totalcycles, mame_time_to_double(cpu[cpunum].localtime)));
+			/* AdvanceMAME: run the CPU before the parallel CPU at the same time of it */
+			if (cpunum + 1 == parallel_cpu && !cpu[parallel_cpu].suspend && cpuexec_parallel_timeslice(cpunum, &target, base))
+				break;
 
-				/* if the new local CPU time is less than our target, move the target up */
-				if (compare_mame_times(cpu[cpunum].localtime, target) < 0)
-				{
-					if (compare_mame_times(cpu[cpunum].localtime, base) > 0)
-						target = cpu[cpunum].localtime;
-					else
-						target = base;
-					LOG(("         (new target)\n"));
-				}
-			}
+			cpuexec_run(cpunum, &target, base);
 		}
 	}
 
@@ -565,6 +708,531 @@ void cpuexec_timeslice(void)
 
 
 
+/*************************************
+ *
+ *  AdvanceMAME: check if the last CPU
+ *  can run in parallel
+ *
+ *************************************/
+
+static void cpuexec_parallel_init(int totalcpu)
+{
+	int last = totalcpu - 1;
+	int cpunum, k;
+
+	if (totalcpu < 2 || !(Machine->drv->cpu[last].cpu_flags & CPU_PARALLEL))
+	{
+		logerror("cpu: no cpu declared to run in parallel\n");
+		return;
+	}
+
+#if !defined(USE_THREAD_LOCAL) || defined(MAME_DEBUG)
+	logerror("cpu: parallel execution not supported in this build\n");
+	return;
+#endif
+
+	/* the CPU cores keep the state of the executing CPU in static variables */
+	for (cpunum = 0; cpunum < last; cpunum++)
+		if (strcmp(cputype_core_file(Machine->drv->cpu[cpunum].cpu_type), cputype_core_file(Machine->drv->cpu[last].cpu_type)) == 0)
+		{
+			logerror("cpu: cpu #%d %s shares the core with cpu #%d, no parallel execution\n", last, cputype_name(Machine->drv->cpu[last].cpu_type), cpunum);
+			return;
+		}
+
+	for (k = 0; k < PARALLEL_CHUNKS; k++)
+	{
+		parallel_lock[k] = osd_lock_alloc();
+		if (!parallel_lock[k])
+		{
+			cpuexec_parallel_exit();
+			return;
+		}
+	}
+
+	parallel_cpu = last;
+	parallel_conflict = FALSE;
+
+	logerror("cpu: cpu #%d %s runs in parallel with cpu #%d %s\n", last, cputype_name(Machine->drv->cpu[last].cpu_type), last - 1, cputype_name(Machine->drv->cpu[last - 1].cpu_type));
+}
+
+
+static void cpuexec_parallel_exit(void)
+{
+	int k;
+
+	for (k = 0; k < PARALLEL_CHUNKS; k++)
+	{
+		if (parallel_lock[k])
+			osd_lock_free(parallel_lock[k]);
+		parallel_lock[k] = NULL;
+	}
+
+	parallel_cpu = -1;
+}
+
+
+
+/*************************************
+ *
+ *  AdvanceMAME: end the timeslice at
+ *  the time reached by a CPU, like
+ *  when it aborts the timeslice
+ *  running it in a single chunk
+ *
+ *************************************/
+
+INLINE void cpuexec_parallel_stop(int cpunum, mame_time *target, mame_time base)
+{
+	if (compare_mame_times(cpu[cpunum].localtime, *target) < 0)
+	{
+		if (compare_mame_times(cpu[cpunum].localtime, base) > 0)
+			*target = cpu[cpunum].localtime;
+		else
+			*target = base;
+	}
+}
+
+
+
+/*************************************
+ *
+ *  AdvanceMAME: run the parallel CPU
+ *  in a worker thread, every chunk
+ *  after the other CPU completes it
+ *
+ *************************************/
+
+static void cpuexec_parallel_run(void *arg)
+{
+	mame_time target = parallel_base;
+	int k;
+
+	/* nothing shared can be changed before the other CPU completes the timeslice */
+	cpuexec_parallel_pending = TRUE;
+
+	for (k = 0; k < PARALLEL_CHUNKS; k++)
+	{
+		/* wait the end of the chunk in the other CPU */
+		osd_trace_begin("CPU wait");
+		osd_lock_acquire(parallel_lock[k]);
+		osd_lock_release(parallel_lock[k]);
+		osd_trace_end();
+
+		/* stop if the timeslice was aborted, after waiting its end in the other CPU */
+		target = parallel_chunk_end[k];
+		if (cpuexec_run(parallel_cpu, &target, parallel_base))
+		{
+			target = parallel_chunk_end[PARALLEL_CHUNKS - 1];
+			cpuexec_parallel_stop(parallel_cpu, &target, parallel_base);
+			break;
+		}
+	}
+
+	parallel_target = target;
+
+	/* save the memory context for the main thread */
+	memory_set_context(-1);
+
+	cpuexec_parallel_pending = FALSE;
+}
+
+
+
+/*************************************
+ *
+ *  AdvanceMAME: wait the completion of
+ *  the timeslice in the other CPUs
+ *  before changing a shared state
+ *
+ *************************************/
+
+void cpuexec_parallel_wait(void)
+{
+	osd_trace_begin("CPU wait");
+	osd_lock_acquire(parallel_lock[PARALLEL_CHUNKS - 1]);
+	osd_lock_release(parallel_lock[PARALLEL_CHUNKS - 1]);
+	osd_trace_end();
+
+	cpuexec_parallel_pending = FALSE;
+}
+
+
+
+/*************************************
+ *
+ *  AdvanceMAME: report a change of a
+ *  state read directly by the parallel
+ *  CPU, done by the other CPUs in the
+ *  middle of the timeslice
+ *
+ *************************************/
+
+int cpuexec_parallel_conflict(int cpunum)
+{
+	if (cpunum >= 0 && cpunum != parallel_cpu)
+		return 0;
+
+	parallel_conflict = TRUE;
+	return 1;
+}
+
+
+
+/*************************************
+ *
+ *  AdvanceMAME: run in chunks the CPU
+ *  before the parallel CPU, with the
+ *  parallel CPU in a worker thread.
+ *  Return 0 if it isn't possible.
+ *
+ *************************************/
+
+static int cpuexec_parallel_timeslice(int cpunum, mame_time *target, mame_time base)
+{
+	osd_work_item *item;
+	mame_time start = cpu[cpunum].localtime;
+	subseconds_t length;
+	int k;
+
+	/* the timeslices longer than a second don't happen when running */
+	if (target->seconds != start.seconds || compare_mame_times(start, *target) >= 0)
+		return 0;
+	length = target->subseconds - start.subseconds;
+
+	for (k = 0; k < PARALLEL_CHUNKS; k++)
+	{
+		osd_lock_acquire(parallel_lock[k]);
+		parallel_chunk_end[k].seconds = start.seconds;
+		parallel_chunk_end[k].subseconds = start.subseconds + length / PARALLEL_CHUNKS * (k + 1);
+	}
+	parallel_chunk_end[PARALLEL_CHUNKS - 1] = *target;
+	parallel_base = base;
+
+	/* hand over the memory context of the parallel CPU to the worker thread */
+	memory_set_context(-1);
+	memory_set_parallel_cpu(parallel_cpu);
+
+	item = osd_work_item_queue(cpuexec_parallel_run, NULL);
+	if (!item)
+	{
+		memory_set_parallel_cpu(-1);
+		for (k = 0; k < PARALLEL_CHUNKS; k++)
+			osd_lock_release(parallel_lock[k]);
+		return 0;
+	}
+
+	cpuexec_parallel_active = TRUE;
+
+	for (k = 0; k < PARALLEL_CHUNKS; k++)
+	{
+		/* the parallel CPU runs until the time reached, or stops with it if aborted */
+		int aborted = cpuexec_run(cpunum, &parallel_chunk_end[k], base);
+
+		if (aborted || k == PARALLEL_CHUNKS - 1)
+		{
+			if (aborted)
+				cpuexec_parallel_stop(cpunum, target, base);
+			else
+				*target = parallel_chunk_end[k];
+			for (; k < PARALLEL_CHUNKS; k++)
+			{
+				parallel_chunk_end[k] = *target;
+				osd_lock_release(parallel_lock[k]);
+			}
+			break;
+		}
+
+		osd_lock_release(parallel_lock[k]);
+	}
+
+	cpuexec_parallel_active = FALSE;
+
+	osd_trace_begin("CPU wait");
+	osd_work_item_wait(item);
+	osd_trace_end();
+
+	memory_set_parallel_cpu(-1);
+
+	/* the parallel CPU may have read a state before a change that serially happens before */
+	if (parallel_conflict)
+	{
+		logerror("cpu: cpu #%d changed a state read by the parallel cpu #%d, the next timeslices are serial\n", cpunum, parallel_cpu);
+		cpuexec_parallel_exit();
+	}
+
+	/* the parallel CPU may have aborted the timeslice */
+	if (compare_mame_times(parallel_target, *target) < 0)
+		*target = parallel_target;
+
+	return 1;
+}
+
+
+
+/*************************************
+ *
+ *  AdvanceMAME: prepare the detection
+ *  of the idle loops
+ *
+ *************************************/
+
+static void cpuexec_idle_init(int totalcpu)
+{
+	int cpunum;
+	size_t i;
+
+#ifdef MAME_DEBUG
+	logerror("cpu: idle loop detection not supported in this build\n");
+	return;
+#endif
+
+	/* the memory shared with the parallel CPU may change in the middle of a loop */
+	if (parallel_cpu >= 0)
+	{
+		logerror("cpu: idle loop detection disabled by the parallel execution\n");
+		return;
+	}
+
+	for (cpunum = 0; cpunum < totalcpu; cpunum++)
+	{
+		cpuexec_idle *idle = &idle_data[cpunum];
+
+		memset(idle, 0, sizeof(*idle));
+		idle->pc = ~0;
+		idle->loop_first = ~0;
+		idle->loop_last = 0;
+
+		/* the driver knows that the idle loops of the CPU can't be skipped */
+		if (Machine->drv->cpu[cpunum].cpu_flags & CPU_NO_IDLESKIP)
+		{
+			logerror("cpu: cpu #%d idle loop detection disabled by the driver\n", cpunum);
+			continue;
+		}
+
+		idle->size = cpunum_context_size(cpunum);
+		if (idle->size == 0)
+			continue;
+
+		/* the buffers are cleared to compare also the padding of the contexts */
+		idle->context = auto_malloc(idle->size);
+		idle->current = auto_malloc(idle->size);
+		idle->mask = auto_malloc(idle->size);
+		memset(idle->context, 0, idle->size);
+		memset(idle->current, 0, idle->size);
+		memset(idle->mask, 0, idle->size);
+
+		/* find the bytes of the context changed by the refresh register */
+		idle->refresh = cpunum_get_info_int(cpunum, CPUINFO_INT_REFRESH_REGISTER);
+		if (idle->refresh)
+		{
+			cpunum_get_context(cpunum, idle->context);
+			cpunum_set_reg(cpunum, idle->refresh, 0x00);
+			cpunum_get_context(cpunum, idle->current);
+			cpunum_set_reg(cpunum, idle->refresh, 0xff);
+			cpunum_get_context(cpunum, idle->mask);
+			cpunum_set_context(cpunum, idle->context);
+
+			for (i = 0; i < idle->size; i++)
+				idle->mask[i] = idle->current[i] != idle->mask[i];
+		}
+	}
+
+	idle_enabled = TRUE;
+
+	logerror("cpu: idle loop detection enabled\n");
+}
+
+
+static void cpuexec_idle_exit(void)
+{
+	int cpunum;
+
+	if (!idle_enabled)
+		return;
+
+	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+		if (cpu[cpunum].totalcycles != 0)
+			logerror("cpu: cpu #%d skipped %.1f%% of the cycles in idle loops\n", cpunum, 100.0 * (double)idle_data[cpunum].skipped / (double)cpu[cpunum].totalcycles);
+
+	idle_enabled = FALSE;
+}
+
+
+
+/*************************************
+ *
+ *  AdvanceMAME: log an idle loop the
+ *  first time it's found
+ *
+ *************************************/
+
+static void cpuexec_idle_log(int cpunum, offs_t first, offs_t last, int instructions, int flags, offs_t address)
+{
+	cpuexec_idle *idle = &idle_data[cpunum];
+	int i;
+
+	for (i = 0; i < idle->logged; i++)
+		if (idle->log[i] == first)
+			return;
+	if (idle->logged == IDLE_LOGGED)
+		return;
+	idle->log[idle->logged++] = first;
+
+	if (flags & MEMORY_WATCH_READ)
+		logerror("cpu: cpu #%d idle loop at %X-%X, %d instructions in %d cycles, reading %X\n", cpunum, first, last, instructions, idle->loop_cycles, address);
+	else
+		logerror("cpu: cpu #%d idle loop at %X-%X, %d instructions in %d cycles, without reads\n", cpunum, first, last, instructions, idle->loop_cycles);
+}
+
+
+
+/*************************************
+ *
+ *  AdvanceMAME: check if a CPU is in
+ *  an idle loop, and skip its next
+ *  iterations
+ *
+ *  A loop is idle if an iteration only
+ *  reads memory, without handlers, and
+ *  leaves the CPU context unchanged.
+ *  Until the end of the timeslice
+ *  nothing else can change the memory
+ *  read, so all the next iterations
+ *  are the same, and they are skipped
+ *  advancing the time of the CPU. The
+ *  last one is left to run, to end the
+ *  timeslice at the same instruction.
+ *
+ *************************************/
+
+static int cpuexec_idle_skip(int cpunum, int cycles)
+{
+	cpuexec_idle *idle = &idle_data[cpunum];
+	offs_t start, pc, first, last, distance, address;
+	int ran, loop, steps, flags, skip, found;
+	size_t i;
+
+	start = cpunum_get_reg(cpunum, REG_PC);
+	distance = start > idle->pc ? start - idle->pc : idle->pc - start;
+	idle->pc = start;
+
+	/* check only a CPU in the last idle loop found, or near the PC of the previous check, */
+	/* and with the cycles to skip at least an iteration */
+	if ((start < idle->loop_first || start > idle->loop_last) && distance >= IDLE_BYTES)
+		return 0;
+	if (cycles <= 2 * idle->loop_cycles)
+		return 0;
+
+	cpunum_get_context(cpunum, idle->context);
+
+	/* run one iteration an instruction at time, watching the memory accesses */
+	first = last = start;
+	ran = 0;
+	memory_watch_start();
+	for (steps = 1; ; steps++)
+	{
+		ran += cpuexec_execute(cpunum, 1);
+		pc = cpunum_get_reg(cpunum, REG_PC);
+		if (pc == start || steps == IDLE_INSTRUCTIONS || ran >= cycles || cycles_aborted)
+			break;
+		if (pc < first)
+			first = pc;
+		if (pc > last)
+			last = pc;
+	}
+	flags = memory_watch_stop(&address);
+	loop = ran;
+
+	/* the end of the timeslice cut the iteration */
+	if (ran >= cycles || cycles_aborted)
+		return ran;
+
+	/* it must be a complete iteration reading only memory, and the context, */
+	/* except the refresh register, must be the same */
+	found = pc == start && (flags & ~MEMORY_WATCH_READ) == 0;
+	if (found)
+	{
+		cpunum_get_context(cpunum, idle->current);
+		for (i = 0; i < idle->size && found; i++)
+			if (idle->context[i] != idle->current[i] && !idle->mask[i])
+				found = FALSE;
+	}
+
+	if (!found)
+	{
+		idle->loop_first = ~0;
+		idle->loop_last = 0;
+		idle->loop_cycles = 0;
+		return ran;
+	}
+
+	idle->loop_first = first;
+	idle->loop_last = last;
+	idle->loop_cycles = loop;
+	idle->found = TRUE;
+	cpuexec_idle_log(cpunum, first, last, steps, flags, address);
+
+	/* skip the iterations, leaving at least a cycle to run the last one */
+	skip = (cycles - ran - 1) / loop;
+	if (skip > 0)
+	{
+		/* advance the refresh register as in the iterations skipped */
+		if (idle->refresh)
+		{
+			for (i = 0; i < idle->size; i++)
+				if (idle->mask[i])
+					idle->current[i] += skip * (UINT8)(idle->current[i] - idle->context[i]);
+			cpunum_set_context(cpunum, idle->current);
+		}
+
+		skip *= loop;
+		cpu[cpunum].totalcycles += skip;
+		cpu[cpunum].localtime = add_mame_times(cpu[cpunum].localtime, MAME_TIME_IN_CYCLES(skip, cpunum));
+		idle->skipped += skip;
+		ran += skip;
+	}
+
+	return ran;
+}
+
+
+
+/*************************************
+ *
+ *  AdvanceMAME: execute a CPU looking
+ *  for the idle loops at the start of
+ *  the timeslice, and also in the
+ *  middle if the CPU already idled
+ *
+ *************************************/
+
+static int cpuexec_idle_execute(int cpunum, int cycles)
+{
+	cpuexec_idle *idle = &idle_data[cpunum];
+	int ran, chunk;
+
+	if (idle->size == 0)
+		return cpuexec_execute(cpunum, cycles);
+
+	chunk = idle->found ? (cycles + IDLE_CHUNKS - 1) / IDLE_CHUNKS : cycles;
+
+	ran = 0;
+	while (1)
+	{
+		ran += cpuexec_idle_skip(cpunum, cycles - ran);
+		if (ran >= cycles || cycles_aborted)
+			break;
+
+		ran += cpuexec_execute(cpunum, MIN(chunk, cycles - ran));
+		if (ran >= cycles || cycles_aborted)
+			break;
+	}
+
+	return ran;
+}
+
+
+
 /*************************************
  *
  *  Abort the timeslice for the
@@ -579,6 +1247,10 @@ void activecpu_abort_timeslice(void)
 	VERIFY_EXECUTINGCPU(activecpu_abort_timeslice);
 	LOG(("activecpu_abort_timeslice (CPU=%d, cycles_left=%d)\n", cpu_getexecutingcpu(), activecpu_get_icount() + 1));
 
+	/* AdvanceMAME: the end of the timeslice is shared with the CPUs running in parallel */
+	cpuexec_serialize();
+	cycles_aborted = TRUE;
+
 	/* swallow the remaining cycles */
 	current_icount = activecpu_get_icount() + 1;
 	cycles_stolen += current_icount;
@@ -624,6 +1296,7 @@ mame_time cpunum_get_localtime(int cpunum)
 void cpunum_suspend(int cpunum, int reason, int eatcycles)
 {
 	VERIFY_CPUNUM(cpunum_suspend);
+	cpuexec_serialize();
 	LOG(("cpunum_suspend (CPU=%d, r=%X, eat=%d)\n", cpunum, reason, eatcycles));
 
 	/* set the pending suspend bits, and force a resync */
@@ -645,6 +1318,7 @@ void cpunum_suspend(int cpunum, int reason, int eatcycles)
 void cpunum_resume(int cpunum, int reason)
 {
 	VERIFY_CPUNUM(cpunum_resume);
+	cpuexec_serialize();
 	LOG(("cpunum_resume (CPU=%d, r=%X)\n", cpunum, reason));
 
 	/* clear the pending suspend bits, and force a resync */
@@ -693,6 +1367,7 @@ int cpunum_get_clock(int cpunum)
 void cpunum_set_clock(int cpunum, int clock)
 {
 	VERIFY_CPUNUM(cpunum_set_clock);
+	cpuexec_serialize_state(cpunum);
 
 	cpu[cpunum].clock = clock;
 	sec_to_cycles[cpunum] = (double)clock * cpu[cpunum].clockscale;
@@ -709,6 +1384,7 @@ void cpunum_set_clock(int cpunum, int clock)
 void cpunum_set_clock_period(int cpunum, subseconds_t clock_period)
 {
 	VERIFY_CPUNUM(cpunum_set_clock);
+	cpuexec_serialize_state(cpunum);
 
 	cpu[cpunum].clock = MAX_SUBSECONDS / clock_period;
 	sec_to_cycles[cpunum] = (double) (MAX_SUBSECONDS / clock_period) * cpu[cpunum].clockscale;
@@ -747,6 +1423,7 @@ double cpunum_get_clockscale(int cpunum)
 void cpunum_set_clockscale(int cpunum, double clockscale)
 {
 	VERIFY_CPUNUM(cpunum_set_clockscale);
+	cpuexec_serialize_state(cpunum);
 
 	cpu[cpunum].clockscale = clockscale;
 	sec_to_cycles[cpunum] = (double)cpu[cpunum].clock * clockscale;
@@ -1135,6 +1812,8 @@ void cpu_trigger(int trigger)
 {
 	int cpunum;
 
+	cpuexec_serialize();
+
 	/* cause an immediate resynchronization */
 	if (cpu_getexecutingcpu() >= 0)
 		activecpu_abort_timeslice();
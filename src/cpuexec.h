@@ -50,7 +50,17 @@ enum
 {
 	/* set this flag to disable execution of a CPU (if one is there for documentation */
 	/* purposes only, for example */
-	CPU_DISABLE = 0x0001
+	CPU_DISABLE = 0x0001,
+
+	/* AdvanceMAME: set this flag on the last CPU if it interacts with the other CPUs */
+	/* only through latches, interrupts and timers, and the other CPUs never access */
+	/* its memory and its devices. With the misc_cpuparallel option it runs in */
+	/* another thread at the same time of the CPU before it */
+	CPU_PARALLEL = 0x0002,
+
+	/* AdvanceMAME: set this flag to never skip the idle loops of a CPU, for example */
+	/* if it polls a memory changed by something else than the CPUs, like a DMA */
+	CPU_NO_IDLESKIP = 0x0004
 };
 
 
@@ -68,6 +78,39 @@ int cpuexec_init(void);
 /* Execute for a single timeslice */
 void cpuexec_timeslice(void);
 
+/* AdvanceMAME: wait until the CPUs running before the parallel CPU are done */
+void cpuexec_parallel_wait(void);
+
+/* AdvanceMAME: report a change of a state read by the parallel CPU */
+int cpuexec_parallel_conflict(int cpunum);
+
+/* AdvanceMAME: call before changing the state shared by the CPUs, like the */
+/* timers, the interrupts and the banks. If the executing CPU is running in */
+/* parallel, it waits for the other CPUs to keep the same order of the serial case. */
+/* The other CPUs don't wait, but their changes of the timers and of the */
+/* input lines are applied by the scheduler between the timeslices */
+INLINE void cpuexec_serialize(void)
+{
+	extern THREAD_LOCAL int cpuexec_parallel_pending;
+	if (cpuexec_parallel_pending)
+		cpuexec_parallel_wait();
+}
+
+/* AdvanceMAME: call before changing a state that the parallel CPU reads */
+/* directly, like the banks, the handlers, its clock and its vectors. */
+/* The parallel CPU may have already read the old state in the timeslice, */
+/* when serially it would read the new one, so the next timeslices run */
+/* serially. The cpunum is the CPU affected, or -1 for all. */
+/* Return nonzero if the change happens while the parallel CPU is running */
+INLINE int cpuexec_serialize_state(int cpunum)
+{
+	extern THREAD_LOCAL int cpuexec_parallel_active;
+	cpuexec_serialize();
+	if (cpuexec_parallel_active)
+		return cpuexec_parallel_conflict(cpunum);
+	return 0;
+}
+
 
 
 /*************************************
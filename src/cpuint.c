@@ -284,6 +284,9 @@ void cpunum_set_input_line(int cpunum, int line, int state)
 
 void cpunum_set_input_line_vector(int cpunum, int line, int vector)
 {
+	/* AdvanceMAME: the vectors are read by the CPU running in parallel when interrupted */
+	cpuexec_serialize_state(cpunum);
+
 	if (cpunum < cpu_gettotalcpu() && line >= 0 && line < MAX_INPUT_LINES)
 	{
 		LOG(("cpunum_set_input_line_vector(%d,%d,$%04x)\n",cpunum,line,vector));
@@ -296,6 +299,9 @@ void cpunum_set_input_line_vector(int cpunum, int line, int vector)
 
 void cpunum_set_input_line_and_vector(int cpunum, int line, int state, int vector)
 {
+	/* AdvanceMAME: the input lines are shared with the CPUs running in parallel */
+	cpuexec_serialize();
+
 	if (line >= 0 && line < MAX_INPUT_LINES)
 	{
 		INT32 input_event = (state & 0xff) | (vector << 8);
@@ -304,6 +310,14 @@ void cpunum_set_input_line_and_vector(int cpunum, int line, int state, int vecto
 		LOG(("cpunum_set_input_line_and_vector(%d,%d,%d,%02x)\n", cpunum, line, state, vector));
 
 		/* if we're full of events, flush the queue and log a message */
+		/* AdvanceMAME: the CPU running in parallel can't be interrupted directly, */
+		/* and the event is lost */
+		if (event_index >= MAX_INPUT_EVENTS && cpuexec_serialize_state(cpunum))
+		{
+			input_event_index[cpunum][line]--;
+			logerror("Exceeded pending input line event queue on CPU %d!\n", cpunum);
+			return;
+		}
 		if (event_index >= MAX_INPUT_EVENTS)
 		{
 			input_event_index[cpunum][line]--;
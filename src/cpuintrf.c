@@ -753,15 +753,16 @@ UINT8 default_win_layout[] =
  *
  *************************************/
 
-int activecpu;		/* index of active CPU (or -1) */
-int executingcpu;	/* index of executing CPU (or -1) */
+/* AdvanceMAME: the active and executing CPUs are private of every thread */
+THREAD_LOCAL int activecpu = -1;	/* index of active CPU (or -1) */
+THREAD_LOCAL int executingcpu = -1;	/* index of executing CPU (or -1) */
 int totalcpu;		/* total number of CPUs */
 
 static cpuintrf_data cpu[MAX_CPU];
 
 static int cpu_active_context[CPU_COUNT];
-static int cpu_context_stack[4];
-static int cpu_context_stack_ptr;
+static THREAD_LOCAL int cpu_context_stack[4];
+static THREAD_LOCAL int cpu_context_stack_ptr;
 
 static unsigned (*cpu_dasm_override)(int cpunum, char *buffer, unsigned pc);
 
@@ -782,6 +783,19 @@ INLINE void set_cpu_context(int cpunum)
 	int newfamily = cpu[cpunum].family;
 	int oldcontext = cpu_active_context[newfamily];
 
+	/* AdvanceMAME: if the core works directly on the context buffers, just select the new one */
+	if (cpu[cpunum].intf.select_context)
+	{
+		activecpu = cpunum;
+		memory_set_context(cpunum);
+		if (oldcontext != cpunum)
+		{
+			(*cpu[cpunum].intf.select_context)(cpu[cpunum].context);
+			cpu_active_context[newfamily] = cpunum;
+		}
+		return;
+	}
+
 	/* if we need to change contexts, save the one that was there */
 	if (oldcontext != cpunum && oldcontext != -1)
 		(*cpu[oldcontext].intf.get_context)(cpu[oldcontext].context);
@@ -886,6 +900,10 @@ void cpuintrf_init(void)
 		(*intf->get_info)(CPUINFO_PTR_SET_CONTEXT, &info);
 		intf->set_context = info.setcontext;
 
+		info.selectcontext = NULL;
+		(*intf->get_info)(CPUINFO_PTR_SELECT_CONTEXT, &info);
+		intf->select_context = info.selectcontext;
+
 		info.init = NULL;
 		(*intf->get_info)(CPUINFO_PTR_INIT, &info);
 		intf->init = info.init;
@@ -1007,8 +1025,19 @@ int cpuintrf_init_cpu(int cpunum, int cputype, int clock, const void *config, in
 
 	/* initialize the CPU and stash the context */
 	activecpu = cpunum;
-	(*cpu[cpunum].intf.init)(cpunum, clock, config, irqcallback);
-	(*cpu[cpunum].intf.get_context)(cpu[cpunum].context);
+	if (cpu[cpunum].intf.select_context)
+	{
+		/* AdvanceMAME: initialize directly the context of the CPU, the memory */
+		/* context is required because selecting it updates the opcode base */
+		memory_set_context(cpunum);
+		(*cpu[cpunum].intf.select_context)(cpu[cpunum].context);
+		(*cpu[cpunum].intf.init)(cpunum, clock, config, irqcallback);
+	}
+	else
+	{
+		(*cpu[cpunum].intf.init)(cpunum, clock, config, irqcallback);
+		(*cpu[cpunum].intf.get_context)(cpu[cpunum].context);
+	}
 	activecpu = -1;
 
 	/* clear out the registered CPU for this family */
@@ -1038,6 +1067,70 @@ void cpuintrf_exit_cpu(int cpunum)
 
 
 
+/*************************************
+ *
+ *  AdvanceMAME: measure the speed of
+ *  the context switches
+ *
+ *************************************/
+
+#define BENCHMARK_SWITCHES	1000000
+
+void cpuintrf_benchmark(void)
+{
+	int cpunum, i;
+
+	for (cpunum = 0; cpunum < totalcpu; cpunum++)
+	{
+		cpu_interface *intf = &cpu[cpunum].intf;
+		double copy, select = 0;
+		cycles_t start, stop;
+		void *buffer;
+
+		buffer = malloc(intf->context_size);
+		if (!buffer)
+			continue;
+
+		cpuintrf_push_context(cpunum);
+
+		/* save and restore the context with a copy */
+		start = osd_cycles();
+		for (i = 0; i < BENCHMARK_SWITCHES; i++)
+		{
+			memory_set_context(cpunum);
+			(*intf->get_context)(buffer);
+			(*intf->set_context)(buffer);
+		}
+		stop = osd_cycles();
+		copy = (double)BENCHMARK_SWITCHES * osd_cycles_per_second() / (stop - start);
+
+		/* select the context buffer */
+		if (intf->select_context)
+		{
+			start = osd_cycles();
+			for (i = 0; i < BENCHMARK_SWITCHES; i++)
+			{
+				memory_set_context(cpunum);
+				(*intf->select_context)(cpu[cpunum].context);
+			}
+			stop = osd_cycles();
+			select = (double)BENCHMARK_SWITCHES * osd_cycles_per_second() / (stop - start);
+		}
+
+		cpuintrf_pop_context();
+		free(buffer);
+
+		if (intf->select_context)
+			logerror("cpu: cpu #%d %s, %.1f Mswitches/s copying %d bytes of context, %.1f Mswitches/s selecting the context, %.2fx\n",
+				cpunum, cputype_name(cpu[cpunum].cputype), copy / 1E6, (int)intf->context_size, select / 1E6, select / copy);
+		else
+			logerror("cpu: cpu #%d %s, %.1f Mswitches/s copying %d bytes of context\n",
+				cpunum, cputype_name(cpu[cpunum].cputype), copy / 1E6, (int)intf->context_size);
+	}
+}
+
+
+
 /*************************************
  *
  *  Interfaces to the active CPU
@@ -1513,6 +1606,30 @@ void *cpunum_get_context_ptr(int cpunum)
 }
 
 
+/*--------------------------
+    AdvanceMAME: copy the
+    context in a buffer, and
+    restore it
+--------------------------*/
+
+void cpunum_get_context(int cpunum, void *buffer)
+{
+	VERIFY_CPUNUM(cpunum_get_context);
+	cpuintrf_push_context(cpunum);
+	(*cpu[cpunum].intf.get_context)(buffer);
+	cpuintrf_pop_context();
+}
+
+
+void cpunum_set_context(int cpunum, void *buffer)
+{
+	VERIFY_CPUNUM(cpunum_set_context);
+	cpuintrf_push_context(cpunum);
+	(*cpu[cpunum].intf.set_context)(buffer);
+	cpuintrf_pop_context();
+}
+
+
 /*--------------------------
     Get/set PC
 --------------------------*/
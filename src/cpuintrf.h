@@ -278,6 +278,7 @@ enum
 	CPUINFO_INT_LOGADDR_WIDTH_LAST = CPUINFO_INT_LOGADDR_WIDTH + ADDRESS_SPACES - 1,
 	CPUINFO_INT_PAGE_SHIFT,								/* R/O: size of a page log 2 (i.e., 12=4096), or 0 if paging not supported */
 	CPUINFO_INT_PAGE_SHIFT_LAST = CPUINFO_INT_PAGE_SHIFT + ADDRESS_SPACES - 1,
+	CPUINFO_INT_REFRESH_REGISTER,						/* R/O: AdvanceMAME: 8-bit register incremented by every instruction, like the Z80 R, or 0 */
 
 	CPUINFO_INT_SP,										/* R/W: the current stack pointer value */
 	CPUINFO_INT_PC,										/* R/W: the current PC value */
@@ -315,6 +316,7 @@ enum
 	CPUINFO_PTR_INTERNAL_MEMORY_MAP,					/* R/O: construct_map_t map */
 	CPUINFO_PTR_INTERNAL_MEMORY_MAP_LAST = CPUINFO_PTR_INTERNAL_MEMORY_MAP + ADDRESS_SPACES - 1,
 	CPUINFO_PTR_DEBUG_REGISTER_LIST,					/* R/O: int *list: list of registers for NEW_DEBUGGER */
+	CPUINFO_PTR_SELECT_CONTEXT,							/* R/O: void (*select_context)(void *buffer), AdvanceMAME: work directly on the buffer */
 
 	CPUINFO_PTR_CPU_SPECIFIC = 0x18000,					/* R/W: CPU-specific values start here */
 
@@ -358,6 +360,7 @@ union cpuinfo
 	void	(*setup_commands)(void);					/* CPUINFO_PTR_DEBUG_SETUP_COMMANDS */
 	int *	icount;										/* CPUINFO_PTR_INSTRUCTION_COUNTER */
 	construct_map_t internal_map;						/* CPUINFO_PTR_INTERNAL_MEMORY_MAP */
+	void	(*selectcontext)(void *context);			/* CPUINFO_PTR_SELECT_CONTEXT */
 };
 
 
@@ -411,6 +414,7 @@ struct _cpu_interface
 	void		(*set_info)(UINT32 state, union cpuinfo *info);
 	void		(*get_context)(void *buffer);
 	void		(*set_context)(void *buffer);
+	void		(*select_context)(void *buffer);
 	void		(*init)(int index, int clock, const void *config, int (*irqcallback)(int));
 	void		(*reset)(void);
 	void		(*exit)(void);
@@ -450,6 +454,9 @@ void cpuintrf_push_context(int cpunum);
 /* restore the previous context */
 void cpuintrf_pop_context(void);
 
+/* AdvanceMAME: measure the speed of the context switches */
+void cpuintrf_benchmark(void);
+
 /* circular string buffer */
 char *cpuintrf_temp_str(void);
 
@@ -565,6 +572,10 @@ void cpunum_write_byte(int cpunum, offs_t address, UINT8 data);
    context is active (and contained within the CPU core */
 void *cpunum_get_context_ptr(int cpunum);
 
+/* AdvanceMAME: copy the context of a given CPU in a buffer, and restore it */
+void cpunum_get_context(int cpunum, void *buffer);
+void cpunum_set_context(int cpunum, void *buffer);
+
 /* return the PC, corrected to a byte offset, on a given CPU */
 offs_t cpunum_get_physical_pc_byte(int cpunum);
 
@@ -687,7 +698,7 @@ INLINE const cpu_interface *cputype_get_interface(int cputype)
 /* return a the index of the active CPU */
 INLINE int cpu_getactivecpu(void)
 {
-	extern int activecpu;
+	extern THREAD_LOCAL int activecpu;
 	return activecpu;
 }
 
@@ -695,7 +706,7 @@ INLINE int cpu_getactivecpu(void)
 /* return a the index of the executing CPU */
 INLINE int cpu_getexecutingcpu(void)
 {
-	extern int executingcpu;
+	extern THREAD_LOCAL int executingcpu;
 	return executingcpu;
 }
 
@@ -0,0 +1,318 @@
+/***************************************************************************
+
+    AdvanceMAME test boards
+
+    Synthetic boards used to check the changes of the emulation core. The
+    programs are stored by the driver init, and no ROM is needed.
+
+    idletest
+        A Z80 main CPU and a M6809 sound CPU communicating with latches.
+        Both wait their interrupts polling a RAM flag, and they are used
+        to check the idle loop detection. The state hashes saved with
+        -debug_statehash must be the same with and without
+        -misc_idleskip.
+
+    partest
+        The same CPUs, with the M6809 declared to run in parallel. The
+        CPUs never wait, and the M6809 reads and writes the latches at
+        every iteration. The state hashes saved with -debug_statehash
+        must be the same with and without -misc_cpuparallel.
+        The M6809 also writes two DACs, generated by different workers
+        with -misc_soundparallel, and the sound hash must be the same
+        with and without it.
+
+***************************************************************************/
+
+#include "driver.h"
+#include "sound/dac.h"
+
+
+/*************************************
+ *
+ *  Programs
+ *
+ *************************************/
+
+static const UINT8 idletest_main_program[] =
+{
+	0xf3,				/* 0000: di */
+	0x31,0xf0,0xff,		/* 0001: ld   sp,$fff0 */
+	0xed,0x56,			/* 0004: im   1 */
+	0xfb,				/* 0006: ei */
+	0x21,0x00,0xc0,		/* 0007: ld   hl,$c000 */
+	0x06,0xc8,			/* 000a: ld   b,200 */
+	0x34,				/* 000c: inc  (hl) */
+	0x23,				/* 000d: inc  hl */
+	0x10,0xfc,			/* 000e: djnz $000c */
+	0x3a,0x01,0x80,		/* 0010: ld   a,($8001) */
+	0x32,0x01,0xc1,		/* 0013: ld   ($c101),a */
+	0x3a,0x00,0xc1,		/* 0016: ld   a,($c100) */
+	0x3c,				/* 0019: inc  a */
+	0x32,0x00,0xc1,		/* 001a: ld   ($c100),a */
+	0x32,0x00,0x80,		/* 001d: ld   ($8000),a */
+	0xaf,				/* 0020: xor  a */
+	0x32,0x03,0xc1,		/* 0021: ld   ($c103),a */
+	0x3a,0x03,0xc1,		/* 0024: ld   a,($c103)    idle loop */
+	0xb7,				/* 0027: or   a */
+	0x28,0xfa,			/* 0028: jr   z,$0024 */
+	0xc3,0x07,0x00		/* 002a: jp   $0007 */
+};
+
+static const UINT8 idletest_main_irq[] =
+{
+	0xf5,				/* 0038: push af */
+	0x3e,0x01,			/* 0039: ld   a,1 */
+	0x32,0x03,0xc1,		/* 003b: ld   ($c103),a */
+	0x3a,0x02,0xc1,		/* 003e: ld   a,($c102) */
+	0x3c,				/* 0041: inc  a */
+	0x32,0x02,0xc1,		/* 0042: ld   ($c102),a */
+	0xf1,				/* 0045: pop  af */
+	0xfb,				/* 0046: ei */
+	0xed,0x4d			/* 0047: reti */
+};
+
+static const UINT8 idletest_sound_program[] =
+{
+	0x10,0xce,0x0f,0x00,	/* f000: lds  #$0f00 */
+	0x1c,0xef,			/* f004: andcc #$ef */
+	0x7f,0x02,0x03,		/* f006: clr  $0203 */
+	0xb6,0x02,0x03,		/* f009: lda  $0203        idle loop */
+	0x27,0xfb,			/* f00c: beq  $f009 */
+	0xb6,0x10,0x00,		/* f00e: lda  $1000 */
+	0xbb,0x02,0x00,		/* f011: adda $0200 */
+	0xb7,0x02,0x00,		/* f014: sta  $0200 */
+	0xb7,0x20,0x00,		/* f017: sta  $2000 */
+	0xb7,0x30,0x00,		/* f01a: sta  $3000 */
+	0x7e,0xf0,0x06		/* f01d: jmp  $f006 */
+};
+
+static const UINT8 idletest_sound_irq[] =
+{
+	0x7c,0x02,0x02,		/* f100: inc  $0202 */
+	0x86,0x01,			/* f103: lda  #1 */
+	0xb7,0x02,0x03,		/* f105: sta  $0203 */
+	0x3b				/* f108: rti */
+};
+
+
+static const UINT8 partest_main_program[] =
+{
+	0xf3,				/* 0000: di */
+	0x31,0xf0,0xff,		/* 0001: ld   sp,$fff0 */
+	0xed,0x56,			/* 0004: im   1 */
+	0xfb,				/* 0006: ei */
+	0x21,0x00,0xc0,		/* 0007: ld   hl,$c000 */
+	0x06,0xc8,			/* 000a: ld   b,200 */
+	0x34,				/* 000c: inc  (hl) */
+	0x23,				/* 000d: inc  hl */
+	0x10,0xfc,			/* 000e: djnz $000c */
+	0x3a,0x01,0x80,		/* 0010: ld   a,($8001) */
+	0x32,0x01,0xc1,		/* 0013: ld   ($c101),a */
+	0x18,0xef			/* 0016: jr   $0007 */
+};
+
+static const UINT8 partest_main_irq[] =
+{
+	0xf5,				/* 0038: push af */
+	0x3a,0x02,0xc1,		/* 0039: ld   a,($c102) */
+	0x3c,				/* 003c: inc  a */
+	0x32,0x02,0xc1,		/* 003d: ld   ($c102),a */
+	0x32,0x00,0x80,		/* 0040: ld   ($8000),a */
+	0xf1,				/* 0043: pop  af */
+	0xfb,				/* 0044: ei */
+	0xed,0x4d			/* 0045: reti */
+};
+
+static const UINT8 partest_sound_program[] =
+{
+	0x10,0xce,0x0f,0x00,	/* f000: lds  #$0f00 */
+	0x1c,0xef,			/* f004: andcc #$ef */
+	0x8e,0x00,0x00,		/* f006: ldx  #$0000 */
+	0x6c,0x80,			/* f009: inc  ,x+ */
+	0x8c,0x01,0x00,		/* f00b: cmpx #$0100 */
+	0x26,0xf9,			/* f00e: bne  $f009 */
+	0xb6,0x10,0x00,		/* f010: lda  $1000 */
+	0xbb,0x02,0x00,		/* f013: adda $0200 */
+	0xb7,0x02,0x00,		/* f016: sta  $0200 */
+	0xb7,0x20,0x00,		/* f019: sta  $2000 */
+	0xb7,0x30,0x00,		/* f01c: sta  $3000 */
+	0x43,				/* f01f: coma */
+	0xb7,0x20,0x01,		/* f020: sta  $2001 */
+	0x7e,0xf0,0x06		/* f023: jmp  $f006 */
+};
+
+static const UINT8 partest_sound_irq[] =
+{
+	0x7c,0x02,0x02,		/* f100: inc  $0202 */
+	0x3b				/* f103: rti */
+};
+
+
+static void advtest_init(const UINT8 *main_program, size_t main_size, const UINT8 *main_irq, size_t main_irq_size,
+	const UINT8 *sound_program, size_t sound_size, const UINT8 *sound_irq, size_t sound_irq_size)
+{
+	UINT8 *main = memory_region(REGION_CPU1);
+	UINT8 *sound = memory_region(REGION_CPU2);
+
+	memcpy(main + 0x0000, main_program, main_size);
+	memcpy(main + 0x0038, main_irq, main_irq_size);
+
+	memcpy(sound + 0xf000, sound_program, sound_size);
+	memcpy(sound + 0xf100, sound_irq, sound_irq_size);
+	sound[0xfff8] = 0xf1; sound[0xfff9] = 0x00;	/* IRQ vector */
+	sound[0xfffe] = 0xf0; sound[0xffff] = 0x00;	/* reset vector */
+}
+
+
+static DRIVER_INIT( idletest )
+{
+	advtest_init(idletest_main_program, sizeof(idletest_main_program), idletest_main_irq, sizeof(idletest_main_irq),
+		idletest_sound_program, sizeof(idletest_sound_program), idletest_sound_irq, sizeof(idletest_sound_irq));
+}
+
+
+static DRIVER_INIT( partest )
+{
+	advtest_init(partest_main_program, sizeof(partest_main_program), partest_main_irq, sizeof(partest_main_irq),
+		partest_sound_program, sizeof(partest_sound_program), partest_sound_irq, sizeof(partest_sound_irq));
+}
+
+
+
+/*************************************
+ *
+ *  Memory maps
+ *
+ *************************************/
+
+static ADDRESS_MAP_START( idletest_main_map, ADDRESS_SPACE_PROGRAM, 8 )
+	AM_RANGE(0x0000, 0x7fff) AM_ROM
+	AM_RANGE(0x8000, 0x8000) AM_WRITE(soundlatch_w)
+	AM_RANGE(0x8001, 0x8001) AM_READ(soundlatch2_r)
+	AM_RANGE(0xc000, 0xffff) AM_RAM
+ADDRESS_MAP_END
+
+
+static ADDRESS_MAP_START( idletest_sound_map, ADDRESS_SPACE_PROGRAM, 8 )
+	AM_RANGE(0x0000, 0x0fff) AM_RAM
+	AM_RANGE(0x1000, 0x1000) AM_READ(soundlatch_r)
+	AM_RANGE(0x2000, 0x2000) AM_WRITE(DAC_0_data_w)
+	AM_RANGE(0x3000, 0x3000) AM_WRITE(soundlatch2_w)
+	AM_RANGE(0xf000, 0xffff) AM_ROM
+ADDRESS_MAP_END
+
+
+static ADDRESS_MAP_START( partest_sound_map, ADDRESS_SPACE_PROGRAM, 8 )
+	AM_RANGE(0x0000, 0x0fff) AM_RAM
+	AM_RANGE(0x1000, 0x1000) AM_READ(soundlatch_r)
+	AM_RANGE(0x2000, 0x2000) AM_WRITE(DAC_0_data_w)
+	AM_RANGE(0x2001, 0x2001) AM_WRITE(DAC_1_data_w)
+	AM_RANGE(0x3000, 0x3000) AM_WRITE(soundlatch2_w)
+	AM_RANGE(0xf000, 0xffff) AM_ROM
+ADDRESS_MAP_END
+
+
+
+/*************************************
+ *
+ *  Video
+ *
+ *************************************/
+
+static VIDEO_UPDATE( advtest )
+{
+	fillbitmap(bitmap, Machine->pens[0], cliprect);
+}
+
+
+
+/*************************************
+ *
+ *  Port definitions
+ *
+ *************************************/
+
+INPUT_PORTS_START( advtest )
+	PORT_START
+	PORT_BIT( 0x01, IP_ACTIVE_LOW, IPT_BUTTON1 )
+INPUT_PORTS_END
+
+
+
+/*************************************
+ *
+ *  Machine drivers
+ *
+ *************************************/
+
+static MACHINE_DRIVER_START( idletest )
+
+	/* basic machine hardware */
+	MDRV_CPU_ADD(Z80, 3579545)
+	MDRV_CPU_PROGRAM_MAP(idletest_main_map,0)
+	MDRV_CPU_VBLANK_INT(irq0_line_hold,1)
+
+	MDRV_CPU_ADD_TAG("sound", M6809, 1500000)
+	MDRV_CPU_PROGRAM_MAP(idletest_sound_map,0)
+	MDRV_CPU_PERIODIC_INT(irq0_line_hold,TIME_IN_HZ(1000))
+
+	MDRV_FRAMES_PER_SECOND(60)
+
+	/* video hardware */
+	MDRV_VIDEO_ATTRIBUTES(VIDEO_TYPE_RASTER)
+	MDRV_SCREEN_SIZE(256, 240)
+	MDRV_VISIBLE_AREA(0, 255, 0, 239)
+	MDRV_PALETTE_LENGTH(2)
+	MDRV_VIDEO_UPDATE(advtest)
+
+	/* sound hardware */
+	MDRV_SPEAKER_STANDARD_MONO("mono")
+
+	MDRV_SOUND_ADD(DAC, 0)
+	MDRV_SOUND_ROUTE(ALL_OUTPUTS, "mono", 1.0)
+MACHINE_DRIVER_END
+
+
+static MACHINE_DRIVER_START( partest )
+
+	/* basic machine hardware */
+	MDRV_IMPORT_FROM(idletest)
+
+	MDRV_CPU_MODIFY("sound")
+	MDRV_CPU_FLAGS(CPU_PARALLEL)
+	MDRV_CPU_PROGRAM_MAP(partest_sound_map,0)
+
+	/* sound hardware */
+	MDRV_SOUND_ADD(DAC, 0)
+	MDRV_SOUND_ROUTE(ALL_OUTPUTS, "mono", 1.0)
+MACHINE_DRIVER_END
+
+
+
+/*************************************
+ *
+ *  ROM definitions
+ *
+ *************************************/
+
+ROM_START( idletest )
+	ROM_REGION( 0x10000, REGION_CPU1, ROMREGION_ERASE00 )
+	ROM_REGION( 0x10000, REGION_CPU2, ROMREGION_ERASE00 )
+ROM_END
+
+
+ROM_START( partest )
+	ROM_REGION( 0x10000, REGION_CPU1, ROMREGION_ERASE00 )
+	ROM_REGION( 0x10000, REGION_CPU2, ROMREGION_ERASE00 )
+ROM_END
+
+
+
+/*************************************
+ *
+ *  Game drivers
+ *
+ *************************************/
+
+GAME( 2006, idletest, 0, idletest, advtest, idletest, ROT0, "AdvanceMAME", "Idle loop test board", 0 )
+GAME( 2006, partest,  0, partest,  advtest, partest,  ROT0, "AdvanceMAME", "Parallel CPU test board", 0 )
@@ -138,6 +138,7 @@ static chd_interface mame_chd_interface =
 void fileio_init(void)
 {
 	chd_set_interface(&mame_chd_interface);
+	unzip_init();
 	add_exit_callback(fileio_exit);
 }
 
@@ -148,7 +149,7 @@ void fileio_init(void)
 
 void fileio_exit(void)
 {
-	unzip_cache_clear();
+	unzip_exit();
 }
 
 
@@ -977,6 +978,58 @@ static const char *get_extension_for_filetype(int filetype)
 }
 
 
+/*-------------------------------------------------
+    compute_hash - compute the checksums of a
+    loaded file, or get them from the hash cache
+    of the previous runs if the file is unchanged
+-------------------------------------------------*/
+
+static void compute_hash(char *hash, int pathtype, int pathindex, const char *file, const char *entry, const UINT8 *data, UINT64 length, unsigned functions)
+{
+	char cached[HASH_BUF_SIZE];
+	char merged[HASH_BUF_SIZE];
+	unsigned cached_functions;
+	UINT8 chksum[256];
+	int i;
+
+	/* zero means all the functions */
+	if (functions == 0)
+		functions = (1 << HASH_NUM_FUNCTIONS) - 1;
+
+	if (osd_hash_cache_get(pathtype, pathindex, file, entry, length, cached) == 0)
+		cached_functions = hash_data_used_functions(cached);
+	else
+		cached_functions = 0;
+
+	/* use the cached checksums if they include all the functions requested */
+	if ((cached_functions & functions) == functions)
+	{
+		hash_data_clear(hash);
+		for (i = 0; i < HASH_NUM_FUNCTIONS; i++)
+			if (functions & (1 << i))
+			{
+				hash_data_extract_binary_checksum(cached, 1 << i, chksum);
+				hash_data_insert_binary_checksum(hash, 1 << i, chksum);
+			}
+		return;
+	}
+
+	hash_compute(hash, data, length, functions);
+
+	/* the cache entry is replaced, so keep in it also the cached checksums */
+	/* of the other functions, like a SHA1 when only the CRC is requested */
+	strcpy(merged, hash);
+	for (i = 0; i < HASH_NUM_FUNCTIONS; i++)
+		if ((cached_functions & ~functions) & (1 << i))
+		{
+			hash_data_extract_binary_checksum(cached, 1 << i, chksum);
+			hash_data_insert_binary_checksum(merged, 1 << i, chksum);
+		}
+
+	osd_hash_cache_set(pathtype, pathindex, file, entry, length, merged);
+}
+
+
 /*-------------------------------------------------
     generic_fopen - master logic for finding and
     opening a file
@@ -1226,6 +1279,8 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
 					if (err == 0)
 					{
 						unsigned functions;
+						char entry[256 + 16];
+						char crcn[9];
 
 						VPRINTF(("Using (mame_fopen) zip file for %s\n", filename));
 						file.length = ziplength;
@@ -1236,7 +1291,13 @@ static mame_file *generic_fopen(int pathtype, const char *gamename, const char *
                            functions for which we have an expected checksum to compare with. */
 						functions = hash_data_used_functions(hash);
 
-						hash_compute(file.hash, file.data, file.length, functions);
+						/* The entry loaded depends also on the expected CRC, so it's part of
+                           the key of the hash cache */
+						strcpy(entry, tempname);
+						if (hash && hash_data_extract_printable_checksum(hash, HASH_CRC, crcn) != 0)
+							sprintf(entry + strlen(entry), ":%s", crcn);
+
+						compute_hash(file.hash, pathtype, pathindex, name, entry, file.data, file.length, functions);
 						break;
 					}
 				}
@@ -1326,7 +1387,7 @@ static int checksum_file(int pathtype, int pathindex, const char *file, UINT8 **
        checksum). Take also care of crconly: if the user asked, we will calculate
        only the CRC, but only if there is an expected CRC for this file. */
 	functions = hash_data_used_functions(hash);
-	hash_compute(hash, data, length, functions);
+	compute_hash(hash, pathtype, pathindex, file, NULL, data, length, functions);
 
 	/* if the caller wants the data, give it away, otherwise free it */
 	if (p)
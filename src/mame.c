@@ -151,6 +151,9 @@ static mame_timer *soft_reset_timer;
 static void (*saveload_schedule_callback)(void);
 static mame_time saveload_schedule_time;
 
+/* AdvanceMAME: state hash statics */
+static int state_hash_done;
+
 /* error recovery and exiting */
 static callback_item *reset_callback_list;
 static callback_item *pause_callback_list;
@@ -245,6 +248,7 @@ static void free_callback_list(callback_item **cb);
 static void saveload_init(void);
 static void handle_save(void);
 static void handle_load(void);
+static void handle_state_hash(void);
 
 
 static void logfile_callback(const char *buffer);
@@ -303,6 +307,12 @@ int run_game(int game)
 			/* then finish setting up our local machine */
 			init_machine();
 
+			/* AdvanceMAME: measure the memory accessors and the context switches */
+			if (options.memory_benchmark)
+				memory_benchmark();
+			if (options.cpu_benchmark)
+				cpuintrf_benchmark();
+
 			/* load the configuration settings and NVRAM */
 			settingsloaded = config_load_settings();
 			nvram_load();
@@ -324,6 +334,7 @@ int run_game(int game)
 
 			/* run the CPUs until a reset or exit */
 			hard_reset_pending = FALSE;
+			state_hash_done = FALSE;
 			while ((!hard_reset_pending && !exit_pending) || saveload_pending_file != NULL)
 			{
 				profiler_mark(PROFILER_EXTRA);
@@ -343,6 +354,10 @@ int run_game(int game)
 				if (saveload_schedule_callback)
 					(*saveload_schedule_callback)();
 
+				/* AdvanceMAME: hash the state to compare different runs */
+				if (options.state_hash_frame && !state_hash_done && cpu_getcurrentframe() >= options.state_hash_frame)
+					handle_state_hash();
+
 				profiler_mark(PROFILER_END);
 			}
 
@@ -866,6 +881,9 @@ void CLIB_DECL logerror(const char *text, ...)
 	{
 		va_list arg;
 
+		/* AdvanceMAME: the buffer is shared with the CPUs running in parallel */
+		cpuexec_serialize();
+
 		profiler_mark(PROFILER_LOGERROR);
 
 		/* dump to the buffer */
@@ -973,6 +991,9 @@ int mame_find_cpu_index(const char *tag)
 
 UINT32 mame_rand(void)
 {
+	/* AdvanceMAME: the seed is shared with the CPUs running in parallel */
+	cpuexec_serialize();
+
 	rand_seed = 1664525 * rand_seed + 1013904223;
 	return rand_seed;
 }
@@ -1329,6 +1350,45 @@ cancel:
 }
 
 
+/*-------------------------------------------------
+    handle_state_hash - AdvanceMAME: log a hash
+    of the data saved in the save states, and
+    one of the sound generated until now
+-------------------------------------------------*/
+
+static void handle_state_hash(void)
+{
+	UINT32 crc;
+	int cpunum;
+
+	state_hash_done = TRUE;
+
+	/* hash the default tag */
+	state_save_push_tag(0);
+	crc = state_save_hash_continue(0);
+	state_save_pop_tag();
+
+	/* loop over CPUs */
+	for (cpunum = 0; cpunum < cpu_gettotalcpu(); cpunum++)
+	{
+		cpuintrf_push_context(cpunum);
+
+		/* make sure banking is set */
+		activecpu_reset_banking();
+
+		/* hash the CPU data */
+		state_save_push_tag(cpunum + 1);
+		crc = state_save_hash_continue(crc);
+		state_save_pop_tag();
+
+		cpuintrf_pop_context();
+	}
+
+	logerror("state: hash %08x at frame %d\n", crc, cpu_getcurrentframe());
+	logerror("sound: hash %08x at frame %d\n", sound_get_hash(), cpu_getcurrentframe());
+}
+
+
 /*-------------------------------------------------
     handle_load - attempt to perform a load
 -------------------------------------------------*/
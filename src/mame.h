@@ -202,6 +202,16 @@ struct _global_options
 
 	int		samplerate;		/* sound sample playback rate, in Hz */
 	int		use_samples;	/* 1 to enable external .wav samples */
+	int		sound_resample_sinc; /* AdvanceMAME: 1 to resample the streams with a windowed sinc filter */
+	int		sound_parallel;	/* AdvanceMAME: 1 to generate in parallel the streams of the thread safe chips */
+	UINT32	chd_cache;		/* AdvanceMAME: size in bytes of the hunk cache of every CHD */
+	UINT32	chd_readahead;	/* AdvanceMAME: number of CHD hunks to decompress in advance, 0 to disable */
+	int		memory_benchmark; /* AdvanceMAME: 1 to measure the memory accessors at startup */
+	int		memory_specialize; /* AdvanceMAME: 1 to use the accessors specialized on the memory map */
+	int		cpu_benchmark;	/* AdvanceMAME: 1 to measure the CPU context switches at startup */
+	int		cpu_parallel;	/* AdvanceMAME: 1 to run in parallel the CPUs declared by the driver */
+	int		cpu_idle;		/* AdvanceMAME: 1 to detect and skip the idle loops of the CPUs */
+	int		state_hash_frame; /* AdvanceMAME: frame at which to log a hash of the state, 0 to disable */
 
 	float	brightness;		/* brightness of the display */
 	float	pause_bright;		/* additional brightness when in pause */
@@ -572,6 +572,16 @@ INLINE int gregorian_days_in_month(int month, int year)
 
 
 
+/* AdvanceMAME: storage of the state of the executing CPU, private of every */
+/* thread to allow a CPU to run in parallel with the others */
+#if defined(USE_THREAD_LOCAL) && defined(__GNUC__)
+#define THREAD_LOCAL			__thread
+#else
+#define THREAD_LOCAL
+#endif
+
+
+
 /* And some MSVC optimizations/warnings */
 #if defined(_MSC_VER) && (_MSC_VER >= 1200)
 #define DECL_NORETURN			__declspec(noreturn)
@@ -133,6 +133,13 @@
     (such as RAM, ROM, NOP, and banking). Table values between 64 and 192
     are assigned dynamically at startup.
 
+    AdvanceMAME: Before the lookup, every accessor checks a small direct
+    mapped cache of pages (TLB), containing a direct pointer to the bank
+    memory for the pages completely covered by a bank with a linear
+    mapping. A miss falls back to the lookup, which fills the TLB if the
+    entry is a bank. The TLB is flushed when the banks or the handlers
+    change, incrementing a key stored in the upper bits of the tags.
+
 ***************************************************************************/
 
 /* macros for the profiler */
@@ -157,6 +164,23 @@
 
 #define SUBTABLE_PTR(tabledata, entry) (&(tabledata)->table[(1 << LEVEL1_BITS) + (((entry) - SUBTABLE_BASE) << LEVEL2_BITS)])
 
+#define TLB_PAGE_BITS			10						/* number of address bits of a TLB page */
+#define TLB_PAGE_SIZE			(1 << TLB_PAGE_BITS)	/* bytes in a TLB page */
+#define TLB_ENTRIES				256						/* number of entries of every TLB */
+#define TLB_KEY_SHIFT			(32 - TLB_PAGE_BITS)	/* position of the flush key in the tags */
+#define TLB_KEY_MAX				((offs_t)((1 << TLB_PAGE_BITS) - 1) << TLB_KEY_SHIFT) /* key reserved for the empty entries */
+#define TLB_INVALID				(~(offs_t)0)			/* tag of the empty entries, never matched */
+
+#define TLB_INDEX(a)			(((a) >> TLB_PAGE_BITS) & (TLB_ENTRIES - 1))
+#define TLB_TAG(a)				(((a) >> TLB_PAGE_BITS) | memory_tlb_key)
+
+#define ACCESS_GENERIC			0						/* accessors for RAM, ROM, banks and handlers */
+#define ACCESS_MEMORY			1						/* accessors for only RAM, ROM and banks */
+#define ACCESS_HANDLER			2						/* accessors for only handlers */
+#define ACCESS_KINDS			3						/* number of kinds of accessors */
+
+#define ACCESS_IS_BANK(k,e)		((k) == ACCESS_MEMORY || ((k) == ACCESS_GENERIC && (e) < STATIC_RAM))
+
 #if defined(MAME_DEBUG) && defined(NEW_DEBUGGER)
 #define DEBUG_HOOK_READ(a,b,c) if (debug_hook_read) (*debug_hook_read)(a, b, c)
 #define DEBUG_HOOK_WRITE(a,b,c,d) if (debug_hook_write) (*debug_hook_write)(a, b, c, d)
@@ -165,6 +189,10 @@
 #define DEBUG_HOOK_WRITE(a,b,c,d)
 #endif
 
+/* AdvanceMAME: with the empty TLB of the watch every access reaches the lookup, and it's recorded */
+#define WATCH_HOOK_READ(a,e) if (memory_watch) memory_watch_read(a, e)
+#define WATCH_HOOK_WRITE(a,e) if (memory_watch) memory_watch_flags |= MEMORY_WATCH_WRITE
+
 
 /*-------------------------------------------------
     TYPE DEFINITIONS
@@ -228,6 +256,7 @@ struct _table_data
 	UINT8 					subtable_alloc;			/* number of subtables allocated */
 	subtable_data			subtable[SUBTABLE_COUNT]; /* info about each subtable */
 	handler_data			handlers[ENTRY_COUNT];	/* array of user-installed handlers */
+	memory_tlb_entry		tlb[TLB_ENTRIES];		/* direct access cache of the bank pages */
 };
 typedef struct _table_data table_data;
 
@@ -244,6 +273,11 @@ struct _addrspace_data
 	table_data				read;					/* memory read lookup table */
 	table_data				write;					/* memory write lookup table */
 	data_accessors *		accessors;				/* pointer to the memory accessors */
+	UINT8					accessorindex;			/* data width index of the accessors */
+	UINT8					endianindex;			/* endianness index of the accessors */
+	UINT8					readkind;				/* kind of the read accessors */
+	UINT8					writekind;				/* kind of the write accessors */
+	data_accessors			specialized;			/* accessors specialized on the kind of entries */
 	address_map *			map;					/* original memory map */
 	address_map *			adjmap;					/* adjusted memory map */
 };
@@ -270,14 +304,15 @@ typedef struct _cpu_data cpu_data;
     GLOBAL VARIABLES
 -------------------------------------------------*/
 
-UINT8 *						opcode_base;					/* opcode base */
-UINT8 *						opcode_arg_base;				/* opcode argument base */
-offs_t						opcode_mask;					/* mask to apply to the opcode address */
-offs_t						opcode_memory_min;				/* opcode memory minimum */
-offs_t						opcode_memory_max;				/* opcode memory maximum */
-UINT8		 				opcode_entry;					/* opcode readmem entry */
+/* AdvanceMAME: the context of the active CPU is private of every thread */
+THREAD_LOCAL UINT8 *		opcode_base;					/* opcode base */
+THREAD_LOCAL UINT8 *		opcode_arg_base;				/* opcode argument base */
+THREAD_LOCAL offs_t			opcode_mask;					/* mask to apply to the opcode address */
+THREAD_LOCAL offs_t			opcode_memory_min;				/* opcode memory minimum */
+THREAD_LOCAL offs_t			opcode_memory_max;				/* opcode memory maximum */
+THREAD_LOCAL UINT8			opcode_entry;					/* opcode readmem entry */
 
-address_space				active_address_space[ADDRESS_SPACES];/* address space data */
+THREAD_LOCAL address_space	active_address_space[ADDRESS_SPACES];/* address space data */
 
 static UINT8 *				bank_ptr[STATIC_COUNT];			/* array of bank pointers */
 static UINT8 *				bankd_ptr[STATIC_COUNT];		/* array of decrypted bank pointers */
@@ -286,9 +321,9 @@ static void *				shared_ptr[MAX_SHARED_POINTERS];/* array of shared pointers */
 static memory_block 		memory_block_list[MAX_MEMORY_BLOCKS];/* array of memory blocks we are tracking */
 static int 					memory_block_count = 0;			/* number of memory_block[] entries used */
 
-static int					cur_context;					/* current CPU context */
+static THREAD_LOCAL int		cur_context = -1;				/* current CPU context */
 
-static opbase_handler		opbasefunc;						/* opcode base override */
+static THREAD_LOCAL opbase_handler opbasefunc;				/* opcode base override */
 
 static int					debugger_access;				/* treat accesses as coming from the debugger */
 static int					log_unmap[ADDRESS_SPACES];		/* log unmapped memory accesses */
@@ -296,6 +331,16 @@ static int					log_unmap[ADDRESS_SPACES];		/* log unmapped memory accesses */
 static cpu_data				cpudata[MAX_CPU];				/* data gathered for each CPU */
 static bank_data 			bankdata[STATIC_COUNT];			/* data gathered for each bank */
 
+static offs_t				memory_tlb_key;					/* flush key of the valid TLB entries */
+static int					memory_tlb_disabled;			/* don't fill the TLB, used by the benchmark */
+static int					memory_accessors_selected;		/* the specialized accessors are selected */
+static int					memory_parallel_cpu = -1;		/* CPU running in another thread */
+static int					memory_parallel_clear;			/* TLB of the parallel CPU to clear when it stops */
+static THREAD_LOCAL int		memory_watch;					/* record the data accesses, used by the idle loop detection */
+static THREAD_LOCAL int		memory_watch_flags;				/* kind of the accesses recorded */
+static THREAD_LOCAL offs_t	memory_watch_address;			/* address of the first memory read recorded */
+static memory_tlb_entry		memory_watch_tlb[TLB_ENTRIES];	/* always empty TLB used while watching */
+
 #if defined(MAME_DEBUG) && defined(NEW_DEBUGGER)
 static debug_hook_read_ptr	debug_hook_read;				/* pointer to debugger callback for memory reads */
 static debug_hook_write_ptr	debug_hook_write;				/* pointer to debugger callback for memory writes */
@@ -364,6 +409,10 @@ static data_accessors memory_accessors[ADDRESS_SPACES][4][2] =
 	},
 };
 
+static data_accessors memory_specialized_accessors[ACCESS_KINDS - 1][ADDRESS_SPACES][4][2];
+
+static const char *access_kind_names[ACCESS_KINDS] = { "generic", "memory", "handler" };
+
 const char *address_space_names[ADDRESS_SPACES] = { "program", "data", "I/O" };
 
 
@@ -372,6 +421,11 @@ const char *address_space_names[ADDRESS_SPACES] = { "program", "data", "I/O" };
 -------------------------------------------------*/
 
 static int init_cpudata(void);
+static void memory_tlb_clear(void);
+static void memory_tlb_flush(void);
+static void memory_watch_select_tlb(void);
+static void select_accessors(addrspace_data *space);
+static void dump_accessors(void);
 static int init_addrspace(UINT8 cpunum, UINT8 spacenum);
 static int preflight_memory(void);
 static int populate_memory(void);
@@ -455,6 +509,25 @@ int memory_init(void)
 	if (!find_memory())
 		return 1;
 
+	/* start with empty TLBs */
+	memory_tlb_disabled = 0;
+	memory_tlb_clear();
+	for (i = 0; i < TLB_ENTRIES; i++)
+		memory_watch_tlb[i].tag = TLB_INVALID;
+
+	/* select the accessors specialized on the final tables */
+	memory_accessors_selected = options.memory_specialize;
+	if (memory_accessors_selected)
+	{
+		int cpunum, spacenum;
+
+		for (cpunum = 0; cpunum < MAX_CPU && Machine->drv->cpu[cpunum].cpu_type != CPU_DUMMY; cpunum++)
+			for (spacenum = 0; spacenum < ADDRESS_SPACES; spacenum++)
+				if (cpudata[cpunum].spacemask & (1 << spacenum))
+					select_accessors(&cpudata[cpunum].space[spacenum]);
+	}
+	dump_accessors();
+
 	/* dump the final memory configuration */
 	mem_dump();
 	return 0;
@@ -499,6 +572,10 @@ void memory_set_context(int activecpu)
 	}
 	cur_context = activecpu;
 
+	/* AdvanceMAME: -1 only saves the context, when a thread stops executing a CPU */
+	if (activecpu == -1)
+		return;
+
 	opcode_arg_base = cpudata[activecpu].op_ram;
 	opcode_base = cpudata[activecpu].op_rom;
 	opcode_mask = cpudata[activecpu].op_mask;
@@ -512,6 +589,8 @@ void memory_set_context(int activecpu)
 	active_address_space[ADDRESS_SPACE_PROGRAM].writelookup = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].write.table;
 	active_address_space[ADDRESS_SPACE_PROGRAM].readhandlers = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].read.handlers;
 	active_address_space[ADDRESS_SPACE_PROGRAM].writehandlers = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].write.handlers;
+	active_address_space[ADDRESS_SPACE_PROGRAM].readtlb = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].read.tlb;
+	active_address_space[ADDRESS_SPACE_PROGRAM].writetlb = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].write.tlb;
 	active_address_space[ADDRESS_SPACE_PROGRAM].accessors = cpudata[activecpu].space[ADDRESS_SPACE_PROGRAM].accessors;
 
 	/* data address space */
@@ -522,6 +601,8 @@ void memory_set_context(int activecpu)
 		active_address_space[ADDRESS_SPACE_DATA].writelookup = cpudata[activecpu].space[ADDRESS_SPACE_DATA].write.table;
 		active_address_space[ADDRESS_SPACE_DATA].readhandlers = cpudata[activecpu].space[ADDRESS_SPACE_DATA].read.handlers;
 		active_address_space[ADDRESS_SPACE_DATA].writehandlers = cpudata[activecpu].space[ADDRESS_SPACE_DATA].write.handlers;
+		active_address_space[ADDRESS_SPACE_DATA].readtlb = cpudata[activecpu].space[ADDRESS_SPACE_DATA].read.tlb;
+		active_address_space[ADDRESS_SPACE_DATA].writetlb = cpudata[activecpu].space[ADDRESS_SPACE_DATA].write.tlb;
 		active_address_space[ADDRESS_SPACE_DATA].accessors = cpudata[activecpu].space[ADDRESS_SPACE_DATA].accessors;
 	}
 
@@ -533,11 +614,17 @@ void memory_set_context(int activecpu)
 		active_address_space[ADDRESS_SPACE_IO].writelookup = cpudata[activecpu].space[ADDRESS_SPACE_IO].write.table;
 		active_address_space[ADDRESS_SPACE_IO].readhandlers = cpudata[activecpu].space[ADDRESS_SPACE_IO].read.handlers;
 		active_address_space[ADDRESS_SPACE_IO].writehandlers = cpudata[activecpu].space[ADDRESS_SPACE_IO].write.handlers;
+		active_address_space[ADDRESS_SPACE_IO].readtlb = cpudata[activecpu].space[ADDRESS_SPACE_IO].read.tlb;
+		active_address_space[ADDRESS_SPACE_IO].writetlb = cpudata[activecpu].space[ADDRESS_SPACE_IO].write.tlb;
 		active_address_space[ADDRESS_SPACE_IO].accessors = cpudata[activecpu].space[ADDRESS_SPACE_IO].accessors;
 	}
 
 	opbasefunc = cpudata[activecpu].opbase;
 
+	/* AdvanceMAME: keep bypassing the TLB if the context changes while watching */
+	if (memory_watch)
+		memory_watch_select_tlb();
+
 #if defined(MAME_DEBUG) && defined(NEW_DEBUGGER)
 	if (activecpu != -1)
 		debug_get_memory_hooks(activecpu, &debug_hook_read, &debug_hook_write);
@@ -550,6 +637,32 @@ void memory_set_context(int activecpu)
 }
 
 
+/*-------------------------------------------------
+    memory_set_parallel_cpu - AdvanceMAME: set the
+    CPU running in another thread, or -1 when it
+    stops; its TLB isn't cleared while it runs
+-------------------------------------------------*/
+
+void memory_set_parallel_cpu(int cpunum)
+{
+	int spacenum, i;
+
+	/* clear the TLB skipped while the CPU was running */
+	if (memory_parallel_clear)
+	{
+		for (spacenum = 0; spacenum < ADDRESS_SPACES; spacenum++)
+			for (i = 0; i < TLB_ENTRIES; i++)
+			{
+				cpudata[memory_parallel_cpu].space[spacenum].read.tlb[i].tag = TLB_INVALID;
+				cpudata[memory_parallel_cpu].space[spacenum].write.tlb[i].tag = TLB_INVALID;
+			}
+		memory_parallel_clear = FALSE;
+	}
+
+	memory_parallel_cpu = cpunum;
+}
+
+
 /*-------------------------------------------------
     memory_get_map - return a pointer to a CPU's
     memory map
@@ -845,6 +958,9 @@ void memory_configure_bank_decrypted(int banknum, int startentry, int numentries
 
 void memory_set_bank(int banknum, int entrynum)
 {
+	/* AdvanceMAME: the banks are shared by all the CPUs */
+	cpuexec_serialize_state(-1);
+
 	/* validation checks */
 	if (banknum < STATIC_BANK1 || banknum > MAX_EXPLICIT_BANKS || !bankdata[banknum].used)
 		fatalerror("memory_set_bank called with invalid bank %d", banknum);
@@ -857,7 +973,11 @@ void memory_set_bank(int banknum, int entrynum)
 
 	/* set the base */
 	bankdata[banknum].curentry = entrynum;
-	bank_ptr[banknum] = bankdata[banknum].entry[entrynum];
+	if (bank_ptr[banknum] != bankdata[banknum].entry[entrynum])
+	{
+		bank_ptr[banknum] = bankdata[banknum].entry[entrynum];
+		memory_tlb_flush();
+	}
 	bankd_ptr[banknum] = bankdata[banknum].entryd[entrynum];
 
 	/* if we're executing out of this bank, adjust the opbase pointer */
@@ -876,6 +996,9 @@ void memory_set_bank(int banknum, int entrynum)
 
 void memory_set_bankptr(int banknum, void *base)
 {
+	/* AdvanceMAME: the banks are shared by all the CPUs */
+	cpuexec_serialize_state(-1);
+
 	/* validation checks */
 	if (banknum < STATIC_BANK1 || banknum > MAX_EXPLICIT_BANKS || !bankdata[banknum].used)
 		fatalerror("memory_set_bankptr called with invalid bank %d", banknum);
@@ -885,7 +1008,11 @@ void memory_set_bankptr(int banknum, void *base)
 		fatalerror("memory_set_bankptr called NULL base");
 
 	/* set the base */
-	bank_ptr[banknum] = base;
+	if (bank_ptr[banknum] != base)
+	{
+		bank_ptr[banknum] = base;
+		memory_tlb_flush();
+	}
 
 	/* if we're executing out of this bank, adjust the opbase pointer */
 	if (opcode_entry == banknum && cpu_getactivecpu() >= 0)
@@ -928,6 +1055,111 @@ int memory_get_log_unmap(int spacenum)
 }
 
 
+/*-------------------------------------------------
+    memory_benchmark_run - AdvanceMAME: read all
+    the RAM, ROM and banks of the active program
+    space through the accessors
+-------------------------------------------------*/
+
+#define BENCHMARK_READS			(8 * 1024 * 1024)
+#define BENCHMARK_RANGE			0x10000
+
+static double memory_benchmark_run(addrspace_data *space, UINT64 *sum)
+{
+	data_accessors *acc = active_address_space[ADDRESS_SPACE_PROGRAM].accessors;
+	int step = space->dbits / 8;
+	cycles_t start, stop;
+	address_map *map;
+	UINT32 count = 0;
+	UINT64 total = 0;
+
+	start = osd_cycles();
+	do
+	{
+		UINT32 last = count;
+
+		for (map = space->adjmap; map && !IS_AMENTRY_END(map) && count < BENCHMARK_READS; map++)
+		{
+			offs_t address, length;
+
+			if (IS_AMENTRY_EXTENDED(map) || IS_AMENTRY_MATCH_MASK(map))
+				continue;
+			if (!HANDLER_IS_RAM(map->read.handler) && !HANDLER_IS_ROM(map->read.handler) && !HANDLER_IS_BANK(map->read.handler))
+				continue;
+
+			/* read at most BENCHMARK_RANGE bytes of every range to visit all of them */
+			length = map->end - map->start;
+			if (length > BENCHMARK_RANGE - 1)
+				length = BENCHMARK_RANGE - 1;
+			length = (length + 1) / step;
+
+			for (address = map->start; length != 0 && count < BENCHMARK_READS; address += step, length--, count++)
+			{
+				switch (step)
+				{
+					case 1:	total += (*acc->read_byte)(address);	break;
+					case 2:	total += (*acc->read_word)(address);	break;
+					case 4:	total += (*acc->read_dword)(address);	break;
+					case 8:	total += (*acc->read_qword)(address);	break;
+				}
+			}
+		}
+
+		/* no memory to read */
+		if (count == last)
+			return 0;
+	} while (count < BENCHMARK_READS);
+	stop = osd_cycles();
+
+	*sum = total;
+	return (double)count * osd_cycles_per_second() / (stop - start);
+}
+
+
+/*-------------------------------------------------
+    memory_benchmark - AdvanceMAME: measure the
+    speed of the program space read accessors of
+    every CPU, with and without the TLB
+-------------------------------------------------*/
+
+void memory_benchmark(void)
+{
+	int prev_context = cur_context;
+	int cpunum;
+
+	for (cpunum = 0; cpunum < MAX_CPU && Machine->drv->cpu[cpunum].cpu_type != CPU_DUMMY; cpunum++)
+	{
+		addrspace_data *space = &cpudata[cpunum].space[ADDRESS_SPACE_PROGRAM];
+		double slow, fast;
+		UINT64 slow_sum = 0, fast_sum = 0;
+
+		if (!(cpudata[cpunum].spacemask & (1 << ADDRESS_SPACE_PROGRAM)))
+			continue;
+
+		memory_set_context(cpunum);
+
+		memory_tlb_disabled = 1;
+		memory_tlb_clear();
+		slow = memory_benchmark_run(space, &slow_sum);
+
+		memory_tlb_disabled = 0;
+		memory_tlb_flush();
+		fast = memory_benchmark_run(space, &fast_sum);
+
+		if (slow == 0)
+			logerror("memory: cpu #%d has no RAM or ROM to benchmark\n", cpunum);
+		else
+			logerror("memory: cpu #%d %d-bit bus, %.1f Mreads/s without TLB, %.1f Mreads/s with TLB, %.2fx\n", cpunum, space->dbits, slow / 1E6, fast / 1E6, fast / slow);
+
+		if (slow_sum != fast_sum)
+			logerror("memory: cpu #%d read different data with the TLB!\n", cpunum);
+	}
+
+	if (prev_context >= 0)
+		memory_set_context(prev_context);
+}
+
+
 /*-------------------------------------------------
     memory_install_readX_handler - install dynamic
     read handler for X-bit case
@@ -1212,7 +1444,10 @@ static int init_addrspace(UINT8 cpunum, UINT8 spacenum)
 	space->dbits = dbits;
 	space->rawmask = 0xffffffffUL >> (32 - abits);
 	space->mask = SPACE_SHIFT_END(space, space->rawmask);
-	space->accessors = &memory_accessors[spacenum][accessorindex][cputype_endianness(cputype) == CPU_IS_LE ? 0 : 1];
+	space->accessorindex = accessorindex;
+	space->endianindex = cputype_endianness(cputype) == CPU_IS_LE ? 0 : 1;
+	space->accessors = &memory_accessors[spacenum][space->accessorindex][space->endianindex];
+	space->readkind = space->writekind = ACCESS_GENERIC;
 	space->map = NULL;
 	space->adjmap = NULL;
 
@@ -1471,12 +1706,18 @@ static void install_mem_handler(addrspace_data *space, int iswrite, int databits
 	offs_t original_mask = mask;
 	int i;
 
+	/* AdvanceMAME: the memory tables are shared by all the CPUs */
+	cpuexec_serialize_state(space->cpunum);
+
 	/* sanity check */
 	if (space->dbits != databits)
 		fatalerror("fatal: install_mem_handler called with a %d-bit handler for a %d-bit address space", databits, space->dbits);
 	if (start > end)
 		fatalerror("fatal: install_mem_handler called with start greater than end");
 
+	/* the TLB may contain the pages of the previous handlers */
+	memory_tlb_flush();
+
 	/* if we're installing a new bank, make sure we mark it */
 	if (HANDLER_IS_BANK(handler))
 	{
@@ -1596,6 +1837,10 @@ static void install_mem_handler(addrspace_data *space, int iswrite, int databits
 		}
 	}
 
+	/* the new handler may change the kind of the accessors */
+	if (memory_accessors_selected)
+		select_accessors(space);
+
 	/* if this is being installed to a live CPU, update the context */
 	if (space->cpunum == cur_context)
 		memory_set_context(cur_context);
@@ -2250,6 +2495,8 @@ static void reattach_banks(void)
 			if (bankdata[banknum].curentry != MAX_BANK_ENTRIES)
 				bank_ptr[banknum] = bankdata[banknum].entry[bankdata[banknum].curentry];
 		}
+
+	memory_tlb_flush();
 }
 
 
@@ -2364,6 +2611,280 @@ static void *memory_find_base(int cpunum, int spacenum, int readwrite, offs_t of
 }
 
 
+/*-------------------------------------------------
+    table_access_kind - find the kind of accessors
+    able to handle all the entries of a table
+-------------------------------------------------*/
+
+static int table_access_kind(const table_data *tabledata, offs_t addrmask)
+{
+	int memory = 0, handler = 0;
+	offs_t l1index, l2count, i;
+
+	/* a small space uses only the start of the subtables */
+	l2count = (addrmask < (1 << LEVEL2_BITS)) ? addrmask + 1 : (1 << LEVEL2_BITS);
+
+	for (l1index = 0; l1index <= LEVEL1_INDEX(addrmask) && !(memory && handler); l1index++)
+	{
+		UINT8 entry = tabledata->table[l1index];
+
+		if (entry >= SUBTABLE_BASE)
+		{
+			const UINT8 *subtable = SUBTABLE_PTR(tabledata, entry);
+			for (i = 0; i < l2count; i++)
+			{
+				if (subtable[i] < STATIC_RAM)
+					memory = 1;
+				else
+					handler = 1;
+			}
+		}
+		else if (entry < STATIC_RAM)
+			memory = 1;
+		else
+			handler = 1;
+	}
+
+	if (!handler)
+		return ACCESS_MEMORY;
+	if (!memory)
+		return ACCESS_HANDLER;
+	return ACCESS_GENERIC;
+}
+
+
+/*-------------------------------------------------
+    select_accessors - select the accessors
+    specialized on the kind of entries of the
+    read and write tables of an address space
+-------------------------------------------------*/
+
+static void select_accessors(addrspace_data *space)
+{
+	data_accessors *generic = &memory_accessors[space->spacenum][space->accessorindex][space->endianindex];
+	data_accessors *acc = &space->specialized;
+
+	space->readkind = table_access_kind(&space->read, space->mask);
+	space->writekind = table_access_kind(&space->write, space->mask);
+
+	*acc = *generic;
+
+	if (space->readkind != ACCESS_GENERIC)
+	{
+		data_accessors *read = &memory_specialized_accessors[space->readkind - 1][space->spacenum][space->accessorindex][space->endianindex];
+		acc->read_byte = read->read_byte;
+		acc->read_word = read->read_word;
+		acc->read_dword = read->read_dword;
+		acc->read_qword = read->read_qword;
+	}
+
+	if (space->writekind != ACCESS_GENERIC)
+	{
+		data_accessors *write = &memory_specialized_accessors[space->writekind - 1][space->spacenum][space->accessorindex][space->endianindex];
+		acc->write_byte = write->write_byte;
+		acc->write_word = write->write_word;
+		acc->write_dword = write->write_dword;
+		acc->write_qword = write->write_qword;
+	}
+
+	space->accessors = acc;
+}
+
+
+/*-------------------------------------------------
+    dump_accessors - log the kind of accessors
+    selected for every address space
+-------------------------------------------------*/
+
+static void dump_accessors(void)
+{
+	int count[ACCESS_KINDS];
+	int cpunum, spacenum, i;
+
+	memset(count, 0, sizeof(count));
+
+	for (cpunum = 0; cpunum < MAX_CPU && Machine->drv->cpu[cpunum].cpu_type != CPU_DUMMY; cpunum++)
+		for (spacenum = 0; spacenum < ADDRESS_SPACES; spacenum++)
+			if (cpudata[cpunum].spacemask & (1 << spacenum))
+			{
+				addrspace_data *space = &cpudata[cpunum].space[spacenum];
+
+				logerror("memory: cpu #%d %s space, %d-bit %s, read %s, write %s\n", cpunum, address_space_names[spacenum],
+					space->dbits, space->endianindex ? "BE" : "LE", access_kind_names[space->readkind], access_kind_names[space->writekind]);
+
+				count[space->readkind]++;
+				count[space->writekind]++;
+			}
+
+	logerror("memory: accessors selected");
+	for (i = 0; i < ACCESS_KINDS; i++)
+		logerror(", %d %s", count[i], access_kind_names[i]);
+	logerror("\n");
+}
+
+
+/*-------------------------------------------------
+    memory_tlb_clear - empty all the TLBs
+-------------------------------------------------*/
+
+static void memory_tlb_clear(void)
+{
+	int cpunum, spacenum, i;
+
+	memory_tlb_key = 0;
+
+	for (cpunum = 0; cpunum < MAX_CPU; cpunum++)
+	{
+		/* AdvanceMAME: the TLB of a CPU running in another thread is cleared when it stops */
+		if (cpunum == memory_parallel_cpu && cpunum != cur_context)
+		{
+			memory_parallel_clear = TRUE;
+			continue;
+		}
+
+		for (spacenum = 0; spacenum < ADDRESS_SPACES; spacenum++)
+			for (i = 0; i < TLB_ENTRIES; i++)
+			{
+				cpudata[cpunum].space[spacenum].read.tlb[i].tag = TLB_INVALID;
+				cpudata[cpunum].space[spacenum].write.tlb[i].tag = TLB_INVALID;
+			}
+	}
+}
+
+
+/*-------------------------------------------------
+    memory_tlb_flush - invalidate all the TLB
+    entries changing the key of the valid tags
+-------------------------------------------------*/
+
+static void memory_tlb_flush(void)
+{
+	memory_tlb_key += 1 << TLB_KEY_SHIFT;
+
+	/* when all the keys are used, really clear the TLBs */
+	if (memory_tlb_key == TLB_KEY_MAX)
+		memory_tlb_clear();
+}
+
+
+/*-------------------------------------------------
+    memory_tlb_fill - add a page at the TLB if it
+    is completely covered by a single bank with a
+    linear mapping
+-------------------------------------------------*/
+
+static void memory_tlb_fill(memory_tlb_entry *tlb, const UINT8 *lookup, const handler_data *handler, UINT32 entry, offs_t address)
+{
+	offs_t start = address & ~(offs_t)(TLB_PAGE_SIZE - 1);
+	offs_t end = start + (TLB_PAGE_SIZE - 1);
+	UINT32 l1entry;
+	INT64 delta;
+	int i;
+
+	if (memory_tlb_disabled || memory_watch || entry < STATIC_BANK1)
+		return;
+
+	/* all the page must use the same entry */
+	l1entry = lookup[LEVEL1_INDEX(start)];
+	if (l1entry >= SUBTABLE_BASE)
+	{
+		const UINT8 *subtable = &lookup[LEVEL2_INDEX(l1entry, start)];
+		for (i = 0; i < TLB_PAGE_SIZE; i++)
+			if (subtable[i] != entry)
+				return;
+	}
+
+	/* the mask must keep all the offsets in the page, and the page */
+	/* must not cross a mirror boundary */
+	if ((handler->mask & (TLB_PAGE_SIZE - 1)) != TLB_PAGE_SIZE - 1)
+		return;
+	delta = (INT64)((start - handler->offset) & handler->mask) - (INT64)start;
+	if ((INT64)((end - handler->offset) & handler->mask) - (INT64)end != delta)
+		return;
+
+	/* the byte swapping of the accessors must work on the direct pointer */
+	if ((delta & 7) != 0)
+		return;
+
+	tlb->base = bank_ptr[entry] + delta;
+	tlb->tag = TLB_TAG(start);
+}
+
+
+/*-------------------------------------------------
+    memory_watch_select_tlb - AdvanceMAME: select
+    the empty TLB while watching, or the TLB of
+    the current CPU, without invalidating the TLB
+    of the other CPUs
+-------------------------------------------------*/
+
+static void memory_watch_select_tlb(void)
+{
+	int spacenum;
+
+	if (cur_context == -1)
+		return;
+
+	for (spacenum = 0; spacenum < ADDRESS_SPACES; spacenum++)
+		if (cpudata[cur_context].spacemask & (1 << spacenum))
+		{
+			active_address_space[spacenum].readtlb = memory_watch ? memory_watch_tlb : cpudata[cur_context].space[spacenum].read.tlb;
+			active_address_space[spacenum].writetlb = memory_watch ? memory_watch_tlb : cpudata[cur_context].space[spacenum].write.tlb;
+		}
+}
+
+
+/*-------------------------------------------------
+    memory_watch_start - AdvanceMAME: start to
+    record the data accesses of the current CPU,
+    bypassing its TLB to see all of them
+-------------------------------------------------*/
+
+void memory_watch_start(void)
+{
+	memory_watch = TRUE;
+	memory_watch_flags = 0;
+	memory_watch_address = 0;
+
+	memory_watch_select_tlb();
+}
+
+
+/*-------------------------------------------------
+    memory_watch_stop - AdvanceMAME: stop to
+    record the data accesses, and return the kind
+    of the accesses seen
+-------------------------------------------------*/
+
+int memory_watch_stop(offs_t *address)
+{
+	memory_watch = FALSE;
+
+	memory_watch_select_tlb();
+
+	if (address)
+		*address = memory_watch_address;
+	return memory_watch_flags;
+}
+
+
+/*-------------------------------------------------
+    memory_watch_read - AdvanceMAME: record a read,
+    telling apart the banks from the handlers
+-------------------------------------------------*/
+
+INLINE void memory_watch_read(offs_t address, UINT32 entry)
+{
+	if (entry >= STATIC_RAM)
+		memory_watch_flags |= MEMORY_WATCH_HANDLER;
+	else if (!(memory_watch_flags & MEMORY_WATCH_READ))
+	{
+		memory_watch_flags |= MEMORY_WATCH_READ;
+		memory_watch_address = address;
+	}
+}
+
+
 /*-------------------------------------------------
     PERFORM_LOOKUP - common lookup procedure
 -------------------------------------------------*/
@@ -2376,21 +2897,40 @@ static void *memory_find_base(int cpunum, int spacenum, int readwrite, offs_t of
 		entry = space.lookup[LEVEL2_INDEX(entry,address)];								\
 
 
+/*-------------------------------------------------
+    PERFORM_TLB_LOOKUP - common TLB procedure
+-------------------------------------------------*/
+
+#define PERFORM_TLB_LOOKUP(tlbname,space,extraand)										\
+	/* mask the address and find its TLB entry */										\
+	address &= space.addrmask & extraand;												\
+	tlb = &space.tlbname[TLB_INDEX(address)];											\
+
+
 /*-------------------------------------------------
     READBYTE - generic byte-sized read handler
 -------------------------------------------------*/
 
-#define READBYTE8(name,spacenum)														\
+#define READBYTE8(name,spacenum,kind)													\
 UINT8 name(offs_t address)																\
 {																						\
 	UINT32 entry;																		\
+	memory_tlb_entry *tlb;																\
 	MEMREADSTART();																		\
-	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~0);						\
+	PERFORM_TLB_LOOKUP(readtlb,active_address_space[spacenum],~0);						\
 	DEBUG_HOOK_READ(spacenum, 1, address);												\
 																						\
-	/* handle banks inline */															\
+	/* handle the pages in the TLB inline */											\
+	if (kind != ACCESS_HANDLER && tlb->tag == TLB_TAG(address))							\
+		MEMREADEND(tlb->base[address]);													\
+																						\
+	/* handle banks inline, adding their pages at the TLB */							\
+	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~0);						\
+	WATCH_HOOK_READ(address, entry);													\
+	if (ACCESS_IS_BANK(kind, entry))													\
+		memory_tlb_fill(tlb, active_address_space[spacenum].readlookup, &active_address_space[spacenum].readhandlers[entry], entry, address);\
 	address = (address - active_address_space[spacenum].readhandlers[entry].offset) & active_address_space[spacenum].readhandlers[entry].mask;\
-	if (entry < STATIC_RAM) 															\
+	if (ACCESS_IS_BANK(kind, entry))													\
 		MEMREADEND(bank_ptr[entry][address]);											\
 																						\
 	/* fall back to the handler */														\
@@ -2399,17 +2939,26 @@ UINT8 name(offs_t address)																\
 	return 0;																			\
 }																						\
 
-#define READBYTE(name,spacenum,xormacro,handlertype,ignorebits,shiftbytes,masktype)		\
+#define READBYTE(name,spacenum,xormacro,handlertype,ignorebits,shiftbytes,masktype,kind)\
 UINT8 name(offs_t address)																\
 {																						\
 	UINT32 entry;																		\
+	memory_tlb_entry *tlb;																\
 	MEMREADSTART();																		\
-	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~0);						\
+	PERFORM_TLB_LOOKUP(readtlb,active_address_space[spacenum],~0);						\
 	DEBUG_HOOK_READ(spacenum, 1, address);												\
 																						\
-	/* handle banks inline */															\
+	/* handle the pages in the TLB inline */											\
+	if (kind != ACCESS_HANDLER && tlb->tag == TLB_TAG(address))							\
+		MEMREADEND(tlb->base[xormacro(address)]);										\
+																						\
+	/* handle banks inline, adding their pages at the TLB */							\
+	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~0);						\
+	WATCH_HOOK_READ(address, entry);													\
+	if (ACCESS_IS_BANK(kind, entry))													\
+		memory_tlb_fill(tlb, active_address_space[spacenum].readlookup, &active_address_space[spacenum].readhandlers[entry], entry, address);\
 	address = (address - active_address_space[spacenum].readhandlers[entry].offset) & active_address_space[spacenum].readhandlers[entry].mask;\
-	if (entry < STATIC_RAM)																\
+	if (ACCESS_IS_BANK(kind, entry))													\
 		MEMREADEND(bank_ptr[entry][xormacro(address)]);									\
 																						\
 	/* fall back to the handler */														\
@@ -2421,12 +2970,12 @@ UINT8 name(offs_t address)																\
 	return 0;																			\
 }																						\
 
-#define READBYTE16BE(name,space)	READBYTE(name,space,BYTE_XOR_BE, handler16,1,~address & 1,UINT16)
-#define READBYTE16LE(name,space)	READBYTE(name,space,BYTE_XOR_LE, handler16,1, address & 1,UINT16)
-#define READBYTE32BE(name,space)	READBYTE(name,space,BYTE4_XOR_BE,handler32,2,~address & 3,UINT32)
-#define READBYTE32LE(name,space)	READBYTE(name,space,BYTE4_XOR_LE,handler32,2, address & 3,UINT32)
-#define READBYTE64BE(name,space)	READBYTE(name,space,BYTE8_XOR_BE,handler64,3,~address & 7,UINT64)
-#define READBYTE64LE(name,space)	READBYTE(name,space,BYTE8_XOR_LE,handler64,3, address & 7,UINT64)
+#define READBYTE16BE(name,space,kind)	READBYTE(name,space,BYTE_XOR_BE, handler16,1,~address & 1,UINT16,kind)
+#define READBYTE16LE(name,space,kind)	READBYTE(name,space,BYTE_XOR_LE, handler16,1, address & 1,UINT16,kind)
+#define READBYTE32BE(name,space,kind)	READBYTE(name,space,BYTE4_XOR_BE,handler32,2,~address & 3,UINT32,kind)
+#define READBYTE32LE(name,space,kind)	READBYTE(name,space,BYTE4_XOR_LE,handler32,2, address & 3,UINT32,kind)
+#define READBYTE64BE(name,space,kind)	READBYTE(name,space,BYTE8_XOR_BE,handler64,3,~address & 7,UINT64,kind)
+#define READBYTE64LE(name,space,kind)	READBYTE(name,space,BYTE8_XOR_LE,handler64,3, address & 7,UINT64,kind)
 
 
 /*-------------------------------------------------
@@ -2434,17 +2983,26 @@ UINT8 name(offs_t address)																\
     (16-bit, 32-bit and 64-bit aligned only!)
 -------------------------------------------------*/
 
-#define READWORD16(name,spacenum)														\
+#define READWORD16(name,spacenum,kind)													\
 UINT16 name(offs_t address)																\
 {																						\
 	UINT32 entry;																		\
+	memory_tlb_entry *tlb;																\
 	MEMREADSTART();																		\
-	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~1);						\
+	PERFORM_TLB_LOOKUP(readtlb,active_address_space[spacenum],~1);						\
 	DEBUG_HOOK_READ(spacenum, 2, address);												\
 																						\
-	/* handle banks inline */															\
+	/* handle the pages in the TLB inline */											\
+	if (kind != ACCESS_HANDLER && tlb->tag == TLB_TAG(address))							\
+		MEMREADEND(*(UINT16 *)&tlb->base[address]);										\
+																						\
+	/* handle banks inline, adding their pages at the TLB */							\
+	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~1);						\
+	WATCH_HOOK_READ(address, entry);													\
+	if (ACCESS_IS_BANK(kind, entry))													\
+		memory_tlb_fill(tlb, active_address_space[spacenum].readlookup, &active_address_space[spacenum].readhandlers[entry], entry, address);\
 	address = (address - active_address_space[spacenum].readhandlers[entry].offset) & active_address_space[spacenum].readhandlers[entry].mask;\
-	if (entry < STATIC_RAM)																\
+	if (ACCESS_IS_BANK(kind, entry))													\
 		MEMREADEND(*(UINT16 *)&bank_ptr[entry][address]);								\
 																						\
 	/* fall back to the handler */														\
@@ -2453,17 +3011,26 @@ UINT16 name(offs_t address)																\
 	return 0;																			\
 }																						\
 
-#define READWORD(name,spacenum,xormacro,handlertype,ignorebits,shiftbytes,masktype)		\
+#define READWORD(name,spacenum,xormacro,handlertype,ignorebits,shiftbytes,masktype,kind)\
 UINT16 name(offs_t address)																\
 {																						\
 	UINT32 entry;																		\
+	memory_tlb_entry *tlb;																\
 	MEMREADSTART();																		\
-	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~1);						\
+	PERFORM_TLB_LOOKUP(readtlb,active_address_space[spacenum],~1);						\
 	DEBUG_HOOK_READ(spacenum, 2, address);												\
 																						\
-	/* handle banks inline */															\
+	/* handle the pages in the TLB inline */											\
+	if (kind != ACCESS_HANDLER && tlb->tag == TLB_TAG(address))							\
+		MEMREADEND(*(UINT16 *)&tlb->base[xormacro(address)]);							\
+																						\
+	/* handle banks inline, adding their pages at the TLB */							\
+	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~1);						\
+	WATCH_HOOK_READ(address, entry);													\
+	if (ACCESS_IS_BANK(kind, entry))													\
+		memory_tlb_fill(tlb, active_address_space[spacenum].readlookup, &active_address_space[spacenum].readhandlers[entry], entry, address);\
 	address = (address - active_address_space[spacenum].readhandlers[entry].offset) & active_address_space[spacenum].readhandlers[entry].mask;\
-	if (entry < STATIC_RAM)																\
+	if (ACCESS_IS_BANK(kind, entry))													\
 		MEMREADEND(*(UINT16 *)&bank_ptr[entry][xormacro(address)]);						\
 																						\
 	/* fall back to the handler */														\
@@ -2475,10 +3042,10 @@ UINT16 name(offs_t address)																\
 	return 0;																			\
 }																						\
 
-#define READWORD32BE(name,space)	READWORD(name,space,WORD_XOR_BE, handler32,2,~address & 2,UINT32)
-#define READWORD32LE(name,space)	READWORD(name,space,WORD_XOR_LE, handler32,2, address & 2,UINT32)
-#define READWORD64BE(name,space)	READWORD(name,space,WORD2_XOR_BE,handler64,3,~address & 6,UINT64)
-#define READWORD64LE(name,space)	READWORD(name,space,WORD2_XOR_LE,handler64,3, address & 6,UINT64)
+#define READWORD32BE(name,space,kind)	READWORD(name,space,WORD_XOR_BE, handler32,2,~address & 2,UINT32,kind)
+#define READWORD32LE(name,space,kind)	READWORD(name,space,WORD_XOR_LE, handler32,2, address & 2,UINT32,kind)
+#define READWORD64BE(name,space,kind)	READWORD(name,space,WORD2_XOR_BE,handler64,3,~address & 6,UINT64,kind)
+#define READWORD64LE(name,space,kind)	READWORD(name,space,WORD2_XOR_LE,handler64,3, address & 6,UINT64,kind)
 
 
 /*-------------------------------------------------
@@ -2486,17 +3053,26 @@ UINT16 name(offs_t address)																\
     (32-bit and 64-bit aligned only!)
 -------------------------------------------------*/
 
-#define READDWORD32(name,spacenum)														\
+#define READDWORD32(name,spacenum,kind)													\
 UINT32 name(offs_t address)																\
 {																						\
 	UINT32 entry;																		\
+	memory_tlb_entry *tlb;																\
 	MEMREADSTART();																		\
-	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~3);						\
+	PERFORM_TLB_LOOKUP(readtlb,active_address_space[spacenum],~3);						\
 	DEBUG_HOOK_READ(spacenum, 4, address);												\
 																						\
-	/* handle banks inline */															\
+	/* handle the pages in the TLB inline */											\
+	if (kind != ACCESS_HANDLER && tlb->tag == TLB_TAG(address))							\
+		MEMREADEND(*(UINT32 *)&tlb->base[address]);										\
+																						\
+	/* handle banks inline, adding their pages at the TLB */							\
+	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~3);						\
+	WATCH_HOOK_READ(address, entry);													\
+	if (ACCESS_IS_BANK(kind, entry))													\
+		memory_tlb_fill(tlb, active_address_space[spacenum].readlookup, &active_address_space[spacenum].readhandlers[entry], entry, address);\
 	address = (address - active_address_space[spacenum].readhandlers[entry].offset) & active_address_space[spacenum].readhandlers[entry].mask;\
-	if (entry < STATIC_RAM)																\
+	if (ACCESS_IS_BANK(kind, entry))													\
 		MEMREADEND(*(UINT32 *)&bank_ptr[entry][address]);								\
 																						\
 	/* fall back to the handler */														\
@@ -2505,17 +3081,26 @@ UINT32 name(offs_t address)																\
 	return 0;																			\
 }																						\
 
-#define READDWORD(name,spacenum,xormacro,handlertype,ignorebits,shiftbytes,masktype)	\
+#define READDWORD(name,spacenum,xormacro,handlertype,ignorebits,shiftbytes,masktype,kind)\
 UINT32 name(offs_t address)																\
 {																						\
 	UINT32 entry;																		\
+	memory_tlb_entry *tlb;																\
 	MEMREADSTART();																		\
-	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~3);						\
+	PERFORM_TLB_LOOKUP(readtlb,active_address_space[spacenum],~3);						\
 	DEBUG_HOOK_READ(spacenum, 4, address);												\
 																						\
-	/* handle banks inline */															\
+	/* handle the pages in the TLB inline */											\
+	if (kind != ACCESS_HANDLER && tlb->tag == TLB_TAG(address))							\
+		MEMREADEND(*(UINT32 *)&tlb->base[xormacro(address)]);							\
+																						\
+	/* handle banks inline, adding their pages at the TLB */							\
+	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~3);						\
+	WATCH_HOOK_READ(address, entry);													\
+	if (ACCESS_IS_BANK(kind, entry))													\
+		memory_tlb_fill(tlb, active_address_space[spacenum].readlookup, &active_address_space[spacenum].readhandlers[entry], entry, address);\
 	address = (address - active_address_space[spacenum].readhandlers[entry].offset) & active_address_space[spacenum].readhandlers[entry].mask;\
-	if (entry < STATIC_RAM)																\
+	if (ACCESS_IS_BANK(kind, entry))													\
 		MEMREADEND(*(UINT32 *)&bank_ptr[entry][xormacro(address)]);						\
 																						\
 	/* fall back to the handler */														\
@@ -2527,8 +3112,8 @@ UINT32 name(offs_t address)																\
 	return 0;																			\
 }																						\
 
-#define READDWORD64BE(name,space)	READDWORD(name,space,DWORD_XOR_BE,handler64,3,~address & 4,UINT64)
-#define READDWORD64LE(name,space)	READDWORD(name,space,DWORD_XOR_LE,handler64,3, address & 4,UINT64)
+#define READDWORD64BE(name,space,kind)	READDWORD(name,space,DWORD_XOR_BE,handler64,3,~address & 4,UINT64,kind)
+#define READDWORD64LE(name,space,kind)	READDWORD(name,space,DWORD_XOR_LE,handler64,3, address & 4,UINT64,kind)
 
 
 /*-------------------------------------------------
@@ -2536,17 +3121,26 @@ UINT32 name(offs_t address)																\
     (64-bit aligned only!)
 -------------------------------------------------*/
 
-#define READQWORD64(name,spacenum)														\
+#define READQWORD64(name,spacenum,kind)													\
 UINT64 name(offs_t address)																\
 {																						\
 	UINT32 entry;																		\
+	memory_tlb_entry *tlb;																\
 	MEMREADSTART();																		\
-	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~7);						\
+	PERFORM_TLB_LOOKUP(readtlb,active_address_space[spacenum],~7);						\
 	DEBUG_HOOK_READ(spacenum, 8, address);												\
 																						\
-	/* handle banks inline */															\
+	/* handle the pages in the TLB inline */											\
+	if (kind != ACCESS_HANDLER && tlb->tag == TLB_TAG(address))							\
+		MEMREADEND(*(UINT64 *)&tlb->base[address]);										\
+																						\
+	/* handle banks inline, adding their pages at the TLB */							\
+	PERFORM_LOOKUP(readlookup,active_address_space[spacenum],~7);						\
+	WATCH_HOOK_READ(address, entry);													\
+	if (ACCESS_IS_BANK(kind, entry))													\
+		memory_tlb_fill(tlb, active_address_space[spacenum].readlookup, &active_address_space[spacenum].readhandlers[entry], entry, address);\
 	address = (address - active_address_space[spacenum].readhandlers[entry].offset) & active_address_space[spacenum].readhandlers[entry].mask;\
-	if (entry < STATIC_RAM)																\
+	if (ACCESS_IS_BANK(kind, entry))													\
 		MEMREADEND(*(UINT64 *)&bank_ptr[entry][address]);								\
 																						\
 	/* fall back to the handler */														\
@@ -2560,17 +3154,26 @@ UINT64 name(offs_t address)																\
     WRITEBYTE - generic byte-sized write handler
 -------------------------------------------------*/
 
-#define WRITEBYTE8(name,spacenum)														\
+#define WRITEBYTE8(name,spacenum,kind)													\
 void name(offs_t address, UINT8 data)													\
 {																						\
 	UINT32 entry;																		\
+	memory_tlb_entry *tlb;																\
 	MEMWRITESTART();																	\
-	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~0);						\
+	PERFORM_TLB_LOOKUP(writetlb,active_address_space[spacenum],~0);						\
 	DEBUG_HOOK_WRITE(spacenum, 1, address, data);										\
 																						\
-	/* handle banks inline */															\
+	/* handle the pages in the TLB inline */											\
+	if (kind != ACCESS_HANDLER && tlb->tag == TLB_TAG(address))							\
+		MEMWRITEEND(tlb->base[address] = data);											\
+																						\
+	/* handle banks inline, adding their pages at the TLB */							\
+	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~0);						\
+	WATCH_HOOK_WRITE(address, entry);													\
+	if (ACCESS_IS_BANK(kind, entry))													\
+		memory_tlb_fill(tlb, active_address_space[spacenum].writelookup, &active_address_space[spacenum].writehandlers[entry], entry, address);\
 	address = (address - active_address_space[spacenum].writehandlers[entry].offset) & active_address_space[spacenum].writehandlers[entry].mask;\
-	if (entry < STATIC_RAM)																\
+	if (ACCESS_IS_BANK(kind, entry))													\
 		MEMWRITEEND(bank_ptr[entry][address] = data);									\
 																						\
 	/* fall back to the handler */														\
@@ -2578,17 +3181,26 @@ void name(offs_t address, UINT8 data)													\
 		MEMWRITEEND((*active_address_space[spacenum].writehandlers[entry].handler.write.handler8)(address, data));\
 }																						\
 
-#define WRITEBYTE(name,spacenum,xormacro,handlertype,ignorebits,shiftbytes,masktype)	\
+#define WRITEBYTE(name,spacenum,xormacro,handlertype,ignorebits,shiftbytes,masktype,kind)\
 void name(offs_t address, UINT8 data)													\
 {																						\
 	UINT32 entry;																		\
+	memory_tlb_entry *tlb;																\
 	MEMWRITESTART();																	\
-	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~0);						\
+	PERFORM_TLB_LOOKUP(writetlb,active_address_space[spacenum],~0);						\
 	DEBUG_HOOK_WRITE(spacenum, 1, address, data);										\
 																						\
-	/* handle banks inline */															\
+	/* handle the pages in the TLB inline */											\
+	if (kind != ACCESS_HANDLER && tlb->tag == TLB_TAG(address))							\
+		MEMWRITEEND(tlb->base[xormacro(address)] = data);								\
+																						\
+	/* handle banks inline, adding their pages at the TLB */							\
+	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~0);						\
+	WATCH_HOOK_WRITE(address, entry);													\
+	if (ACCESS_IS_BANK(kind, entry))													\
+		memory_tlb_fill(tlb, active_address_space[spacenum].writelookup, &active_address_space[spacenum].writehandlers[entry], entry, address);\
 	address = (address - active_address_space[spacenum].writehandlers[entry].offset) & active_address_space[spacenum].writehandlers[entry].mask;\
-	if (entry < STATIC_RAM)																\
+	if (ACCESS_IS_BANK(kind, entry))													\
 		MEMWRITEEND(bank_ptr[entry][xormacro(address)] = data);							\
 																						\
 	/* fall back to the handler */														\
@@ -2599,12 +3211,12 @@ void name(offs_t address, UINT8 data)													\
 	}																					\
 }																						\
 
-#define WRITEBYTE16BE(name,space)	WRITEBYTE(name,space,BYTE_XOR_BE, handler16,1,~address & 1,UINT16)
-#define WRITEBYTE16LE(name,space)	WRITEBYTE(name,space,BYTE_XOR_LE, handler16,1, address & 1,UINT16)
-#define WRITEBYTE32BE(name,space)	WRITEBYTE(name,space,BYTE4_XOR_BE,handler32,2,~address & 3,UINT32)
-#define WRITEBYTE32LE(name,space)	WRITEBYTE(name,space,BYTE4_XOR_LE,handler32,2, address & 3,UINT32)
-#define WRITEBYTE64BE(name,space)	WRITEBYTE(name,space,BYTE8_XOR_BE,handler64,3,~address & 7,UINT64)
-#define WRITEBYTE64LE(name,space)	WRITEBYTE(name,space,BYTE8_XOR_LE,handler64,3, address & 7,UINT64)
+#define WRITEBYTE16BE(name,space,kind)	WRITEBYTE(name,space,BYTE_XOR_BE, handler16,1,~address & 1,UINT16,kind)
+#define WRITEBYTE16LE(name,space,kind)	WRITEBYTE(name,space,BYTE_XOR_LE, handler16,1, address & 1,UINT16,kind)
+#define WRITEBYTE32BE(name,space,kind)	WRITEBYTE(name,space,BYTE4_XOR_BE,handler32,2,~address & 3,UINT32,kind)
+#define WRITEBYTE32LE(name,space,kind)	WRITEBYTE(name,space,BYTE4_XOR_LE,handler32,2, address & 3,UINT32,kind)
+#define WRITEBYTE64BE(name,space,kind)	WRITEBYTE(name,space,BYTE8_XOR_BE,handler64,3,~address & 7,UINT64,kind)
+#define WRITEBYTE64LE(name,space,kind)	WRITEBYTE(name,space,BYTE8_XOR_LE,handler64,3, address & 7,UINT64,kind)
 
 
 /*-------------------------------------------------
@@ -2612,17 +3224,26 @@ void name(offs_t address, UINT8 data)													\
     (16-bit, 32-bit and 64-bit aligned only!)
 -------------------------------------------------*/
 
-#define WRITEWORD16(name,spacenum)														\
+#define WRITEWORD16(name,spacenum,kind)													\
 void name(offs_t address, UINT16 data)													\
 {																						\
 	UINT32 entry;																		\
+	memory_tlb_entry *tlb;																\
 	MEMWRITESTART();																	\
-	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~1);						\
+	PERFORM_TLB_LOOKUP(writetlb,active_address_space[spacenum],~1);						\
 	DEBUG_HOOK_WRITE(spacenum, 2, address, data);										\
 																						\
-	/* handle banks inline */															\
+	/* handle the pages in the TLB inline */											\
+	if (kind != ACCESS_HANDLER && tlb->tag == TLB_TAG(address))							\
+		MEMWRITEEND(*(UINT16 *)&tlb->base[address] = data);								\
+																						\
+	/* handle banks inline, adding their pages at the TLB */							\
+	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~1);						\
+	WATCH_HOOK_WRITE(address, entry);													\
+	if (ACCESS_IS_BANK(kind, entry))													\
+		memory_tlb_fill(tlb, active_address_space[spacenum].writelookup, &active_address_space[spacenum].writehandlers[entry], entry, address);\
 	address = (address - active_address_space[spacenum].writehandlers[entry].offset) & active_address_space[spacenum].writehandlers[entry].mask;\
-	if (entry < STATIC_RAM)																\
+	if (ACCESS_IS_BANK(kind, entry))													\
 		MEMWRITEEND(*(UINT16 *)&bank_ptr[entry][address] = data);						\
 																						\
 	/* fall back to the handler */														\
@@ -2630,17 +3251,26 @@ void name(offs_t address, UINT16 data)													\
 		MEMWRITEEND((*active_address_space[spacenum].writehandlers[entry].handler.write.handler16)(address >> 1, data, 0));\
 }																						\
 
-#define WRITEWORD(name,spacenum,xormacro,handlertype,ignorebits,shiftbytes,masktype)	\
+#define WRITEWORD(name,spacenum,xormacro,handlertype,ignorebits,shiftbytes,masktype,kind)\
 void name(offs_t address, UINT16 data)													\
 {																						\
 	UINT32 entry;																		\
+	memory_tlb_entry *tlb;																\
 	MEMWRITESTART();																	\
-	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~1);						\
+	PERFORM_TLB_LOOKUP(writetlb,active_address_space[spacenum],~1);						\
 	DEBUG_HOOK_WRITE(spacenum, 2, address, data);										\
 																						\
-	/* handle banks inline */															\
+	/* handle the pages in the TLB inline */											\
+	if (kind != ACCESS_HANDLER && tlb->tag == TLB_TAG(address))							\
+		MEMWRITEEND(*(UINT16 *)&tlb->base[xormacro(address)] = data);					\
+																						\
+	/* handle banks inline, adding their pages at the TLB */							\
+	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~1);						\
+	WATCH_HOOK_WRITE(address, entry);													\
+	if (ACCESS_IS_BANK(kind, entry))													\
+		memory_tlb_fill(tlb, active_address_space[spacenum].writelookup, &active_address_space[spacenum].writehandlers[entry], entry, address);\
 	address = (address - active_address_space[spacenum].writehandlers[entry].offset) & active_address_space[spacenum].writehandlers[entry].mask;\
-	if (entry < STATIC_RAM)																\
+	if (ACCESS_IS_BANK(kind, entry))													\
 		MEMWRITEEND(*(UINT16 *)&bank_ptr[entry][xormacro(address)] = data);				\
 																						\
 	/* fall back to the handler */														\
@@ -2651,10 +3281,10 @@ void name(offs_t address, UINT16 data)													\
 	}																					\
 }																						\
 
-#define WRITEWORD32BE(name,space)	WRITEWORD(name,space,WORD_XOR_BE, handler32,2,~address & 2,UINT32)
-#define WRITEWORD32LE(name,space)	WRITEWORD(name,space,WORD_XOR_LE, handler32,2, address & 2,UINT32)
-#define WRITEWORD64BE(name,space)	WRITEWORD(name,space,WORD2_XOR_BE,handler64,3,~address & 6,UINT64)
-#define WRITEWORD64LE(name,space)	WRITEWORD(name,space,WORD2_XOR_LE,handler64,3, address & 6,UINT64)
+#define WRITEWORD32BE(name,space,kind)	WRITEWORD(name,space,WORD_XOR_BE, handler32,2,~address & 2,UINT32,kind)
+#define WRITEWORD32LE(name,space,kind)	WRITEWORD(name,space,WORD_XOR_LE, handler32,2, address & 2,UINT32,kind)
+#define WRITEWORD64BE(name,space,kind)	WRITEWORD(name,space,WORD2_XOR_BE,handler64,3,~address & 6,UINT64,kind)
+#define WRITEWORD64LE(name,space,kind)	WRITEWORD(name,space,WORD2_XOR_LE,handler64,3, address & 6,UINT64,kind)
 
 
 /*-------------------------------------------------
@@ -2662,17 +3292,26 @@ void name(offs_t address, UINT16 data)													\
     (32-bit and 64-bit aligned only!)
 -------------------------------------------------*/
 
-#define WRITEDWORD32(name,spacenum)														\
+#define WRITEDWORD32(name,spacenum,kind)												\
 void name(offs_t address, UINT32 data)													\
 {																						\
 	UINT32 entry;																		\
+	memory_tlb_entry *tlb;																\
 	MEMWRITESTART();																	\
-	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~3);						\
+	PERFORM_TLB_LOOKUP(writetlb,active_address_space[spacenum],~3);						\
 	DEBUG_HOOK_WRITE(spacenum, 4, address, data);										\
 																						\
-	/* handle banks inline */															\
+	/* handle the pages in the TLB inline */											\
+	if (kind != ACCESS_HANDLER && tlb->tag == TLB_TAG(address))							\
+		MEMWRITEEND(*(UINT32 *)&tlb->base[address] = data);								\
+																						\
+	/* handle banks inline, adding their pages at the TLB */							\
+	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~3);						\
+	WATCH_HOOK_WRITE(address, entry);													\
+	if (ACCESS_IS_BANK(kind, entry))													\
+		memory_tlb_fill(tlb, active_address_space[spacenum].writelookup, &active_address_space[spacenum].writehandlers[entry], entry, address);\
 	address = (address - active_address_space[spacenum].writehandlers[entry].offset) & active_address_space[spacenum].writehandlers[entry].mask;\
-	if (entry < STATIC_RAM)																\
+	if (ACCESS_IS_BANK(kind, entry))													\
 		MEMWRITEEND(*(UINT32 *)&bank_ptr[entry][address] = data);						\
 																						\
 	/* fall back to the handler */														\
@@ -2680,17 +3319,26 @@ void name(offs_t address, UINT32 data)													\
 		MEMWRITEEND((*active_address_space[spacenum].writehandlers[entry].handler.write.handler32)(address >> 2, data, 0));\
 }																						\
 
-#define WRITEDWORD(name,spacenum,xormacro,handlertype,ignorebits,shiftbytes,masktype)	\
+#define WRITEDWORD(name,spacenum,xormacro,handlertype,ignorebits,shiftbytes,masktype,kind)\
 void name(offs_t address, UINT32 data)													\
 {																						\
 	UINT32 entry;																		\
+	memory_tlb_entry *tlb;																\
 	MEMWRITESTART();																	\
-	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~3);						\
+	PERFORM_TLB_LOOKUP(writetlb,active_address_space[spacenum],~3);						\
 	DEBUG_HOOK_WRITE(spacenum, 4, address, data);										\
 																						\
-	/* handle banks inline */															\
+	/* handle the pages in the TLB inline */											\
+	if (kind != ACCESS_HANDLER && tlb->tag == TLB_TAG(address))							\
+		MEMWRITEEND(*(UINT32 *)&tlb->base[xormacro(address)] = data);					\
+																						\
+	/* handle banks inline, adding their pages at the TLB */							\
+	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~3);						\
+	WATCH_HOOK_WRITE(address, entry);													\
+	if (ACCESS_IS_BANK(kind, entry))													\
+		memory_tlb_fill(tlb, active_address_space[spacenum].writelookup, &active_address_space[spacenum].writehandlers[entry], entry, address);\
 	address = (address - active_address_space[spacenum].writehandlers[entry].offset) & active_address_space[spacenum].writehandlers[entry].mask;\
-	if (entry < STATIC_RAM)																\
+	if (ACCESS_IS_BANK(kind, entry))													\
 		MEMWRITEEND(*(UINT32 *)&bank_ptr[entry][xormacro(address)] = data);				\
 																						\
 	/* fall back to the handler */														\
@@ -2701,8 +3349,8 @@ void name(offs_t address, UINT32 data)													\
 	}																					\
 }																						\
 
-#define WRITEDWORD64BE(name,space)	WRITEDWORD(name,space,DWORD_XOR_BE,handler64,3,~address & 4,UINT64)
-#define WRITEDWORD64LE(name,space)	WRITEDWORD(name,space,DWORD_XOR_LE,handler64,3, address & 4,UINT64)
+#define WRITEDWORD64BE(name,space,kind)	WRITEDWORD(name,space,DWORD_XOR_BE,handler64,3,~address & 4,UINT64,kind)
+#define WRITEDWORD64LE(name,space,kind)	WRITEDWORD(name,space,DWORD_XOR_LE,handler64,3, address & 4,UINT64,kind)
 
 
 /*-------------------------------------------------
@@ -2710,17 +3358,26 @@ void name(offs_t address, UINT32 data)													\
     (64-bit aligned only!)
 -------------------------------------------------*/
 
-#define WRITEQWORD64(name,spacenum)														\
+#define WRITEQWORD64(name,spacenum,kind)												\
 void name(offs_t address, UINT64 data)													\
 {																						\
 	UINT32 entry;																		\
+	memory_tlb_entry *tlb;																\
 	MEMWRITESTART();																	\
-	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~7);						\
+	PERFORM_TLB_LOOKUP(writetlb,active_address_space[spacenum],~7);						\
 	DEBUG_HOOK_WRITE(spacenum, 8, address, data);										\
 																						\
-	/* handle banks inline */															\
+	/* handle the pages in the TLB inline */											\
+	if (kind != ACCESS_HANDLER && tlb->tag == TLB_TAG(address))							\
+		MEMWRITEEND(*(UINT64 *)&tlb->base[address] = data);								\
+																						\
+	/* handle banks inline, adding their pages at the TLB */							\
+	PERFORM_LOOKUP(writelookup,active_address_space[spacenum],~7);						\
+	WATCH_HOOK_WRITE(address, entry);													\
+	if (ACCESS_IS_BANK(kind, entry))													\
+		memory_tlb_fill(tlb, active_address_space[spacenum].writelookup, &active_address_space[spacenum].writehandlers[entry], entry, address);\
 	address = (address - active_address_space[spacenum].writehandlers[entry].offset) & active_address_space[spacenum].writehandlers[entry].mask;\
-	if (entry < STATIC_RAM)																\
+	if (ACCESS_IS_BANK(kind, entry))													\
 		MEMWRITEEND(*(UINT64 *)&bank_ptr[entry][address] = data);						\
 																						\
 	/* fall back to the handler */														\
@@ -2733,150 +3390,241 @@ void name(offs_t address, UINT64 data)													\
     Program memory handlers
 -------------------------------------------------*/
 
-     READBYTE8(program_read_byte_8,      ADDRESS_SPACE_PROGRAM)
-    WRITEBYTE8(program_write_byte_8,     ADDRESS_SPACE_PROGRAM)
-
-  READBYTE16BE(program_read_byte_16be,   ADDRESS_SPACE_PROGRAM)
-    READWORD16(program_read_word_16be,   ADDRESS_SPACE_PROGRAM)
- WRITEBYTE16BE(program_write_byte_16be,  ADDRESS_SPACE_PROGRAM)
-   WRITEWORD16(program_write_word_16be,  ADDRESS_SPACE_PROGRAM)
-
-  READBYTE16LE(program_read_byte_16le,   ADDRESS_SPACE_PROGRAM)
-    READWORD16(program_read_word_16le,   ADDRESS_SPACE_PROGRAM)
- WRITEBYTE16LE(program_write_byte_16le,  ADDRESS_SPACE_PROGRAM)
-   WRITEWORD16(program_write_word_16le,  ADDRESS_SPACE_PROGRAM)
-
-  READBYTE32BE(program_read_byte_32be,   ADDRESS_SPACE_PROGRAM)
-  READWORD32BE(program_read_word_32be,   ADDRESS_SPACE_PROGRAM)
-   READDWORD32(program_read_dword_32be,  ADDRESS_SPACE_PROGRAM)
- WRITEBYTE32BE(program_write_byte_32be,  ADDRESS_SPACE_PROGRAM)
- WRITEWORD32BE(program_write_word_32be,  ADDRESS_SPACE_PROGRAM)
-  WRITEDWORD32(program_write_dword_32be, ADDRESS_SPACE_PROGRAM)
-
-  READBYTE32LE(program_read_byte_32le,   ADDRESS_SPACE_PROGRAM)
-  READWORD32LE(program_read_word_32le,   ADDRESS_SPACE_PROGRAM)
-   READDWORD32(program_read_dword_32le,  ADDRESS_SPACE_PROGRAM)
- WRITEBYTE32LE(program_write_byte_32le,  ADDRESS_SPACE_PROGRAM)
- WRITEWORD32LE(program_write_word_32le,  ADDRESS_SPACE_PROGRAM)
-  WRITEDWORD32(program_write_dword_32le, ADDRESS_SPACE_PROGRAM)
-
-  READBYTE64BE(program_read_byte_64be,   ADDRESS_SPACE_PROGRAM)
-  READWORD64BE(program_read_word_64be,   ADDRESS_SPACE_PROGRAM)
- READDWORD64BE(program_read_dword_64be,  ADDRESS_SPACE_PROGRAM)
-   READQWORD64(program_read_qword_64be,  ADDRESS_SPACE_PROGRAM)
- WRITEBYTE64BE(program_write_byte_64be,  ADDRESS_SPACE_PROGRAM)
- WRITEWORD64BE(program_write_word_64be,  ADDRESS_SPACE_PROGRAM)
-WRITEDWORD64BE(program_write_dword_64be, ADDRESS_SPACE_PROGRAM)
-  WRITEQWORD64(program_write_qword_64be, ADDRESS_SPACE_PROGRAM)
-
-  READBYTE64LE(program_read_byte_64le,   ADDRESS_SPACE_PROGRAM)
-  READWORD64LE(program_read_word_64le,   ADDRESS_SPACE_PROGRAM)
- READDWORD64LE(program_read_dword_64le,  ADDRESS_SPACE_PROGRAM)
-   READQWORD64(program_read_qword_64le,  ADDRESS_SPACE_PROGRAM)
- WRITEBYTE64LE(program_write_byte_64le,  ADDRESS_SPACE_PROGRAM)
- WRITEWORD64LE(program_write_word_64le,  ADDRESS_SPACE_PROGRAM)
-WRITEDWORD64LE(program_write_dword_64le, ADDRESS_SPACE_PROGRAM)
-  WRITEQWORD64(program_write_qword_64le, ADDRESS_SPACE_PROGRAM)
+     READBYTE8(program_read_byte_8,      ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+    WRITEBYTE8(program_write_byte_8,     ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+
+  READBYTE16BE(program_read_byte_16be,   ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+    READWORD16(program_read_word_16be,   ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+ WRITEBYTE16BE(program_write_byte_16be,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+   WRITEWORD16(program_write_word_16be,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+
+  READBYTE16LE(program_read_byte_16le,   ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+    READWORD16(program_read_word_16le,   ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+ WRITEBYTE16LE(program_write_byte_16le,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+   WRITEWORD16(program_write_word_16le,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+
+  READBYTE32BE(program_read_byte_32be,   ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+  READWORD32BE(program_read_word_32be,   ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+   READDWORD32(program_read_dword_32be,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+ WRITEBYTE32BE(program_write_byte_32be,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+ WRITEWORD32BE(program_write_word_32be,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+  WRITEDWORD32(program_write_dword_32be, ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+
+  READBYTE32LE(program_read_byte_32le,   ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+  READWORD32LE(program_read_word_32le,   ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+   READDWORD32(program_read_dword_32le,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+ WRITEBYTE32LE(program_write_byte_32le,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+ WRITEWORD32LE(program_write_word_32le,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+  WRITEDWORD32(program_write_dword_32le, ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+
+  READBYTE64BE(program_read_byte_64be,   ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+  READWORD64BE(program_read_word_64be,   ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+ READDWORD64BE(program_read_dword_64be,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+   READQWORD64(program_read_qword_64be,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+ WRITEBYTE64BE(program_write_byte_64be,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+ WRITEWORD64BE(program_write_word_64be,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+WRITEDWORD64BE(program_write_dword_64be, ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+  WRITEQWORD64(program_write_qword_64be, ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+
+  READBYTE64LE(program_read_byte_64le,   ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+  READWORD64LE(program_read_word_64le,   ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+ READDWORD64LE(program_read_dword_64le,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+   READQWORD64(program_read_qword_64le,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+ WRITEBYTE64LE(program_write_byte_64le,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+ WRITEWORD64LE(program_write_word_64le,  ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+WRITEDWORD64LE(program_write_dword_64le, ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
+  WRITEQWORD64(program_write_qword_64le, ADDRESS_SPACE_PROGRAM, ACCESS_GENERIC)
 
 
 /*-------------------------------------------------
     Data memory handlers
 -------------------------------------------------*/
 
-     READBYTE8(data_read_byte_8,      ADDRESS_SPACE_DATA)
-    WRITEBYTE8(data_write_byte_8,     ADDRESS_SPACE_DATA)
-
-  READBYTE16BE(data_read_byte_16be,   ADDRESS_SPACE_DATA)
-    READWORD16(data_read_word_16be,   ADDRESS_SPACE_DATA)
- WRITEBYTE16BE(data_write_byte_16be,  ADDRESS_SPACE_DATA)
-   WRITEWORD16(data_write_word_16be,  ADDRESS_SPACE_DATA)
-
-  READBYTE16LE(data_read_byte_16le,   ADDRESS_SPACE_DATA)
-    READWORD16(data_read_word_16le,   ADDRESS_SPACE_DATA)
- WRITEBYTE16LE(data_write_byte_16le,  ADDRESS_SPACE_DATA)
-   WRITEWORD16(data_write_word_16le,  ADDRESS_SPACE_DATA)
-
-  READBYTE32BE(data_read_byte_32be,   ADDRESS_SPACE_DATA)
-  READWORD32BE(data_read_word_32be,   ADDRESS_SPACE_DATA)
-   READDWORD32(data_read_dword_32be,  ADDRESS_SPACE_DATA)
- WRITEBYTE32BE(data_write_byte_32be,  ADDRESS_SPACE_DATA)
- WRITEWORD32BE(data_write_word_32be,  ADDRESS_SPACE_DATA)
-  WRITEDWORD32(data_write_dword_32be, ADDRESS_SPACE_DATA)
-
-  READBYTE32LE(data_read_byte_32le,   ADDRESS_SPACE_DATA)
-  READWORD32LE(data_read_word_32le,   ADDRESS_SPACE_DATA)
-   READDWORD32(data_read_dword_32le,  ADDRESS_SPACE_DATA)
- WRITEBYTE32LE(data_write_byte_32le,  ADDRESS_SPACE_DATA)
- WRITEWORD32LE(data_write_word_32le,  ADDRESS_SPACE_DATA)
-  WRITEDWORD32(data_write_dword_32le, ADDRESS_SPACE_DATA)
-
-  READBYTE64BE(data_read_byte_64be,   ADDRESS_SPACE_DATA)
-  READWORD64BE(data_read_word_64be,   ADDRESS_SPACE_DATA)
- READDWORD64BE(data_read_dword_64be,  ADDRESS_SPACE_DATA)
-   READQWORD64(data_read_qword_64be,  ADDRESS_SPACE_DATA)
- WRITEBYTE64BE(data_write_byte_64be,  ADDRESS_SPACE_DATA)
- WRITEWORD64BE(data_write_word_64be,  ADDRESS_SPACE_DATA)
-WRITEDWORD64BE(data_write_dword_64be, ADDRESS_SPACE_DATA)
-  WRITEQWORD64(data_write_qword_64be, ADDRESS_SPACE_DATA)
-
-  READBYTE64LE(data_read_byte_64le,   ADDRESS_SPACE_DATA)
-  READWORD64LE(data_read_word_64le,   ADDRESS_SPACE_DATA)
- READDWORD64LE(data_read_dword_64le,  ADDRESS_SPACE_DATA)
-   READQWORD64(data_read_qword_64le,  ADDRESS_SPACE_DATA)
- WRITEBYTE64LE(data_write_byte_64le,  ADDRESS_SPACE_DATA)
- WRITEWORD64LE(data_write_word_64le,  ADDRESS_SPACE_DATA)
-WRITEDWORD64LE(data_write_dword_64le, ADDRESS_SPACE_DATA)
-  WRITEQWORD64(data_write_qword_64le, ADDRESS_SPACE_DATA)
+     READBYTE8(data_read_byte_8,      ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+    WRITEBYTE8(data_write_byte_8,     ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+
+  READBYTE16BE(data_read_byte_16be,   ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+    READWORD16(data_read_word_16be,   ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+ WRITEBYTE16BE(data_write_byte_16be,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+   WRITEWORD16(data_write_word_16be,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+
+  READBYTE16LE(data_read_byte_16le,   ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+    READWORD16(data_read_word_16le,   ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+ WRITEBYTE16LE(data_write_byte_16le,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+   WRITEWORD16(data_write_word_16le,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+
+  READBYTE32BE(data_read_byte_32be,   ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+  READWORD32BE(data_read_word_32be,   ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+   READDWORD32(data_read_dword_32be,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+ WRITEBYTE32BE(data_write_byte_32be,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+ WRITEWORD32BE(data_write_word_32be,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+  WRITEDWORD32(data_write_dword_32be, ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+
+  READBYTE32LE(data_read_byte_32le,   ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+  READWORD32LE(data_read_word_32le,   ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+   READDWORD32(data_read_dword_32le,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+ WRITEBYTE32LE(data_write_byte_32le,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+ WRITEWORD32LE(data_write_word_32le,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+  WRITEDWORD32(data_write_dword_32le, ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+
+  READBYTE64BE(data_read_byte_64be,   ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+  READWORD64BE(data_read_word_64be,   ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+ READDWORD64BE(data_read_dword_64be,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+   READQWORD64(data_read_qword_64be,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+ WRITEBYTE64BE(data_write_byte_64be,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+ WRITEWORD64BE(data_write_word_64be,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+WRITEDWORD64BE(data_write_dword_64be, ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+  WRITEQWORD64(data_write_qword_64be, ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+
+  READBYTE64LE(data_read_byte_64le,   ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+  READWORD64LE(data_read_word_64le,   ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+ READDWORD64LE(data_read_dword_64le,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+   READQWORD64(data_read_qword_64le,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+ WRITEBYTE64LE(data_write_byte_64le,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+ WRITEWORD64LE(data_write_word_64le,  ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+WRITEDWORD64LE(data_write_dword_64le, ADDRESS_SPACE_DATA, ACCESS_GENERIC)
+  WRITEQWORD64(data_write_qword_64le, ADDRESS_SPACE_DATA, ACCESS_GENERIC)
 
 
 /*-------------------------------------------------
     I/O memory handlers
 -------------------------------------------------*/
 
-     READBYTE8(io_read_byte_8,      ADDRESS_SPACE_IO)
-    WRITEBYTE8(io_write_byte_8,     ADDRESS_SPACE_IO)
-
-  READBYTE16BE(io_read_byte_16be,   ADDRESS_SPACE_IO)
-    READWORD16(io_read_word_16be,   ADDRESS_SPACE_IO)
- WRITEBYTE16BE(io_write_byte_16be,  ADDRESS_SPACE_IO)
-   WRITEWORD16(io_write_word_16be,  ADDRESS_SPACE_IO)
-
-  READBYTE16LE(io_read_byte_16le,   ADDRESS_SPACE_IO)
-    READWORD16(io_read_word_16le,   ADDRESS_SPACE_IO)
- WRITEBYTE16LE(io_write_byte_16le,  ADDRESS_SPACE_IO)
-   WRITEWORD16(io_write_word_16le,  ADDRESS_SPACE_IO)
-
-  READBYTE32BE(io_read_byte_32be,   ADDRESS_SPACE_IO)
-  READWORD32BE(io_read_word_32be,   ADDRESS_SPACE_IO)
-   READDWORD32(io_read_dword_32be,  ADDRESS_SPACE_IO)
- WRITEBYTE32BE(io_write_byte_32be,  ADDRESS_SPACE_IO)
- WRITEWORD32BE(io_write_word_32be,  ADDRESS_SPACE_IO)
-  WRITEDWORD32(io_write_dword_32be, ADDRESS_SPACE_IO)
-
-  READBYTE32LE(io_read_byte_32le,   ADDRESS_SPACE_IO)
-  READWORD32LE(io_read_word_32le,   ADDRESS_SPACE_IO)
-   READDWORD32(io_read_dword_32le,  ADDRESS_SPACE_IO)
- WRITEBYTE32LE(io_write_byte_32le,  ADDRESS_SPACE_IO)
- WRITEWORD32LE(io_write_word_32le,  ADDRESS_SPACE_IO)
-  WRITEDWORD32(io_write_dword_32le, ADDRESS_SPACE_IO)
-
-  READBYTE64BE(io_read_byte_64be,   ADDRESS_SPACE_IO)
-  READWORD64BE(io_read_word_64be,   ADDRESS_SPACE_IO)
- READDWORD64BE(io_read_dword_64be,  ADDRESS_SPACE_IO)
-   READQWORD64(io_read_qword_64be,  ADDRESS_SPACE_IO)
- WRITEBYTE64BE(io_write_byte_64be,  ADDRESS_SPACE_IO)
- WRITEWORD64BE(io_write_word_64be,  ADDRESS_SPACE_IO)
-WRITEDWORD64BE(io_write_dword_64be, ADDRESS_SPACE_IO)
-  WRITEQWORD64(io_write_qword_64be, ADDRESS_SPACE_IO)
-
-  READBYTE64LE(io_read_byte_64le,   ADDRESS_SPACE_IO)
-  READWORD64LE(io_read_word_64le,   ADDRESS_SPACE_IO)
- READDWORD64LE(io_read_dword_64le,  ADDRESS_SPACE_IO)
-   READQWORD64(io_read_qword_64le,  ADDRESS_SPACE_IO)
- WRITEBYTE64LE(io_write_byte_64le,  ADDRESS_SPACE_IO)
- WRITEWORD64LE(io_write_word_64le,  ADDRESS_SPACE_IO)
-WRITEDWORD64LE(io_write_dword_64le, ADDRESS_SPACE_IO)
-  WRITEQWORD64(io_write_qword_64le, ADDRESS_SPACE_IO)
+     READBYTE8(io_read_byte_8,      ADDRESS_SPACE_IO, ACCESS_GENERIC)
+    WRITEBYTE8(io_write_byte_8,     ADDRESS_SPACE_IO, ACCESS_GENERIC)
+
+  READBYTE16BE(io_read_byte_16be,   ADDRESS_SPACE_IO, ACCESS_GENERIC)
+    READWORD16(io_read_word_16be,   ADDRESS_SPACE_IO, ACCESS_GENERIC)
+ WRITEBYTE16BE(io_write_byte_16be,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+   WRITEWORD16(io_write_word_16be,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+
+  READBYTE16LE(io_read_byte_16le,   ADDRESS_SPACE_IO, ACCESS_GENERIC)
+    READWORD16(io_read_word_16le,   ADDRESS_SPACE_IO, ACCESS_GENERIC)
+ WRITEBYTE16LE(io_write_byte_16le,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+   WRITEWORD16(io_write_word_16le,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+
+  READBYTE32BE(io_read_byte_32be,   ADDRESS_SPACE_IO, ACCESS_GENERIC)
+  READWORD32BE(io_read_word_32be,   ADDRESS_SPACE_IO, ACCESS_GENERIC)
+   READDWORD32(io_read_dword_32be,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+ WRITEBYTE32BE(io_write_byte_32be,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+ WRITEWORD32BE(io_write_word_32be,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+  WRITEDWORD32(io_write_dword_32be, ADDRESS_SPACE_IO, ACCESS_GENERIC)
+
+  READBYTE32LE(io_read_byte_32le,   ADDRESS_SPACE_IO, ACCESS_GENERIC)
+  READWORD32LE(io_read_word_32le,   ADDRESS_SPACE_IO, ACCESS_GENERIC)
+   READDWORD32(io_read_dword_32le,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+ WRITEBYTE32LE(io_write_byte_32le,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+ WRITEWORD32LE(io_write_word_32le,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+  WRITEDWORD32(io_write_dword_32le, ADDRESS_SPACE_IO, ACCESS_GENERIC)
+
+  READBYTE64BE(io_read_byte_64be,   ADDRESS_SPACE_IO, ACCESS_GENERIC)
+  READWORD64BE(io_read_word_64be,   ADDRESS_SPACE_IO, ACCESS_GENERIC)
+ READDWORD64BE(io_read_dword_64be,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+   READQWORD64(io_read_qword_64be,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+ WRITEBYTE64BE(io_write_byte_64be,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+ WRITEWORD64BE(io_write_word_64be,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+WRITEDWORD64BE(io_write_dword_64be, ADDRESS_SPACE_IO, ACCESS_GENERIC)
+  WRITEQWORD64(io_write_qword_64be, ADDRESS_SPACE_IO, ACCESS_GENERIC)
+
+  READBYTE64LE(io_read_byte_64le,   ADDRESS_SPACE_IO, ACCESS_GENERIC)
+  READWORD64LE(io_read_word_64le,   ADDRESS_SPACE_IO, ACCESS_GENERIC)
+ READDWORD64LE(io_read_dword_64le,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+   READQWORD64(io_read_qword_64le,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+ WRITEBYTE64LE(io_write_byte_64le,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+ WRITEWORD64LE(io_write_word_64le,  ADDRESS_SPACE_IO, ACCESS_GENERIC)
+WRITEDWORD64LE(io_write_dword_64le, ADDRESS_SPACE_IO, ACCESS_GENERIC)
+  WRITEQWORD64(io_write_qword_64le, ADDRESS_SPACE_IO, ACCESS_GENERIC)
+
+
+/*-------------------------------------------------
+    Specialized memory handlers, used through the
+    accessors of the address spaces with only
+    memory or only handlers
+-------------------------------------------------*/
+
+#define SPECIALIZED_HANDLERS(space,spacenum,suffix,kind)								\
+static      READBYTE8(space##_read_byte_8##suffix,      spacenum, kind)					\
+static     WRITEBYTE8(space##_write_byte_8##suffix,     spacenum, kind)					\
+static   READBYTE16BE(space##_read_byte_16be##suffix,   spacenum, kind)					\
+static     READWORD16(space##_read_word_16be##suffix,   spacenum, kind)					\
+static  WRITEBYTE16BE(space##_write_byte_16be##suffix,  spacenum, kind)					\
+static    WRITEWORD16(space##_write_word_16be##suffix,  spacenum, kind)					\
+static   READBYTE16LE(space##_read_byte_16le##suffix,   spacenum, kind)					\
+static     READWORD16(space##_read_word_16le##suffix,   spacenum, kind)					\
+static  WRITEBYTE16LE(space##_write_byte_16le##suffix,  spacenum, kind)					\
+static    WRITEWORD16(space##_write_word_16le##suffix,  spacenum, kind)					\
+static   READBYTE32BE(space##_read_byte_32be##suffix,   spacenum, kind)					\
+static   READWORD32BE(space##_read_word_32be##suffix,   spacenum, kind)					\
+static    READDWORD32(space##_read_dword_32be##suffix,  spacenum, kind)					\
+static  WRITEBYTE32BE(space##_write_byte_32be##suffix,  spacenum, kind)					\
+static  WRITEWORD32BE(space##_write_word_32be##suffix,  spacenum, kind)					\
+static   WRITEDWORD32(space##_write_dword_32be##suffix, spacenum, kind)					\
+static   READBYTE32LE(space##_read_byte_32le##suffix,   spacenum, kind)					\
+static   READWORD32LE(space##_read_word_32le##suffix,   spacenum, kind)					\
+static    READDWORD32(space##_read_dword_32le##suffix,  spacenum, kind)					\
+static  WRITEBYTE32LE(space##_write_byte_32le##suffix,  spacenum, kind)					\
+static  WRITEWORD32LE(space##_write_word_32le##suffix,  spacenum, kind)					\
+static   WRITEDWORD32(space##_write_dword_32le##suffix, spacenum, kind)					\
+static   READBYTE64BE(space##_read_byte_64be##suffix,   spacenum, kind)					\
+static   READWORD64BE(space##_read_word_64be##suffix,   spacenum, kind)					\
+static  READDWORD64BE(space##_read_dword_64be##suffix,  spacenum, kind)					\
+static    READQWORD64(space##_read_qword_64be##suffix,  spacenum, kind)					\
+static  WRITEBYTE64BE(space##_write_byte_64be##suffix,  spacenum, kind)					\
+static  WRITEWORD64BE(space##_write_word_64be##suffix,  spacenum, kind)					\
+static WRITEDWORD64BE(space##_write_dword_64be##suffix, spacenum, kind)					\
+static   WRITEQWORD64(space##_write_qword_64be##suffix, spacenum, kind)					\
+static   READBYTE64LE(space##_read_byte_64le##suffix,   spacenum, kind)					\
+static   READWORD64LE(space##_read_word_64le##suffix,   spacenum, kind)					\
+static  READDWORD64LE(space##_read_dword_64le##suffix,  spacenum, kind)					\
+static    READQWORD64(space##_read_qword_64le##suffix,  spacenum, kind)					\
+static  WRITEBYTE64LE(space##_write_byte_64le##suffix,  spacenum, kind)					\
+static  WRITEWORD64LE(space##_write_word_64le##suffix,  spacenum, kind)					\
+static WRITEDWORD64LE(space##_write_dword_64le##suffix, spacenum, kind)					\
+static   WRITEQWORD64(space##_write_qword_64le##suffix, spacenum, kind)					\
+
+SPECIALIZED_HANDLERS(program, ADDRESS_SPACE_PROGRAM, _memory,  ACCESS_MEMORY)
+SPECIALIZED_HANDLERS(program, ADDRESS_SPACE_PROGRAM, _handler, ACCESS_HANDLER)
+SPECIALIZED_HANDLERS(data,    ADDRESS_SPACE_DATA,    _memory,  ACCESS_MEMORY)
+SPECIALIZED_HANDLERS(data,    ADDRESS_SPACE_DATA,    _handler, ACCESS_HANDLER)
+SPECIALIZED_HANDLERS(io,      ADDRESS_SPACE_IO,      _memory,  ACCESS_MEMORY)
+SPECIALIZED_HANDLERS(io,      ADDRESS_SPACE_IO,      _handler, ACCESS_HANDLER)
+
+#define SPECIALIZED_ACCESSORS(space,suffix)												\
+	{																					\
+		{																				\
+			{ space##_read_byte_8##suffix, NULL, NULL, NULL, space##_write_byte_8##suffix, NULL, NULL, NULL },\
+			{ space##_read_byte_8##suffix, NULL, NULL, NULL, space##_write_byte_8##suffix, NULL, NULL, NULL }\
+		},																				\
+		{																				\
+			{ space##_read_byte_16le##suffix, space##_read_word_16le##suffix, NULL, NULL, space##_write_byte_16le##suffix, space##_write_word_16le##suffix, NULL, NULL },\
+			{ space##_read_byte_16be##suffix, space##_read_word_16be##suffix, NULL, NULL, space##_write_byte_16be##suffix, space##_write_word_16be##suffix, NULL, NULL }\
+		},																				\
+		{																				\
+			{ space##_read_byte_32le##suffix, space##_read_word_32le##suffix, space##_read_dword_32le##suffix, NULL, space##_write_byte_32le##suffix, space##_write_word_32le##suffix, space##_write_dword_32le##suffix, NULL },\
+			{ space##_read_byte_32be##suffix, space##_read_word_32be##suffix, space##_read_dword_32be##suffix, NULL, space##_write_byte_32be##suffix, space##_write_word_32be##suffix, space##_write_dword_32be##suffix, NULL }\
+		},																				\
+		{																				\
+			{ space##_read_byte_64le##suffix, space##_read_word_64le##suffix, space##_read_dword_64le##suffix, space##_read_qword_64le##suffix, space##_write_byte_64le##suffix, space##_write_word_64le##suffix, space##_write_dword_64le##suffix, space##_write_qword_64le##suffix },\
+			{ space##_read_byte_64be##suffix, space##_read_word_64be##suffix, space##_read_dword_64be##suffix, space##_read_qword_64be##suffix, space##_write_byte_64be##suffix, space##_write_word_64be##suffix, space##_write_dword_64be##suffix, space##_write_qword_64be##suffix }\
+		}																				\
+	}																					\
+
+static data_accessors memory_specialized_accessors[ACCESS_KINDS - 1][ADDRESS_SPACES][4][2] =
+{
+	/* memory accessors */
+	{
+		SPECIALIZED_ACCESSORS(program, _memory),
+		SPECIALIZED_ACCESSORS(data, _memory),
+		SPECIALIZED_ACCESSORS(io, _memory)
+	},
+
+	/* handler accessors */
+	{
+		SPECIALIZED_ACCESSORS(program, _handler),
+		SPECIALIZED_ACCESSORS(data, _handler),
+		SPECIALIZED_ACCESSORS(io, _handler)
+	}
+};
 
 
 /*-------------------------------------------------
@@ -212,6 +212,11 @@ typedef struct _data_accessors data_accessors;
 #define MAX_EXPLICIT_BANKS		32						/* maximum number of explicitly-defined banks */
 #define STATIC_BANKMAX			(STATIC_RAM - 1)		/* handler constant of last bank */
 
+/* ----- AdvanceMAME: kind of the accesses recorded by the watch ----- */
+#define MEMORY_WATCH_READ		0x01					/* read from RAM, ROM or a bank */
+#define MEMORY_WATCH_HANDLER	0x02					/* read from a handler */
+#define MEMORY_WATCH_WRITE		0x04					/* write of any kind */
+
 
 
 /***************************************************************************
@@ -592,6 +597,13 @@ struct _address_map
 typedef struct _address_map address_map;
 
 /* ----- structs to contain internal data ----- */
+struct _memory_tlb_entry
+{
+	offs_t				tag;				/* page number and flush key */
+	UINT8 *				base;				/* direct pointer to the bank memory, relative to the address */
+};
+typedef struct _memory_tlb_entry memory_tlb_entry;
+
 struct _address_space
 {
 	offs_t				addrmask;			/* address mask */
@@ -599,6 +611,8 @@ struct _address_space
 	UINT8 *				writelookup;		/* write table lookup */
 	handler_data *		readhandlers;		/* read handlers */
 	handler_data *		writehandlers;		/* write handlers */
+	memory_tlb_entry *	readtlb;			/* read direct access cache */
+	memory_tlb_entry *	writetlb;			/* write direct access cache */
 	data_accessors *	accessors;			/* pointers to the data access handlers */
 };
 typedef struct _address_space address_space;
@@ -916,6 +930,11 @@ void io_write_qword_64le(offs_t address, UINT64 data);
 int			memory_init(void);
 void		memory_exit(void);
 void		memory_set_context(int activecpu);
+void		memory_set_parallel_cpu(int cpunum);
+
+/* ----- AdvanceMAME: watch of the data accesses ----- */
+void		memory_watch_start(void);
+int			memory_watch_stop(offs_t *address);
 
 /* ----- address map functions ----- */
 const address_map *memory_get_map(int cpunum, int spacenum);
@@ -942,6 +961,7 @@ void		memory_set_bankptr(int banknum, void *base);
 void		memory_set_debugger_access(int debugger);
 void		memory_set_log_unmap(int spacenum, int log);
 int			memory_get_log_unmap(int spacenum);
+void		memory_benchmark(void);
 
 /* ----- dynamic address space mapping ----- */
 void *		_memory_install_read_handler   (int cpunum, int spacenum, offs_t start, offs_t end, offs_t mask, offs_t mirror, int handler, const char *handler_name);
@@ -978,13 +998,14 @@ const char *memory_get_handler_string(int read0_or_write1, int cpunum, int space
 
 ***************************************************************************/
 
-extern UINT8 			opcode_entry;				/* current entry for opcode fetching */
-extern UINT8 *			opcode_base;				/* opcode ROM base */
-extern UINT8 *			opcode_arg_base;			/* opcode RAM base */
-extern offs_t			opcode_mask;				/* mask to apply to the opcode address */
-extern offs_t			opcode_memory_min;			/* opcode memory minimum */
-extern offs_t			opcode_memory_max;			/* opcode memory maximum */
-extern address_space	active_address_space[];		/* address spaces */
+/* AdvanceMAME: the context of the active CPU is private of every thread */
+extern THREAD_LOCAL UINT8 			opcode_entry;				/* current entry for opcode fetching */
+extern THREAD_LOCAL UINT8 *			opcode_base;				/* opcode ROM base */
+extern THREAD_LOCAL UINT8 *			opcode_arg_base;			/* opcode RAM base */
+extern THREAD_LOCAL offs_t			opcode_mask;				/* mask to apply to the opcode address */
+extern THREAD_LOCAL offs_t			opcode_memory_min;			/* opcode memory minimum */
+extern THREAD_LOCAL offs_t			opcode_memory_max;			/* opcode memory maximum */
+extern THREAD_LOCAL address_space	active_address_space[];		/* address spaces */
 extern address_map *	construct_map_0(address_map *map);
 
 
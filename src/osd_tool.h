@@ -28,4 +28,9 @@ UINT32 osd_tool_fread(osd_tool_file *file, UINT64 offset, UINT32 count, void *bu
 UINT32 osd_tool_fwrite(osd_tool_file *file, UINT64 offset, UINT32 count, const void *buffer);
 UINT64 osd_tool_flength(osd_tool_file *file);
 
+/* the CHD code also needs osd_parallelize(), osd_lock_*() and osd_work_item_*() */
+/* declared in osdepend.h, to compress and verify with more threads, and */
+/* chdman osd_cycles() to measure the speed. AdvanceMAME implements them for */
+/* the tools in advance/osd/tool.c */
+
 #endif /* __OSD_TOOL_H__ */
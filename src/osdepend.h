@@ -346,6 +346,37 @@ INT32 osd_get_analog_value(unsigned type, unsigned player, int* analog_type);
 /* called then the game is reset */
 void osd_reset(void);
 
+/* run a function splitting the work in max slices, possibly in parallel */
+/* the function is called with num from 0 to max - 1, and max may be reduced */
+void osd_parallelize(void (*func)(void *arg, int num, int max), void *arg, int max);
+
+/* locks used to synchronize the core with the asynchronous work items */
+typedef struct _osd_lock osd_lock;
+osd_lock *osd_lock_alloc(void);
+void osd_lock_acquire(osd_lock *lock);
+void osd_lock_release(osd_lock *lock);
+void osd_lock_free(osd_lock *lock);
+
+/* run a function asynchronously in a worker thread */
+/* return NULL if no thread is available, in such case the function is not called */
+typedef struct _osd_work_item osd_work_item;
+osd_work_item *osd_work_item_queue(void (*func)(void *arg), void *arg);
+
+/* wait the completion of a work item and free it */
+void osd_work_item_wait(osd_work_item *item);
+
+/* start and end a named scope in the trace of the current thread, the scopes can be nested */
+/* the name must be a static string. nothing is done if the trace is not active */
+void osd_trace_begin(const char *name);
+void osd_trace_end(void);
+
+/* get the hash of a file computed in a previous run, if the file, or the zip */
+/* containing the entry, is unchanged. return 0 if found */
+int osd_hash_cache_get(int pathtype, int pathindex, const char *filename, const char *entry, UINT64 length, char *hash);
+
+/* store the hash of a file for the next runs, replacing the one stored before */
+void osd_hash_cache_set(int pathtype, int pathindex, const char *filename, const char *entry, UINT64 length, const char *hash);
+
 /* execute the specified menu (0,1,...) */
 int osd_menu(unsigned menu, int sel);
 
@@ -36,6 +36,7 @@ struct _profile_data
 {
 	UINT64 count[MEMORY][PROFILER_TOTAL];
 	unsigned int cpu_context_switches[MEMORY];
+	UINT64 counter[MEMORY][PROFILER_COUNT_TOTAL];
 };
 typedef struct _profile_data profile_data;
 
@@ -109,6 +110,14 @@ logerror("Profiler error: FILO buffer underflow\n");
 	}
 }
 
+void profiler_count(int type, int value)
+{
+	if (!use_profiler)
+		return;
+
+	profile.counter[memory][type] += value;
+}
+
 const char *profiler_get_text(void)
 {
 	int i,j;
@@ -149,8 +158,15 @@ const char *profiler_get_text(void)
 		"Profilr",
 		"Idle   ",
 	};
+	static const char *counter_names[PROFILER_COUNT_TOTAL] =
+	{
+		"Tmr ins ",
+		"Tmr rem ",
+		"Tmr upd ",
+		"Tmr step",
+	};
 	static int showdelay[PROFILER_TOTAL];
-	static char buf[30*20];
+	static char buf[30*26];
 	char *bufptr = buf;
 
 
@@ -204,11 +220,22 @@ const char *profiler_get_text(void)
 		i += profile.cpu_context_switches[j];
 	bufptr += sprintf(bufptr,"CPU switches%4d\n",i / MEMORY);
 
+	/* counters, as average per frame */
+	for (i = 0;i < PROFILER_COUNT_TOTAL;i++)
+	{
+		computed = 0;
+		for (j = 0;j < MEMORY;j++)
+			computed += profile.counter[j][i];
+		bufptr += sprintf(bufptr,"%s%8d\n",counter_names[i],(int)(computed / MEMORY));
+	}
+
 	/* reset the counters */
 	memory = (memory + 1) % MEMORY;
 	profile.cpu_context_switches[memory] = 0;
 	for (i = 0;i < PROFILER_TOTAL;i++)
 		profile.count[memory][i] = 0;
+	for (i = 0;i < PROFILER_COUNT_TOTAL;i++)
+		profile.counter[memory][i] = 0;
 
 	profiler_mark(PROFILER_END);
 
@@ -56,6 +56,18 @@ enum
 };
 
 
+/* counters */
+enum
+{
+	PROFILER_COUNT_TIMER_INSERT = 0,	/* timers inserted in the queue */
+	PROFILER_COUNT_TIMER_REMOVE,		/* timers removed from the queue */
+	PROFILER_COUNT_TIMER_UPDATE,		/* timers moved in the queue */
+	PROFILER_COUNT_TIMER_STEP,			/* timer queue levels walked by the above operations */
+
+	PROFILER_COUNT_TOTAL
+};
+
+
 /*
 To start profiling a certain section, e.g. video:
 profiler_mark(PROFILER_VIDEO);
@@ -64,10 +76,14 @@ to end profiling the current section:
 profiler_mark(PROFILER_END);
 
 the profiler handles a FILO list so calls may be nested.
+
+to count an event, e.g. a timer insert:
+profiler_count(PROFILER_COUNT_TIMER_INSERT, 1);
 */
 
 #ifdef MAME_DEBUG
 void profiler_mark(int type);
+void profiler_count(int type, int value);
 
 /* functions called by usrintf.c */
 void profiler_start(void);
@@ -75,6 +91,7 @@ void profiler_stop(void);
 const char *profiler_get_text(void);
 #else
 #define profiler_mark(type)
+#define profiler_count(type,value)
 
 #define profiler_start()
 #define profiler_stop()
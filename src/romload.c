@@ -24,6 +24,45 @@
 //#define LOG_LOAD
 
 
+/* max number of files loaded in advance */
+#define FETCH_MAX			16
+
+/* max size of the files loaded in advance */
+#define FETCH_BYTES			(64*1024*1024)
+
+
+
+/***************************************************************************
+
+    Type definitions
+
+***************************************************************************/
+
+/* a ROM file loaded by a worker thread */
+typedef struct _rom_fetch rom_fetch;
+struct _rom_fetch
+{
+	const rom_entry *	romp;				/* entry of the file */
+	UINT32				length;				/* expected length of the file */
+	mame_file *			file;				/* loaded file, NULL if not found */
+	osd_work_item *		item;				/* work item loading the file, NULL if not queued */
+	cycles_t			time;				/* time spent to open, inflate and hash */
+};
+
+/* time spent loading a region */
+typedef struct _rom_load_time rom_load_time;
+struct _rom_load_time
+{
+	int					files;				/* number of files */
+	UINT32				bytes;				/* size of the files */
+	cycles_t			fetch;				/* open, inflate and hash, summed over all the threads */
+	cycles_t			wait;				/* waiting for the files */
+	cycles_t			copy;				/* copy in the region */
+	cycles_t			verify;				/* length and hash verification */
+	cycles_t			total;				/* total time */
+};
+
+
 
 /***************************************************************************
 
@@ -39,6 +78,17 @@ int system_bios;
 
 static int total_rom_load_warnings;
 
+/* ROM files loaded in advance by the worker threads */
+static rom_fetch *fetch_list;
+static int fetch_count;				/* number of files of the region */
+static int fetch_next;				/* next file to load */
+static int fetch_current;			/* next file to copy in the region */
+static UINT32 fetch_bytes;			/* size of the files loaded and not yet copied */
+static int fetch_serial;			/* no worker threads, files are loaded when required */
+
+/* time spent loading the current region */
+static rom_load_time region_time;
+
 
 
 /***************************************************************************
@@ -461,26 +511,176 @@ static void region_post_process(rom_load_data *romdata, const rom_entry *regiond
 
 
 /*-------------------------------------------------
-    open_rom_file - open a ROM file, searching
-    up the parent and loading by checksum
+    fetch_rom_proc - open a ROM file, searching
+    up the parent and loading by checksum. The
+    file is loaded in memory, inflated and hashed
+    by mame_fopen_rom(), and it's called by the
+    worker threads.
 -------------------------------------------------*/
 
-static int open_rom_file(rom_load_data *romdata, const rom_entry *romp)
+static void fetch_rom_proc(void *param)
 {
+	rom_fetch *fetch = param;
 	const game_driver *drv;
+	cycles_t start = osd_cycles();
+
+	/* Attempt reading up the chain through the parents. It automatically also
+       attempts any kind of load by checksum supported by the archives. */
+	fetch->file = NULL;
+	for (drv = Machine->gamedrv; !fetch->file && drv; drv = driver_get_clone(drv))
+		if (drv->name && *drv->name)
+			fetch->file = mame_fopen_rom(drv->name, ROM_GETNAME(fetch->romp), ROM_GETHASHDATA(fetch->romp));
+
+	fetch->time = osd_cycles() - start;
+}
+
+
+/*-------------------------------------------------
+    fetch_start - queue the loads of the next
+    files, up to the limits of files and memory
+-------------------------------------------------*/
+
+static void fetch_start(void)
+{
+	while (!fetch_serial && fetch_next < fetch_count && fetch_next - fetch_current < FETCH_MAX)
+	{
+		rom_fetch *fetch = &fetch_list[fetch_next];
+
+		/* one file is always allowed */
+		if (fetch_next != fetch_current && fetch_bytes + fetch->length > FETCH_BYTES)
+			break;
+
+		fetch->item = osd_work_item_queue(fetch_rom_proc, fetch);
+		if (!fetch->item)
+		{
+			/* no worker threads */
+			fetch_serial = 1;
+			break;
+		}
+
+		fetch_bytes += fetch->length;
+		fetch_next++;
+	}
+}
+
+
+/*-------------------------------------------------
+    fetch_init - collect the files of a region
+    and start to load them
+-------------------------------------------------*/
+
+static void fetch_init(const rom_entry *romp)
+{
+	const rom_entry *entry;
+
+	fetch_count = 0;
+	for (entry = romp; !ROMENTRY_ISREGIONEND(entry); entry++)
+		if (ROMENTRY_ISFILE(entry))
+			fetch_count++;
+
+	fetch_list = malloc_or_die((fetch_count + 1) * sizeof(fetch_list[0]));
+
+	/* the files are in the same order of process_rom_entries() */
+	fetch_count = 0;
+	for (entry = romp; !ROMENTRY_ISREGIONEND(entry); entry++)
+		if (ROMENTRY_ISFILE(entry) && (!ROM_GETBIOSFLAGS(entry) || (ROM_GETBIOSFLAGS(entry) == (system_bios+1))))
+		{
+			rom_fetch *fetch = &fetch_list[fetch_count++];
+			const rom_entry *chunk;
+
+			fetch->romp = entry;
+			fetch->length = ROM_GETLENGTH(entry);
+			for (chunk = entry + 1; ROMENTRY_ISCONTINUE(chunk); chunk++)
+				fetch->length += ROM_GETLENGTH(chunk);
+			fetch->file = NULL;
+			fetch->item = NULL;
+			fetch->time = 0;
+		}
+
+	fetch_next = 0;
+	fetch_current = 0;
+	fetch_bytes = 0;
+	fetch_serial = 0;
+
+	fetch_start();
+}
+
+
+/*-------------------------------------------------
+    fetch_exit - wait the pending loads and close
+    the files not used
+-------------------------------------------------*/
+
+static void fetch_exit(void)
+{
+	int i;
+
+	for (i = fetch_current; i < fetch_next; i++)
+	{
+		osd_work_item_wait(fetch_list[i].item);
+		if (fetch_list[i].file)
+			mame_fclose(fetch_list[i].file);
+	}
+
+	free(fetch_list);
+	fetch_list = NULL;
+	fetch_count = 0;
+}
+
+
+/*-------------------------------------------------
+    open_rom_file - get a ROM file loaded by the
+    worker threads, or load it now
+-------------------------------------------------*/
+
+static int open_rom_file(rom_load_data *romdata, const rom_entry *romp)
+{
+	rom_fetch *fetch = &fetch_list[fetch_current];
+	cycles_t start;
+	int skip;
+
+	assert(fetch_current < fetch_count && fetch->romp == romp);
 
 	++romdata->romsloaded;
 
 	/* update status display */
-	if (osd_display_loading_rom_message(ROM_GETNAME(romp), romdata))
-       return 0;
+	skip = osd_display_loading_rom_message(ROM_GETNAME(romp), romdata);
 
-	/* Attempt reading up the chain through the parents. It automatically also
-       attempts any kind of load by checksum supported by the archives. */
-	romdata->file = NULL;
-	for (drv = Machine->gamedrv; !romdata->file && drv; drv = driver_get_clone(drv))
-		if (drv->name && *drv->name)
-			romdata->file = mame_fopen_rom(drv->name, ROM_GETNAME(romp), ROM_GETHASHDATA(romp));
+	/* wait the file */
+	start = osd_cycles();
+	if (fetch->item)
+	{
+		osd_work_item_wait(fetch->item);
+		fetch->item = NULL;
+		fetch_bytes -= fetch->length;
+	}
+	else
+	{
+		fetch_rom_proc(fetch);
+		fetch_next++;
+	}
+	region_time.wait += osd_cycles() - start;
+	region_time.fetch += fetch->time;
+	region_time.files++;
+
+	fetch_current++;
+
+	/* load the next files while this one is copied */
+	fetch_start();
+
+	romdata->file = fetch->file;
+	fetch->file = NULL;
+
+	if (skip)
+	{
+		if (romdata->file)
+			mame_fclose(romdata->file);
+		romdata->file = NULL;
+		return 0;
+	}
+
+	if (romdata->file)
+		region_time.bytes += mame_fsize(romdata->file);
 
 	/* return the result */
 	return (romdata->file != NULL);
@@ -709,6 +909,10 @@ static int copy_rom_data(rom_load_data *romdata, const rom_entry *romp)
 static int process_rom_entries(rom_load_data *romdata, const rom_entry *romp)
 {
 	UINT32 lastflags = 0;
+	cycles_t start;
+
+	/* start to load the files in the worker threads */
+	fetch_init(romp);
 
 	/* loop until we hit the end of this region */
 	while (!ROMENTRY_ISREGIONEND(romp))
@@ -772,7 +976,9 @@ static int process_rom_entries(rom_load_data *romdata, const rom_entry *romp)
 						explength += ROM_GETLENGTH(&modified_romp);
 
 						/* attempt to read using the modified entry */
+						start = osd_cycles();
 						readresult = read_rom_data(romdata, &modified_romp);
+						region_time.copy += osd_cycles() - start;
 						if (readresult == -1)
 							goto fatalerror;
 					}
@@ -782,7 +988,9 @@ static int process_rom_entries(rom_load_data *romdata, const rom_entry *romp)
 					if (baserom)
 					{
 						debugload("Verifying length (%X) and checksums\n", explength);
+						start = osd_cycles();
 						verify_length_and_hash(romdata, ROM_GETNAME(baserom), explength, ROM_GETHASHDATA(baserom));
+						region_time.verify += osd_cycles() - start;
 						debugload("Verify finished\n");
 					}
 
@@ -812,6 +1020,7 @@ static int process_rom_entries(rom_load_data *romdata, const rom_entry *romp)
 			romp++;	/* something else; skip */
 		}
 	}
+	fetch_exit();
 	return 1;
 
 	/* error case */
@@ -819,10 +1028,25 @@ fatalerror:
 	if (romdata->file)
 		mame_fclose(romdata->file);
 	romdata->file = NULL;
+	fetch_exit();
 	return 0;
 }
 
 
+/*-------------------------------------------------
+    log_load_time - log the time spent loading
+    the ROM files
+-------------------------------------------------*/
+
+static void log_load_time(const char *what, const rom_load_time *time)
+{
+	double ms = 1000.0 / osd_cycles_per_second();
+
+	logerror("romload: %s, %d files, %u KB, total %.1f ms, waiting files %.1f ms, copy %.1f ms, verify %.1f ms, open+inflate+hash %.1f ms on all threads\n",
+		what, time->files, time->bytes / 1024, time->total * ms, time->wait * ms, time->copy * ms, time->verify * ms, time->fetch * ms);
+}
+
+
 /*-------------------------------------------------
     process_disk_entries - process all disk entries
     for a region
@@ -934,12 +1158,17 @@ int rom_init(const rom_entry *romp)
 	const rom_entry *regionlist[REGION_MAX];
 	const rom_entry *region;
 	static rom_load_data romdata;
+	rom_load_time all_time;
+	cycles_t start = osd_cycles();
 	int regnum;
 
 	/* if no roms, bail */
 	if (romp == NULL)
 		return 0;
 
+	/* configure the hunk cache of the disks */
+	chd_set_cache(options.chd_cache, options.chd_readahead);
+
 	/* reset the region list */
 	memset((void *)regionlist, 0, sizeof(regionlist));
 
@@ -950,6 +1179,8 @@ int rom_init(const rom_entry *romp)
 	/* reset the disk list */
 	memset(disk_handle, 0, sizeof(disk_handle));
 
+	memset(&all_time, 0, sizeof(all_time));
+
 	/* determine the correct biosset to load based on options.bios string */
 	system_bios = determine_bios_rom(Machine->gamedrv->bios);
 
@@ -996,8 +1227,23 @@ int rom_init(const rom_entry *romp)
 		/* now process the entries in the region */
 		if (ROMREGION_ISROMDATA(region))
 		{
+			cycles_t start = osd_cycles();
+			char what[32];
+
+			memset(&region_time, 0, sizeof(region_time));
 			if (!process_rom_entries(&romdata, region + 1))
 				return 1;
+			region_time.total = osd_cycles() - start;
+
+			sprintf(what, "region %02X", regiontype);
+			log_load_time(what, &region_time);
+
+			all_time.files += region_time.files;
+			all_time.bytes += region_time.bytes;
+			all_time.fetch += region_time.fetch;
+			all_time.wait += region_time.wait;
+			all_time.copy += region_time.copy;
+			all_time.verify += region_time.verify;
 		}
 		else if (ROMREGION_ISDISKDATA(region))
 		{
@@ -1020,6 +1266,9 @@ int rom_init(const rom_entry *romp)
 			region_post_process(&romdata, regionlist[regnum]);
 		}
 
+	all_time.total = osd_cycles() - start;
+	log_load_time("all regions", &all_time);
+
 	/* display the results and exit */
 	total_rom_load_warnings = romdata.warnings;
 
@@ -126,6 +126,8 @@ enum
 	/* --- the following bits of info are returned as 64-bit signed integers --- */
 	SNDINFO_INT_FIRST = 0x00000,
 
+	SNDINFO_INT_THREAD_SAFE = SNDINFO_INT_FIRST,		/* R/O: AdvanceMAME: the stream update uses only the state of its chip, without calling the core; it can run in a worker thread */
+
 	SNDINFO_INT_CORE_SPECIFIC = 0x08000,				/* R/W: core-specific values start here */
 
 	/* --- the following bits of info are returned as pointers to data or functions --- */
@@ -15,6 +15,7 @@
 #include "config.h"
 #include "profiler.h"
 #include "sound/wavwrite.h"
+#include <zlib.h>
 
 
 
@@ -107,6 +108,8 @@ static int nosound_mode;
 
 static wav_file *wavfile;
 
+static UINT32 sound_hash;					/* AdvanceMAME: hash of the speaker streams, for -debug_statehash */
+
 
 
 /***************************************************************************
@@ -161,7 +164,6 @@ INLINE sound_info *find_sound_by_tag(const char *tag)
 }
 
 
-
 /***************************************************************************
 
     Initialization/Tear Down
@@ -189,6 +191,8 @@ int sound_init(void)
 	if (!samples_this_frame)
 		return 1;
 
+	sound_hash = 0;
+
 	/* allocate memory for mix buffers */
 	leftmix = auto_malloc(Machine->sample_rate * sizeof(*leftmix));
 	rightmix = auto_malloc(Machine->sample_rate * sizeof(*rightmix));
@@ -320,6 +324,7 @@ static int start_sound_chips(void)
 		VPRINTF(("sndnum = %d -- sound_type = %d\n", sndnum, msound->sound_type));
 		num_regs = state_save_get_reg_count();
 		streams_set_tag(info);
+		streams_set_thread_safe(sndtype_get_info_int(msound->sound_type, SNDINFO_INT_THREAD_SAFE));
 		if (sndintrf_init_sound(sndnum, msound->sound_type, msound->clock, msound->config) != 0)
 			return 1;
 
@@ -453,6 +458,7 @@ static int route_sound(void)
 
 	/* now allocate the mixers and input data */
 	streams_set_tag(NULL);
+	streams_set_thread_safe(FALSE);
 	for (spknum = 0; spknum < totalspeakers; spknum++)
 	{
 		speaker_info *info = &speaker[spknum];
@@ -561,6 +567,17 @@ void sound_global_enable(int enable)
 }
 
 
+/*-------------------------------------------------
+    sound_get_hash - AdvanceMAME: return the hash
+    of all the samples generated by the speakers
+-------------------------------------------------*/
+
+UINT32 sound_get_hash(void)
+{
+	return sound_hash;
+}
+
+
 
 /***************************************************************************
 
@@ -654,6 +671,7 @@ void sound_frame_update(void)
 	VPRINTF(("sound_frame_update\n"));
 
 	profiler_mark(PROFILER_SOUND);
+	osd_trace_begin("Sound");
 
 	/* reset the mixing streams */
 	memset(leftmix, 0, samples_this_frame * sizeof(*leftmix));
@@ -673,6 +691,10 @@ void sound_frame_update(void)
 			{
 				stream_buf = stream_consume_output(spk->mixer_stream, 0, samples_this_frame);
 
+				/* AdvanceMAME: hash the generated samples to compare the serial and parallel streams */
+				if (options.state_hash_frame != 0)
+					sound_hash = crc32(sound_hash, (const Bytef *)stream_buf, samples_this_frame * sizeof(*stream_buf));
+
 #ifdef MAME_DEBUG
 				/* debug version: keep track of the maximum sample */
 				for (sample = 0; sample < samples_this_frame; sample++)
@@ -746,6 +768,7 @@ void sound_frame_update(void)
 	/* reset the timer to resync for this frame */
 	mame_timer_adjust(sound_update_timer, time_never, 0, time_never);
 
+	osd_trace_end();
 	profiler_mark(PROFILER_END);
 }
 
@@ -71,6 +71,9 @@ int sound_scalebufferpos(int value);
 /* global sound enable/disable */
 void sound_global_enable(int enable);
 
+/* AdvanceMAME: hash of the generated samples, computed only with -debug_statehash */
+UINT32 sound_get_hash(void);
+
 /* user gain controls on speaker inputs for mixing */
 int sound_get_user_gain_count(void);
 void sound_set_user_gain(int index, float gain);
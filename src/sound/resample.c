@@ -0,0 +1,220 @@
+/***************************************************************************
+
+    resample.c
+
+    Resample the audio streams at a different sample rate
+
+    AdvanceMAME: the resampler of streams.c, in a separate file without
+    dependencies on the core to also build it in the advance/bench
+    benchmark.
+
+***************************************************************************/
+
+#include "resample.h"
+
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI    3.14159265358979323846
+#endif
+
+#define SINC_ZEROS						8
+#define SINC_CUTOFF						0.45
+#define SINC_BETA						8.0
+#define SINC_COEF_BITS					16
+
+
+
+/*************************************
+ *
+ *  Compute the polyphase windowed
+ *  sinc filter
+ *
+ *************************************/
+
+static double sinc_bessel_i0(double x)
+{
+	double sum = 1.0, term = 1.0;
+	int k;
+
+	for (k = 1; k < 32; k++)
+	{
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+		if (term < sum * 1E-12)
+			break;
+	}
+
+	return sum;
+}
+
+
+int resample_sinc_compute(INT32 *coef_table, UINT32 step)
+{
+	double ratio = (double)step / RESAMPLE_FRAC_ONE;
+	double cutoff, norm;
+	int half, taps, phase, k;
+
+	/* the cutoff is below the Nyquist frequency of the slower of the two rates */
+	if (ratio < 1.0)
+		ratio = 1.0;
+	cutoff = SINC_CUTOFF / ratio;
+
+	/* the filter spans SINC_ZEROS zero crossings on each side, limited by the */
+	/* table size; with a very large ratio keep the box filter */
+	half = (int)ceil(SINC_ZEROS * ratio);
+	if (half > RESAMPLE_SINC_TAPS_MAX / 2)
+	{
+		if (ratio * 4 > RESAMPLE_SINC_TAPS_MAX)
+			return 0;
+		half = RESAMPLE_SINC_TAPS_MAX / 2;
+	}
+	taps = 2 * half;
+
+	norm = sinc_bessel_i0(SINC_BETA);
+
+	for (phase = 0; phase <= RESAMPLE_SINC_PHASES; phase++)
+	{
+		INT32 *coef = coef_table + phase * taps;
+		double frac = (double)phase / RESAMPLE_SINC_PHASES;
+		double value[RESAMPLE_SINC_TAPS_MAX];
+		double sum = 0;
+		INT32 total = 0;
+
+		/* tap k reads the source sample at (pos >> FRAC_BITS) + 2 - taps + k, */
+		/* the output is delayed by half - 1 samples to never read ahead of pos + 1 */
+		for (k = 0; k < taps; k++)
+		{
+			double t = k + 1 - half - frac;
+			double x = t / half;
+			double h = 2 * cutoff;
+
+			if (t != 0)
+				h = sin(2 * M_PI * cutoff * t) / (M_PI * t);
+			if (x <= -1 || x >= 1)
+				h = 0;
+			else
+				h *= sinc_bessel_i0(SINC_BETA * sqrt(1 - x * x)) / norm;
+
+			value[k] = h;
+			sum += h;
+		}
+
+		/* normalize to unity gain, and put the rounding error in the center tap */
+		for (k = 0; k < taps; k++)
+		{
+			coef[k] = (INT32)floor(value[k] / sum * (1 << SINC_COEF_BITS) + 0.5);
+			total += coef[k];
+		}
+		coef[half - 1] += (1 << SINC_COEF_BITS) - total;
+	}
+
+	return taps;
+}
+
+
+
+/*************************************
+ *
+ *  Resample a stream into the
+ *  correct sample rate with gain
+ *  adjustment
+ *
+ *  The loops are written without
+ *  loop carried dependencies to let
+ *  the compiler vectorize them
+ *
+ *************************************/
+
+UINT32 resample_process(INT32 *dest, const INT32 *source, UINT32 pos, UINT32 step, int gain, const INT32 *sinc_coef, int sinc_taps, int samples)
+{
+	INT32 sample;
+	int i;
+
+	/* perfectly matching */
+	if (step == RESAMPLE_FRAC_ONE)
+	{
+		const INT32 *src = source + (pos >> RESAMPLE_FRAC_BITS);
+
+		for (i = 0; i < samples; i++)
+			dest[i] = (src[i] * gain) >> 8;
+		pos += samples << RESAMPLE_FRAC_BITS;
+	}
+
+	/* band-limited: polyphase windowed sinc filter */
+	else if (sinc_taps != 0)
+	{
+		int taps = sinc_taps;
+
+		for (i = 0; i < samples; i++)
+		{
+			INT32 first = (INT32)(pos >> RESAMPLE_FRAC_BITS) + 2 - taps;
+			int phase = ((pos & RESAMPLE_FRAC_MASK) + (1 << (RESAMPLE_FRAC_BITS - RESAMPLE_SINC_PHASE_BITS - 1))) >> (RESAMPLE_FRAC_BITS - RESAMPLE_SINC_PHASE_BITS);
+			const INT32 *coef = sinc_coef + phase * taps;
+			INT64 acc = 0;
+			int k = 0;
+
+			/* before the start of the source data assume silence */
+			if (first < 0)
+				k = -first;
+			for (; k < taps; k++)
+				acc += (INT64)source[first + k] * coef[k];
+
+			sample = (INT32)((acc + (1 << (SINC_COEF_BITS - 1))) >> SINC_COEF_BITS);
+			dest[i] = (sample * gain) >> 8;
+			pos += step;
+		}
+	}
+
+	/* input is undersampled: use linear interpolation */
+	else if (step < RESAMPLE_FRAC_ONE)
+	{
+		for (i = 0; i < samples; i++)
+		{
+			UINT32 tpos = pos + i * step;
+			const INT32 *src = source + (tpos >> RESAMPLE_FRAC_BITS);
+			INT32 frac = tpos & RESAMPLE_FRAC_MASK;
+
+			/* compute the sample */
+			sample = (src[0] * (RESAMPLE_FRAC_ONE - frac) + src[1] * frac) >> RESAMPLE_FRAC_BITS;
+			dest[i] = (sample * gain) >> 8;
+		}
+		pos += samples * step;
+	}
+
+	/* input is oversampled: sum the energy */
+	else
+	{
+		/* use 8 bits to allow some extra headroom */
+		int smallstep = step >> (RESAMPLE_FRAC_BITS - 8);
+
+		for (i = 0; i < samples; i++)
+		{
+			const INT32 *src = source + (pos >> RESAMPLE_FRAC_BITS);
+			int scale = (RESAMPLE_FRAC_ONE - (pos & RESAMPLE_FRAC_MASK)) >> (RESAMPLE_FRAC_BITS - 8);
+			int remainder = smallstep - scale;
+			int count = remainder > 0x100 ? (remainder - 1) >> 8 : 0;
+			INT32 sum = 0;
+			int k;
+
+			/* the full samples in the middle have all the same weight */
+			for (k = 1; k <= count; k++)
+				sum += src[k];
+			remainder -= count * 0x100;
+
+			/* compute the sample, divided in the next loop */
+			dest[i] = src[0] * scale + sum * 0x100 + src[count + 1] * remainder;
+			pos += step;
+		}
+
+		/* the division in double precision is exact for 32 bit integers, */
+		/* and unlike the integer division it's vectorized */
+		for (i = 0; i < samples; i++)
+		{
+			sample = (INT32)(dest[i] / (double)smallstep);
+			dest[i] = (sample * gain) >> 8;
+		}
+	}
+
+	return pos;
+}
@@ -0,0 +1,38 @@
+/***************************************************************************
+
+    resample.h
+
+    Resample the audio streams at a different sample rate
+
+    AdvanceMAME: the resampler of streams.c, in a separate file without
+    dependencies on the core to also build it in the advance/bench
+    benchmark.
+
+***************************************************************************/
+
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+#include "osd_cpu.h"
+
+/* fixed point format of the source position and step */
+#define RESAMPLE_FRAC_BITS				14
+#define RESAMPLE_FRAC_ONE				(1 << RESAMPLE_FRAC_BITS)
+#define RESAMPLE_FRAC_MASK				(RESAMPLE_FRAC_ONE - 1)
+
+/* size of the polyphase filter table */
+#define RESAMPLE_SINC_PHASE_BITS		6
+#define RESAMPLE_SINC_PHASES			(1 << RESAMPLE_SINC_PHASE_BITS)
+#define RESAMPLE_SINC_TAPS_MAX			128
+#define RESAMPLE_SINC_SIZE				((RESAMPLE_SINC_PHASES + 1) * RESAMPLE_SINC_TAPS_MAX)
+
+/* compute the windowed sinc filter table of RESAMPLE_SINC_SIZE entries for a source step */
+/* returns the number of taps, or 0 if the ratio is too large to use the filter */
+int resample_sinc_compute(INT32 *coef, UINT32 step);
+
+/* resample the source from the position pos with the step and the gain in 8.8 format */
+/* the sinc filter is used if sinc_taps isn't 0, otherwise the linear interpolation or */
+/* the box filter; returns the source position after the last sample */
+UINT32 resample_process(INT32 *dest, const INT32 *source, UINT32 pos, UINT32 step, int gain, const INT32 *sinc_coef, int sinc_taps, int samples);
+
+#endif
@@ -825,6 +825,28 @@ void state_save_save_continue(void)
 }
 
 
+/*-------------------------------------------------
+    state_save_hash_continue - AdvanceMAME: hash
+    the data within the current tag, like saving
+    it, to compare different runs
+-------------------------------------------------*/
+
+UINT32 state_save_hash_continue(UINT32 crc)
+{
+	ss_entry *entry;
+
+	/* call the pre-save functions */
+	call_hook_functions(ss_prefunc_reg);
+
+	/* iterate over entries with matching tags */
+	for (entry = ss_registry; entry; entry = entry->next)
+		if (entry->tag == ss_current_tag)
+			crc = crc32(crc, (UINT8 *)entry->data, entry->typesize * entry->typecount);
+
+	return crc;
+}
+
+
 /*-------------------------------------------------
     state_save_save_finish - finish saving the
     file by writing the header and closing
@@ -103,6 +103,9 @@ void state_save_pop_tag(void);
 void state_save_save_continue(void);
 void state_save_load_continue(void);
 
+/* AdvanceMAME: hash of the data within the current tag */
+UINT32 state_save_hash_continue(UINT32 crc);
+
 void state_save_save_finish(void);
 void state_save_load_finish(void);
 
@@ -11,7 +11,7 @@
 
 #include "driver.h"
 #include "streams.h"
-#include <math.h>
+#include "sound/resample.h"
 
 #define VERBOSE			(0)
 
@@ -30,9 +30,9 @@
 #define OUTPUT_TOSS_SAMPLES_THRESH		(OUTPUT_BUFFER_SAMPLES/2)
 #define OUTPUT_KEEP_SAMPLES				256
 
-#define FRAC_BITS						14
-#define FRAC_ONE						(1 << FRAC_BITS)
-#define FRAC_MASK						(FRAC_ONE - 1)
+#define FRAC_BITS						RESAMPLE_FRAC_BITS
+#define FRAC_ONE						RESAMPLE_FRAC_ONE
+#define FRAC_MASK						RESAMPLE_FRAC_MASK
 
 
 
@@ -52,6 +52,10 @@ struct stream_input
 	UINT32			resample_in_pos;			/* resample index where next sample will be written */
 	UINT32			resample_out_pos;			/* resample index where next sample will be read */
 	INT16			gain;						/* gain to apply to this input */
+	INT32 *			sinc_coef;					/* polyphase filter table, NULL if not used */
+	UINT32			sinc_step;					/* step_frac the filter table was computed for */
+	int				sinc_taps;					/* taps of the filter, 0 if not usable */
+	int				slot;						/* slice of the parallel generation, -1 if none */
 };
 
 
@@ -71,6 +75,9 @@ struct _sound_stream
 	struct _sound_stream *next;					/* next stream in the chain */
 	void *			tag;						/* tag (used for identification) */
 	int				index;						/* index for save states */
+	int				thread_safe;				/* the callback can run in a worker thread */
+	int				group;						/* group of the streams connected to this one */
+	int				group_safe;					/* all the streams of the group are thread safe */
 
 	/* general information */
 	INT32			sample_rate;				/* sample rate of this stream */
@@ -102,7 +109,9 @@ struct _sound_stream
 
 static sound_stream *stream_head;
 static void *stream_current_tag;
+static int stream_current_thread_safe;
 static int stream_index;
+static int stream_groups_dirty;
 
 
 
@@ -113,6 +122,7 @@ static int stream_index;
  *************************************/
 
 static void stream_generate_samples(sound_stream *stream, int samples);
+static void stream_generate_samples_parallel(sound_stream *stream, int samples);
 static void resample_input_stream(struct stream_input *input, int samples);
 
 
@@ -128,7 +138,9 @@ int streams_init(void)
 	/* reset globals */
 	stream_head = NULL;
 	stream_current_tag = NULL;
+	stream_current_thread_safe = FALSE;
 	stream_index = 0;
+	stream_groups_dirty = TRUE;
 
 	return 0;
 }
@@ -148,6 +160,20 @@ void streams_set_tag(void *streamtag)
 
 
 
+/*************************************
+ *
+ *  Set if the streams created by the
+ *  current sound chip are thread safe
+ *
+ *************************************/
+
+void streams_set_thread_safe(int thread_safe)
+{
+	stream_current_thread_safe = thread_safe;
+}
+
+
+
 /*************************************
  *
  *  Update all
@@ -300,6 +326,7 @@ sound_stream *stream_create(int inputs, int outputs, int sample_rate, void *para
 	/* fill in the data */
 	stream->tag         = stream_current_tag;
 	stream->index		= stream_index++;
+	stream->thread_safe	= stream_current_thread_safe;
 	stream->sample_rate = sample_rate;
 	stream->samples_per_frame_frac = (UINT32)((double)sample_rate * (double)(1 << FRAC_BITS) / Machine->drv->frames_per_second);
 	stream->inputs      = inputs;
@@ -317,6 +344,8 @@ sound_stream *stream_create(int inputs, int outputs, int sample_rate, void *para
 	{
 		stream->input[inputnum].resample = auto_malloc(RESAMPLE_BUFFER_SAMPLES * sizeof(*stream->input[inputnum].resample));
 		stream->input[inputnum].gain = 0x100;
+		if (options.sound_resample_sinc)
+			stream->input[inputnum].sinc_coef = auto_malloc(RESAMPLE_SINC_SIZE * sizeof(*stream->input[inputnum].sinc_coef));
 		state_save_register_item(statetag, inputnum, stream->input[inputnum].gain);
 	}
 
@@ -338,6 +367,7 @@ sound_stream *stream_create(int inputs, int outputs, int sample_rate, void *para
 		for (temp = stream_head; temp->next; temp = temp->next) ;
 		temp->next = stream;
 	}
+	stream_groups_dirty = TRUE;
 
 	return stream;
 }
@@ -382,6 +412,7 @@ void stream_set_input(sound_stream *stream, int index, sound_stream *input_strea
 	/* update the dependent info */
 	if (input->source)
 		input->source->dependents++;
+	stream_groups_dirty = TRUE;
 }
 
 
@@ -517,7 +548,7 @@ stream_sample_t *stream_consume_output(sound_stream *stream, int outputnum, int
 	VPRINTF(("stream_consume_output(%p, %d, %d)\n", stream, outputnum, samples));
 
 	/* if we don't have enough samples, fix it */
-	stream_generate_samples(stream, target_sample - output->cur_in_pos);
+	stream_generate_samples_parallel(stream, target_sample - output->cur_in_pos);
 
 	/* return a pointer to the buffer, and adjust the base */
 	output->cur_out_pos += samples;
@@ -609,79 +640,207 @@ static void stream_generate_samples(sound_stream *stream, int samples)
 
 /*************************************
  *
- *  Resample an input stream into the
- *  correct sample rate with gain
- *  adjustment
+ *  Compute the groups of connected
+ *  streams, without the final ones;
+ *  streams in different groups don't
+ *  share any state
  *
  *************************************/
 
-static void resample_input_stream(struct stream_input *input, int samples)
+static void streams_compute_groups(void)
 {
-	stream_sample_t *dest = input->resample + input->resample_in_pos;
-	stream_sample_t *source = input->source->buffer;
-	INT16 gain = (input->gain * input->source->gain) >> 8;
-	UINT32 pos = input->source_frac;
-	UINT32 step = input->step_frac;
-	INT32 sample;
+	sound_stream *stream, *other;
+	int inputnum;
 
-	VPRINTF(("    resample_input_stream -- step = %d\n", step));
+	/* every stream starts in its own group */
+	for (stream = stream_head; stream != NULL; stream = stream->next)
+	{
+		stream->group = stream->index;
+		stream->group_safe = TRUE;
+	}
 
-	/* perfectly matching */
-	if (step == FRAC_ONE)
+	/* merge the groups of every input with the group of the stream */
+	for (stream = stream_head; stream != NULL; stream = stream->next)
 	{
-		while (samples--)
+		int outputnum, dependents = 0;
+
+		/* the final streams, like the speaker mixers, don't join the groups of their inputs */
+		for (outputnum = 0; outputnum < stream->outputs; outputnum++)
+			dependents += stream->output[outputnum].dependents;
+		if (dependents == 0)
+			continue;
+
+		for (inputnum = 0; inputnum < stream->inputs; inputnum++)
 		{
-			/* compute the sample */
-			sample = source[pos >> FRAC_BITS];
-			*dest++ = (sample * gain) >> 8;
-			pos += FRAC_ONE;
+			sound_stream *source = stream->input[inputnum].stream;
+
+			if (source != NULL && source->group != stream->group)
+			{
+				int group1 = source->group;
+				int group2 = stream->group;
+				int group = (group1 < group2) ? group1 : group2;
+
+				for (other = stream_head; other != NULL; other = other->next)
+					if (other->group == group1 || other->group == group2)
+						other->group = group;
+			}
 		}
 	}
 
-	/* input is undersampled: use linear interpolation */
-	else if (step < FRAC_ONE)
+	/* a single stream not thread safe forces all its group in the emulation thread */
+	for (stream = stream_head; stream != NULL; stream = stream->next)
+		if (!stream->thread_safe)
+			for (other = stream_head; other != NULL; other = other->next)
+				if (other->group == stream->group)
+					other->group_safe = FALSE;
+
+	stream_groups_dirty = FALSE;
+}
+
+
+
+/*************************************
+ *
+ *  Generate the source samples of the
+ *  inputs of a stream in parallel
+ *
+ *************************************/
+
+struct stream_parallel_info
+{
+	sound_stream *	stream;						/* stream to generate */
+	int				samples;					/* number of samples to generate */
+};
+
+
+static void stream_generate_inputs_slice(void *arg, int num, int max)
+{
+	struct stream_parallel_info *info = arg;
+	sound_stream *stream = info->stream;
+	int inputnum;
+
+	osd_trace_begin("Sound group");
+
+	/* same computation of stream_generate_samples(), in the same order, */
+	/* but only for the inputs of this slice */
+	for (inputnum = 0; inputnum < stream->inputs; inputnum++)
 	{
-		while (samples--)
+		struct stream_input *input = &stream->input[inputnum];
+		INT32 resample_samples_needed;
+
+		if (input->slot < 0 || input->slot % max != num)
+			continue;
+
+		resample_samples_needed = input->resample_out_pos + info->samples - input->resample_in_pos;
+		if (resample_samples_needed > 0)
 		{
-			/* compute the sample */
-			sample  = source[(pos >> FRAC_BITS) + 0] * (FRAC_ONE - (pos & FRAC_MASK));
-			sample += source[(pos >> FRAC_BITS) + 1] * (pos & FRAC_MASK);
-			sample >>= FRAC_BITS;
-			*dest++ = (sample * gain) >> 8;
-			pos += step;
+			UINT32 target_source_frac = input->source_frac + resample_samples_needed * input->step_frac;
+			INT32 source_samples_needed;
+
+			if (input->step_frac < FRAC_ONE)
+				target_source_frac += FRAC_ONE;
+
+			source_samples_needed = ((target_source_frac + FRAC_ONE - 1) >> FRAC_BITS) - input->source->cur_in_pos;
+			if (source_samples_needed > 0)
+				stream_generate_samples(input->stream, source_samples_needed);
 		}
 	}
 
-	/* input is oversampled: sum the energy */
-	else
+	osd_trace_end();
+}
+
+
+static void stream_generate_samples_parallel(sound_stream *stream, int samples)
+{
+	struct stream_parallel_info info;
+	int inputnum, slots;
+
+	/* if we're already there, skip it */
+	if (samples <= 0)
+		return;
+
+	/* the parallel generation is enabled only on request */
+	if (!options.sound_parallel)
 	{
-		/* use 8 bits to allow some extra headroom */
-		int smallstep = step >> (FRAC_BITS - 8);
+		stream_generate_samples(stream, samples);
+		return;
+	}
 
-		while (samples--)
-		{
-			int tpos = pos >> FRAC_BITS;
-			int remainder = smallstep;
-			int scale;
-
-			/* compute the sample */
-			scale = (FRAC_ONE - (pos & FRAC_MASK)) >> (FRAC_BITS - 8);
-			sample = source[tpos++] * scale;
-			remainder -= scale;
-			while (remainder > 0x100)
+	if (stream_groups_dirty)
+		streams_compute_groups();
+
+	/* assign a slot to every thread safe group of the inputs, the others */
+	/* are generated later by the serial case in the emulation thread */
+	slots = 0;
+	for (inputnum = 0; inputnum < stream->inputs; inputnum++)
+	{
+		struct stream_input *input = &stream->input[inputnum];
+		int prevnum;
+
+		input->slot = -1;
+		if (input->stream == NULL || !input->stream->group_safe)
+			continue;
+
+		for (prevnum = 0; prevnum < inputnum; prevnum++)
+			if (stream->input[prevnum].slot >= 0 && stream->input[prevnum].stream->group == input->stream->group)
 			{
-				sample += source[tpos++] * 0x100;
-				remainder -= 0x100;
+				input->slot = stream->input[prevnum].slot;
+				break;
 			}
-			sample += source[tpos] * remainder;
-			sample /= smallstep;
+		if (input->slot < 0)
+			input->slot = slots++;
+	}
 
-			*dest++ = (sample * gain) >> 8;
-			pos += step;
-		}
+	/* the independent groups are generated in parallel, every group in the same order */
+	/* of the serial case, then the serial case finds all the source samples already there */
+	if (slots > 1)
+	{
+		VPRINTF(("stream_generate_samples_parallel(%p, %d) with %d groups\n", stream, samples, slots));
+
+		info.stream = stream;
+		info.samples = samples;
+		osd_parallelize(stream_generate_inputs_slice, &info, slots);
 	}
 
+	stream_generate_samples(stream, samples);
+}
+
+
+
+/*************************************
+ *
+ *  Resample an input stream into the
+ *  correct sample rate with gain
+ *  adjustment
+ *
+ *  The loops are written without
+ *  loop carried dependencies to let
+ *  the compiler vectorize them
+ *
+ *************************************/
+
+static void resample_input_stream(struct stream_input *input, int samples)
+{
+	stream_sample_t *dest = input->resample + input->resample_in_pos;
+	stream_sample_t *source = input->source->buffer;
+	INT16 gain = (input->gain * input->source->gain) >> 8;
+	UINT32 pos = input->source_frac;
+	UINT32 step = input->step_frac;
+
+	VPRINTF(("    resample_input_stream -- step = %d\n", step));
+
+	/* AdvanceMAME: the resampler is in sound/resample.c */
+	if (step != FRAC_ONE && input->sinc_coef != NULL && input->sinc_step != step)
+	{
+		input->sinc_step = step;
+		input->sinc_taps = resample_sinc_compute(input->sinc_coef, step);
+
+		VPRINTF(("    resample_sinc_compute -- step = %d, taps = %d\n", step, input->sinc_taps));
+	}
+
+	pos = resample_process(dest, source, pos, step, gain, input->sinc_coef, input->sinc_coef != NULL ? input->sinc_taps : 0, samples);
+
 	/* update the input parameters */
-	input->resample_in_pos = dest - input->resample;
+	input->resample_in_pos += samples;
 	input->source_frac = pos;
 }
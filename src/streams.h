@@ -20,6 +20,7 @@ typedef void (*stream_callback)(void *param, stream_sample_t **inputs, stream_sa
 
 int streams_init(void);
 void streams_set_tag(void *streamtag);
+void streams_set_thread_safe(int thread_safe);	/* the next streams created can be generated in a worker thread */
 void streams_frame_update(void);
 
 /* core stream configuration and operation */
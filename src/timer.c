@@ -33,7 +33,8 @@
     CONSTANTS
 ***************************************************************************/
 
-#define MAX_TIMERS		256
+/* timers are allocated in blocks, a new block is added when all are used */
+#define TIMER_BLOCK_SIZE	64
 
 
 
@@ -45,7 +46,9 @@
 struct _mame_timer
 {
 	mame_timer *	next;
-	mame_timer *	prev;
+	int				index;
+	UINT64			seq;
+	mame_time		key;
 	void 			(*callback)(int);
 	void			(*callback_ptr)(void *);
 	int 			callback_param;
@@ -62,6 +65,14 @@ struct _mame_timer
 	mame_time 		expire;
 };
 
+/* block of contiguous timers */
+typedef struct _timer_block timer_block;
+struct _timer_block
+{
+	timer_block *	next;
+	mame_timer		timers[TIMER_BLOCK_SIZE];
+};
+
 
 
 /***************************************************************************
@@ -74,9 +85,15 @@ UINT32 cycles_per_second[MAX_CPU];
 double cycles_to_sec[MAX_CPU];
 double sec_to_cycles[MAX_CPU];
 
-/* list of active timers */
-static mame_timer timers[MAX_TIMERS];
-static mame_timer *timer_head;
+/* allocated blocks of timers */
+static timer_block *timer_block_list;
+static int timer_block_count;
+
+/* queue of active timers, a binary heap ordered by expire time and insertion */
+static mame_timer **timer_heap;
+static int timer_heap_count;
+static int timer_heap_max;
+static UINT64 timer_seq;
 static mame_timer *timer_free_head;
 static mame_timer *timer_free_tail;
 
@@ -97,6 +114,7 @@ mame_time time_never;
 ***************************************************************************/
 
 static void timer_postload(void);
+static void timer_exit(void);
 static void timer_logtimers(void);
 static void mame_timer_remove(mame_timer *which);
 
@@ -130,6 +148,49 @@ INLINE mame_time get_current_time(void)
 }
 
 
+/*-------------------------------------------------
+    timer_grow - add a new block of timers to
+    the free list
+-------------------------------------------------*/
+
+static void timer_grow(void)
+{
+	timer_block *block;
+	mame_timer **heap;
+	int i;
+
+	/* allocate the new block */
+	block = malloc_or_die(sizeof(*block));
+	memset(block, 0, sizeof(*block));
+	block->next = timer_block_list;
+	timer_block_list = block;
+	timer_block_count++;
+
+	/* the queue must be able to hold all the timers */
+	heap = realloc(timer_heap, timer_block_count * TIMER_BLOCK_SIZE * sizeof(*heap));
+	if (!heap)
+		fatalerror("Out of memory allocating %d timers", timer_block_count * TIMER_BLOCK_SIZE);
+	timer_heap = heap;
+
+	/* link the new timers at the end of the free list */
+	for (i = 0; i < TIMER_BLOCK_SIZE; i++)
+	{
+		mame_timer *timer = &block->timers[i];
+
+		timer->tag = -1;
+		timer->index = -1;
+		timer->next = NULL;
+		if (timer_free_tail)
+			timer_free_tail->next = timer;
+		else
+			timer_free_head = timer;
+		timer_free_tail = timer;
+	}
+
+	LOG(("timer_grow: %d timers allocated\n", timer_block_count * TIMER_BLOCK_SIZE));
+}
+
+
 /*-------------------------------------------------
     timer_new - allocate a new timer
 -------------------------------------------------*/
@@ -138,13 +199,11 @@ INLINE mame_timer *timer_new(void)
 {
 	mame_timer *timer;
 
-	/* remove an empty entry */
+	/* grow if there isn't an empty entry */
 	if (!timer_free_head)
-	{
-		timer_logtimers();
-		fatalerror("Out of timers!");
-		return NULL;
-	}
+		timer_grow();
+
+	/* remove an empty entry */
 	timer = timer_free_head;
 	timer_free_head = timer->next;
 	if (!timer_free_head)
@@ -154,87 +213,188 @@ INLINE mame_timer *timer_new(void)
 }
 
 
+/*-------------------------------------------------
+    timer_before - return true if the first timer
+    fires before the second one; timers with the
+    same expire time fire in insertion order
+-------------------------------------------------*/
+
+INLINE int timer_before(const mame_timer *timer1, const mame_timer *timer2)
+{
+	int cmp = compare_mame_times(timer1->key, timer2->key);
+	if (cmp != 0)
+		return cmp < 0;
+	return timer1->seq < timer2->seq;
+}
+
+
+/*-------------------------------------------------
+    timer_heap_up - move a timer toward the root
+    of the heap until it's in order
+-------------------------------------------------*/
+
+INLINE int timer_heap_up(mame_timer *timer)
+{
+	int index = timer->index;
+	int steps = 0;
+
+	while (index > 0)
+	{
+		int parent = (index - 1) / 2;
+		mame_timer *t = timer_heap[parent];
+
+		if (!timer_before(timer, t))
+			break;
+
+		timer_heap[index] = t;
+		t->index = index;
+		index = parent;
+		steps++;
+	}
+
+	timer_heap[index] = timer;
+	timer->index = index;
+	return steps;
+}
+
+
+/*-------------------------------------------------
+    timer_heap_down - move a timer toward the
+    leaves of the heap until it's in order
+-------------------------------------------------*/
+
+INLINE int timer_heap_down(mame_timer *timer)
+{
+	int index = timer->index;
+	int steps = 0;
+
+	while (1)
+	{
+		int child = index * 2 + 1;
+		mame_timer *t;
+
+		if (child >= timer_heap_count)
+			break;
+
+		/* pick the earlier of the two children */
+		if (child + 1 < timer_heap_count && timer_before(timer_heap[child + 1], timer_heap[child]))
+			child++;
+
+		t = timer_heap[child];
+		if (!timer_before(t, timer))
+			break;
+
+		timer_heap[index] = t;
+		t->index = index;
+		index = child;
+		steps++;
+	}
+
+	timer_heap[index] = timer;
+	timer->index = index;
+	return steps;
+}
+
+
 /*-------------------------------------------------
     timer_list_insert - insert a new timer into
-    the list at the appropriate location
+    the queue at the appropriate location
 -------------------------------------------------*/
 
 INLINE void timer_list_insert(mame_timer *timer)
 {
-	mame_time expire = timer->enabled ? timer->expire : time_never;
-	mame_timer *t, *lt = NULL;
+	int steps;
 
 	/* sanity checks for the debug build */
 	#ifdef MAME_DEBUG
 	{
-		int tnum = 0;
-
-		/* loop over the timer list */
-		for (t = timer_head; t; t = t->next, tnum++)
-		{
-			if (t == timer)
-				fatalerror("This timer is already inserted in the list!");
-			if (tnum == MAX_TIMERS-1)
-				fatalerror("Timer list is full!");
-		}
+		if (timer->index >= 0 && timer->index < timer_heap_count && timer_heap[timer->index] == timer)
+			fatalerror("This timer is already inserted in the list!");
+		if (timer_heap_count == timer_block_count * TIMER_BLOCK_SIZE)
+			fatalerror("Timer list is full!");
 	}
 	#endif
 
-	/* loop over the timer list */
-	for (t = timer_head; t; lt = t, t = t->next)
-	{
-		/* if the current list entry expires after us, we should be inserted before it */
-		if (compare_mame_times(t->expire, expire) > 0)
-		{
-			/* link the new guy in before the current list entry */
-			timer->prev = t->prev;
-			timer->next = t;
+	/* disabled timers are ordered as they never expire */
+	timer->key = timer->enabled ? timer->expire : time_never;
+	timer->seq = timer_seq++;
 
-			if (t->prev)
-				t->prev->next = timer;
-			else
-				timer_head = timer;
-			t->prev = timer;
-			return;
-		}
-	}
+	/* add as last leaf and move it up */
+	timer->index = timer_heap_count++;
+	steps = timer_heap_up(timer);
 
-	/* need to insert after the last one */
-	if (lt)
-		lt->next = timer;
-	else
-		timer_head = timer;
-	timer->prev = lt;
-	timer->next = NULL;
+	/* keep track of the high-water mark */
+	if (timer_heap_max < timer_heap_count)
+		timer_heap_max = timer_heap_count;
+
+	profiler_count(PROFILER_COUNT_TIMER_INSERT, 1);
+	profiler_count(PROFILER_COUNT_TIMER_STEP, steps);
 }
 
 
 /*-------------------------------------------------
     timer_list_remove - remove a timer from the
-    linked list
+    queue
 -------------------------------------------------*/
 
 INLINE void timer_list_remove(mame_timer *timer)
 {
+	int index = timer->index;
+	int steps = 0;
+	mame_timer *last;
+
 	/* sanity checks for the debug build */
 	#ifdef MAME_DEBUG
 	{
-		mame_timer *t;
+		if (index < 0 || index >= timer_heap_count || timer_heap[index] != timer)
+			fatalerror("timer (%s from %s:%d) not found in list", timer->func, timer->file, timer->line);
+	}
+	#endif
+
+	/* replace it with the last leaf and restore the order */
+	last = timer_heap[--timer_heap_count];
+	if (last != timer)
+	{
+		last->index = index;
+		steps = timer_heap_up(last);
+		if (steps == 0)
+			steps = timer_heap_down(last);
+	}
+	timer->index = -1;
+
+	profiler_count(PROFILER_COUNT_TIMER_REMOVE, 1);
+	profiler_count(PROFILER_COUNT_TIMER_STEP, steps);
+}
+
+
+/*-------------------------------------------------
+    timer_list_update - move a timer already in
+    the queue after a change of its expire time;
+    it's the same as a remove followed by an
+    insert, but without the extra moves
+-------------------------------------------------*/
 
-		/* loop over the timer list */
-		for (t = timer_head; t && t != timer; t = t->next) ;
-		if (t == NULL)
+INLINE void timer_list_update(mame_timer *timer)
+{
+	int steps;
+
+	/* sanity checks for the debug build */
+	#ifdef MAME_DEBUG
+	{
+		if (timer->index < 0 || timer->index >= timer_heap_count || timer_heap[timer->index] != timer)
 			fatalerror("timer (%s from %s:%d) not found in list", timer->func, timer->file, timer->line);
 	}
 	#endif
 
-	/* remove it from the list */
-	if (timer->prev)
-		timer->prev->next = timer->next;
-	else
-		timer_head = timer->next;
-	if (timer->next)
-		timer->next->prev = timer->prev;
+	timer->key = timer->enabled ? timer->expire : time_never;
+	timer->seq = timer_seq++;
+
+	steps = timer_heap_up(timer);
+	if (steps == 0)
+		steps = timer_heap_down(timer);
+
+	profiler_count(PROFILER_COUNT_TIMER_UPDATE, 1);
+	profiler_count(PROFILER_COUNT_TIMER_STEP, steps);
 }
 
 
@@ -251,8 +411,6 @@ INLINE void timer_list_remove(mame_timer *timer)
 
 void timer_init(void)
 {
-	int i;
-
 	/* init the constant times */
 	time_zero.seconds = time_zero.subseconds = 0;
 	time_never.seconds = MAX_SECONDS;
@@ -270,19 +428,50 @@ void timer_init(void)
 	state_save_register_func_postload(timer_postload);
 	state_save_pop_tag();
 
-	/* reset the timers */
-	memset(timers, 0, sizeof(timers));
-
 	/* initialize the lists */
-	timer_head = NULL;
-	timer_free_head = &timers[0];
-	for (i = 0; i < MAX_TIMERS-1; i++)
+	timer_block_list = NULL;
+	timer_block_count = 0;
+	timer_heap = NULL;
+	timer_heap_count = 0;
+	timer_heap_max = 0;
+	timer_seq = 0;
+	timer_free_head = NULL;
+	timer_free_tail = NULL;
+
+	/* allocate the first block, enough for most of the games */
+	timer_grow();
+
+	add_exit_callback(timer_exit);
+}
+
+
+/*-------------------------------------------------
+    timer_exit - free the timer system
+-------------------------------------------------*/
+
+static void timer_exit(void)
+{
+#if VERBOSE
+	timer_logtimers();
+#endif
+
+	logerror("Timers: %d max used, %d allocated in %d blocks\n", timer_heap_max, timer_block_count * TIMER_BLOCK_SIZE, timer_block_count);
+
+	/* free all the blocks, the remaining timers are discarded */
+	while (timer_block_list)
 	{
-		timers[i].tag = -1;
-		timers[i].next = &timers[i+1];
+		timer_block *block = timer_block_list;
+		timer_block_list = block->next;
+		free(block);
 	}
-	timers[MAX_TIMERS-1].next = NULL;
-	timer_free_tail = &timers[MAX_TIMERS-1];
+	timer_block_count = 0;
+
+	free(timer_heap);
+	timer_heap = NULL;
+	timer_heap_count = 0;
+
+	timer_free_head = NULL;
+	timer_free_tail = NULL;
 }
 
 
@@ -294,17 +483,27 @@ void timer_init(void)
 void timer_free(void)
 {
 	int tag = get_resource_tag();
-	mame_timer *timer, *next;
+	mame_timer *list = NULL;
+	mame_timer *timer;
+	int i;
 
-	/* scan the list */
-	for (timer = timer_head; timer != NULL; timer = next)
+	/* collect the matching timers, the queue is reordered by every remove */
+	for (i = 0; i < timer_heap_count; i++)
 	{
-		/* prefetch the next timer in case we remove this one */
-		next = timer->next;
-
-		/* if this tag matches, remove it */
+		timer = timer_heap[i];
 		if (timer->tag == tag)
-			mame_timer_remove(timer);
+		{
+			timer->next = list;
+			list = timer;
+		}
+	}
+
+	/* remove them */
+	while (list != NULL)
+	{
+		timer = list;
+		list = timer->next;
+		mame_timer_remove(timer);
 	}
 }
 
@@ -323,7 +522,7 @@ void timer_free(void)
 
 mame_time mame_timer_next_fire_time(void)
 {
-	return timer_head->expire;
+	return timer_heap[0]->expire;
 }
 
 
@@ -339,15 +538,15 @@ void mame_timer_set_global_time(mame_time newbase)
 	/* set the new global offset */
 	global_basetime = newbase;
 
-	LOG(("mame_timer_set_global_time: new=%.9f head->expire=%.9f\n", mame_time_to_double(newbase), mame_time_to_double(timer_head->expire)));
+	LOG(("mame_timer_set_global_time: new=%.9f head->expire=%.9f\n", mame_time_to_double(newbase), mame_time_to_double(timer_heap[0]->expire)));
 
 	/* now process any timers that are overdue */
-	while (compare_mame_times(timer_head->expire, global_basetime) <= 0)
+	while (compare_mame_times(timer_heap[0]->expire, global_basetime) <= 0)
 	{
-		int was_enabled = timer_head->enabled;
+		int was_enabled = timer_heap[0]->enabled;
 
 		/* if this is a one-shot timer, disable it now */
-		timer = timer_head;
+		timer = timer_heap[0];
 		if (compare_mame_times(timer->period, time_zero) == 0 || compare_mame_times(timer->period, time_never) == 0)
 			timer->enabled = FALSE;
 
@@ -391,8 +590,7 @@ void mame_timer_set_global_time(mame_time newbase)
 				timer->start = timer->expire;
 				timer->expire = add_mame_times(timer->expire, timer->period);
 
-				timer_list_remove(timer);
-				timer_list_insert(timer);
+				timer_list_update(timer);
 			}
 		}
 	}
@@ -415,11 +613,11 @@ static void timer_register_save(mame_timer *timer)
 {
 	char buf[256];
 	int count = 0;
-	mame_timer *t;
+	int i;
 
 	/* find other timers that match our func name */
-	for (t = timer_head; t; t = t->next)
-		if (!strcmp(t->func, timer->func))
+	for (i = 0; i < timer_heap_count; i++)
+		if (!strcmp(timer_heap[i]->func, timer->func))
 			count++;
 
 	/* make up a name */
@@ -448,10 +646,11 @@ static void timer_postload(void)
 	mame_timer *privlist = NULL;
 	mame_timer *t;
 
-	/* remove all timers and make a private list */
-	while (timer_head)
+	/* remove all timers in order and make a private list */
+	/* the list is reversed, as the re-insert order decides between equal times */
+	while (timer_heap_count)
 	{
-		t = timer_head;
+		t = timer_heap[0];
 
 		/* temporary timers go away entirely */
 		if (t->temporary)
@@ -485,14 +684,18 @@ int timer_count_anonymous(void)
 {
 	mame_timer *t;
 	int count = 0;
+	int i;
 
 	logerror("timer_count_anonymous:\n");
-	for (t = timer_head; t; t = t->next)
+	for (i = 0; i < timer_heap_count; i++)
+	{
+		t = timer_heap[i];
 		if (t->temporary && t != callback_timer)
 		{
 			count++;
 			logerror("  Temp. timer %p, file %s:%d[%s]\n", (void *) t, t->file, t->line, t->func);
 		}
+	}
 	logerror("%d temporary timers found\n", count);
 
 	return count;
@@ -513,8 +716,14 @@ int timer_count_anonymous(void)
 
 INLINE mame_timer *_mame_timer_alloc_common(void (*callback)(int), void (*callback_ptr)(void *), void *param, const char *file, int line, const char *func, int temp)
 {
-	mame_time time = get_current_time();
-	mame_timer *timer = timer_new();
+	mame_time time;
+	mame_timer *timer;
+
+	/* AdvanceMAME: the timers are shared with the CPUs running in parallel */
+	cpuexec_serialize();
+
+	time = get_current_time();
+	timer = timer_new();
 
 	/* fail if we can't allocate a new entry */
 	if (!timer)
@@ -565,6 +774,9 @@ mame_timer *_mame_timer_alloc_ptr(void (*callback_ptr)(void *), void *param, con
 
 static void mame_timer_remove(mame_timer *which)
 {
+	/* AdvanceMAME: the timers are shared with the CPUs running in parallel */
+	cpuexec_serialize();
+
 	/* error if this is an inactive timer */
 	if (which->tag == -1)
 	{
@@ -608,7 +820,12 @@ static void mame_timer_remove(mame_timer *which)
 
 INLINE void mame_timer_adjust_common(mame_timer *which, mame_time duration, INT32 param, mame_time period)
 {
-	mame_time time = get_current_time();
+	mame_time time;
+
+	/* AdvanceMAME: the timers are shared with the CPUs running in parallel */
+	cpuexec_serialize();
+
+	time = get_current_time();
 
 	/* error if this is an inactive timer */
 	if (which->tag == -1)
@@ -635,13 +852,12 @@ INLINE void mame_timer_adjust_common(mame_timer *which, mame_time duration, INT3
 	which->expire = add_mame_times(time, duration);
 	which->period = period;
 
-	/* remove and re-insert the timer in its new order */
-	timer_list_remove(which);
-	timer_list_insert(which);
+	/* move the timer in its new order */
+	timer_list_update(which);
 
 	/* if this was inserted as the head, abort the current timeslice and resync */
 	LOG(("timer_adjust %s.%s:%d to expire @ %.9f\n", which->file, which->func, which->line, mame_time_to_double(which->expire)));
-	if (which == timer_head && cpu_getexecutingcpu() >= 0)
+	if (which == timer_heap[0] && cpu_getexecutingcpu() >= 0)
 		activecpu_abort_timeslice();
 }
 
@@ -765,13 +981,15 @@ int mame_timer_enable(mame_timer *which, int enable)
 {
 	int old;
 
+	/* AdvanceMAME: the timers are shared with the CPUs running in parallel */
+	cpuexec_serialize();
+
 	/* set the enable flag */
 	old = which->enabled;
 	which->enabled = enable;
 
-	/* remove the timer and insert back into the list */
-	timer_list_remove(which);
-	timer_list_insert(which);
+	/* move the timer in its new order */
+	timer_list_update(which);
 
 	return old;
 }
@@ -852,15 +1070,19 @@ mame_time mame_timer_firetime(mame_timer *which)
 static void timer_logtimers(void)
 {
 	mame_timer *t;
+	int i;
 
 	logerror("===============\n");
 	logerror("TIMER LOG START\n");
 	logerror("===============\n");
 
 	logerror("Enqueued timers:\n");
-	for (t = timer_head; t; t = t->next)
+	for (i = 0; i < timer_heap_count; i++)
+	{
+		t = timer_heap[i];
 		logerror("  Start=%15.6f Exp=%15.6f Per=%15.6f Ena=%d Tmp=%d (%s:%d[%s])\n",
 			mame_time_to_double(t->start), mame_time_to_double(t->expire), mame_time_to_double(t->period), t->enabled, t->temporary, t->file, t->line, t->func);
+	}
 
 	logerror("Free timers:\n");
 	for (t = timer_free_head; t; t = t->next)
@@ -29,8 +29,8 @@ COREOBJS += $(OBJ)/tiny.o
 #	an & in front of each name.
 #-------------------------------------------------
 
-COREDEFS += -DTINY_NAME="driver_robby,driver_gridlee,driver_polyplay,driver_alienar"
-COREDEFS += -DTINY_POINTER="&driver_robby,&driver_gridlee,&driver_polyplay,&driver_alienar"
+COREDEFS += -DTINY_NAME="driver_robby,driver_gridlee,driver_polyplay,driver_alienar,driver_idletest,driver_partest"
+COREDEFS += -DTINY_POINTER="&driver_robby,&driver_gridlee,&driver_polyplay,&driver_alienar,&driver_idletest,&driver_partest"
 
 
 
@@ -70,6 +70,7 @@ DRVLIBS = \
 	$(OBJ)/machine/6821pia.o \
 	$(OBJ)/machine/ticket.o \
 	$(OBJ)/vidhrdw/res_net.o \
+	$(OBJ)/drivers/advtest.o \
 	$(OBJ)/drivers/astrocde.o $(OBJ)/machine/astrocde.o $(OBJ)/vidhrdw/astrocde.o \
 	$(OBJ)/sndhrdw/gorf.o $(OBJ)/sndhrdw/wow.o \
 	$(OBJ)/drivers/gridlee.o $(OBJ)/sndhrdw/gridlee.o $(OBJ)/vidhrdw/gridlee.o \
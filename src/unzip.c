@@ -179,6 +179,175 @@ static int ecd_read(zip_file* zip) {
 #define ZIPXTRALN	0x1c
 #define ZIPNAME		0x1e
 
+/* -------------------------------------------------------------------------
+   Central directory index
+ ------------------------------------------------------------------------- */
+
+/* Compare two filename
+   note:
+     don't check directory in zip and ignore case
+*/
+static int equal_filename(const char* zipfile, const char* file) {
+	const char* s1 = file;
+	/* start comparison after last / */
+	const char* s2 = strrchr(zipfile,'/');
+	if (s2)
+		++s2;
+	else
+		s2 = zipfile;
+	while (*s1 && toupper(*s1)==toupper(*s2)) {
+		++s1;
+		++s2;
+	}
+	return !*s1 && !*s2;
+}
+
+/* Hash of a filename
+   note:
+     like equal_filename() the directory and the case are ignored
+*/
+static unsigned hash_filename(const char* file) {
+	unsigned h = 0;
+	const char* s = strrchr(file,'/');
+	if (s)
+		++s;
+	else
+		s = file;
+	while (*s) {
+		h = h * 31 + toupper(*s);
+		++s;
+	}
+	return h;
+}
+
+/* Hash of a CRC */
+static unsigned hash_crc(UINT32 crc) {
+	return crc ^ (crc >> 16);
+}
+
+/* Compile a zip entry from the central directory data */
+static void entry_read(zip_entry* ent, char* buf) {
+	ent->cent_file_header_sig = read_dword (buf+ZIPCENSIG);
+	ent->version_made_by = *(buf+ZIPCVER);
+	ent->host_os = *(buf+ZIPCOS);
+	ent->version_needed_to_extract = *(buf+ZIPCVXT);
+	ent->os_needed_to_extract = *(buf+ZIPCEXOS);
+	ent->general_purpose_bit_flag = read_word (buf+ZIPCFLG);
+	ent->compression_method = read_word (buf+ZIPCMTHD);
+	ent->last_mod_file_time = read_word (buf+ZIPCTIM);
+	ent->last_mod_file_date = read_word (buf+ZIPCDAT);
+	ent->crc32 = read_dword (buf+ZIPCCRC);
+	ent->compressed_size = read_dword (buf+ZIPCSIZ);
+	ent->uncompressed_size = read_dword (buf+ZIPCUNC);
+	ent->filename_length = read_word (buf+ZIPCFNL);
+	ent->extra_field_length = read_word (buf+ZIPCXTL);
+	ent->file_comment_length = read_word (buf+ZIPCCML);
+	ent->disk_number_start = read_word (buf+ZIPDSK);
+	ent->internal_file_attrib = read_word (buf+ZIPINT);
+	ent->external_file_attrib = read_dword (buf+ZIPEXT);
+	ent->offset_lcl_hdr_frm_frst_disk = read_dword (buf+ZIPOFST);
+}
+
+/* Parse the central directory and build the name and CRC hash tables
+   in:
+     cd cent_dir data
+   out:
+     zip->dir, zip->dir_count and the hash tables
+   note:
+     the entries after a corrupt one are ignored, like readzip() always did
+*/
+static int index_build(zip_file* zip, char* cd) {
+	unsigned pos;
+	unsigned count;
+	unsigned name_size;
+	unsigned hash_size;
+	unsigned i;
+	char* name;
+
+	/* count the entries and the size of the names */
+	count = 0;
+	name_size = 0;
+	pos = 0;
+	while (pos + ZIPCFN <= zip->size_of_cent_dir) {
+		unsigned filename_length = read_word(cd+pos+ZIPCFNL);
+
+		/* check to see if filename length is illegally long (past the size of this directory
+		   entry) */
+		if (pos + ZIPCFN + filename_length > zip->size_of_cent_dir) {
+			errormsg("Invalid filename length in directory", ERROR_CORRUPT,zip->zip);
+			break;
+		}
+
+		++count;
+		name_size += filename_length + 1;
+
+		/* skip to next entry in central dir */
+		pos += ZIPCFN + filename_length + read_word(cd+pos+ZIPCXTL) + read_word(cd+pos+ZIPCCML);
+	}
+
+	/* at least twice the number of entries to have short chains */
+	hash_size = 16;
+	while (hash_size < 2 * count)
+		hash_size *= 2;
+
+	zip->dir = (zip_entry*)malloc( (count + 1) * sizeof(zip_entry) );
+	zip->dir_name = (char*)malloc( name_size + 1 );
+	zip->name_hash = (int*)malloc( 2 * (hash_size + count) * sizeof(int) );
+	if (!zip->dir || !zip->dir_name || !zip->name_hash)
+		return -1;
+
+	zip->dir_count = count;
+	zip->hash_mask = hash_size - 1;
+	zip->crc_hash = zip->name_hash + hash_size;
+	zip->name_next = zip->crc_hash + hash_size;
+	zip->crc_next = zip->name_next + count;
+
+	/* parse the entries */
+	name = zip->dir_name;
+	pos = 0;
+	for(i=0;i<count;++i) {
+		zip_entry* ent = &zip->dir[i];
+
+		entry_read(ent, cd+pos);
+
+		/* copy filename */
+		memcpy(name, cd+pos+ZIPCFN, ent->filename_length);
+		name[ent->filename_length] = 0;
+		ent->name = name;
+		name += ent->filename_length + 1;
+
+		pos += ZIPCFN + ent->filename_length + ent->extra_field_length + ent->file_comment_length;
+	}
+
+	/* insert in reverse order to have every chain in directory order */
+	for(i=0;i<hash_size;++i) {
+		zip->name_hash[i] = -1;
+		zip->crc_hash[i] = -1;
+	}
+	for(i=count;i>0;--i) {
+		unsigned h;
+		zip_entry* ent = &zip->dir[i-1];
+
+		h = hash_filename(ent->name) & zip->hash_mask;
+		zip->name_next[i-1] = zip->name_hash[h];
+		zip->name_hash[h] = i-1;
+
+		/* a zero CRC is never used for "load by CRC" */
+		zip->crc_next[i-1] = -1;
+		if (ent->crc32) {
+			h = hash_crc(ent->crc32) & zip->hash_mask;
+			zip->crc_next[i-1] = zip->crc_hash[h];
+			zip->crc_hash[h] = i-1;
+		}
+	}
+
+	zip->memory = sizeof(zip_file) + strlen(zip->zip) + 1 + zip->ecd_length
+		+ (count + 1) * sizeof(zip_entry) + name_size + 1
+		+ 2 * (hash_size + count) * sizeof(int);
+
+	return 0;
+}
+
 /* Opens a zip stream for reading
    return:
      !=0 success, zip stream
@@ -186,6 +355,7 @@ static int ecd_read(zip_file* zip) {
 */
 zip_file* openzip(int pathtype, int pathindex, const char* zipfile) {
 	osd_file_error error;
+	char* cd;
 
 	/* allocate */
 	zip_file* zip = (zip_file*)malloc( sizeof(zip_file) );
@@ -193,6 +363,13 @@ zip_file* openzip(int pathtype, int pathindex, const char* zipfile) {
 		return 0;
 	}
 
+	/* no index */
+	zip->dir = 0;
+	zip->dir_name = 0;
+	zip->dir_count = 0;
+	zip->name_hash = 0;
+	zip->cache_in = 0;
+
 	/* open */
 	zip->fp = osd_fopen(pathtype, pathindex, zipfile, "rb", &error);
 	if (!zip->fp) {
@@ -263,33 +440,30 @@ zip_file* openzip(int pathtype, int pathindex, const char* zipfile) {
 	}
 
 	/* read from start of central directory */
-	zip->cd = (char*)malloc( zip->size_of_cent_dir );
-	if (!zip->cd) {
+	cd = (char*)malloc( zip->size_of_cent_dir );
+	if (!cd) {
 		free(zip->ecd);
 		osd_fclose(zip->fp);
 		free(zip);
 		return 0;
 	}
 
-	if (osd_fread(zip->fp, zip->cd, zip->size_of_cent_dir)!=zip->size_of_cent_dir) {
+	if (osd_fread(zip->fp, cd, zip->size_of_cent_dir)!=zip->size_of_cent_dir) {
 		errormsg ("Reading central directory", ERROR_CORRUPT, zipfile);
-		free(zip->cd);
+		free(cd);
 		free(zip->ecd);
 		osd_fclose(zip->fp);
 		free(zip);
 		return 0;
 	}
 
-	/* reset ent */
-	zip->ent.name = 0;
-
 	/* rewind */
 	zip->cd_pos = 0;
 
 	/* file name */
 	zip->zip = (char*)malloc(strlen(zipfile)+1);
 	if (!zip->zip) {
-		free(zip->cd);
+		free(cd);
 		free(zip->ecd);
 		osd_fclose(zip->fp);
 		free(zip);
@@ -299,6 +473,15 @@ zip_file* openzip(int pathtype, int pathindex, const char* zipfile) {
 	zip->pathtype = pathtype;
 	zip->pathindex = pathindex;
 
+	/* parse and index the central directory, only the index is kept */
+	if (index_build(zip, cd)!=0) {
+		free(cd);
+		closezip(zip);
+		return 0;
+	}
+
+	free(cd);
+
 	return zip;
 }
 
@@ -312,55 +495,43 @@ zip_file* openzip(int pathtype, int pathindex, const char* zipfile) {
 zip_entry* readzip(zip_file* zip) {
 
 	/* end of directory */
-	if (zip->cd_pos >= zip->size_of_cent_dir)
+	if (zip->cd_pos >= zip->dir_count)
 		return 0;
 
-	/* compile zipent info */
-	zip->ent.cent_file_header_sig = read_dword (zip->cd+zip->cd_pos+ZIPCENSIG);
-	zip->ent.version_made_by = *(zip->cd+zip->cd_pos+ZIPCVER);
-	zip->ent.host_os = *(zip->cd+zip->cd_pos+ZIPCOS);
-	zip->ent.version_needed_to_extract = *(zip->cd+zip->cd_pos+ZIPCVXT);
-	zip->ent.os_needed_to_extract = *(zip->cd+zip->cd_pos+ZIPCEXOS);
-	zip->ent.general_purpose_bit_flag = read_word (zip->cd+zip->cd_pos+ZIPCFLG);
-	zip->ent.compression_method = read_word (zip->cd+zip->cd_pos+ZIPCMTHD);
-	zip->ent.last_mod_file_time = read_word (zip->cd+zip->cd_pos+ZIPCTIM);
-	zip->ent.last_mod_file_date = read_word (zip->cd+zip->cd_pos+ZIPCDAT);
-	zip->ent.crc32 = read_dword (zip->cd+zip->cd_pos+ZIPCCRC);
-	zip->ent.compressed_size = read_dword (zip->cd+zip->cd_pos+ZIPCSIZ);
-	zip->ent.uncompressed_size = read_dword (zip->cd+zip->cd_pos+ZIPCUNC);
-	zip->ent.filename_length = read_word (zip->cd+zip->cd_pos+ZIPCFNL);
-	zip->ent.extra_field_length = read_word (zip->cd+zip->cd_pos+ZIPCXTL);
-	zip->ent.file_comment_length = read_word (zip->cd+zip->cd_pos+ZIPCCML);
-	zip->ent.disk_number_start = read_word (zip->cd+zip->cd_pos+ZIPDSK);
-	zip->ent.internal_file_attrib = read_word (zip->cd+zip->cd_pos+ZIPINT);
-	zip->ent.external_file_attrib = read_dword (zip->cd+zip->cd_pos+ZIPEXT);
-	zip->ent.offset_lcl_hdr_frm_frst_disk = read_dword (zip->cd+zip->cd_pos+ZIPOFST);
-
-    /* check to see if filename length is illegally long (past the size of this directory
-       entry) */
-    if (zip->cd_pos + ZIPCFN + zip->ent.filename_length > zip->size_of_cent_dir)
-    {
-        errormsg("Invalid filename length in directory", ERROR_CORRUPT,zip->zip);
-        return 0;
-    }
+	return &zip->dir[zip->cd_pos++];
+}
+
+/* Finds an entry by name */
+zip_entry* findzip(zip_file* zip, const char* filename) {
+	int i;
+
+	for(i=zip->name_hash[hash_filename(filename) & zip->hash_mask];i>=0;i=zip->name_next[i])
+		if (equal_filename(zip->dir[i].name, filename))
+			return &zip->dir[i];
+
+	return 0;
+}
+
+/* Finds an entry by CRC */
+zip_entry* findcrczip(zip_file* zip, UINT32 crc) {
+	int i;
 
-	/* copy filename */
-	free(zip->ent.name);
-	zip->ent.name = (char*)malloc(zip->ent.filename_length + 1);
-	memcpy(zip->ent.name, zip->cd+zip->cd_pos+ZIPCFN, zip->ent.filename_length);
-	zip->ent.name[zip->ent.filename_length] = 0;
+	if (!crc)
+		return 0;
 
-	/* skip to next entry in central dir */
-	zip->cd_pos += ZIPCFN + zip->ent.filename_length + zip->ent.extra_field_length + zip->ent.file_comment_length;
+	for(i=zip->crc_hash[hash_crc(crc) & zip->hash_mask];i>=0;i=zip->crc_next[i])
+		if (zip->dir[i].crc32 == crc)
+			return &zip->dir[i];
 
-	return &zip->ent;
+	return 0;
 }
 
 /* Closes a zip stream */
 void closezip(zip_file* zip) {
 	/* release all */
-	free(zip->ent.name);
-	free(zip->cd);
+	free(zip->name_hash);
+	free(zip->dir_name);
+	free(zip->dir);
 	free(zip->ecd);
 	/* only if not suspended */
 	if (zip->fp)
@@ -541,6 +712,61 @@ static int inflate_file(osd_file* in_file, unsigned in_size, unsigned char* out_
 	return 0;
 }
 
+/* Inflate a memory buffer
+   in:
+   in_data compressed data, followed by a dummy byte
+   in_size size of the compressed data
+   out_size size of decompressed data
+   out:
+   out_data buffer for decompressed data
+   return:
+   ==0 ok
+*/
+static int inflate_buffer(unsigned char* in_data, unsigned in_size, unsigned char* out_data, unsigned out_size)
+{
+	int err;
+	z_stream d_stream; /* decompression stream */
+
+	d_stream.zalloc = 0;
+	d_stream.zfree = 0;
+	d_stream.opaque = 0;
+
+	d_stream.next_in = in_data;
+	d_stream.avail_in = in_size + 1; /* add dummy byte at end of compressed data */
+	d_stream.next_out = out_data;
+	d_stream.avail_out = out_size;
+
+	err = inflateInit2(&d_stream, -MAX_WBITS);
+	if (err != Z_OK)
+	{
+		logerror("inflateInit error: %d\n", err);
+		return -1;
+	}
+
+	err = inflate(&d_stream, Z_FINISH);
+	if (err != Z_STREAM_END)
+	{
+		logerror("inflate error: %d\n", err);
+		inflateEnd(&d_stream);
+		return -1;
+	}
+
+	err = inflateEnd(&d_stream);
+	if (err != Z_OK)
+	{
+		logerror("inflateEnd error: %d\n", err);
+		return -1;
+	}
+
+	if (d_stream.avail_out > 0)
+	{
+		logerror("zip size mismatch. %i\n", d_stream.avail_out);
+		return -1;
+	}
+
+	return 0;
+}
+
 /* Read compressed data
    out:
     data compressed data read
@@ -561,6 +787,30 @@ int readcompresszip(zip_file* zip, zip_entry* ent, char* data) {
 	return 0;
 }
 
+/* Check if a "Deflate" entry is supported
+   return:
+    ==0 supported
+    <0 error
+*/
+static int checkdeflatezip(zip_file* zip, zip_entry* ent) {
+	if (ent->version_needed_to_extract > 0x14) {
+		errormsg("Version too new", ERROR_UNSUPPORTED,zip->zip);
+		return -2;
+	}
+
+	if (ent->os_needed_to_extract != 0x00) {
+		errormsg("OS not supported", ERROR_UNSUPPORTED,zip->zip);
+		return -2;
+	}
+
+	if (ent->disk_number_start != zip->number_of_this_disk) {
+		errormsg("Cannot span disks", ERROR_UNSUPPORTED,zip->zip);
+		return -2;
+	}
+
+	return 0;
+}
+
 /* Read UNcompressed data
    out:
     data UNcompressed data
@@ -581,18 +831,7 @@ int readuncompresszip(zip_file* zip, zip_entry* ent, char* data) {
 		return readcompresszip(zip,ent,data);
 	} else if (ent->compression_method == 0x0008) {
 		/* file is compressed using "Deflate" method */
-		if (ent->version_needed_to_extract > 0x14) {
-			errormsg("Version too new", ERROR_UNSUPPORTED,zip->zip);
-			return -2;
-		}
-
-		if (ent->os_needed_to_extract != 0x00) {
-			errormsg("OS not supported", ERROR_UNSUPPORTED,zip->zip);
-			return -2;
-		}
-
-		if (ent->disk_number_start != zip->number_of_this_disk) {
-			errormsg("Cannot span disks", ERROR_UNSUPPORTED,zip->zip);
+		if (checkdeflatezip(zip,ent)!=0) {
 			return -2;
 		}
 
@@ -624,90 +863,137 @@ int readuncompresszip(zip_file* zip, zip_entry* ent, char* data) {
 
 #ifdef ZIP_CACHE
 
-/* ZIP cache entries */
-#define ZIP_CACHE_MAX 5
+/* Memory budget of the ZIP cache. Only the index of the central directory
+   is kept in memory, and the file handler is released, so even a small budget
+   holds many hundreds of zips */
+#define ZIP_CACHE_MEMORY (4*1024*1024)
+
+/* Minimum number of zips kept also if the budget is exceeded */
+#define ZIP_CACHE_MIN 5
+
+/* Size of the hash table of the cache */
+#define ZIP_CACHE_HASH 1024
 
-/* ZIP cache buffer LRU ( Last Recently Used )
-     zip_cache_map[0] is the newer
-     zip_cache_map[ZIP_CACHE_MAX-1] is the older
+/* ZIP cache LRU ( Last Recently Used )
+     zip_cache_head is the newer
+     zip_cache_tail is the older
 */
-static zip_file* zip_cache_map[ZIP_CACHE_MAX];
+/* Lock of the cache. The roms are loaded by many threads at the same time */
+static osd_lock* zip_lock;
+
+static zip_file* zip_cache_head;
+static zip_file* zip_cache_tail;
+static zip_file* zip_cache_bucket[ZIP_CACHE_HASH];
+static unsigned zip_cache_count;
+static unsigned zip_cache_memory;
+static unsigned zip_cache_hit;
+static unsigned zip_cache_miss;
+
+static void cache_lock(void) {
+	if (zip_lock)
+		osd_lock_acquire(zip_lock);
+}
+
+static void cache_unlock(void) {
+	if (zip_lock)
+		osd_lock_release(zip_lock);
+}
+
+static unsigned cache_hash(int pathtype, int pathindex, const char* zipfile) {
+	unsigned h = pathtype * 257 + pathindex;
+	while (*zipfile) {
+		h = h * 31 + (unsigned char)*zipfile;
+		++zipfile;
+	}
+	return h % ZIP_CACHE_HASH;
+}
+
+/* Insert a zip as the newer entry */
+static void cache_insert(zip_file* zip) {
+	unsigned h = cache_hash(zip->pathtype, zip->pathindex, zip->zip);
+
+	zip->cache_prev = 0;
+	zip->cache_next = zip_cache_head;
+	if (zip_cache_head)
+		zip_cache_head->cache_prev = zip;
+	else
+		zip_cache_tail = zip;
+	zip_cache_head = zip;
+
+	zip->cache_link = zip_cache_bucket[h];
+	zip_cache_bucket[h] = zip;
+
+	zip->cache_in = 1;
+	++zip_cache_count;
+	zip_cache_memory += zip->memory;
+}
+
+/* Remove a zip from the cache */
+static void cache_remove(zip_file* zip) {
+	zip_file** link = &zip_cache_bucket[cache_hash(zip->pathtype, zip->pathindex, zip->zip)];
+
+	while (*link != zip)
+		link = &(*link)->cache_link;
+	*link = zip->cache_link;
+
+	if (zip->cache_prev)
+		zip->cache_prev->cache_next = zip->cache_next;
+	else
+		zip_cache_head = zip->cache_next;
+	if (zip->cache_next)
+		zip->cache_next->cache_prev = zip->cache_prev;
+	else
+		zip_cache_tail = zip->cache_prev;
+
+	zip->cache_in = 0;
+	--zip_cache_count;
+	zip_cache_memory -= zip->memory;
+}
 
 static zip_file* cache_openzip(int pathtype, int pathindex, const char* zipfile) {
 	zip_file* zip;
-	unsigned i;
 
 	/* search in the cache buffer */
-	for(i=0;i<ZIP_CACHE_MAX;++i) {
-		if (zip_cache_map[i] && zip_cache_map[i]->pathtype == pathtype && zip_cache_map[i]->pathindex == pathindex && strcmp(zip_cache_map[i]->zip,zipfile)==0) {
+	for(zip=zip_cache_bucket[cache_hash(pathtype, pathindex, zipfile)];zip;zip=zip->cache_link) {
+		if (zip->pathtype == pathtype && zip->pathindex == pathindex && strcmp(zip->zip,zipfile)==0) {
 			/* found */
-			unsigned j;
-
-/*
-            logerror("Zip cache HIT  for %s\n", zipfile);
-*/
+			++zip_cache_hit;
 
 			/* reset the zip directory */
-			rewindzip( zip_cache_map[i] );
-
-			/* store */
-			zip = zip_cache_map[i];
-
-			/* shift */
-			for(j=i;j>0;--j)
-				zip_cache_map[j] = zip_cache_map[j-1];
+			rewindzip(zip);
 
-			/* set the first entry */
-			zip_cache_map[0] = zip;
+			/* move as the newer entry */
+			if (zip != zip_cache_head) {
+				cache_remove(zip);
+				cache_insert(zip);
+			}
 
-			return zip_cache_map[0];
+			return zip;
 		}
 	}
 	/* not found */
-
-/*
-    logerror("Zip cache FAIL for %s\n", zipfile);
-*/
+	++zip_cache_miss;
 
 	/* open the zip */
 	zip = openzip( pathtype, pathindex, zipfile );
 	if (!zip)
 		return 0;
 
-	/* close the oldest entry */
-	if (zip_cache_map[ZIP_CACHE_MAX-1]) {
-		/* close last zip */
-		closezip(zip_cache_map[ZIP_CACHE_MAX-1]);
-		/* reset the entry */
-		zip_cache_map[ZIP_CACHE_MAX-1] = 0;
-	}
-
-	/* shift */
-	for(i=ZIP_CACHE_MAX-1;i>0;--i)
-		zip_cache_map[i] = zip_cache_map[i-1];
+	cache_insert(zip);
 
-	/* set the first entry */
-	zip_cache_map[0] = zip;
+	/* close the oldest entries */
+	while (zip_cache_memory > ZIP_CACHE_MEMORY && zip_cache_count > ZIP_CACHE_MIN) {
+		zip_file* old = zip_cache_tail;
+		cache_remove(old);
+		closezip(old);
+	}
 
-	return zip_cache_map[0];
+	return zip;
 }
 
 static void cache_closezip(zip_file* zip) {
-	unsigned i;
-
-	/* search in the cache buffer */
-	for(i=0;i<ZIP_CACHE_MAX;++i) {
-		if (zip_cache_map[i]==zip) {
-			/* close zip */
-			closezip(zip);
-
-			/* reset cache entry */
-			zip_cache_map[i] = 0;
-			return;
-
-		}
-	}
-	/* not found */
+	if (zip->cache_in)
+		cache_remove(zip);
 
 	/* close zip */
 	closezip(zip);
@@ -717,19 +1003,38 @@ static void cache_closezip(zip_file* zip) {
    the user opens up an audit for a game we should reread the zip */
 void unzip_cache_clear()
 {
-	unsigned i;
+	cache_lock();
 
-	/* search in the cache buffer for any zip info and clear it */
-	for(i=0;i<ZIP_CACHE_MAX;++i) {
-		if (zip_cache_map[i] != NULL) {
-			/* close zip */
-			closezip(zip_cache_map[i]);
+	if (zip_cache_hit || zip_cache_miss)
+		logerror("Zip cache hits %u, misses %u, %u zips using %u bytes\n", zip_cache_hit, zip_cache_miss, zip_cache_count, zip_cache_memory);
 
-			/* reset cache entry */
-			zip_cache_map[i] = 0;
-/*          return; */
+	/* close all the zips */
+	while (zip_cache_head) {
+		zip_file* zip = zip_cache_head;
+		cache_remove(zip);
+		closezip(zip);
+	}
 
-		}
+	zip_cache_hit = 0;
+	zip_cache_miss = 0;
+
+	cache_unlock();
+}
+
+/* Allow the use of the zip functions from many threads */
+void unzip_init(void)
+{
+	if (!zip_lock)
+		zip_lock = osd_lock_alloc();
+}
+
+void unzip_exit(void)
+{
+	unzip_cache_clear();
+
+	if (zip_lock) {
+		osd_lock_free(zip_lock);
+		zip_lock = 0;
 	}
 }
 
@@ -740,8 +1045,12 @@ void unzip_cache_clear()
 #define cache_openzip(a,b,c) openzip(a,b,c)
 #define cache_closezip(a) closezip(a)
 #define cache_suspendzip(a) closezip(a)
+#define cache_lock()
+#define cache_unlock()
 
 #define unzip_cache_clear()
+#define unzip_init()
+#define unzip_exit()
 
 #endif
 
@@ -749,23 +1058,28 @@ void unzip_cache_clear()
    Backward MAME compatibility
  ------------------------------------------------------------------------- */
 
-/* Compare two filename
+/* Decode a "load by CRC" filename
    note:
-     don't check directory in zip and ignore case
+     it must be the exact "%08x" format of the CRC
 */
-static int equal_filename(const char* zipfile, const char* file) {
-	const char* s1 = file;
-	/* start comparison after last / */
-	const char* s2 = strrchr(zipfile,'/');
-	if (s2)
-		++s2;
-	else
-		s2 = zipfile;
-	while (*s1 && toupper(*s1)==toupper(*s2)) {
-		++s1;
-		++s2;
+static int crc_filename(const char* filename, UINT32* crc) {
+	UINT32 v = 0;
+	unsigned i;
+
+	for(i=0;i<8;++i) {
+		char c = filename[i];
+		if (c >= '0' && c <= '9')
+			v = v * 16 + c - '0';
+		else if (c >= 'a' && c <= 'f')
+			v = v * 16 + c - 'a' + 10;
+		else
+			return 0;
 	}
-	return !*s1 && !*s2;
+	if (filename[8])
+		return 0;
+
+	*crc = v;
+	return 1;
 }
 
 /* Pass the path to the zipfile and the name of the file within the zipfile.
@@ -774,87 +1088,122 @@ static int equal_filename(const char* zipfile, const char* file) {
 int /* error */ load_zipped_file (int pathtype, int pathindex, const char* zipfile, const char* filename, unsigned char** buf, unsigned int* length) {
 	zip_file* zip;
 	zip_entry* ent;
+	UINT32 crc;
+	unsigned char* compressed;
+	unsigned compressed_size;
+
+	cache_lock();
 
 	zip = cache_openzip(pathtype, pathindex, zipfile);
-	if (!zip)
+	if (!zip) {
+		cache_unlock();
 		return -1;
+	}
 
-	while (readzip(zip)) {
-		/* NS981003: support for "load by CRC" */
-		char crc[9];
+	ent = findzip(zip, filename);
 
-		ent = &(zip->ent);
+	/* NS981003: support for "load by CRC" */
+	if (crc_filename(filename, &crc)) {
+		zip_entry* crc_ent = findcrczip(zip, crc);
+		/* the first in directory order wins */
+		if (crc_ent && (!ent || crc_ent < ent))
+			ent = crc_ent;
+	}
 
-		sprintf(crc,"%08x",ent->crc32);
-		if (equal_filename(ent->name, filename) ||
-				(ent->crc32 && !strcmp(crc, filename)))
-		{
-			*length = ent->uncompressed_size;
-			*buf = (unsigned char*)malloc( *length );
-			if (!*buf) {
-				if (!gUnzipQuiet)
-					printf("load_zipped_file(): Unable to allocate %d bytes of RAM\n",*length);
-				cache_closezip(zip);
-				return -1;
-			}
+	if (!ent) {
+		cache_suspendzip(zip);
+		cache_unlock();
+		return -1;
+	}
 
-			if (readuncompresszip(zip, ent, (char*)*buf)!=0) {
-				free(*buf);
-				cache_closezip(zip);
-				return -1;
-			}
+	*length = ent->uncompressed_size;
+	*buf = (unsigned char*)malloc( *length );
+	if (!*buf) {
+		if (!gUnzipQuiet)
+			printf("load_zipped_file(): Unable to allocate %d bytes of RAM\n",*length);
+		cache_closezip(zip);
+		cache_unlock();
+		return -1;
+	}
 
-			cache_suspendzip(zip);
-			return 0;
+	/* stored files and errors */
+	if (ent->compression_method != 0x0008 || checkdeflatezip(zip,ent)!=0) {
+		if (readuncompresszip(zip, ent, (char*)*buf)!=0) {
+			free(*buf);
+			cache_closezip(zip);
+			cache_unlock();
+			return -1;
 		}
+
+		cache_suspendzip(zip);
+		cache_unlock();
+		return 0;
+	}
+
+	/* read the compressed data with the lock, and inflate it without */
+	compressed_size = ent->compressed_size;
+	compressed = (unsigned char*)malloc( compressed_size + 1 );
+	if (!compressed) {
+		free(*buf);
+		cache_closezip(zip);
+		cache_unlock();
+		return -1;
+	}
+
+	if (readcompresszip(zip, ent, (char*)compressed)!=0) {
+		free(compressed);
+		free(*buf);
+		cache_closezip(zip);
+		cache_unlock();
+		return -1;
 	}
 
 	cache_suspendzip(zip);
-	return -1;
+	cache_unlock();
+
+	compressed[compressed_size] = 0;
+	if (inflate_buffer(compressed, compressed_size, *buf, *length)!=0) {
+		errormsg("Inflating compressed data", ERROR_CORRUPT, zipfile);
+		free(compressed);
+		free(*buf);
+		return -1;
+	}
+
+	free(compressed);
+	return 0;
 }
 
 /*  Pass the path to the zipfile and the name of the file within the zipfile.
     sum will be set to the CRC-32 of that zipped file. */
 /*  The caller can preset sum to the expected checksum to enable "load by CRC" */
+/*  The CRC is taken from the central directory, nothing is decompressed */
 int /* error */ checksum_zipped_file (int pathtype, int pathindex, const char *zipfile, const char *filename, unsigned int *length, unsigned int *sum) {
 	zip_file* zip;
 	zip_entry* ent;
 
+	cache_lock();
+
 	zip = cache_openzip(pathtype, pathindex, zipfile);
-	if (!zip)
+	if (!zip) {
+		cache_unlock();
 		return -1;
-
-	while (readzip(zip)) {
-		ent = &(zip->ent);
-
-		if (equal_filename(ent->name, filename))
-		{
-			*length = ent->uncompressed_size;
-			*sum = ent->crc32;
-			cache_suspendzip(zip);
-			return 0;
-		}
 	}
 
-	cache_suspendzip(zip);
+	ent = findzip(zip, filename);
 
 	/* NS981003: support for "load by CRC" */
-	zip = cache_openzip(pathtype, pathindex, zipfile);
-	if (!zip)
-		return -1;
-
-	while (readzip(zip)) {
-		ent = &(zip->ent);
-
-		if (*sum && ent->crc32 == *sum)
-		{
-			*length = ent->uncompressed_size;
-			*sum = ent->crc32;
-			cache_suspendzip(zip);
-			return 0;
-		}
+	if (!ent)
+		ent = findcrczip(zip, *sum);
+
+	if (ent) {
+		*length = ent->uncompressed_size;
+		*sum = ent->crc32;
+		cache_suspendzip(zip);
+		cache_unlock();
+		return 0;
 	}
 
 	cache_suspendzip(zip);
+	cache_unlock();
 	return -1;
 }
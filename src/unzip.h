@@ -53,11 +53,25 @@ struct _zip_file
 	char* ecd; /* end_of_cent_dir data */
 	unsigned ecd_length; /* end_of_cent_dir length */
 
-	char* cd; /* cent_dir data */
-
-	unsigned cd_pos; /* position in cent_dir */
-
-	zip_entry ent; /* buffer for readzip */
+	zip_entry* dir; /* entries of the cent_dir, in directory order */
+	char* dir_name; /* names of the entries */
+	unsigned dir_count; /* number of entries */
+
+	unsigned cd_pos; /* next entry returned by readzip */
+
+	/* index of the cent_dir */
+	unsigned hash_mask; /* size of the hash tables - 1 */
+	int* name_hash; /* first entry for every name hash, -1 if none */
+	int* crc_hash; /* first entry for every crc hash, -1 if none */
+	int* name_next; /* next entry with the same name hash, -1 at the end */
+	int* crc_next; /* next entry with the same crc hash, -1 at the end */
+
+	/* cache */
+	unsigned memory; /* memory used by the zip and its index */
+	struct _zip_file* cache_prev; /* newer zip in the cache */
+	struct _zip_file* cache_next; /* older zip in the cache */
+	struct _zip_file* cache_link; /* next zip in the same cache bucket */
+	int cache_in; /* the zip is in the cache */
 
 	/* end_of_cent_dir */
 	UINT32	end_of_cent_dir_sig;
@@ -91,6 +105,26 @@ void closezip(zip_file* zip);
 */
 zip_entry* readzip(zip_file* zip);
 
+/* Finds an entry by name
+   in:
+     zip opened zip
+     filename name of the entry, the directory in the zip and the case are ignored
+   return:
+     !=0 first matching entry in directory order
+     ==0 not found
+*/
+zip_entry* findzip(zip_file* zip, const char* filename);
+
+/* Finds an entry by CRC
+   in:
+     zip opened zip
+     crc CRC of the entry, 0 never matches
+   return:
+     !=0 first matching entry in directory order
+     ==0 not found
+*/
+zip_entry* findcrczip(zip_file* zip, UINT32 crc);
+
 /* Suspend access to a zip file (release file handler)
    in:
       zip opened zip
@@ -139,6 +173,10 @@ int /* error */ checksum_zipped_file (int pathtype, int pathindex, const char *z
 
 void unzip_cache_clear(void);
 
+/* Allow the use of load_zipped_file() and checksum_zipped_file() from many threads */
+void unzip_init(void);
+void unzip_exit(void);
+
 /* public globals */
 extern int	gUnzipQuiet;	/* flag controls error messages */
 
@@ -642,8 +642,10 @@ void force_partial_update(int scanline)
 	if (clip.min_y <= clip.max_y)
 	{
 		profiler_mark(PROFILER_VIDEO);
+		osd_trace_begin("Video update");
 		(*Machine->drv->video_update)(0, scrbitmap[0], &clip);
 		performance.partial_updates_this_frame++;
+		osd_trace_end();
 		profiler_mark(PROFILER_END);
 	}
 
@@ -804,7 +806,9 @@ void updatescreen(void)
 	if (!osd_skip_this_frame())
 	{
 		profiler_mark(PROFILER_VIDEO);
+		osd_trace_begin("Video update");
 		draw_screen();
+		osd_trace_end();
 		profiler_mark(PROFILER_END);
 	}
 
@@ -824,7 +828,9 @@ void updatescreen(void)
 	if (Machine->drv->video_eof && !mame_is_paused())
 	{
 		profiler_mark(PROFILER_VIDEO);
+		osd_trace_begin("Video eof");
 		(*Machine->drv->video_eof)();
+		osd_trace_end();
 		profiler_mark(PROFILER_END);
 	}
 }